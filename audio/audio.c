@@ -95,25 +95,13 @@ static vec2 CalculateBarycentric(const vec3 p, const vec3 a, const vec3 b, const
 	return Vec2((d11*d20-d01*d21)*invDenom, (d00*d21-d01*d20)*invDenom);
 }
 
-static float maxDistanceSq=-1.0f;
-static uint32_t triangleIndex=-1;
-
-static void HRIR_FindBestTriangle(void *a, void *b)
-{
-	const vec3 *position=(vec3 *)a;
-	const uint32_t tri=*(uint32_t *)b;
-	const float d=Vec3_Dot(*position, sphere.vertices[3*tri].normal);
-
-	if(d>maxDistanceSq)
-	{
-		maxDistanceSq=d;
-		triangleIndex=tri;
-	}
-}
+// Triangle normals are hashed at this radius, so the hash's grid size is meaningful against them
+#define HRIR_HASH_RADIUS 100.0f
 
 // HRIR sample interpolation, takes world-space position as input.
 // HRIR samples are taken as float, but interpolated output is int16.
-static void HRIRInterpolate(vec3 xyz)
+// Only touches the passed kernel, so separate kernels can be interpolated at the same time.
+static bool HRIRInterpolate(vec3 xyz, int16_t *kernel)
 {
 	// Sound distance drop-off constant, this is the radius of the hearable range
 	const float invRadius=1.0f/500.0f;
@@ -127,19 +115,18 @@ static void HRIRInterpolate(vec3 xyz)
 
 	Vec3_Normalize(&position);
 
-	maxDistanceSq=-1.0f;
-	triangleIndex=-1;
+	// Closest triangle normal to the direction is the triangle it passes through,
+	// the search radius covers the whole sphere so there's always an answer.
+	uint32_t triangle;
+	float distanceSq;
 
-	// Query spatial hash for nearby triangles
-	SpatialHash_TestObjects(&HRIRHash, position, &position, HRIR_FindBestTriangle);
-
-	if(triangleIndex>sphere.numIndex)
-		return;
+	if(!SpatialHash_QueryNearest(&HRIRHash, Vec3_Muls(position, HRIR_HASH_RADIUS), 1, 2.0f*HRIR_HASH_RADIUS, &triangle, &distanceSq))
+		return false;
 
 	// Calculate the barycentric coordinates and use them to interpolate the HRIR samples.
-	const HRIR_Vertex_t *v0=&sphere.vertices[triangleIndex+0];
-	const HRIR_Vertex_t *v1=&sphere.vertices[triangleIndex+1];
-	const HRIR_Vertex_t *v2=&sphere.vertices[triangleIndex+2];
+	const HRIR_Vertex_t *v0=&sphere.vertices[sphere.indices[3*triangle+0]];
+	const HRIR_Vertex_t *v1=&sphere.vertices[sphere.indices[3*triangle+1]];
+	const HRIR_Vertex_t *v2=&sphere.vertices[sphere.indices[3*triangle+2]];
 	const vec2 g=Vec2_Clamp(CalculateBarycentric(position, v0->vertex, v1->vertex, v2->vertex), 0.0f, 1.0f);
 	const vec3 coords=Vec3(g.x, g.y, 1.0f-g.x-g.y);
 
@@ -152,10 +139,12 @@ static void HRIRInterpolate(vec3 xyz)
 			const float gain=4.0f;
 			const float final=falloffDist*gain*HRIRWindow[i]*INT16_MAX;
 
-			HRIRKernel[2*i+0]=(int16_t)(final*Vec3_Dot(left, coords));
-			HRIRKernel[2*i+1]=(int16_t)(final*Vec3_Dot(right, coords));
+			kernel[2*i+0]=(int16_t)(final*Vec3_Dot(left, coords));
+			kernel[2*i+1]=(int16_t)(final*Vec3_Dot(right, coords));
 		}
 	}
+
+	return true;
 }
 
 // Integer audio convolution, this is a current chokepoint in the audio system at 25% CPU usage in the profiler.
@@ -225,7 +214,7 @@ void Audio_FillBuffer(void *buffer, uint32_t length)
 			continue;
 
 		// Interpolate HRIR samples that are closest to the sound's position
-		HRIRInterpolate(channel->xyz);
+		HRIRInterpolate(channel->xyz, HRIRKernel);
 
 		// Calculate the remaining amount of data to process.
 		size_t remainingData=channel->sample->length-channel->position;
@@ -407,14 +396,14 @@ static bool HRIR_Init(void)
 	if(sphere.sampleLength>MAX_HRIR_SAMPLES)
 		return false;
 
-	sphere.indices=(uint32_t *)Zone_Malloc(zone, sizeof(uint32_t)*sphere.numIndex);
+	sphere.indices=(uint32_t *)Zone_MallocTagged(zone, sizeof(uint32_t)*sphere.numIndex, TAG_AUDIO);
 
 	if(sphere.indices==NULL)
 		return false;
 
 	fread(sphere.indices, sizeof(uint32_t), sphere.numIndex, stream);
 
-	sphere.vertices=(HRIR_Vertex_t *)Zone_Malloc(zone, sizeof(HRIR_Vertex_t)*sphere.numVertex);
+	sphere.vertices=(HRIR_Vertex_t *)Zone_MallocTagged(zone, sizeof(HRIR_Vertex_t)*sphere.numVertex, TAG_AUDIO);
 
 	if(sphere.vertices==NULL)
 		return false;
@@ -431,7 +420,7 @@ static bool HRIR_Init(void)
 
 	fclose(stream);
 
-	if(!SpatialHash_Create(&HRIRHash, 512, 2.0f))
+	if(!SpatialHash_Create(&HRIRHash, 512, 10.0f))
 		return false;
 
 	SpatialHash_Clear(&HRIRHash);
@@ -449,9 +438,11 @@ static bool HRIR_Init(void)
 		v1->normal=Vec3_Addv(v1->normal, normal);
 		v2->normal=Vec3_Addv(v2->normal, normal);
 
-		SpatialHash_AddObject(&HRIRHash, Vec3_Muls(normal, 100.0f), &sphere.indices[i]);
+		SpatialHash_AddObject(&HRIRHash, Vec3_Muls(normal, HRIR_HASH_RADIUS), &sphere.indices[i]);
 	}
 
+	SpatialHash_Build(&HRIRHash);
+
 	for(uint32_t i=0;i<sphere.sampleLength;i++)
 		HRIRWindow[i]=0.5f*(0.5f-cosf(2.0f*PI*(float)i/(sphere.sampleLength-1)));
 
@@ -521,7 +512,7 @@ static int16_t *ConvertAndResample(const void *in, const uint32_t numSamples, co
 	const float stepScale=(float)sampleRate/AUDIO_SAMPLE_RATE;
 	const uint32_t outCount=(uint32_t)(numSamples/stepScale);
 
-	int16_t *out=(int16_t *)Zone_Malloc(zone, sizeof(int16_t)*outCount*channels);
+	int16_t *out=(int16_t *)Zone_MallocTagged(zone, sizeof(int16_t)*outCount*channels, TAG_AUDIO);
 
 	if(out==NULL)
 		return NULL;
@@ -659,7 +650,7 @@ bool Audio_LoadStatic(const char *filename, Sample_t *sample)
 
 			fseek(stream, 0, SEEK_SET);
 
-			uint8_t *data=(uint8_t *)Zone_Malloc(zone, size);
+			uint8_t *data=(uint8_t *)Zone_MallocTagged(zone, size, TAG_AUDIO);
 
 			if(data==NULL)
 			{
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "../system/system.h"
+#include "../system/threads.h"
 #include "qoa.h"
 
 static const uint32_t QOA_MAGIC='q'<<24|'o'<<16|'a'<<8|'f';
@@ -226,7 +227,7 @@ void *QOA_Encode(const int16_t *samples, QOA_Desc_t *qoa, uint32_t *outLength)
 	uint32_t numFrames=(qoa->numSamples+QOA_FRAME_LEN-1)/QOA_FRAME_LEN;
 	uint32_t numSlices=(qoa->numSamples+QOA_SLICE_LEN-1)/QOA_SLICE_LEN;
 	uint32_t encodedSize=8+numFrames*8+numFrames*QOA_LMS_LEN*4*qoa->channels+numSlices*8*qoa->channels;
-	uint8_t *bytes=(uint8_t *)Zone_Malloc(zone, encodedSize);
+	uint8_t *bytes=(uint8_t *)Zone_MallocTagged(zone, encodedSize, TAG_AUDIO);
 
 	for(uint32_t channelIndex=0;channelIndex<qoa->channels;channelIndex++)
 	{
@@ -253,6 +254,9 @@ void *QOA_Encode(const int16_t *samples, QOA_Desc_t *qoa, uint32_t *outLength)
 
 		uint32_t frameSize=QOA_EncodeFrame(samples+sampleIndex*qoa->channels, qoa, frameLength, p);
 		p+=frameSize>>3;
+
+		// Frame boundary is a safe point to let higher priority jobs run, if this is a background job
+		Thread_YieldJob();
 	}
 
 	*outLength=(uint32_t)((uint8_t *)p-bytes);
@@ -364,7 +368,7 @@ void *QOA_Decode(const uint8_t *bytes, uint32_t size, QOA_Desc_t *qoa)
 	if(!QOA_DecodeHeader(&p, size, qoa))
 		return NULL;
 
-	int16_t *samples=(int16_t *)Zone_Malloc(zone, qoa->numSamples*qoa->channels*sizeof(int16_t));
+	int16_t *samples=(int16_t *)Zone_MallocTagged(zone, qoa->numSamples*qoa->channels*sizeof(int16_t), TAG_AUDIO);
 
 	if(samples==NULL)
 		return NULL;
@@ -414,7 +418,7 @@ bool QOA_OpenFile(QOA_File_t *qoaFile, const char *filename)
 	fseek(qoaFile->file, -(long)sizeof(uint64_t), SEEK_CUR);
 
 	// Allocate memory for decoded samples.
-	qoaFile->samples=(int16_t *)Zone_Malloc(zone, qoaFile->qoa.frameNumSamples*qoaFile->qoa.channels*sizeof(int16_t));
+	qoaFile->samples=(int16_t *)Zone_MallocTagged(zone, qoaFile->qoa.frameNumSamples*qoaFile->qoa.channels*sizeof(int16_t), TAG_AUDIO);
 
 	if(qoaFile->samples==NULL)
 	{
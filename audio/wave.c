@@ -70,7 +70,7 @@ void *WavRead(const char *filename, WaveFormat_t *format, uint32_t *numSamples)
 
 			case DATA_MAGIC:
 			{
-				buffer=(uint8_t *)Zone_Malloc(zone, chunk.size);
+				buffer=(uint8_t *)Zone_MallocTagged(zone, chunk.size, TAG_AUDIO);
 
 				if(buffer==NULL)
 					goto error;
@@ -0,0 +1,711 @@
+// Physics microbenchmark and consistency checks.
+
+// Times the SIMD OBB-OBB separating axis test against the scalar reference on a fixed set of random box pairs,
+//		PhysicsWorld_QuerySphere against a plain loop over the same bounding spheres,
+//		and PhysicsWorld_Integrate against PhysicsIntegrate on every body.
+// Both sides are run over the same data and checked against each other before any times are reported,
+//		so a faster kernel that gets a different answer shows up as a mismatch rather than a speedup.
+// Physics_Step is run on two copies of one world, one on the calling thread and one on a worker pool,
+//		which have to stay bit for bit identical, every step.
+// Last is a sleep check, two resting stacks have to fall asleep, an explosion has to wake only the stack it hits,
+//		and removing a body from the other has to wake the rest of it, with numSleeping matching the sleeping flags throughout.
+//
+// Usage: physicsbench [-p OBB pairs] [-b bodies] [-q sphere queries] [-i iterations] [-n steps] [-w workers] [-s seed]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <float.h>
+#include "../system/system.h"
+#include "../physics/physics.h"
+#include "../physics/physicssimd.h"
+#include "../physics/physicsworld.h"
+
+MemZone_t *zone=NULL;
+
+// Sum of every result, volatile so the compiler can't throw the timed loops away
+static volatile float benchSink=0.0f;
+
+static uint64_t GetTime(void)
+{
+	struct timespec ts;
+
+#if defined(LINUX)||defined(ANDROID)
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+	timespec_get(&ts, TIME_UTC);
+#endif
+
+	return (uint64_t)ts.tv_sec*1000000000ull+(uint64_t)ts.tv_nsec;
+}
+
+static vec4 RandomOrientation(void)
+{
+	vec4 orientation=Vec4(RandFloatRange(-1.0f, 1.0f), RandFloatRange(-1.0f, 1.0f), RandFloatRange(-1.0f, 1.0f), RandFloatRange(-1.0f, 1.0f));
+
+	if(Vec4_Normalize(&orientation)<FLT_EPSILON)
+		orientation=Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	return orientation;
+}
+
+static void RandomOBB(RigidBody_t *body, const float spread)
+{
+	memset(body, 0, sizeof(RigidBody_t));
+
+	body->type=RIGIDBODY_OBB;
+	body->position=Vec3(RandFloatRange(-spread, spread), RandFloatRange(-spread, spread), RandFloatRange(-spread, spread));
+	body->orientation=RandomOrientation();
+	body->size=Vec3(RandFloatRange(1.0f, 5.0f), RandFloatRange(1.0f, 5.0f), RandFloatRange(1.0f, 5.0f));
+	body->mass=1.0f;
+	body->invMass=1.0f;
+}
+
+//////// OBB-OBB
+
+typedef bool (*OBBContactFunc_t)(const RigidBody_t *a, const RigidBody_t *b, PhysicsContact_t *contact);
+
+static uint64_t TimeOBB(OBBContactFunc_t func, const RigidBody_t *bodies, const uint32_t numPairs, const uint32_t iterations)
+{
+	float sum=0.0f;
+	const uint64_t start=GetTime();
+
+	for(uint32_t iteration=0;iteration<iterations;iteration++)
+	{
+		for(uint32_t i=0;i<numPairs;i++)
+		{
+			PhysicsContact_t contact;
+
+			if(func(&bodies[2*i+0], &bodies[2*i+1], &contact))
+				sum+=contact.penetration;
+		}
+	}
+
+	const uint64_t time=GetTime()-start;
+
+	benchSink+=sum;
+
+	return time;
+}
+
+static bool BenchOBB(const uint32_t numPairs, const uint32_t iterations)
+{
+	RigidBody_t *bodies=(RigidBody_t *)malloc(sizeof(RigidBody_t)*numPairs*2);
+
+	if(bodies==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "BenchOBB: Unable to allocate %u pairs.\n", numPairs);
+		return false;
+	}
+
+	// Second box within a few box lengths of the first, so there's a mix of early outs, late outs and hits
+	for(uint32_t i=0;i<numPairs;i++)
+	{
+		RandomOBB(&bodies[2*i+0], 100.0f);
+		RandomOBB(&bodies[2*i+1], 10.0f);
+		bodies[2*i+1].position=Vec3_Addv(bodies[2*i+1].position, bodies[2*i+0].position);
+	}
+
+	// Check the SIMD test agrees with the reference before timing anything
+	uint32_t numHits=0, hitMismatches=0, normalMismatches=0;
+	float maxPenetrationError=0.0f;
+
+	for(uint32_t i=0;i<numPairs;i++)
+	{
+		PhysicsContact_t scalar, simd;
+		const bool scalarHit=PhysicsOBBToOBBContactScalar(&bodies[2*i+0], &bodies[2*i+1], &scalar);
+		const bool simdHit=PhysicsOBBToOBBContact(&bodies[2*i+0], &bodies[2*i+1], &simd);
+
+		if(scalarHit!=simdHit)
+		{
+			hitMismatches++;
+			continue;
+		}
+
+		if(!scalarHit)
+			continue;
+
+		numHits++;
+		maxPenetrationError=fmaxf(maxPenetrationError, fabsf(scalar.penetration-simd.penetration));
+
+		// Near ties between two axes can round either way, only count it if the penetrations differ too
+		if(Vec3_Dot(scalar.normal, simd.normal)<0.999f&&fabsf(scalar.penetration-simd.penetration)>1e-4f)
+			normalMismatches++;
+	}
+
+	const uint64_t scalarTime=TimeOBB(PhysicsOBBToOBBContactScalar, bodies, numPairs, iterations);
+	const uint64_t simdTime=TimeOBB(PhysicsOBBToOBBContact, bodies, numPairs, iterations);
+	const double numTests=(double)numPairs*iterations;
+
+	DBGPRINTF(DEBUG_INFO, "\nOBB-OBB: %u pairs x %u iterations, %0.1f%% colliding\n", numPairs, iterations, 100.0*numHits/numPairs);
+	DBGPRINTF(DEBUG_NONE, "%-8s %12s %10s\n", "Test", "Total (ms)", "ns/pair");
+	DBGPRINTF(DEBUG_NONE, "%-8s %12.3f %10.2f\n", "Scalar", (double)scalarTime/1e6, (double)scalarTime/numTests);
+	DBGPRINTF(DEBUG_NONE, "%-8s %12.3f %10.2f\n", "SIMD", (double)simdTime/1e6, (double)simdTime/numTests);
+	DBGPRINTF(DEBUG_NONE, "Speedup: %0.2fx, hit mismatches: %u, normal mismatches: %u, max penetration error: %g\n",
+			  (double)scalarTime/(double)simdTime, hitMismatches, normalMismatches, maxPenetrationError);
+
+	free(bodies);
+
+	return !hitMismatches&&!normalMismatches;
+}
+
+//////// Sphere queries
+
+// What PhysicsWorld_QuerySphere does, one body at a time
+static uint32_t QuerySphereScalar(const PhysicsWorld_t *world, const vec3 center, const float radius, uint32_t *indices, const uint32_t maxIndices)
+{
+	uint32_t numFound=0;
+
+	for(uint32_t i=0;i<world->count;i++)
+	{
+		const float dx=world->positionX[i]-center.x;
+		const float dy=world->positionY[i]-center.y;
+		const float dz=world->positionZ[i]-center.z;
+		const float radiiSum=world->boundingRadius[i]+radius;
+
+		if(dx*dx+dy*dy+dz*dz<=radiiSum*radiiSum)
+		{
+			if(numFound<maxIndices)
+				indices[numFound]=i;
+
+			numFound++;
+		}
+	}
+
+	return numFound;
+}
+
+typedef uint32_t (*QuerySphereFunc_t)(const PhysicsWorld_t *world, const vec3 center, const float radius, uint32_t *indices, const uint32_t maxIndices);
+
+static uint64_t TimeQuerySphere(QuerySphereFunc_t func, const PhysicsWorld_t *world, const vec4 *queries, const uint32_t numQueries, const uint32_t iterations, uint32_t *indices, uint64_t *numFound)
+{
+	uint64_t found=0;
+	const uint64_t start=GetTime();
+
+	for(uint32_t iteration=0;iteration<iterations;iteration++)
+	{
+		for(uint32_t i=0;i<numQueries;i++)
+			found+=func(world, Vec3(queries[i].x, queries[i].y, queries[i].z), queries[i].w, indices, world->count);
+	}
+
+	const uint64_t time=GetTime()-start;
+
+	benchSink+=(float)found;
+	*numFound=found;
+
+	return time;
+}
+
+static bool BenchQuerySphere(const uint32_t numBodies, const uint32_t numQueries, const uint32_t iterations)
+{
+	PhysicsWorld_t world;
+
+	if(!PhysicsWorld_Init(&world, numBodies))
+		return false;
+
+	// Same sort of mix the engine has, mostly spheres with some boxes
+	for(uint32_t i=0;i<numBodies;i++)
+	{
+		RigidBody_t body;
+		RandomOBB(&body, 500.0f);
+
+		if(i%4)
+		{
+			body.type=RIGIDBODY_SPHERE;
+			body.radius=RandFloatRange(1.0f, 8.0f);
+		}
+
+		PhysicsWorld_AddBody(&world, &body);
+	}
+
+	vec4 *queries=(vec4 *)malloc(sizeof(vec4)*numQueries);
+	uint32_t *scalarIndices=(uint32_t *)malloc(sizeof(uint32_t)*numBodies);
+	uint32_t *simdIndices=(uint32_t *)malloc(sizeof(uint32_t)*numBodies);
+
+	if(queries==NULL||scalarIndices==NULL||simdIndices==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "BenchQuerySphere: Unable to allocate memory.\n");
+		free(queries);
+		free(scalarIndices);
+		free(simdIndices);
+		PhysicsWorld_Destroy(&world);
+		return false;
+	}
+
+	// Explosion sized queries, a few bodies caught in each
+	for(uint32_t i=0;i<numQueries;i++)
+		queries[i]=Vec4(RandFloatRange(-500.0f, 500.0f), RandFloatRange(-500.0f, 500.0f), RandFloatRange(-500.0f, 500.0f), RandFloatRange(10.0f, 100.0f));
+
+	uint32_t mismatches=0;
+
+	for(uint32_t i=0;i<numQueries;i++)
+	{
+		const vec3 center=Vec3(queries[i].x, queries[i].y, queries[i].z);
+		const uint32_t scalarFound=QuerySphereScalar(&world, center, queries[i].w, scalarIndices, numBodies);
+		const uint32_t simdFound=PhysicsWorld_QuerySphere(&world, center, queries[i].w, simdIndices, numBodies);
+
+		if(scalarFound!=simdFound||memcmp(scalarIndices, simdIndices, sizeof(uint32_t)*scalarFound))
+			mismatches++;
+	}
+
+	uint64_t scalarFound=0, simdFound=0;
+	const uint64_t scalarTime=TimeQuerySphere(QuerySphereScalar, &world, queries, numQueries, iterations, scalarIndices, &scalarFound);
+	const uint64_t simdTime=TimeQuerySphere(PhysicsWorld_QuerySphere, &world, queries, numQueries, iterations, simdIndices, &simdFound);
+	const double numTests=(double)numBodies*numQueries*iterations;
+
+	DBGPRINTF(DEBUG_INFO, "\nSphere query: %u bodies, %u queries x %u iterations, %0.1f found per query\n", numBodies, numQueries, iterations, (double)scalarFound/((double)numQueries*iterations));
+	DBGPRINTF(DEBUG_NONE, "%-8s %12s %10s\n", "Test", "Total (ms)", "ns/body");
+	DBGPRINTF(DEBUG_NONE, "%-8s %12.3f %10.3f\n", "Scalar", (double)scalarTime/1e6, (double)scalarTime/numTests);
+	DBGPRINTF(DEBUG_NONE, "%-8s %12.3f %10.3f\n", "SIMD", (double)simdTime/1e6, (double)simdTime/numTests);
+	DBGPRINTF(DEBUG_NONE, "Speedup: %0.2fx, query mismatches: %u\n", (double)scalarTime/(double)simdTime, mismatches);
+
+	free(queries);
+	free(scalarIndices);
+	free(simdIndices);
+	PhysicsWorld_Destroy(&world);
+
+	return !mismatches&&scalarFound==simdFound;
+}
+
+//////// Integration
+
+static bool BenchIntegrate(const uint32_t numBodies, const uint32_t iterations)
+{
+	const float dt=1.0f/60.0f;
+	PhysicsWorld_t world;
+
+	if(!PhysicsWorld_Init(&world, numBodies))
+		return false;
+
+	RigidBody_t *bodies=(RigidBody_t *)malloc(sizeof(RigidBody_t)*numBodies);
+
+	if(bodies==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "BenchIntegrate: Unable to allocate %u bodies.\n", numBodies);
+		PhysicsWorld_Destroy(&world);
+		return false;
+	}
+
+	for(uint32_t i=0;i<numBodies;i++)
+	{
+		RigidBody_t body;
+		RandomOBB(&body, 2000.0f);
+
+		body.velocity=Vec3(RandFloatRange(-500.0f, 500.0f), RandFloatRange(-500.0f, 500.0f), RandFloatRange(-500.0f, 500.0f));
+		body.force=Vec3(RandFloatRange(-100.0f, 100.0f), RandFloatRange(-100.0f, 100.0f), RandFloatRange(-100.0f, 100.0f));
+		body.angularVelocity=Vec3(RandFloatRange(-3.0f, 3.0f), RandFloatRange(-3.0f, 3.0f), RandFloatRange(-3.0f, 3.0f));
+		body.mass=RandFloatRange(0.5f, 2.0f);
+		body.invMass=1.0f/body.mass;
+		body.inertia=RandFloatRange(1.0f, 4.0f);
+		body.invInertia=1.0f/body.inertia;
+
+		if(i%4)
+		{
+			body.type=RIGIDBODY_SPHERE;
+			body.radius=RandFloatRange(1.0f, 8.0f);
+		}
+
+		PhysicsWorld_AddBody(&world, &body);
+	}
+
+	// Step by step against the reference, starting each step from what the world has so error can't build up
+	float maxError=0.0f;
+
+	for(uint32_t iteration=0;iteration<iterations;iteration++)
+	{
+		for(uint32_t i=0;i<numBodies;i++)
+		{
+			PhysicsWorld_GetBody(&world, i, &bodies[i]);
+			PhysicsIntegrate(&bodies[i], dt);
+		}
+
+		PhysicsWorld_Integrate(&world, NULL, dt);
+
+		for(uint32_t i=0;i<numBodies;i++)
+		{
+			RigidBody_t body;
+			PhysicsWorld_GetBody(&world, i, &body);
+
+			const float simd[]=
+			{
+				body.position.x, body.position.y, body.position.z,
+				body.velocity.x, body.velocity.y, body.velocity.z,
+				body.force.x, body.force.y, body.force.z,
+				body.orientation.x, body.orientation.y, body.orientation.z, body.orientation.w,
+				body.angularVelocity.x, body.angularVelocity.y, body.angularVelocity.z
+			};
+			const float scalar[]=
+			{
+				bodies[i].position.x, bodies[i].position.y, bodies[i].position.z,
+				bodies[i].velocity.x, bodies[i].velocity.y, bodies[i].velocity.z,
+				bodies[i].force.x, bodies[i].force.y, bodies[i].force.z,
+				bodies[i].orientation.x, bodies[i].orientation.y, bodies[i].orientation.z, bodies[i].orientation.w,
+				bodies[i].angularVelocity.x, bodies[i].angularVelocity.y, bodies[i].angularVelocity.z
+			};
+
+			// Relative to the size of the value, positions are in the thousands
+			for(uint32_t j=0;j<sizeof(simd)/sizeof(simd[0]);j++)
+				maxError=fmaxf(maxError, fabsf(simd[j]-scalar[j])/fmaxf(1.0f, fabsf(scalar[j])));
+		}
+	}
+
+	uint64_t start=GetTime();
+
+	for(uint32_t iteration=0;iteration<iterations;iteration++)
+	{
+		for(uint32_t i=0;i<numBodies;i++)
+			PhysicsIntegrate(&bodies[i], dt);
+	}
+
+	const uint64_t scalarTime=GetTime()-start;
+
+	start=GetTime();
+
+	for(uint32_t iteration=0;iteration<iterations;iteration++)
+		PhysicsWorld_Integrate(&world, NULL, dt);
+
+	const uint64_t simdTime=GetTime()-start;
+	const double numTests=(double)numBodies*iterations;
+
+	benchSink+=bodies[0].position.x+world.positionX[0];
+
+	// Same float ops in the same order, anything past rounding noise is a real difference
+	const float tolerance=1e-5f;
+
+	DBGPRINTF(DEBUG_INFO, "\nIntegrate: %u bodies x %u iterations\n", numBodies, iterations);
+	DBGPRINTF(DEBUG_NONE, "%-8s %12s %10s\n", "Test", "Total (ms)", "ns/body");
+	DBGPRINTF(DEBUG_NONE, "%-8s %12.3f %10.3f\n", "Scalar", (double)scalarTime/1e6, (double)scalarTime/numTests);
+	DBGPRINTF(DEBUG_NONE, "%-8s %12.3f %10.3f\n", "SIMD", (double)simdTime/1e6, (double)simdTime/numTests);
+	DBGPRINTF(DEBUG_NONE, "Speedup: %0.2fx, max relative error: %g (tolerance %g)\n", (double)scalarTime/(double)simdTime, maxError, tolerance);
+
+	free(bodies);
+	PhysicsWorld_Destroy(&world);
+
+	return maxError<=tolerance;
+}
+
+//////// Physics step
+
+// Number of bodies that differ between two worlds, in any field or in their sleep state
+static uint32_t CompareWorlds(const PhysicsWorld_t *a, const PhysicsWorld_t *b)
+{
+	if(a->count!=b->count||a->numSleeping!=b->numSleeping)
+		return UINT32_MAX;
+
+	uint32_t mismatches=0;
+
+	for(uint32_t i=0;i<a->count;i++)
+	{
+		RigidBody_t bodyA, bodyB;
+
+		// Cleared first so padding compares equal
+		memset(&bodyA, 0, sizeof(RigidBody_t));
+		memset(&bodyB, 0, sizeof(RigidBody_t));
+		PhysicsWorld_GetBody(a, i, &bodyA);
+		PhysicsWorld_GetBody(b, i, &bodyB);
+
+		if(memcmp(&bodyA, &bodyB, sizeof(RigidBody_t))||a->sleeping[i]!=b->sleeping[i]||a->island[i]!=b->island[i])
+			mismatches++;
+	}
+
+	return mismatches;
+}
+
+static bool BenchStep(const uint32_t numBodies, const uint32_t numSteps, const uint32_t numWorkers)
+{
+	const float dt=1.0f/60.0f;
+	PhysicsWorld_t serial, threaded;
+	ThreadPool_t pool;
+
+	if(!ThreadPool_Init(&pool, numWorkers))
+		return false;
+
+	if(!PhysicsWorld_Init(&serial, numBodies))
+	{
+		ThreadPool_Destroy(&pool);
+		return false;
+	}
+
+	if(!PhysicsWorld_Init(&threaded, numBodies))
+	{
+		PhysicsWorld_Destroy(&serial);
+		ThreadPool_Destroy(&pool);
+		return false;
+	}
+
+	serial.pool=NULL;
+	threaded.pool=&pool;
+
+	// Packed tight enough to keep plenty of contacts going, about 2000 bodies to a 300 unit cube.
+	// Half of them barely moving, so bodies are falling asleep and being woken up through the run too.
+	const float spread=150.0f*cbrtf((float)numBodies/2000.0f);
+
+	for(uint32_t i=0;i<numBodies;i++)
+	{
+		RigidBody_t body;
+		RandomOBB(&body, spread);
+
+		const float speed=(i%2)?40.0f:0.3f;
+
+		body.velocity=Vec3(RandFloatRange(-speed, speed), RandFloatRange(-speed, speed), RandFloatRange(-speed, speed));
+		body.inertia=1.0f;
+		body.invInertia=1.0f;
+
+		if(i%4)
+		{
+			body.type=RIGIDBODY_SPHERE;
+			body.radius=RandFloatRange(3.0f, 6.0f);
+		}
+
+		PhysicsWorld_AddBody(&serial, &body);
+		PhysicsWorld_AddBody(&threaded, &body);
+	}
+
+	uint64_t serialTime=0, threadedTime=0, numContacts=0;
+	uint32_t maxSleeping=0, firstMismatch=UINT32_MAX, mismatches=0;
+
+	for(uint32_t step=0;step<numSteps;step++)
+	{
+		uint64_t start=GetTime();
+		const uint32_t serialContacts=Physics_Step(&serial, dt);
+		serialTime+=GetTime()-start;
+
+		start=GetTime();
+		const uint32_t threadedContacts=Physics_Step(&threaded, dt);
+		threadedTime+=GetTime()-start;
+
+		numContacts+=serialContacts;
+
+		if(serial.numSleeping>maxSleeping)
+			maxSleeping=serial.numSleeping;
+
+		mismatches=CompareWorlds(&serial, &threaded);
+
+		if(mismatches||serialContacts!=threadedContacts)
+		{
+			firstMismatch=step;
+			break;
+		}
+	}
+
+	DBGPRINTF(DEBUG_INFO, "\nPhysics_Step: %u bodies x %u steps, %0.1f contacts per step, up to %u sleeping\n", numBodies, numSteps, (double)numContacts/numSteps, maxSleeping);
+	DBGPRINTF(DEBUG_NONE, "%-8s %12s %10s\n", "Test", "Total (ms)", "ms/step");
+	DBGPRINTF(DEBUG_NONE, "%-8s %12.3f %10.3f\n", "Serial", (double)serialTime/1e6, (double)serialTime/1e6/numSteps);
+	DBGPRINTF(DEBUG_NONE, "%-8s %12.3f %10.3f\n", "Threaded", (double)threadedTime/1e6, (double)threadedTime/1e6/numSteps);
+
+	if(firstMismatch!=UINT32_MAX)
+	{
+		if(mismatches==UINT32_MAX)
+			DBGPRINTF(DEBUG_ERROR, "Worlds diverged at step %u: %u/%u sleeping.\n", firstMismatch, serial.numSleeping, threaded.numSleeping);
+		else
+			DBGPRINTF(DEBUG_ERROR, "Worlds diverged at step %u: %u bodies differ.\n", firstMismatch, mismatches);
+	}
+	else
+		DBGPRINTF(DEBUG_NONE, "Speedup with %u workers: %0.2fx, serial and threaded worlds identical\n", numWorkers, (double)serialTime/(double)threadedTime);
+
+	PhysicsWorld_Destroy(&serial);
+	PhysicsWorld_Destroy(&threaded);
+	ThreadPool_Destroy(&pool);
+
+	return firstMismatch==UINT32_MAX;
+}
+
+//////// Sleeping
+
+#define SLEEP_STACK_HEIGHT 8
+
+// Sleeping flags should always add up to numSleeping
+static bool CheckSleepingCount(const PhysicsWorld_t *world, const char *when)
+{
+	uint32_t count=0;
+
+	for(uint32_t i=0;i<world->count;i++)
+	{
+		if(world->sleeping[i])
+			count++;
+	}
+
+	if(count!=world->numSleeping)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Sleep: %s, %u bodies flagged sleeping but numSleeping is %u.\n", when, count, world->numSleeping);
+		return false;
+	}
+
+	return true;
+}
+
+// Column of spheres resting on each other, each one sunk a little into the one below so they stay in contact
+static void AddStack(PhysicsWorld_t *world, const vec3 base)
+{
+	for(uint32_t i=0;i<SLEEP_STACK_HEIGHT;i++)
+	{
+		RigidBody_t body;
+		memset(&body, 0, sizeof(RigidBody_t));
+
+		body.type=RIGIDBODY_SPHERE;
+		body.position=Vec3(base.x, base.y+(float)i*9.9f, base.z);
+		body.orientation=Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		body.radius=5.0f;
+		body.mass=1.0f;
+		body.invMass=1.0f;
+		body.inertia=1.0f;
+		body.invInertia=1.0f;
+
+		PhysicsWorld_AddBody(world, &body);
+	}
+}
+
+static bool TestSleep(void)
+{
+	const float dt=1.0f/60.0f;
+	PhysicsWorld_t world;
+
+	if(!PhysicsWorld_Init(&world, SLEEP_STACK_HEIGHT*2))
+		return false;
+
+	world.pool=NULL;
+
+	// Two stacks out of reach of each other, bodies 0-7 and 8-15
+	AddStack(&world, Vec3(-200.0f, 0.0f, 0.0f));
+	AddStack(&world, Vec3(200.0f, 0.0f, 0.0f));
+
+	bool result=true;
+	uint32_t step=0;
+
+	for(;step<PHYSICSWORLD_SLEEP_STEPS*4&&world.numSleeping<world.count;step++)
+	{
+		Physics_Step(&world, dt);
+		result&=CheckSleepingCount(&world, "settling");
+	}
+
+	if(world.numSleeping!=world.count)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Sleep: only %u of %u resting bodies asleep after %u steps.\n", world.numSleeping, world.count, step);
+		PhysicsWorld_Destroy(&world);
+		return false;
+	}
+
+	// Each stack should have gone down as one island
+	for(uint32_t i=1;i<SLEEP_STACK_HEIGHT;i++)
+	{
+		if(world.island[i]!=world.island[0]||world.island[SLEEP_STACK_HEIGHT+i]!=world.island[SLEEP_STACK_HEIGHT])
+		{
+			DBGPRINTF(DEBUG_ERROR, "Sleep: a stack fell asleep as more than one island.\n");
+			result=false;
+			break;
+		}
+	}
+
+	if(world.island[0]==world.island[SLEEP_STACK_HEIGHT])
+	{
+		DBGPRINTF(DEBUG_ERROR, "Sleep: two separate stacks share an island.\n");
+		result=false;
+	}
+
+	// Blowing up the middle of the first stack wakes all of it, and none of the second
+	PhysicsWorld_Explode(&world, SLEEP_STACK_HEIGHT/2);
+	result&=CheckSleepingCount(&world, "after explode");
+
+	for(uint32_t i=0;i<SLEEP_STACK_HEIGHT;i++)
+	{
+		if(world.sleeping[i]||!world.sleeping[SLEEP_STACK_HEIGHT+i])
+		{
+			DBGPRINTF(DEBUG_ERROR, "Sleep: explode woke the wrong bodies.\n");
+			result=false;
+			break;
+		}
+	}
+
+	if(world.velocityX[SLEEP_STACK_HEIGHT/2]==0.0f)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Sleep: exploded body didn't get any velocity.\n");
+		result=false;
+	}
+
+	// Pulling the bottom out of the second stack wakes what was resting on it.
+	// Swap remove moves the last body into it's slot, still part of the same stack.
+	PhysicsWorld_RemoveBody(&world, SLEEP_STACK_HEIGHT);
+	result&=CheckSleepingCount(&world, "after remove");
+
+	if(world.numSleeping)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Sleep: %u bodies still asleep after removing the body they rest on.\n", world.numSleeping);
+		result=false;
+	}
+
+	// And keep stepping with bodies going in and out, every step has to keep the count straight
+	for(uint32_t i=0;i<PHYSICSWORLD_SLEEP_STEPS*2;i++)
+	{
+		Physics_Step(&world, dt);
+		result&=CheckSleepingCount(&world, "stepping after remove");
+
+		if(i%16==15&&world.count>1)
+		{
+			PhysicsWorld_RemoveBody(&world, world.count-1);
+			result&=CheckSleepingCount(&world, "removing while stepping");
+		}
+	}
+
+	DBGPRINTF(result?DEBUG_INFO:DEBUG_ERROR, "\nSleep: two stacks of %u asleep after %u steps, explode and remove %s\n", SLEEP_STACK_HEIGHT, step, result?"ok":"failed");
+
+	PhysicsWorld_Destroy(&world);
+
+	return result;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t numPairs=100000;
+	uint32_t numBodies=10000;
+	uint32_t numQueries=1000;
+	uint32_t iterations=10;
+	uint32_t numSteps=300;
+	uint32_t numWorkers=4;
+	uint32_t seed=1234;
+
+	for(int i=1;i<argc;i++)
+	{
+		if(!strcmp(argv[i], "-p")&&i+1<argc)
+			numPairs=(uint32_t)strtoul(argv[++i], NULL, 10);
+		else if(!strcmp(argv[i], "-b")&&i+1<argc)
+			numBodies=(uint32_t)strtoul(argv[++i], NULL, 10);
+		else if(!strcmp(argv[i], "-q")&&i+1<argc)
+			numQueries=(uint32_t)strtoul(argv[++i], NULL, 10);
+		else if(!strcmp(argv[i], "-i")&&i+1<argc)
+			iterations=(uint32_t)strtoul(argv[++i], NULL, 10);
+		else if(!strcmp(argv[i], "-n")&&i+1<argc)
+			numSteps=(uint32_t)strtoul(argv[++i], NULL, 10);
+		else if(!strcmp(argv[i], "-w")&&i+1<argc)
+			numWorkers=(uint32_t)strtoul(argv[++i], NULL, 10);
+		else if(!strcmp(argv[i], "-s")&&i+1<argc)
+			seed=(uint32_t)strtoul(argv[++i], NULL, 10);
+	}
+
+	if(!numPairs||!numBodies||!numQueries||!iterations||!numSteps||!numWorkers)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Usage: %s [-p OBB pairs] [-b bodies] [-q sphere queries] [-i iterations] [-n steps] [-w workers] [-s seed]\n", argv[0]);
+		return 1;
+	}
+
+	zone=Zone_Init(MEMZONE_SIZE);
+
+	if(zone==NULL)
+		return 1;
+
+	RandomSeed(seed);
+
+	DBGPRINTF(DEBUG_INFO, "SIMD lanes: %d, seed: %u\n", PHYSICS_LANES, seed);
+
+	bool result=BenchOBB(numPairs, iterations);
+	result&=BenchQuerySphere(numBodies, numQueries, iterations);
+	result&=BenchIntegrate(numBodies, iterations);
+	result&=BenchStep(numBodies, numSteps, numWorkers);
+	result&=TestSleep();
+
+	Zone_Destroy(zone);
+
+	return result?0:1;
+}
@@ -0,0 +1,653 @@
+// Allocation trace replay benchmark.
+
+// Replays a trace recorded with Zone_TraceStart (or by building with ZONE_TRACE_FILE defined) against an allocator
+//		backend, and reports per-operation latency percentiles, peak footprint and fragmentation over time.
+// Events are replayed on one thread in the order they were recorded, so runs are repeatable.
+//
+// Usage: zonereplay <trace file> [-b backend] [-z zone size in MB] [-s timeline samples]
+// The zone is the same size as the one the trace was recorded from, unless -z is given.
+//
+// Adding a backend is just another entry in the backends table.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "../system/system.h"
+
+MemZone_t *zone=NULL;
+
+typedef struct
+{
+	const char *name;
+	bool (*Init)(size_t size);
+	void (*Destroy)(void);
+	void *(*Malloc)(size_t size, ZoneTag_e tag);
+	void *(*Realloc)(void *ptr, size_t size);
+	void (*Free)(void *ptr);
+
+	// Bytes held by the allocator and fragmentation (0-1), returns false if the backend can't tell
+	bool (*Stats)(size_t *footprint, float *fragmentation);
+	void (*Print)(void);
+} ReplayBackend_t;
+
+// Trace event with the recorded address swapped for a dense slot index
+typedef struct
+{
+	uint32_t op;
+	uint32_t slot;
+	uint32_t size;
+	uint32_t tag;
+} ReplayOp_t;
+
+typedef struct
+{
+	size_t event;
+	size_t liveBytes;
+	size_t footprint;
+	float fragmentation;
+	bool valid;
+} ReplaySample_t;
+
+static uint64_t GetTime(void)
+{
+	struct timespec ts;
+
+#if defined(LINUX)||defined(ANDROID)
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+	timespec_get(&ts, TIME_UTC);
+#endif
+
+	return (uint64_t)ts.tv_sec*1000000000ull+(uint64_t)ts.tv_nsec;
+}
+
+//////// Zone backend
+
+static bool ZoneBackend_Init(size_t size)
+{
+	zone=Zone_Init(size);
+
+	if(zone==NULL)
+		return false;
+
+	Zone_SetVerifyMode(zone, ZONE_VERIFY_OFF, 0, 0);
+
+	return true;
+}
+
+static void ZoneBackend_Destroy(void)
+{
+	Zone_Destroy(zone);
+	zone=NULL;
+}
+
+static void *ZoneBackend_Malloc(size_t size, ZoneTag_e tag)
+{
+	return Zone_MallocTagged(zone, size, tag);
+}
+
+static void *ZoneBackend_Realloc(void *ptr, size_t size)
+{
+	return Zone_Realloc(zone, ptr, size);
+}
+
+static void ZoneBackend_Free(void *ptr)
+{
+	Zone_Free(zone, ptr);
+}
+
+static bool ZoneBackend_Stats(size_t *footprint, float *fragmentation)
+{
+	ZoneStats_t stats;
+
+	if(!Zone_GetStats(zone, &stats))
+		return false;
+
+	// Everything that isn't on a free list, including block headers and thread cached blocks
+	*footprint=zone->size-stats.freeBytes;
+	*fragmentation=stats.fragmentation;
+
+	return true;
+}
+
+static void ZoneBackend_Print(void)
+{
+	Zone_PrintStats(zone);
+}
+
+//////// C runtime backend, as a baseline
+
+static bool LibcBackend_Init(size_t size)
+{
+	return true;
+}
+
+static void LibcBackend_Destroy(void)
+{
+}
+
+static void *LibcBackend_Malloc(size_t size, ZoneTag_e tag)
+{
+	return malloc(size);
+}
+
+static void *LibcBackend_Realloc(void *ptr, size_t size)
+{
+	// Match zone semantics, realloc to 0 frees
+	if(!size)
+	{
+		free(ptr);
+		return NULL;
+	}
+
+	return realloc(ptr, size);
+}
+
+static void LibcBackend_Free(void *ptr)
+{
+	free(ptr);
+}
+
+static bool LibcBackend_Stats(size_t *footprint, float *fragmentation)
+{
+	return false;
+}
+
+static void LibcBackend_Print(void)
+{
+}
+
+static const ReplayBackend_t backends[]=
+{
+	{ "zone", ZoneBackend_Init, ZoneBackend_Destroy, ZoneBackend_Malloc, ZoneBackend_Realloc, ZoneBackend_Free, ZoneBackend_Stats, ZoneBackend_Print },
+	{ "libc", LibcBackend_Init, LibcBackend_Destroy, LibcBackend_Malloc, LibcBackend_Realloc, LibcBackend_Free, LibcBackend_Stats, LibcBackend_Print },
+};
+
+static const uint32_t numBackends=sizeof(backends)/sizeof(backends[0]);
+
+//////// Trace loading
+
+// Recorded address to slot map, open addressing with tombstones.
+// Each address is inserted at most once per event, so sizing for twice the event count means it never fills.
+#define SLOT_EMPTY UINT32_MAX
+#define SLOT_DELETED (UINT32_MAX-1)
+
+typedef struct
+{
+	uint64_t *keys;
+	uint32_t *values;
+	size_t mask;
+} AddressMap_t;
+
+static inline size_t AddressHash(uint64_t key)
+{
+	key^=key>>33;
+	key*=0xFF51AFD7ED558CCDull;
+	key^=key>>33;
+
+	return (size_t)key;
+}
+
+static bool AddressMap_Init(AddressMap_t *map, size_t count)
+{
+	size_t capacity=16;
+
+	while(capacity<count*2)
+		capacity<<=1;
+
+	map->keys=(uint64_t *)malloc(sizeof(uint64_t)*capacity);
+	map->values=(uint32_t *)malloc(sizeof(uint32_t)*capacity);
+	map->mask=capacity-1;
+
+	if(map->keys==NULL||map->values==NULL)
+	{
+		free(map->keys);
+		free(map->values);
+		return false;
+	}
+
+	memset(map->values, 0xFF, sizeof(uint32_t)*capacity);
+
+	return true;
+}
+
+static void AddressMap_Destroy(AddressMap_t *map)
+{
+	free(map->keys);
+	free(map->values);
+}
+
+static void AddressMap_Insert(AddressMap_t *map, uint64_t key, uint32_t value)
+{
+	size_t i=AddressHash(key)&map->mask;
+
+	while(map->values[i]!=SLOT_EMPTY&&map->values[i]!=SLOT_DELETED)
+		i=(i+1)&map->mask;
+
+	map->keys[i]=key;
+	map->values[i]=value;
+}
+
+// Finds and removes an address, returns SLOT_EMPTY if it isn't live
+static uint32_t AddressMap_Remove(AddressMap_t *map, uint64_t key)
+{
+	size_t i=AddressHash(key)&map->mask;
+
+	while(map->values[i]!=SLOT_EMPTY)
+	{
+		if(map->values[i]!=SLOT_DELETED&&map->keys[i]==key)
+		{
+			const uint32_t value=map->values[i];
+
+			map->values[i]=SLOT_DELETED;
+
+			return value;
+		}
+
+		i=(i+1)&map->mask;
+	}
+
+	return SLOT_EMPTY;
+}
+
+// Read a trace and turn it into replay ops, addresses are mapped to slots so the replay doesn't need any lookups
+static ReplayOp_t *LoadTrace(const char *filename, size_t *numOps, uint32_t *numSlots, size_t *zoneSize)
+{
+	FILE *stream=fopen(filename, "rb");
+
+	if(stream==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Unable to open trace file %s.\n", filename);
+		return NULL;
+	}
+
+	ZoneTraceHeader_t header;
+
+	if(fread(&header, sizeof(ZoneTraceHeader_t), 1, stream)!=1||header.magic!=ZONE_TRACE_MAGIC)
+	{
+		DBGPRINTF(DEBUG_ERROR, "%s isn't a zone trace.\n", filename);
+		fclose(stream);
+		return NULL;
+	}
+
+	if(header.version!=ZONE_TRACE_VERSION||header.eventSize!=sizeof(ZoneTraceEvent_t))
+	{
+		DBGPRINTF(DEBUG_ERROR, "%s is an unsupported trace version (%d).\n", filename, header.version);
+		fclose(stream);
+		return NULL;
+	}
+
+	fseek(stream, 0, SEEK_END);
+	const long fileSize=ftell(stream);
+	fseek(stream, sizeof(ZoneTraceHeader_t), SEEK_SET);
+
+	const size_t numEvents=(size_t)(fileSize-(long)sizeof(ZoneTraceHeader_t))/sizeof(ZoneTraceEvent_t);
+	ZoneTraceEvent_t *events=(ZoneTraceEvent_t *)malloc(sizeof(ZoneTraceEvent_t)*(numEvents?numEvents:1));
+	ReplayOp_t *ops=(ReplayOp_t *)malloc(sizeof(ReplayOp_t)*(numEvents?numEvents:1));
+	AddressMap_t map;
+
+	if(events==NULL||ops==NULL||!AddressMap_Init(&map, numEvents))
+	{
+		DBGPRINTF(DEBUG_ERROR, "Unable to allocate memory for %zu events.\n", numEvents);
+		free(events);
+		free(ops);
+		fclose(stream);
+		return NULL;
+	}
+
+	if(fread(events, sizeof(ZoneTraceEvent_t), numEvents, stream)!=numEvents)
+		DBGPRINTF(DEBUG_WARNING, "Trace was truncated.\n");
+
+	fclose(stream);
+
+	size_t count=0, unmatched=0;
+	uint32_t slots=0, threads=0;
+
+	for(size_t i=0;i<numEvents;i++)
+	{
+		const ZoneTraceEvent_t *event=&events[i];
+		ReplayOp_t *op=&ops[count];
+
+		if(event->thread+1u>threads)
+			threads=event->thread+1u;
+
+		op->op=event->op;
+		op->size=event->size;
+		op->tag=event->tag<NUM_ZONE_TAGS?event->tag:TAG_NONE;
+
+		switch(event->op)
+		{
+			case ZONE_TRACE_MALLOC:
+				op->slot=slots++;
+				AddressMap_Insert(&map, event->ptr, op->slot);
+				break;
+
+			case ZONE_TRACE_FREE:
+				op->slot=AddressMap_Remove(&map, event->ptr);
+
+				// Allocated before the trace started
+				if(op->slot==SLOT_EMPTY)
+				{
+					unmatched++;
+					continue;
+				}
+				break;
+
+			case ZONE_TRACE_REALLOC:
+				op->slot=event->oldPtr?AddressMap_Remove(&map, event->oldPtr):SLOT_EMPTY;
+
+				// Reallocating from NULL, or from something allocated before the trace started, starts a new slot
+				if(op->slot==SLOT_EMPTY)
+				{
+					if(event->oldPtr)
+						unmatched++;
+
+					op->slot=slots++;
+				}
+
+				if(event->ptr)
+					AddressMap_Insert(&map, event->ptr, op->slot);
+				break;
+
+			default:
+				unmatched++;
+				continue;
+		}
+
+		count++;
+	}
+
+	DBGPRINTF(DEBUG_INFO, "Trace: %s, %zu events, %d threads, %0.3fs, zone size: %0.3fMB, %zu unmatched\n",
+			  filename, numEvents, threads, numEvents?(double)events[numEvents-1].time/1e9:0.0, (double)header.zoneSize/1000.0/1000.0, unmatched);
+
+	AddressMap_Destroy(&map);
+	free(events);
+
+	*numOps=count;
+	*numSlots=slots;
+	*zoneSize=(size_t)header.zoneSize;
+
+	return ops;
+}
+
+//////// Replay and reporting
+
+static int CompareTime(const void *a, const void *b)
+{
+	const uint32_t x=*(const uint32_t *)a, y=*(const uint32_t *)b;
+
+	return (x>y)-(x<y);
+}
+
+static void PrintLatency(const char *name, uint32_t *times, size_t count)
+{
+	if(!count)
+		return;
+
+	qsort(times, count, sizeof(uint32_t), CompareTime);
+
+	double total=0.0;
+
+	for(size_t i=0;i<count;i++)
+		total+=times[i];
+
+	DBGPRINTF(DEBUG_NONE, "%-8s %10zu %8.1f %8d %8d %8d %8d %8d\n", name, count, total/count,
+			  times[count*50/100], times[count*90/100], times[count*99/100], times[count*999/1000], times[count-1]);
+}
+
+static bool Replay(const ReplayBackend_t *backend, const ReplayOp_t *ops, size_t numOps, uint32_t numSlots, size_t zoneSize, uint32_t numSamples)
+{
+	void **slots=(void **)calloc(numSlots?numSlots:1, sizeof(void *));
+	size_t *slotSizes=(size_t *)calloc(numSlots?numSlots:1, sizeof(size_t));
+	uint32_t *times=(uint32_t *)malloc(sizeof(uint32_t)*(numOps?numOps:1));
+	uint32_t *opTimes=(uint32_t *)malloc(sizeof(uint32_t)*(numOps?numOps:1));
+	ReplaySample_t *samples=(ReplaySample_t *)calloc(numSamples+1, sizeof(ReplaySample_t));
+
+	if(!slots||!slotSizes||!times||!opTimes||!samples)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Unable to allocate replay state.\n");
+		free(slots);
+		free(slotSizes);
+		free(times);
+		free(opTimes);
+		free(samples);
+		return false;
+	}
+
+	if(!backend->Init(zoneSize))
+	{
+		DBGPRINTF(DEBUG_ERROR, "Unable to initialize %s backend.\n", backend->name);
+		free(slots);
+		free(slotSizes);
+		free(times);
+		free(opTimes);
+		free(samples);
+		return false;
+	}
+
+	const size_t sampleInterval=numOps/numSamples?numOps/numSamples:1;
+	uint32_t sampleCount=0;
+	size_t liveBytes=0, peakLiveBytes=0, peakFootprint=0, peakFootprintLive=0, failures=0;
+	uint64_t totalTime=0;
+
+	for(size_t i=0;i<numOps;i++)
+	{
+		const ReplayOp_t *op=&ops[i];
+		void *ptr=slots[op->slot];
+		uint64_t start, end;
+
+		switch(op->op)
+		{
+			case ZONE_TRACE_MALLOC:
+				start=GetTime();
+				ptr=backend->Malloc(op->size, (ZoneTag_e)op->tag);
+				end=GetTime();
+
+				if(ptr==NULL)
+				{
+					failures++;
+					break;
+				}
+
+				slots[op->slot]=ptr;
+				slotSizes[op->slot]=op->size;
+				liveBytes+=op->size;
+				break;
+
+			case ZONE_TRACE_FREE:
+				// Never got allocated, because an earlier op failed
+				if(ptr==NULL)
+				{
+					times[i]=UINT32_MAX;
+					continue;
+				}
+
+				start=GetTime();
+				backend->Free(ptr);
+				end=GetTime();
+
+				slots[op->slot]=NULL;
+				liveBytes-=slotSizes[op->slot];
+				slotSizes[op->slot]=0;
+				break;
+
+			case ZONE_TRACE_REALLOC:
+			default:
+				start=GetTime();
+				ptr=backend->Realloc(ptr, op->size);
+				end=GetTime();
+
+				if(ptr==NULL&&op->size)
+				{
+					failures++;
+					break;
+				}
+
+				slots[op->slot]=ptr;
+				liveBytes+=op->size-slotSizes[op->slot];
+				slotSizes[op->slot]=op->size;
+				break;
+		}
+
+		times[i]=(uint32_t)(end-start>=UINT32_MAX?UINT32_MAX-1:end-start);
+		totalTime+=end-start;
+
+		if(liveBytes>peakLiveBytes)
+			peakLiveBytes=liveBytes;
+
+		// Sample footprint and fragmentation outside of the timed section
+		if((i%sampleInterval==sampleInterval-1||i==numOps-1)&&sampleCount<=numSamples)
+		{
+			ReplaySample_t *sample=&samples[sampleCount++];
+
+			sample->event=i+1;
+			sample->liveBytes=liveBytes;
+			sample->valid=backend->Stats(&sample->footprint, &sample->fragmentation);
+
+			if(sample->valid&&sample->footprint>peakFootprint)
+			{
+				peakFootprint=sample->footprint;
+				peakFootprintLive=liveBytes;
+			}
+		}
+	}
+
+	DBGPRINTF(DEBUG_INFO, "\nBackend: %s, %zu ops in %0.3fms, %zu failed\n", backend->name, numOps, (double)totalTime/1e6, failures);
+	DBGPRINTF(DEBUG_NONE, "%-8s %10s %8s %8s %8s %8s %8s %8s (ns)\n", "Op", "Count", "Mean", "p50", "p90", "p99", "p99.9", "Max");
+
+	static const char *opNames[]={ "malloc", "free", "realloc" };
+
+	for(uint32_t type=ZONE_TRACE_MALLOC;type<=ZONE_TRACE_REALLOC;type++)
+	{
+		size_t count=0;
+
+		for(size_t i=0;i<numOps;i++)
+		{
+			if(ops[i].op==type&&times[i]!=UINT32_MAX)
+				opTimes[count++]=times[i];
+		}
+
+		PrintLatency(opNames[type], opTimes, count);
+	}
+
+	size_t count=0;
+
+	for(size_t i=0;i<numOps;i++)
+	{
+		if(times[i]!=UINT32_MAX)
+			opTimes[count++]=times[i];
+	}
+
+	PrintLatency("all", opTimes, count);
+
+	// Footprint is only known at sample points, overhead is relative to what was live at that sample
+	if(peakFootprint)
+		DBGPRINTF(DEBUG_NONE, "\nPeak live: %0.3fMB, Peak footprint: %0.3fMB (sampled, %0.1f%% over live)\n", (double)peakLiveBytes/1000.0/1000.0,
+				  (double)peakFootprint/1000.0/1000.0, peakFootprintLive?((double)peakFootprint/(double)peakFootprintLive-1.0)*100.0:0.0);
+	else
+		DBGPRINTF(DEBUG_NONE, "\nPeak live: %0.3fMB, Peak footprint: n/a\n", (double)peakLiveBytes/1000.0/1000.0);
+
+	DBGPRINTF(DEBUG_NONE, "\n%12s %12s %14s %8s\n", "Event", "Live MB", "Footprint MB", "Frag");
+
+	for(uint32_t i=0;i<sampleCount;i++)
+	{
+		const ReplaySample_t *sample=&samples[i];
+
+		if(sample->valid)
+			DBGPRINTF(DEBUG_NONE, "%12zu %12.3f %14.3f %7.1f%%\n", sample->event, (double)sample->liveBytes/1000.0/1000.0,
+					  (double)sample->footprint/1000.0/1000.0, sample->fragmentation*100.0f);
+		else
+			DBGPRINTF(DEBUG_NONE, "%12zu %12.3f %14s %8s\n", sample->event, (double)sample->liveBytes/1000.0/1000.0, "n/a", "n/a");
+	}
+
+	backend->Print();
+
+	// Anything the trace never freed
+	for(uint32_t i=0;i<numSlots;i++)
+	{
+		if(slots[i])
+			backend->Free(slots[i]);
+	}
+
+	backend->Destroy();
+
+	free(slots);
+	free(slotSizes);
+	free(times);
+	free(opTimes);
+	free(samples);
+
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	const char *filename=NULL;
+	const char *backendName=NULL;
+	size_t zoneSize=0;
+	uint32_t numSamples=20;
+
+	for(int i=1;i<argc;i++)
+	{
+		if(!strcmp(argv[i], "-b")&&i+1<argc)
+			backendName=argv[++i];
+		else if(!strcmp(argv[i], "-z")&&i+1<argc)
+			zoneSize=(size_t)strtoull(argv[++i], NULL, 10)*1024*1024;
+		else if(!strcmp(argv[i], "-s")&&i+1<argc)
+			numSamples=(uint32_t)strtoul(argv[++i], NULL, 10);
+		else if(argv[i][0]!='-')
+			filename=argv[i];
+	}
+
+	if(filename==NULL||!numSamples)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Usage: %s <trace file> [-b backend] [-z zone size in MB] [-s timeline samples]\n", argv[0]);
+		DBGPRINTF(DEBUG_NONE, "Backends:");
+
+		for(uint32_t i=0;i<numBackends;i++)
+			DBGPRINTF(DEBUG_NONE, " %s", backends[i].name);
+
+		DBGPRINTF(DEBUG_NONE, " (all by default)\n");
+		return 1;
+	}
+
+	size_t numOps=0, traceZoneSize=0;
+	uint32_t numSlots=0;
+	ReplayOp_t *ops=LoadTrace(filename, &numOps, &numSlots, &traceZoneSize);
+
+	if(ops==NULL)
+		return 1;
+
+	// Same size zone as the trace was recorded with, unless overridden
+	if(!zoneSize)
+		zoneSize=traceZoneSize?traceZoneSize:MEMZONE_SIZE;
+
+	bool found=false;
+
+	for(uint32_t i=0;i<numBackends;i++)
+	{
+		if(backendName&&strcmp(backendName, backends[i].name))
+			continue;
+
+		found=true;
+
+		if(!Replay(&backends[i], ops, numOps, numSlots, zoneSize, numSamples))
+		{
+			free(ops);
+			return 1;
+		}
+	}
+
+	free(ops);
+
+	if(!found)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Unknown backend %s.\n", backendName);
+		return 1;
+	}
+
+	return 0;
+}
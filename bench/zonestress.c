@@ -0,0 +1,169 @@
+// Thread cache release stress test.
+
+// Each round an owner thread allocates a batch of small blocks through it's thread cache and hands them to a set of
+//		freer threads, which free them back into the owner's remote free list.
+// Partway through, the owner releases it's cache and exits while the frees are still coming in.
+// Once a round's threads are joined every block has to be back in the zone, a block that ended up on no free list
+//		shows up as a used block with nothing holding it.
+//
+// Usage: zonestress [-r rounds] [-t freer threads] [-n blocks per round]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <threads.h>
+#include <stdatomic.h>
+#include "../system/system.h"
+
+MemZone_t *zone=NULL;
+
+#define STRESS_MAX_FREERS 16
+
+typedef struct
+{
+	MemZone_t *zone;
+	void **blocks;
+	uint32_t numBlocks;
+
+	// Blocks handed out so far, next one for a freer to take, and how many have been freed
+	atomic_uint published;
+	atomic_uint next;
+	atomic_uint freed;
+} StressRound_t;
+
+static int StressOwner(void *arg)
+{
+	StressRound_t *round=(StressRound_t *)arg;
+
+	for(uint32_t i=0;i<round->numBlocks;i++)
+	{
+		// Small enough to go through the thread cache, so every block is tagged with this thread as it's owner
+		round->blocks[i]=Zone_Malloc(round->zone, 16+(i*24)%400);
+		atomic_store_explicit(&round->published, i+1, memory_order_release);
+	}
+
+	// Leave mid-stream, with roughly half the frees still to come
+	while(atomic_load_explicit(&round->freed, memory_order_relaxed)<round->numBlocks/2)
+		thrd_yield();
+
+	Zone_ReleaseThreadCache(round->zone);
+
+	return 0;
+}
+
+static int StressFreer(void *arg)
+{
+	StressRound_t *round=(StressRound_t *)arg;
+
+	while(true)
+	{
+		const uint32_t index=atomic_fetch_add_explicit(&round->next, 1, memory_order_relaxed);
+
+		if(index>=round->numBlocks)
+			break;
+
+		while(atomic_load_explicit(&round->published, memory_order_acquire)<=index)
+			thrd_yield();
+
+		Zone_Free(round->zone, round->blocks[index]);
+		atomic_fetch_add_explicit(&round->freed, 1, memory_order_relaxed);
+	}
+
+	Zone_ReleaseThreadCache(round->zone);
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t numRounds=200;
+	uint32_t numFreers=4;
+	uint32_t numBlocks=4096;
+
+	for(int i=1;i<argc;i++)
+	{
+		if(!strcmp(argv[i], "-r")&&i+1<argc)
+			numRounds=(uint32_t)strtoul(argv[++i], NULL, 10);
+		else if(!strcmp(argv[i], "-t")&&i+1<argc)
+			numFreers=(uint32_t)strtoul(argv[++i], NULL, 10);
+		else if(!strcmp(argv[i], "-n")&&i+1<argc)
+			numBlocks=(uint32_t)strtoul(argv[++i], NULL, 10);
+	}
+
+	if(!numRounds||!numFreers||numFreers>STRESS_MAX_FREERS||!numBlocks)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Usage: %s [-r rounds] [-t freer threads (1-%d)] [-n blocks per round]\n", argv[0], STRESS_MAX_FREERS);
+		return 1;
+	}
+
+	zone=Zone_Init(64*1024*1024);
+
+	if(zone==NULL)
+		return 1;
+
+	void **blocks=(void **)malloc(sizeof(void *)*numBlocks);
+
+	if(blocks==NULL)
+	{
+		Zone_Destroy(zone);
+		return 1;
+	}
+
+	uint32_t leakedRounds=0;
+
+	for(uint32_t i=0;i<numRounds;i++)
+	{
+		StressRound_t round={ .zone=zone, .blocks=blocks, .numBlocks=numBlocks };
+		thrd_t owner, freers[STRESS_MAX_FREERS];
+
+		if(thrd_create(&owner, StressOwner, &round)!=thrd_success)
+		{
+			DBGPRINTF(DEBUG_ERROR, "Unable to create owner thread.\n");
+			return 1;
+		}
+
+		for(uint32_t j=0;j<numFreers;j++)
+		{
+			if(thrd_create(&freers[j], StressFreer, &round)!=thrd_success)
+			{
+				DBGPRINTF(DEBUG_ERROR, "Unable to create freer thread.\n");
+				return 1;
+			}
+		}
+
+		thrd_join(owner, NULL);
+
+		for(uint32_t j=0;j<numFreers;j++)
+			thrd_join(freers[j], NULL);
+
+		// Checked every round, the next owner to claim the same cache slot would otherwise pick up a stranded block and hide it
+		ZoneStats_t stats;
+		Zone_GetStats(zone, &stats);
+
+		if(stats.usedBlocks||stats.cachedBlocks||stats.usedBytes)
+		{
+			DBGPRINTF(DEBUG_ERROR, "Round %u: %zu used blocks (%zu bytes), %zu cached blocks left after every thread exited.\n", i, stats.usedBlocks, stats.usedBytes, stats.cachedBlocks);
+			leakedRounds++;
+		}
+	}
+
+	free(blocks);
+
+	ZoneStats_t stats;
+	Zone_GetStats(zone, &stats);
+
+	const bool heapIntact=Zone_VerifyHeap(zone);
+	const bool failed=leakedRounds||!heapIntact;
+
+	// Should be a single free block
+	Zone_Print(zone);
+
+	DBGPRINTF(failed?DEBUG_ERROR:DEBUG_INFO, "%u rounds of %u blocks, %u freers: %zu remote frees, %u rounds leaked blocks, heap %s\n",
+			  numRounds, numBlocks, numFreers, stats.remoteFrees, leakedRounds, heapIntact?"intact":"corrupt");
+
+	Zone_Destroy(zone);
+
+	return failed?1:0;
+}
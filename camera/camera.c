@@ -402,7 +402,7 @@ int32_t CameraLoadPath(char *filename, CameraPath_t *path)
 		return 0;
 	}
 
-	path->position=(float *)Zone_Malloc(zone, sizeof(float)*path->numPoints*3);
+	path->position=(float *)Zone_MallocTagged(zone, sizeof(float)*path->numPoints*3, TAG_CAMERA);
 
 	if(path->position==NULL)
 	{
@@ -410,7 +410,7 @@ int32_t CameraLoadPath(char *filename, CameraPath_t *path)
 		return 0;
 	}
 
-	path->view=(float *)Zone_Malloc(zone, sizeof(float)*path->numPoints*3);
+	path->view=(float *)Zone_MallocTagged(zone, sizeof(float)*path->numPoints*3, TAG_CAMERA);
 
 	if(path->view==NULL)
 	{
@@ -437,7 +437,7 @@ int32_t CameraLoadPath(char *filename, CameraPath_t *path)
 	path->time=0.0f;
 	path->endTime=(float)(path->numPoints-2);
 
-	path->knots=(int32_t *)Zone_Malloc(zone, sizeof(int32_t)*path->numPoints*3);
+	path->knots=(int32_t *)Zone_MallocTagged(zone, sizeof(int32_t)*path->numPoints*3, TAG_CAMERA);
 
 	if(path->knots==NULL)
 	{
@@ -10,14 +10,24 @@ void ConsoleInit(Console_t *console)
 {
     memset(console, 0, sizeof(Console_t));
 
+    HashMap_Init(&console->commandMap, HASHMAP_KEY_STRING, HASHMAP_STORAGE_ZONE, sizeof(uint32_t), CONSOLE_MAX_COMMANDS);
+    HashMap_Init(&console->variableMap, HASHMAP_KEY_STRING, HASHMAP_STORAGE_ZONE, sizeof(uint32_t), CONSOLE_MAX_VARIABLES);
+
     ConsoleRegisterCommand(console, "clear", ConsoleClear);
     ConsoleRegisterCommand(console, "echo", ConsolePrint);
     ConsoleRegisterCommand(console, "listcommands", ConsolePrintCommands);
     ConsoleRegisterCommand(console, "listvariables", ConsolePrintVariables);
+    ConsoleRegisterCommand(console, "zonestats", ConsolePrintZoneStats);
 
     ConsoleRegisterVariable(console, "testvar", 123.0f);
 }
 
+void ConsoleDestroy(Console_t *console)
+{
+    HashMap_Destroy(&console->commandMap);
+    HashMap_Destroy(&console->variableMap);
+}
+
 void ConsolePrint(Console_t *console, const char *text)
 {
     if(console->numLine>=CONSOLE_MAX_LINES)
@@ -52,6 +62,33 @@ void ConsolePrintVariables(Console_t *console, const char *param)
         ConsolePrint(console, console->variables[i].name);
 }
 
+void ConsolePrintZoneStats(Console_t *console, const char *param)
+{
+    (void)param; // Unused
+
+    char line[CONSOLE_LINE_LENGTH];
+    ZoneStats_t stats;
+
+    if(!Zone_GetStats(zone, &stats))
+        return;
+
+    snprintf(line, CONSOLE_LINE_LENGTH, "Zone used: %0.3fMB, free: %0.3fMB, largest free: %0.3fMB, fragmentation: %0.1f%%",
+             (float)stats.usedBytes/1000.0f/1000.0f, (float)stats.freeBytes/1000.0f/1000.0f, (float)stats.largestFree/1000.0f/1000.0f, stats.fragmentation*100.0f);
+    ConsolePrint(console, line);
+
+    for(uint32_t i=0;i<NUM_ZONE_TAGS;i++)
+    {
+        ZoneTagStats_t tagStats;
+
+        if(!Zone_GetTagStats(zone, (ZoneTag_e)i, &tagStats)||!tagStats.totalAllocs)
+            continue;
+
+        snprintf(line, CONSOLE_LINE_LENGTH, "  %s: live %0.3fKB, peak %0.3fKB, allocs/frame %d",
+                 Zone_GetTagName((ZoneTag_e)i), (float)tagStats.liveBytes/1000.0f, (float)tagStats.peakBytes/1000.0f, tagStats.lastFrameAllocs);
+        ConsolePrint(console, line);
+    }
+}
+
 void ConsoleClear(Console_t *console, const char *param)
 {
     (void)param; // Unused
@@ -62,54 +99,93 @@ void ConsoleClear(Console_t *console, const char *param)
 
 void ConsoleRegisterCommand(Console_t *console, const char *name, ConsoleCommandFunc func)
 {
-    if(console->numCommand>=CONSOLE_MAX_COMMANDS)
+    ConsoleCommand_t *command=NULL;
+    uint32_t *index=(uint32_t *)HashMap_Get(&console->commandMap, name);
+
+    // Registering an existing name replaces it
+    if(index)
+        command=&console->commands[*index];
+    else
     {
-        printf("Command list full!\n");
-        return;
+        if(console->numCommand>=CONSOLE_MAX_COMMANDS)
+        {
+            printf("Command list full!\n");
+            return;
+        }
+
+        command=&console->commands[console->numCommand];
+        strncpy(command->name, name, CONSOLE_MAX_NAME-1);
+
+        if(!HashMap_Insert(&console->commandMap, command->name, &console->numCommand))
+            return;
+
+        console->numCommand++;
     }
 
-    strncpy(console->commands[console->numCommand].name, name, CONSOLE_MAX_NAME-1);
-    console->commands[console->numCommand].func=func;
-    console->numCommand++;
+    command->func=func;
 }
 
 void ConsoleRegisterVariable(Console_t *console, const char *name, float value)
 {
-    if(console->numVariable>=CONSOLE_MAX_VARIABLES)
+    ConsoleVariable_t *variable=NULL;
+    uint32_t *index=(uint32_t *)HashMap_Get(&console->variableMap, name);
+
+    if(index)
+        variable=&console->variables[*index];
+    else
     {
-        printf("Variable list full!\n");
-        return;
+        if(console->numVariable>=CONSOLE_MAX_VARIABLES)
+        {
+            printf("Variable list full!\n");
+            return;
+        }
+
+        variable=&console->variables[console->numVariable];
+        strncpy(variable->name, name, CONSOLE_MAX_NAME-1);
+
+        if(!HashMap_Insert(&console->variableMap, variable->name, &console->numVariable))
+            return;
+
+        console->numVariable++;
     }
 
-    strncpy(console->variables[console->numVariable].name, name, CONSOLE_MAX_NAME-1);
-    console->variables[console->numVariable].value=value;
-    console->numVariable++;
+    variable->value=value;
+}
+
+static ConsoleVariable_t *ConsoleFindVariable(Console_t *console, uint32_t hash, const char *name)
+{
+    uint32_t *index=(uint32_t *)HashMap_GetHashed(&console->variableMap, hash, name);
+
+    if(index==NULL)
+        return NULL;
+
+    return &console->variables[*index];
 }
 
 void ConsoleSetVariable(Console_t *console, const char *name, float value)
 {
-    for(uint32_t i=0; i<console->numVariable; i++)
+    ConsoleVariable_t *variable=ConsoleFindVariable(console, HashMap_HashString(name), name);
+
+    if(variable==NULL)
     {
-        if(strncmp(console->variables[i].name, name, CONSOLE_MAX_NAME)==0)
-        {
-            console->variables[i].value=value;
-            return;
-        }
+        ConsolePrint(console, "Variable not found!");
+        return;
     }
 
-    ConsolePrint(console, "Variable not found!");
+    variable->value=value;
 }
 
 float ConsoleGetVariable(Console_t *console, const char *name)
 {
-    for(uint32_t i=0; i<console->numVariable; i++)
+    ConsoleVariable_t *variable=ConsoleFindVariable(console, HashMap_HashString(name), name);
+
+    if(variable==NULL)
     {
-        if(strncmp(console->variables[i].name, name, CONSOLE_MAX_NAME)==0)
-            return console->variables[i].value;
+        ConsolePrint(console, "Variable not found!");
+        return 0.0f;
     }
 
-    ConsolePrint(console, "Variable not found!");
-    return 0.0f;
+    return variable->value;
 }
 
 void ConsoleScroll(Console_t *console, const bool up)
@@ -147,39 +223,34 @@ void ConsoleExecuteCommand(Console_t *console, const char *input)
     else
         strncpy(name, input, CONSOLE_MAX_NAME-1);
 
-    // Search variable list first
-    for(uint32_t i=0; i<console->numVariable; i++)
+    // Same name is looked up in both maps, so only hash it once
+    const uint32_t hash=HashMap_HashString(name);
+
+    // Search variables first
+    ConsoleVariable_t *variable=ConsoleFindVariable(console, hash, name);
+
+    if(variable)
     {
-        if(strncmp(name, console->variables[i].name, CONSOLE_MAX_NAME)==0)
+        // If there's a value, set the variable, if no value, just print the variable's value
+        if(args)
+            variable->value=(float)atof(args);
+        else
         {
-            // If there's a value, set the variable, if no value, just print the variable's value
-            if(args)
-            {
-                float value=atof(args);
-                ConsoleSetVariable(console, name, value);
-            }
-            else
-            {
-                char value[CONSOLE_MAX_NAME]={ 0 };
-                snprintf(value, CONSOLE_MAX_NAME, "%f", console->variables[i].value);
-                ConsolePrint(console, value);
-            }
-
-            return;
+            char value[CONSOLE_MAX_NAME]={ 0 };
+            snprintf(value, CONSOLE_MAX_NAME, "%f", variable->value);
+            ConsolePrint(console, value);
         }
+
+        return;
     }
 
-    // Then search command list
-    for(uint32_t i=0;i<console->numCommand;i++)
+    // Then search commands
+    uint32_t *index=(uint32_t *)HashMap_GetHashed(&console->commandMap, hash, name);
+
+    if(index&&console->commands[*index].func)
     {
-        if(strncmp(name, console->commands[i].name, CONSOLE_MAX_NAME)==0)
-        {
-            if(console->commands[i].func)
-            {
-                console->commands[i].func(console, args?args:"");
-                return;
-            }
-        }
+        console->commands[*index].func(console, args?args:"");
+        return;
     }
 
     ConsolePrint(console, "Unknown command/variable.");
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "../utils/hashmap.h"
 
 #define CONSOLE_MAX_NAME 32
 #define CONSOLE_MAX_COMMANDS 64
@@ -42,6 +43,9 @@ typedef struct Console_s
     uint32_t numVariable;
     ConsoleVariable_t variables[CONSOLE_MAX_VARIABLES];
 
+    // Name to index into commands/variables, the arrays keep registration order for listing and autocomplete
+    HashMap_t commandMap, variableMap;
+
     uint32_t numHistory, historyIndex;
     char history[CONSOLE_MAX_HISTORY][CONSOLE_LINE_LENGTH];
 
@@ -55,6 +59,7 @@ typedef struct Console_s
 } Console_t;
 
 void ConsoleInit(Console_t *console);
+void ConsoleDestroy(Console_t *console);
 void ConsoleClear(Console_t *console, const char *param);
 void ConsoleRegisterCommand(Console_t *console, const char *name, ConsoleCommandFunc func);
 void ConsoleRegisterVariable(Console_t *console, const char *name, float value);
@@ -63,6 +68,7 @@ float ConsoleGetVariable(Console_t *console, const char *name);
 void ConsolePrint(Console_t *console, const char *text);
 void ConsolePrintCommands(Console_t *console, const char *param);
 void ConsolePrintVariables(Console_t *console, const char *param);
+void ConsolePrintZoneStats(Console_t *console, const char *param);
 void ConsoleScroll(Console_t *console, const bool up);
 void ConsoleExecuteCommand(Console_t *console, const char *input);
 void ConsoleHistory(Console_t *console, const bool up);
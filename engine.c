@@ -5,6 +5,9 @@
 #include <stdalign.h>
 #include <string.h>
 #include "system/system.h"
+#include "system/framearena.h"
+#include "system/threads.h"
+#include "system/simclock.h"
 #include "network/network.h"
 #include "vulkan/vulkan.h"
 #include "math/math.h"
@@ -50,6 +53,12 @@ UI_t UI;
 
 PerFrame_t perFrame[FRAMES_IN_FLIGHT];
 
+// Work stealing job pool, one worker per CPU
+ThreadPool_t threadPool;
+
+// Fixed rate clock everything simulated steps on
+SimClock_t simClock;
+
 uint32_t cursorID=UINT32_MAX;
 
 uint32_t sliderID=UINT32_MAX;
@@ -82,12 +91,17 @@ vec3 Bezier(float t, vec3 p0, vec3 p1, vec3 p2, vec3 p3)
 	return Vec3_Addv(Vec3_Addv(Vec3_Addv(Vec3_Muls(a, t*t*t), Vec3_Muls(b, t*t)), Vec3_Muls(c, t)), p0);
 }
 
-void FireRunStep(uint32_t index)
+// Fire colors and threshold, read from the UI once per step instead of per pixel
+typedef struct
 {
-	for(uint32_t i=0;i<FIRE_WIDTH*4;i++)
-		buffer1[Random()%(FIRE_WIDTH*4)]=Random()%255;
+	vec3 color[4];
+	float threshold;
+	bool colorMap;
+} FireParams_t;
 
-	for(uint32_t y=2;y<FIRE_HEIGHT-1;y++)
+static void FireDiffuseRows(uint32_t start, uint32_t end, void *userdata)
+{
+	for(uint32_t y=start;y<end;y++)
 	{
 		for(uint32_t x=1;x<FIRE_WIDTH-1;x++)
 		{
@@ -99,25 +113,24 @@ void FireRunStep(uint32_t index)
 				)/4;
 		}
 	}
+}
 
-	vec3 Color1=Vec3(UI_GetBarGraphValue(&UI, color1ID[0]), UI_GetBarGraphValue(&UI, color1ID[1]), UI_GetBarGraphValue(&UI, color1ID[2]));
-	vec3 Color2=Vec3(UI_GetBarGraphValue(&UI, color2ID[0]), UI_GetBarGraphValue(&UI, color2ID[1]), UI_GetBarGraphValue(&UI, color2ID[2]));
-	vec3 Color3=Vec3(UI_GetBarGraphValue(&UI, color3ID[0]), UI_GetBarGraphValue(&UI, color3ID[1]), UI_GetBarGraphValue(&UI, color3ID[2]));
-	vec3 Color4=Vec3(UI_GetBarGraphValue(&UI, color4ID[0]), UI_GetBarGraphValue(&UI, color4ID[1]), UI_GetBarGraphValue(&UI, color4ID[2]));
-
+static void FireColorRows(uint32_t start, uint32_t end, void *userdata)
+{
+	const FireParams_t *params=(const FireParams_t *)userdata;
 	uint8_t *fb=(uint8_t *)fireStagingBuffer.memory->mappedPointer;
 
-	for(uint32_t y=0;y<FIRE_HEIGHT;y++)
+	for(uint32_t y=start;y<end;y++)
 	{
 		int flipy=FIRE_HEIGHT-1-y;
 
 		for(uint32_t x=0;x<FIRE_WIDTH;x++)
 		{
-			float Fire=clampf(((float)buffer2[flipy*FIRE_WIDTH+x]/255.0f)-UI_GetBarGraphValue(&UI, sliderID), 0.0f, 1.0f);
+			float Fire=clampf(((float)buffer2[flipy*FIRE_WIDTH+x]/255.0f)-params->threshold, 0.0f, 1.0f);
 			vec3 Color;
 
-			if(UI_GetCheckBoxValue(&UI, colorMapID))
-				Color=Bezier(clampf(Fire, 0.0f, 1.0f), Color1, Color2, Color3, Color4);
+			if(params->colorMap)
+				Color=Bezier(clampf(Fire, 0.0f, 1.0f), params->color[0], params->color[1], params->color[2], params->color[3]);
 			else
 				Color=Vec3b(Fire);
 
@@ -127,9 +140,44 @@ void FireRunStep(uint32_t index)
 			fb[4*(y*FIRE_WIDTH+x)+3]=0xFF;
 		}
 	}
+}
+
+// Runs the fire simulation for a number of clock ticks and fills the staging buffer, rows are split across the thread pool
+void FireUpdate(uint32_t steps)
+{
+	if(!steps)
+		return;
+
+	for(uint32_t step=0;step<steps;step++)
+	{
+		for(uint32_t i=0;i<FIRE_WIDTH*4;i++)
+			buffer1[Random()%(FIRE_WIDTH*4)]=Random()%255;
 
-	memcpy(buffer1, buffer2, FIRE_WIDTH*FIRE_HEIGHT);
+		Thread_ParallelFor(2, FIRE_HEIGHT-1, 16, FireDiffuseRows, NULL);
 
+		memcpy(buffer1, buffer2, FIRE_WIDTH*FIRE_HEIGHT);
+	}
+
+	// Only the last step is seen, so only color that one
+	FireParams_t params=
+	{
+		.color=
+		{
+			Vec3(UI_GetBarGraphValue(&UI, color1ID[0]), UI_GetBarGraphValue(&UI, color1ID[1]), UI_GetBarGraphValue(&UI, color1ID[2])),
+			Vec3(UI_GetBarGraphValue(&UI, color2ID[0]), UI_GetBarGraphValue(&UI, color2ID[1]), UI_GetBarGraphValue(&UI, color2ID[2])),
+			Vec3(UI_GetBarGraphValue(&UI, color3ID[0]), UI_GetBarGraphValue(&UI, color3ID[1]), UI_GetBarGraphValue(&UI, color3ID[2])),
+			Vec3(UI_GetBarGraphValue(&UI, color4ID[0]), UI_GetBarGraphValue(&UI, color4ID[1]), UI_GetBarGraphValue(&UI, color4ID[2])),
+		},
+		.threshold=UI_GetBarGraphValue(&UI, sliderID),
+		.colorMap=UI_GetCheckBoxValue(&UI, colorMapID),
+	};
+
+	Thread_ParallelFor(0, FIRE_HEIGHT, 16, FireColorRows, &params);
+}
+
+// Records the staging buffer copy into the fire texture
+void FireUpload(uint32_t index)
+{
 	vkuTransitionLayout(perFrame[index].commandBuffer, fireImage.image, 1, 0, 1, 0, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 	vkCmdCopyBufferToImage(perFrame[index].commandBuffer, fireStagingBuffer.buffer, fireImage.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, (VkBufferImageCopy[1])
 	{
@@ -140,6 +188,96 @@ void FireRunStep(uint32_t index)
 	vkuTransitionLayout(perFrame[index].commandBuffer, fireImage.image, 1, 0, 1, 0, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 }
 
+// Frame render task graph, built once in Init.
+// Fire update, UI instance build and font build don't share any data, so they run in parallel,
+//		command recording waits on all three.
+ThreadTaskGraph_t renderGraph;
+
+// What the render tasks need to know about the current frame
+static struct
+{
+	uint32_t index, imageIndex;
+	uint32_t simSteps;
+} renderFrame;
+
+static void RenderTask_Fire(void *arg)
+{
+	FireUpdate(renderFrame.simSteps);
+}
+
+static void RenderTask_UI(void *arg)
+{
+	UI_BuildInstances(&UI, fTimeStep);
+}
+
+static void RenderTask_Font(void *arg)
+{
+	Font_Print(&font, 32.0f, 0.0f, 0.0f, "FPS: %0.1f\n\x1B[91mFrame time: %0.5fms", fps, fTimeStep*1000.0f);
+}
+
+// May run on any thread, the graph makes sure nothing else is using the command buffer
+static void RenderTask_Record(void *arg)
+{
+	const uint32_t index=renderFrame.index;
+
+	// Start recording the commands
+	vkBeginCommandBuffer(perFrame[index].commandBuffer, &(VkCommandBufferBeginInfo)
+	{
+		.sType=VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.flags=VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+	});
+
+	if(renderFrame.simSteps)
+		FireUpload(index);
+
+	// Start a render pass and clear the frame/depth buffer
+	vkCmdBeginRenderPass(perFrame[index].commandBuffer, &(VkRenderPassBeginInfo)
+	{
+		.sType=VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+		.renderPass=renderPass,
+		.framebuffer=perFrame[renderFrame.imageIndex].frameBuffer,
+		.renderArea=(VkRect2D){ { 0, 0 }, { config.renderWidth, config.renderHeight } },
+		.clearValueCount=2,
+		.pClearValues=(VkClearValue[]){ {{{ 0.0f, 0.0f, 0.0f, 1.0f }}}, {{{ 0.0f, 0 }}} },
+	}, VK_SUBPASS_CONTENTS_INLINE);
+
+	vkCmdSetViewport(perFrame[index].commandBuffer, 0, 1, &(VkViewport) { 0.0f, 0, (float)config.renderWidth, (float)config.renderHeight, 0.0f, 1.0f });
+	vkCmdSetScissor(perFrame[index].commandBuffer, 0, 1, &(VkRect2D) { { 0, 0 }, { config.renderWidth, config.renderHeight } });
+
+	UI_Draw(&UI, index, 0);
+
+	Font_Draw(&font, index, 0);
+	
+	// Reset the font text collection for the next frame
+	Font_Reset(&font);
+
+	vkCmdEndRenderPass(perFrame[index].commandBuffer);
+
+	vkEndCommandBuffer(perFrame[index].commandBuffer);
+}
+
+bool CreateRenderGraph(void)
+{
+	if(!ThreadGraph_Init(&renderGraph, &threadPool))
+		return false;
+
+	ThreadTask_t *stages[3]=
+	{
+		ThreadGraph_AddTask(&renderGraph, RenderTask_Fire, NULL, 0, NULL),
+		ThreadGraph_AddTask(&renderGraph, RenderTask_UI, NULL, 0, NULL),
+		ThreadGraph_AddTask(&renderGraph, RenderTask_Font, NULL, 0, NULL),
+	};
+
+	if(ThreadGraph_AddTask(&renderGraph, RenderTask_Record, NULL, 3, stages)==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "CreateRenderGraph: Unable to build render task graph.\n");
+		ThreadGraph_Destroy(&renderGraph);
+		return false;
+	}
+
+	return true;
+}
+
 void RecreateSwapchain(void);
 
 // Create functions for creating render data for asteroids
@@ -241,13 +379,18 @@ bool CreateFramebuffers(uint32_t targetWidth, uint32_t targetHeight)
 // Render call from system main event loop
 void Render(void)
 {
-	static float fireTime=0.0f;
-	const float OneOver60=1.0f/60.0f;
 	static uint32_t index=0;
 	uint32_t imageIndex;
 
 	vkWaitForFences(vkContext.device, 1, &perFrame[index].frameFence, VK_TRUE, UINT64_MAX);
 
+	// Frame fence signaled, so anything allocated from the frame arenas the last time this frame was used can be released
+	FrameArena_BeginFrame(index);
+
+	// Check a slice of the memory zone each frame (only does anything in incremental verify mode)
+	Zone_VerifyStep(zone);
+	Zone_NextFrame(zone);
+
 	UI_UpdateSpritePosition(&UI, faceID, Vec2(sinf(fTime*4.0f)*50.0f+(config.renderWidth/2), cosf(fTime*4.0f)*50.0f+(config.renderHeight/2)));
 
 	VkResult result=vkAcquireNextImageKHR(vkContext.device, swapchain.swapchain, UINT64_MAX, perFrame[index].completeSemaphore, VK_NULL_HANDLE, &imageIndex);
@@ -264,46 +407,14 @@ void Render(void)
 	vkResetDescriptorPool(vkContext.device, perFrame[index].descriptorPool, 0);
 	vkResetCommandPool(vkContext.device, perFrame[index].commandPool, 0);
 
-	// Start recording the commands
-	vkBeginCommandBuffer(perFrame[index].commandBuffer, &(VkCommandBufferBeginInfo)
-	{
-		.sType=VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-		.flags=VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
-	});
-
-	// Run the fire at 60FPS
-	fireTime+=fTimeStep;
-	if(fireTime>=OneOver60)
-	{
-		fireTime=0.0;
-		FireRunStep(index);
-	}
-
-	// Start a render pass and clear the frame/depth buffer
-	vkCmdBeginRenderPass(perFrame[index].commandBuffer, &(VkRenderPassBeginInfo)
-	{
-		.sType=VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-		.renderPass=renderPass,
-		.framebuffer=perFrame[imageIndex].frameBuffer,
-		.renderArea=(VkRect2D){ { 0, 0 }, { config.renderWidth, config.renderHeight } },
-		.clearValueCount=2,
-		.pClearValues=(VkClearValue[]){ {{{ 0.0f, 0.0f, 0.0f, 1.0f }}}, {{{ 0.0f, 0 }}} },
-	}, VK_SUBPASS_CONTENTS_INLINE);
-
-	vkCmdSetViewport(perFrame[index].commandBuffer, 0, 1, &(VkViewport) { 0.0f, 0, (float)config.renderWidth, (float)config.renderHeight, 0.0f, 1.0f });
-	vkCmdSetScissor(perFrame[index].commandBuffer, 0, 1, &(VkRect2D) { { 0, 0 }, { config.renderWidth, config.renderHeight } });
+	// Simulation runs on fixed ticks, however many fit in the last frame's time
+	renderFrame.simSteps=SimClock_Advance(&simClock, fTimeStep);
 
-	UI_Draw(&UI, index, 0, fTimeStep);
+	renderFrame.index=index;
+	renderFrame.imageIndex=imageIndex;
 
-	Font_Print(&font, 32.0f, 0.0f, 0.0f, "FPS: %0.1f\n\x1B[91mFrame time: %0.5fms", fps, fTimeStep*1000.0f);
-	Font_Draw(&font, index, 0);
-	
-	// Reset the font text collection for the next frame
-	Font_Reset(&font);
-
-	vkCmdEndRenderPass(perFrame[index].commandBuffer);
-
-	vkEndCommandBuffer(perFrame[index].commandBuffer);
+	// Build and record the frame
+	ThreadGraph_Run(&renderGraph);
 
 	// Submit command queue
 	vkQueueSubmit(vkContext.graphicsQueue, 1, &(VkSubmitInfo)
@@ -354,6 +465,15 @@ bool Init(void)
 {
 	RandomSeed(123);
 
+	if(!FrameArena_Init(FRAMES_IN_FLIGHT, FRAMEARENA_SIZE))
+		return false;
+
+	if(!ThreadPool_Init(&threadPool, 0))
+		return false;
+
+	if(!SimClock_Init(&simClock, SIMCLOCK_DEFAULT_RATE, SIMCLOCK_DEFAULT_MAX_STEPS))
+		return false;
+
 	vkuMemAllocator_Init(&vkContext);
 
 	if(!Audio_Init())
@@ -478,6 +598,9 @@ bool Init(void)
 	// Cursor has to be last, otherwise layer order will obstruct it
 	cursorID=UI_AddCursor(&UI, Vec2(0.0f, 0.0f), 16.0, Vec3(1.0f, 1.0f, 1.0f), false);
 
+	if(!CreateRenderGraph())
+		return false;
+
 	if(!Zone_VerifyHeap(zone))
 		exit(-1);
 
@@ -528,6 +651,11 @@ void Destroy(void)
 {
 	vkDeviceWaitIdle(vkContext.device);
 
+	ThreadGraph_Destroy(&renderGraph);
+
+	ThreadPool_Print(&threadPool);
+	ThreadPool_Destroy(&threadPool);
+
 	Audio_Destroy();
 
 	Zone_Free(zone, explode.data);
@@ -568,4 +696,8 @@ void Destroy(void)
 	DBGPRINTF(DEBUG_INFO, "Remaining Vulkan memory blocks:\n");
 	vkuMemAllocator_Print();
 	vkuMemAllocator_Destroy();
+
+	Zone_PrintStats(zone);
+	FrameArena_Print();
+	FrameArena_Destroy();
 }
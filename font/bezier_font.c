@@ -151,7 +151,9 @@ void Font_Print(VkCommandBuffer CommandBuffer, uint32_t Eye, float x, float y, c
 			return;
 
 		// Initalize a list for building a list of control points to feed to the Bezier shader
+		// It's cleared every call but keeps its buffer, so reserve enough up front for a screen of text
 		List_Init(&FontVectors, sizeof(vec4)*2, 4, NULL);
+		List_Reserve(&FontVectors, 4096);
 
 		vkuCreateHostBuffer(&Context, &FontBuffer, 4096*sizeof(vec4)*2*100, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
 
@@ -202,11 +204,22 @@ void Font_Print(VkCommandBuffer CommandBuffer, uint32_t Eye, float x, float y, c
 			ptr+=4;
 		}
 
-		// Push the current character gylph path with offset and color on to the list
+		// Push the current character gylph path with offset and color on to the list, written in place
 		for(uint32_t i=0;i<Gylphs[(uint32_t)*ptr].numPath;i++)
 		{
-			float vert[]={ Gylphs[(uint32_t)*ptr].Path[2*i+0]+x, Gylphs[(uint32_t)*ptr].Path[2*i+1]+y, -1.0f, 1.0f, r, g, b, 1.0f};
-			List_Add(&FontVectors, vert);
+			float *vert=(float *)List_Emplace(&FontVectors);
+
+			if(vert==NULL)
+				break;
+
+			vert[0]=Gylphs[(uint32_t)*ptr].Path[2*i+0]+x;
+			vert[1]=Gylphs[(uint32_t)*ptr].Path[2*i+1]+y;
+			vert[2]=-1.0f;
+			vert[3]=1.0f;
+			vert[4]=r;
+			vert[5]=g;
+			vert[6]=b;
+			vert[7]=1.0f;
 		}
 
 		// Advance one character
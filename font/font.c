@@ -14,6 +14,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "../system/system.h"
+#include "../system/framearena.h"
 #include "../vulkan/vulkan.h"
 #include "../math/math.h"
 #include "../font/font.h"
@@ -205,7 +206,7 @@ float Font_StringBaseWidth(const char *string)
 void Font_Print(Font_t *font, float size, float x, float y, const char *string, ...)
 {
 	// Pointer and buffer for formatted text
-	char *ptr, text[256];
+	char *ptr, *text;
 	// Variable arguments list
 	va_list	ap;
 	// Save starting x position
@@ -217,9 +218,23 @@ void Font_Print(Font_t *font, float size, float x, float y, const char *string,
 	if(string==NULL)
 		return;
 
+	// Get formatted string length, including variable arguments
+	va_start(ap, string);
+	int length=vsnprintf(NULL, 0, string, ap);
+	va_end(ap);
+
+	if(length<=0)
+		return;
+
+	// Text only needs to live until the instance data is built, so it comes from the frame arena
+	text=(char *)FrameArena_Malloc((size_t)length+1);
+
+	if(text==NULL)
+		return;
+
 	// Format string, including variable arguments
 	va_start(ap, string);
-	vsprintf(text, string, ap);
+	vsnprintf(text, (size_t)length+1, string, ap);
 	va_end(ap);
 
 	// Add in how many characters were need to deal with
@@ -286,6 +301,9 @@ void Font_Print(Font_t *font, float size, float x, float y, const char *string,
 		*font->instance++=Vec4(x-((Font_CharacterBaseWidth(*ptr)*0.5f)*size), y, (float)(*ptr), size);	// Instance position, character to render, size
 		*font->instance++=Vec4(r, g, b, charWidth);															// Instance color
 	}
+
+	// Done with the text, give the space back
+	FrameArena_Free(text);
 	// ---
 }
 
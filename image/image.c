@@ -13,6 +13,7 @@
 #include <stdbool.h>
 #include <string.h>
 #include "../system/system.h"
+#include "../system/framearena.h"
 #include "../vulkan/vulkan.h"
 #include "../math/math.h"
 #include "image.h"
@@ -43,7 +44,7 @@ static bool _MakeNormalMap(VkuImage_t *image)
 		return false;
 
 	// Allocate memory for output data.
-	uint16_t *buffer=(uint16_t *)Zone_Malloc(zone, sizeof(uint16_t)*image->width*image->height*4);
+	uint16_t *buffer=(uint16_t *)Zone_MallocTagged(zone, sizeof(uint16_t)*image->width*image->height*4, TAG_IMAGE);
 
 	// Check that memory allocated.
 	if(buffer==NULL)
@@ -111,7 +112,7 @@ static bool _Normalize(VkuImage_t *image)
 	if(image->depth!=32)
 		return false;
 
-	uint16_t *buffer=(uint16_t *)Zone_Malloc(zone, sizeof(uint16_t)*image->width*image->height*4);
+	uint16_t *buffer=(uint16_t *)Zone_MallocTagged(zone, sizeof(uint16_t)*image->width*image->height*4, TAG_IMAGE);
 
 	if(buffer==NULL)
 		return false;
@@ -155,7 +156,7 @@ static bool _Normalize(VkuImage_t *image)
 //   32bit float/channel RGB image, mainly used for HDR images.
 static bool _RGBE2Float(VkuImage_t *image)
 {
-	float *buffer=(float *)Zone_Malloc(zone, sizeof(float)*image->width*image->height*4);
+	float *buffer=(float *)Zone_MallocTagged(zone, sizeof(float)*image->width*image->height*4, TAG_IMAGE);
 
 	if(buffer==NULL)
 		return false;
@@ -222,7 +223,7 @@ static bool _Resize(VkuImage_t *src, VkuImage_t *dst)
 	if(dst->depth!=src->depth)
 		return false;
 
-	dst->data=(uint8_t *)Zone_Malloc(zone, (size_t)dst->width*dst->height*(dst->depth>>3));
+	dst->data=(uint8_t *)Zone_MallocTagged(zone, (size_t)dst->width*dst->height*(dst->depth>>3), TAG_IMAGE);
 
 	if(dst->data==NULL)
 		return false;
@@ -375,7 +376,7 @@ static bool _HalfImage(VkuImage_t *src, VkuImage_t *dst)
 	dst->width=src->width>>1;
 	dst->height=src->height>>1;
 	dst->depth=src->depth;
-	dst->data=(uint8_t *)Zone_Malloc(zone, (size_t)dst->width*dst->height*(dst->depth>>3));
+	dst->data=(uint8_t *)Zone_MallocTagged(zone, (size_t)dst->width*dst->height*(dst->depth>>3), TAG_IMAGE);
 
 	if(dst->data==NULL)
 		return false;
@@ -640,8 +641,8 @@ static vec3 _GetXYZFace(vec2 uv, int face)
 // Gets a selected 2D cubemap face from an angular lightmap probe image
 static bool _AngularMapFace(VkuImage_t *in, int face, VkuImage_t *out)
 {
-	// Allocate memory for output
-	out->data=(uint8_t *)Zone_Malloc(zone, (size_t)out->width*out->height*(out->depth>>3));
+	// Allocate memory for output, this is only temporary, so it comes from the frame arena
+	out->data=(uint8_t *)FrameArena_Malloc((size_t)out->width*out->height*(out->depth>>3));
 
 	if(out->data==NULL)
 		return false;
@@ -683,7 +684,7 @@ static void _RGBtoRGBA(VkuImage_t *image)
 {
 	if(image->depth==96)
 	{
-		float *dst=(float *)Zone_Malloc(zone, sizeof(float)*image->width*image->height*4);
+		float *dst=(float *)Zone_MallocTagged(zone, sizeof(float)*image->width*image->height*4, TAG_IMAGE);
 
 		if(dst==NULL)
 			return;
@@ -705,7 +706,7 @@ static void _RGBtoRGBA(VkuImage_t *image)
 	}
 	else if(image->depth==48)
 	{
-		uint16_t *dst=(uint16_t *)Zone_Malloc(zone, sizeof(uint16_t)*image->width*image->height*4);
+		uint16_t *dst=(uint16_t *)Zone_MallocTagged(zone, sizeof(uint16_t)*image->width*image->height*4, TAG_IMAGE);
 
 		if(dst==NULL)
 			return;
@@ -727,7 +728,7 @@ static void _RGBtoRGBA(VkuImage_t *image)
 	}
 	else if(image->depth==24)
 	{
-		uint8_t *dst=(uint8_t *)Zone_Malloc(zone, sizeof(uint8_t)*image->width*image->height*4);
+		uint8_t *dst=(uint8_t *)Zone_MallocTagged(zone, sizeof(uint8_t)*image->width*image->height*4, TAG_IMAGE);
 
 		if(dst==NULL)
 			return;
@@ -922,7 +923,7 @@ VkBool32 Image_Upload(VkuContext_t *context, VkuImage_t *image, const char *file
 			memcpy((uint8_t *)data+((size_t)size*i), Out.data, size);
 
 			// Free the output data for the next face
-			Zone_Free(zone, Out.data);
+			FrameArena_Free(Out.data);
 		}
 
 		// All faces are copied, free the original image data
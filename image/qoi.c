@@ -67,7 +67,7 @@ bool QOI_Load(const char *filename, VkuImage_t *image)
 	image->width=width;
 	image->height=height;
 	image->depth=channels<<3;
-	image->data=(uint8_t *)Zone_Malloc(zone, width*height*channels);
+	image->data=(uint8_t *)Zone_MallocTagged(zone, width*height*channels, TAG_IMAGE);
 
 	if(!image->data)
 		return false;
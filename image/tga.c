@@ -215,7 +215,7 @@ bool TGA_Load(const char *filename, VkuImage_t *image)
 		case 8:
 			bpp=depth>>3;
 
-			image->data=(uint8_t *)Zone_Malloc(zone, width*height*bpp);
+			image->data=(uint8_t *)Zone_MallocTagged(zone, width*height*bpp, TAG_IMAGE);
 
 			if(image->data==NULL)
 				return false;
@@ -241,7 +241,7 @@ bool TGA_Load(const char *filename, VkuImage_t *image)
 	if(!(imageDescriptor&0x20))
 	{
 		int32_t scanline=width*bpp, size=scanline*height;
-		uint8_t *buffer=(uint8_t *)Zone_Malloc(zone, size);
+		uint8_t *buffer=(uint8_t *)Zone_MallocTagged(zone, size, TAG_IMAGE);
 
 		if(buffer==NULL)
 		{
@@ -40,117 +40,111 @@ uint32_t Lights_Add(Lights_t *Lights, vec3 Position, float Radius, vec4 Kd)
 	Light.SpotInnerCone=0.0f;
 	Light.SpotExponent=0.0f;
 
-	List_Add(&Lights->Lights, (void *)&Light);
+	uint32_t Index=(uint32_t)List_GetCount(&Lights->Lights);
+
+	// Light goes in the list first, so the map never holds an index past the end of it
+	if(!List_Add(&Lights->Lights, (void *)&Light))
+		return UINT32_MAX;
+
+	if(!HashMap_InsertInteger(&Lights->LightMap, ID, &Index))
+	{
+		List_Del(&Lights->Lights, Index);
+		return UINT32_MAX;
+	}
 
 	return ID;
 }
 
+static Light_t *Lights_Find(Lights_t *Lights, uint32_t ID)
+{
+	if(Lights==NULL||ID==UINT32_MAX)
+		return NULL;
+
+	uint32_t *Index=(uint32_t *)HashMap_GetInteger(&Lights->LightMap, ID);
+
+	if(Index==NULL)
+		return NULL;
+
+	return (Light_t *)List_GetPointer(&Lights->Lights, *Index);
+}
+
 void Lights_Del(Lights_t *Lights, uint32_t ID)
 {
-	if(Lights==NULL&&ID!=UINT32_MAX)
+	if(Lights==NULL||ID==UINT32_MAX)
+		return;
+
+	uint32_t *Index=(uint32_t *)HashMap_GetInteger(&Lights->LightMap, ID);
+
+	if(Index==NULL)
 		return;
 
-	for(uint32_t i=0;i<List_GetCount(&Lights->Lights);i++)
+	uint32_t Removed=*Index;
+
+	HashMap_RemoveInteger(&Lights->LightMap, ID);
+	List_Del(&Lights->Lights, Removed);
+
+	// Lights after the removed one moved down a slot
+	for(uint32_t i=Removed;i<List_GetCount(&Lights->Lights);i++)
 	{
-		Light_t *Light=List_GetPointer(&Lights->Lights, i);
+		Light_t *Light=(Light_t *)List_GetPointer(&Lights->Lights, i);
 
-		if(Light->ID==ID)
-		{
-			List_Del(&Lights->Lights, i);
-			break;
-		}
+		HashMap_InsertInteger(&Lights->LightMap, Light->ID, &i);
 	}
 }
 
 void Lights_Update(Lights_t *Lights, uint32_t ID, vec3 Position, float Radius, vec4 Kd)
 {
-	if(Lights==NULL&&ID!=UINT32_MAX)
-		return;
+	Light_t *Light=Lights_Find(Lights, ID);
 
-	for(uint32_t i=0;i<List_GetCount(&Lights->Lights);i++)
-	{
-		Light_t *Light=List_GetPointer(&Lights->Lights, i);
-
-		if(Light->ID==ID)
-		{
-			Vec3_Setv(Light->Position, Position);
-			Light->Radius=1.0f/Radius;
-			Vec4_Setv(Light->Kd, Kd);
+	if(Light==NULL)
+		return;
 
-			return;
-		}
-	}
+	Vec3_Setv(Light->Position, Position);
+	Light->Radius=1.0f/Radius;
+	Vec4_Setv(Light->Kd, Kd);
 }
 
 void Lights_UpdatePosition(Lights_t *Lights, uint32_t ID, vec3 Position)
 {
-	if(Lights==NULL&&ID!=UINT32_MAX)
-		return;
+	Light_t *Light=Lights_Find(Lights, ID);
 
-	for(uint32_t i=0;i<List_GetCount(&Lights->Lights);i++)
-	{
-		Light_t *Light=List_GetPointer(&Lights->Lights, i);
+	if(Light==NULL)
+		return;
 
-		if(Light->ID==ID)
-		{
-			Vec3_Setv(Light->Position, Position);
-			return;
-		}
-	}
+	Vec3_Setv(Light->Position, Position);
 }
 
 void Lights_UpdateRadius(Lights_t *Lights, uint32_t ID, float Radius)
 {
-	if(Lights==NULL&&ID!=UINT32_MAX)
-		return;
+	Light_t *Light=Lights_Find(Lights, ID);
 
-	for(uint32_t i=0;i<List_GetCount(&Lights->Lights);i++)
-	{
-		Light_t *Light=List_GetPointer(&Lights->Lights, i);
+	if(Light==NULL)
+		return;
 
-		if(Light->ID==ID)
-		{
-			Light->Radius=1.0f/Radius;
-			return;
-		}
-	}
+	Light->Radius=1.0f/Radius;
 }
 
 void Lights_UpdateKd(Lights_t *Lights, uint32_t ID, vec4 Kd)
 {
-	if(Lights==NULL&&ID!=UINT32_MAX)
-		return;
+	Light_t *Light=Lights_Find(Lights, ID);
 
-	for(uint32_t i=0;i<List_GetCount(&Lights->Lights);i++)
-	{
-		Light_t *Light=List_GetPointer(&Lights->Lights, i);
+	if(Light==NULL)
+		return;
 
-		if(Light->ID==ID)
-		{
-			Vec4_Setv(Light->Kd, Kd);
-			return;
-		}
-	}
+	Vec4_Setv(Light->Kd, Kd);
 }
 
 void Lights_UpdateSpotlight(Lights_t *Lights, uint32_t ID, vec3 Direction, float OuterCone, float InnerCone, float Exponent)
 {
-	if(Lights==NULL&&ID!=UINT32_MAX)
-		return;
+	Light_t *Light=Lights_Find(Lights, ID);
 
-	for(uint32_t i=0;i<List_GetCount(&Lights->Lights);i++)
-	{
-		Light_t *Light=List_GetPointer(&Lights->Lights, i);
+	if(Light==NULL)
+		return;
 
-		if(Light->ID==ID)
-		{
-			Vec3_Setv(Light->SpotDirection, Direction);
-			Light->SpotOuterCone=OuterCone;
-			Light->SpotInnerCone=InnerCone;
-			Light->SpotExponent=Exponent;
-			return;
-		}
-	}
+	Vec3_Setv(Light->SpotDirection, Direction);
+	Light->SpotOuterCone=OuterCone;
+	Light->SpotInnerCone=InnerCone;
+	Light->SpotExponent=Exponent;
 }
 
 void Lights_UpdateSSBO(Lights_t *Lights)
@@ -203,6 +197,9 @@ bool Lights_Init(Lights_t *Lights)
 {
 	List_Init(&Lights->Lights, sizeof(Light_t), 10, NULL);
 
+	if(!HashMap_Init(&Lights->LightMap, HASHMAP_KEY_INTEGER, HASHMAP_STORAGE_ZONE, sizeof(uint32_t), 10))
+		return false;
+
 	Lights->StorageBuffer.Buffer=VK_NULL_HANDLE;
 	Lights->StorageBuffer.DeviceMemory=VK_NULL_HANDLE;
 
@@ -218,4 +215,5 @@ void Lights_Destroy(Lights_t *Lights)
 	vkFreeMemory(Context.Device, Lights->StorageBuffer.DeviceMemory, VK_NULL_HANDLE);
 
 	List_Destroy(&Lights->Lights);
+	HashMap_Destroy(&Lights->LightMap);
 }
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include "../math/math.h"
 #include "../utils/list.h"
+#include "../utils/hashmap.h"
 #include "../vulkan/vulkan.h"
 
 typedef struct
@@ -26,6 +27,10 @@ typedef struct
 typedef struct
 {
 	List_t Lights;
+
+	// Light ID to index in the Lights list
+	HashMap_t LightMap;
+
 	VkuBuffer_t StorageBuffer;
 } Lights_t;
 
@@ -26,21 +26,21 @@ static void CalculateTangent(BModel_t *model)
 		vec2 uv0, uv1;
 		float r;
 
-		model->tangent=(float *)Zone_Malloc(zone, sizeof(float)*3*model->numVertex);
+		model->tangent=(float *)Zone_MallocTagged(zone, sizeof(float)*3*model->numVertex, TAG_MODEL);
 
 		if(model->tangent==NULL)
 			return;
 
 		memset(model->tangent, 0, sizeof(float)*3*model->numVertex);
 
-		model->binormal=(float *)Zone_Malloc(zone, sizeof(float)*3*model->numVertex);
+		model->binormal=(float *)Zone_MallocTagged(zone, sizeof(float)*3*model->numVertex, TAG_MODEL);
 
 		if(model->binormal==NULL)
 			return;
 
 		memset(model->binormal, 0, sizeof(float)*3*model->numVertex);
 
-		model->normal=(float *)Zone_Malloc(zone, sizeof(float)*3*model->numVertex);
+		model->normal=(float *)Zone_MallocTagged(zone, sizeof(float)*3*model->numVertex, TAG_MODEL);
 
 		if(model->normal==NULL)
 			return;
@@ -208,7 +208,7 @@ bool LoadBModel(BModel_t *model, const char *filename)
 	// If there materials, allocate memory for them
 	if(model->numMaterial)
 	{
-		model->material=(BModel_Material_t *)Zone_Malloc(zone, sizeof(BModel_Material_t)*model->numMaterial);
+		model->material=(BModel_Material_t *)Zone_MallocTagged(zone, sizeof(BModel_Material_t)*model->numMaterial, TAG_MODEL);
 
 		if(model->material==NULL)
 			return false;
@@ -241,7 +241,7 @@ bool LoadBModel(BModel_t *model, const char *filename)
 	// If there meshes, allocate memory for them
 	if(model->numMesh)
 	{
-		model->mesh=(BModel_Mesh_t *)Zone_Malloc(zone, sizeof(BModel_Mesh_t)*model->numMesh);
+		model->mesh=(BModel_Mesh_t *)Zone_MallocTagged(zone, sizeof(BModel_Mesh_t)*model->numMesh, TAG_MODEL);
 
 		if(model->mesh==NULL)
 			return false;
@@ -263,7 +263,7 @@ bool LoadBModel(BModel_t *model, const char *filename)
 
 		if(model->mesh[i].numFace)
 		{
-			model->mesh[i].face=(uint32_t *)Zone_Malloc(zone, sizeof(uint32_t)*model->mesh[i].numFace*3);
+			model->mesh[i].face=(uint32_t *)Zone_MallocTagged(zone, sizeof(uint32_t)*model->mesh[i].numFace*3, TAG_MODEL);
 
 			if(model->mesh[i].face==NULL)
 				return false;
@@ -290,7 +290,7 @@ bool LoadBModel(BModel_t *model, const char *filename)
 			switch(magic)
 			{
 				case VERT_MAGIC:
-					model->vertex=(float *)Zone_Malloc(zone, sizeof(float)*model->numVertex*3);
+					model->vertex=(float *)Zone_MallocTagged(zone, sizeof(float)*model->numVertex*3, TAG_MODEL);
 
 					if(model->vertex==NULL)
 						return false;
@@ -303,7 +303,7 @@ bool LoadBModel(BModel_t *model, const char *filename)
 					break;
 
 				case TEXC_MAGIC:
-					model->UV=(float *)Zone_Malloc(zone, sizeof(float)*model->numVertex*2);
+					model->UV=(float *)Zone_MallocTagged(zone, sizeof(float)*model->numVertex*2, TAG_MODEL);
 
 					if(model->UV==NULL)
 						return false;
@@ -316,7 +316,7 @@ bool LoadBModel(BModel_t *model, const char *filename)
 					break;
 
 				case TANG_MAGIC:
-					model->tangent=(float *)Zone_Malloc(zone, sizeof(float)*model->numVertex*3);
+					model->tangent=(float *)Zone_MallocTagged(zone, sizeof(float)*model->numVertex*3, TAG_MODEL);
 
 					if(model->tangent==NULL)
 						return false;
@@ -329,7 +329,7 @@ bool LoadBModel(BModel_t *model, const char *filename)
 					break;
 
 				case BNRM_MAGIC:
-					model->binormal=(float *)Zone_Malloc(zone, sizeof(float)*model->numVertex*3);
+					model->binormal=(float *)Zone_MallocTagged(zone, sizeof(float)*model->numVertex*3, TAG_MODEL);
 
 					if(model->binormal==NULL)
 						return false;
@@ -342,7 +342,7 @@ bool LoadBModel(BModel_t *model, const char *filename)
 					break;
 
 				case NORM_MAGIC:
-					model->normal=(float *)Zone_Malloc(zone, sizeof(float)*model->numVertex*3);
+					model->normal=(float *)Zone_MallocTagged(zone, sizeof(float)*model->numVertex*3, TAG_MODEL);
 
 					if(model->normal==NULL)
 						return false;
@@ -130,9 +130,10 @@ void ParticleSystem_DeleteEmitter(ParticleSystem_t *system, uint32_t ID)
 	{
 		ParticleEmitter_t *emitter=(ParticleEmitter_t *)List_GetPointer(&system->emitters, i);
 
+		// Emitter order doesn't matter, so swap the last one in rather than shifting the list
 		if(emitter->ID==ID)
 		{
-			List_Del(&system->emitters, i);
+			List_SwapRemove(&system->emitters, i);
 			break;
 		}
 	}
@@ -235,7 +236,7 @@ bool ParticleSystem_Init(ParticleSystem_t *system)
 	system->numParticles=0;
 	system->maxParticles=100000;
 
-	system->particles=(Particle_t *)Zone_Malloc(zone, sizeof(Particle_t)*system->maxParticles);
+	system->particles=(Particle_t *)Zone_MallocTagged(zone, sizeof(Particle_t)*system->maxParticles, TAG_PHYSICS);
 
 	if(system->particles==NULL)
 	{
@@ -255,7 +256,7 @@ bool ParticleSystem_Init(ParticleSystem_t *system)
 		}
 	}
 
-	system->systemBuffer=(vec4 *)Zone_Malloc(zone, sizeof(vec4)*2*system->maxParticles);
+	system->systemBuffer=(vec4 *)Zone_MallocTagged(zone, sizeof(vec4)*2*system->maxParticles, TAG_PHYSICS);
 
 	if(system->systemBuffer==NULL)
 	{
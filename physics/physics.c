@@ -3,13 +3,15 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <float.h>
+#include <stdalign.h>
 #include "physics.h"
+#include "physicssimd.h"
 
 static void ApplyConstraints(RigidBody_t *body)
 {
 	vec3 center={ 0.0f, 0.0f, 0.0f };
-	const float maxRadius=2000.0f;
-	const float maxVelocity=500.0f;
+	const float maxRadius=PHYSICS_BOUNDARY_RADIUS;
+	const float maxVelocity=PHYSICS_MAX_VELOCITY;
 
 	// Clamp velocity, this reduces the chance of the simulation going unstable
 	body->velocity=Vec3_Clamp(body->velocity, -maxVelocity, maxVelocity);
@@ -27,11 +29,11 @@ static void ApplyConstraints(RigidBody_t *body)
 	}
 
 	// Apply linear velocity damping
-	const float linearDamping=0.999f;
+	const float linearDamping=PHYSICS_LINEAR_DAMPING;
 	body->velocity=Vec3_Muls(body->velocity, linearDamping);
 
 	// Apply angular velocity damping
-	const float angularDamping=0.998f;
+	const float angularDamping=PHYSICS_ANGULAR_DAMPING;
 	body->angularVelocity=Vec3_Muls(body->angularVelocity, angularDamping);
 }
 
@@ -182,7 +184,7 @@ static float ResolveCollision(RigidBody_t *a, RigidBody_t *b, const vec3 contact
 	return sqrtf(-relativeSpeed);
 }
 
-static float SphereToSphereCollision(RigidBody_t *a, RigidBody_t *b)
+static bool SphereToSphereContact(const RigidBody_t *a, const RigidBody_t *b, PhysicsContact_t *contact)
 {
 	const vec3 relativePosition=Vec3_Subv(b->position, a->position);
 	const float distanceSq=Vec3_LengthSq(relativePosition);
@@ -191,23 +193,24 @@ static float SphereToSphereCollision(RigidBody_t *a, RigidBody_t *b)
 	if(distanceSq<FLT_EPSILON||distanceSq>radiiSum*radiiSum)
 	{
 		// No collision
-		return 0.0f;
+		return false;
 	}
 
 	// Penetration
 	const float distance=sqrtf(distanceSq);
-	const float penetration=fabsf(distance-radiiSum)*0.5f;
+	contact->penetration=fabsf(distance-radiiSum)*0.5f;
 
 	// Normal
-	const vec3 normal=Vec3_Muls(relativePosition, 1.0f/distance);
+	contact->normal=Vec3_Muls(relativePosition, 1.0f/distance);
 
 	// Contact point
-	const vec3 contact=Vec3_Addv(a->position, Vec3_Muls(normal, a->radius-penetration));
+	contact->position=Vec3_Addv(a->position, Vec3_Muls(contact->normal, a->radius-contact->penetration));
 
-	return ResolveCollision(a, b, contact, normal, penetration);
+	return true;
 }
 
-static float SphereToOBBCollision(RigidBody_t *sphere, RigidBody_t *obb)
+// Contact is for resolving as (obb, sphere)
+static bool SphereToOBBContact(const RigidBody_t *sphere, const RigidBody_t *obb, PhysicsContact_t *contact)
 {
 	vec3 axes[3];
 	QuatAxes(obb->orientation, axes);
@@ -224,23 +227,41 @@ static float SphereToOBBCollision(RigidBody_t *sphere, RigidBody_t *obb)
 	if(distanceSq<FLT_EPSILON||distanceSq>sphere->radius*sphere->radius)
 	{
 		// No collision
-		return 0.0f;
+		return false;
 	}
 
 	// Penetration
 	const float distance=sqrtf(distanceSq);
-	const float penetration=sphere->radius-distance;
+	contact->penetration=sphere->radius-distance;
 
 	// Normal
-	const vec3 normal=Vec3_Muls(relativePosition, 1.0f/distance);
+	contact->normal=Vec3_Muls(relativePosition, 1.0f/distance);
 
 	// Contact point
-	const vec3 contact=Vec3_Subv(closestPoint, Vec3_Muls(normal, penetration*0.5f));
+	contact->position=Vec3_Subv(closestPoint, Vec3_Muls(contact->normal, contact->penetration*0.5f));
+
+	return true;
+}
+
+// Turns the minimum penetration axis into a contact for resolving as (a, b)
+static void OBBToOBBFillContact(const RigidBody_t *a, const RigidBody_t *b, const vec3 relativePosition, vec3 normal, const float penetration, PhysicsContact_t *contact)
+{
+	// Ensure the collision normal points from A to B
+	if(Vec3_Dot(normal, relativePosition)<0.0f)
+		normal=Vec3_Muls(normal, -1.0f);
 
-	return ResolveCollision(obb, sphere, contact, normal, penetration);
+	// Point of contact (TODO: some of this feels redundant)
+	const vec3 pointA=Vec3_Addv(a->position, Vec3_Mulv(normal, a->size));
+	const vec3 pointB=Vec3_Subv(b->position, Vec3_Mulv(normal, b->size));
+
+	contact->position=Vec3_Muls(Vec3_Addv(pointA, pointB), 0.5f);
+	contact->normal=normal;
+	contact->penetration=penetration;
 }
 
-static float OBBToOBBCollision(RigidBody_t *a, RigidBody_t *b)
+// Reference separating axis test, one axis at a time.
+// PhysicsOBBToOBBContact gives the same result, this is kept to check and benchmark it against.
+bool PhysicsOBBToOBBContactScalar(const RigidBody_t *a, const RigidBody_t *b, PhysicsContact_t *contact)
 {
 	// Extract axes
 	vec3 axesA[3], axesB[3];
@@ -287,7 +308,7 @@ static float OBBToOBBCollision(RigidBody_t *a, RigidBody_t *b)
 		if(overlap<0.0f)
 		{
 			// Separating axis found, no collision
-			return 0.0f;
+			return false;
 		}
 		else if(overlap<penetration)
 		{
@@ -298,31 +319,158 @@ static float OBBToOBBCollision(RigidBody_t *a, RigidBody_t *b)
 	}
 
 	// No separating axis found
+	OBBToOBBFillContact(a, b, relativePosition, normal, penetration, contact);
 
-	// Ensure the collision normal points from A to B
-	if(Vec3_Dot(normal, relativePosition)<0.0f)
-		normal=Vec3_Muls(normal, -1.0f);
+	return true;
+}
 
-	// Point of contact (TODO: some of this feels redundant)
-	const vec3 pointA=Vec3_Addv(a->position, Vec3_Mulv(normal, a->size));
-	const vec3 pointB=Vec3_Subv(b->position, Vec3_Mulv(normal, b->size));
-	const vec3 contact=Vec3_Muls(Vec3_Addv(pointA, pointB), 0.5f);
+// 3 face axes from each box, 9 edge cross products, and padding out to whole SIMD vectors
+#define OBB_AXIS_SLOTS 16
+
+_Static_assert(OBB_AXIS_SLOTS%PHYSICS_LANES==0, "OBB axis slots must be a whole number of SIMD vectors");
 
-	return ResolveCollision(a, b, contact, normal, penetration);
+// Edge cross product slots, these get normalized and dropped if the edges are parallel
+static const alignas(32) float edgeAxisSlots[OBB_AXIS_SLOTS]={ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f };
+
+static inline Lane_t Lane_Dot3(const vec3 v, const Lane_t x, const Lane_t y, const Lane_t z)
+{
+	return Lane_Add(Lane_Add(Lane_Mul(Lane_Set(v.x), x), Lane_Mul(Lane_Set(v.y), y)), Lane_Mul(Lane_Set(v.z), z));
 }
 
-float PhysicsCollisionResponse(RigidBody_t *a, RigidBody_t *b)
+// Same separating axis test as PhysicsOBBToOBBContactScalar, with the 15 axes laid out as a structure of arrays
+// and normalized and projected PHYSICS_LANES axes at a time.
+// Parallel edges are masked off rather than skipped, and the first vector holding a separating axis ends the test.
+bool PhysicsOBBToOBBContact(const RigidBody_t *a, const RigidBody_t *b, PhysicsContact_t *contact)
+{
+	vec3 axesA[3], axesB[3];
+	QuatAxes(a->orientation, axesA);
+	QuatAxes(b->orientation, axesB);
+
+	const vec3 relativePosition=Vec3_Subv(b->position, a->position);
+
+	alignas(32) float axisX[OBB_AXIS_SLOTS], axisY[OBB_AXIS_SLOTS], axisZ[OBB_AXIS_SLOTS];
+	alignas(32) float overlaps[OBB_AXIS_SLOTS];
+
+	for(uint32_t i=0;i<3;i++)
+	{
+		axisX[i]=axesA[i].x;	axisY[i]=axesA[i].y;	axisZ[i]=axesA[i].z;
+		axisX[3+i]=axesB[i].x;	axisY[3+i]=axesB[i].y;	axisZ[3+i]=axesB[i].z;
+
+		for(uint32_t j=0;j<3;j++)
+		{
+			const vec3 axis=Vec3_Cross(axesA[i], axesB[j]);
+			axisX[6+i*3+j]=axis.x;	axisY[6+i*3+j]=axis.y;	axisZ[6+i*3+j]=axis.z;
+		}
+	}
+
+	// Zero length padding fails the length test below, so it's never separating or picked
+	axisX[15]=0.0f;	axisY[15]=0.0f;	axisZ[15]=0.0f;
+
+	const Lane_t zero=Lane_Set(0.0f);
+	const Lane_t one=Lane_Set(1.0f);
+	const Lane_t epsilon=Lane_Set(FLT_EPSILON);
+	const Lane_t noOverlap=Lane_Set(FLT_MAX);
+
+	for(uint32_t i=0;i<OBB_AXIS_SLOTS;i+=PHYSICS_LANES)
+	{
+		Lane_t x=Lane_Load(&axisX[i]);
+		Lane_t y=Lane_Load(&axisY[i]);
+		Lane_t z=Lane_Load(&axisZ[i]);
+
+		const Lane_t length=Lane_Sqrt(Lane_Add(Lane_Add(Lane_Mul(x, x), Lane_Mul(y, y)), Lane_Mul(z, z)));
+		const LaneMask_t valid=Lane_Greater(length, epsilon);
+
+		// Face axes are already unit length and left as they are
+		const LaneMask_t edge=Lane_Greater(Lane_Load(&edgeAxisSlots[i]), zero);
+		const Lane_t invLength=Lane_Select(Lane_And(edge, valid), Lane_Div(one, length), one);
+
+		x=Lane_Mul(x, invLength);
+		y=Lane_Mul(y, invLength);
+		z=Lane_Mul(z, invLength);
+
+		// Project OBBs onto the axes
+		const Lane_t rA=Lane_Add(Lane_Add(
+			Lane_Mul(Lane_Abs(Lane_Dot3(axesA[0], x, y, z)), Lane_Set(a->size.x)),
+			Lane_Mul(Lane_Abs(Lane_Dot3(axesA[1], x, y, z)), Lane_Set(a->size.y))),
+			Lane_Mul(Lane_Abs(Lane_Dot3(axesA[2], x, y, z)), Lane_Set(a->size.z)));
+		const Lane_t rB=Lane_Add(Lane_Add(
+			Lane_Mul(Lane_Abs(Lane_Dot3(axesB[0], x, y, z)), Lane_Set(b->size.x)),
+			Lane_Mul(Lane_Abs(Lane_Dot3(axesB[1], x, y, z)), Lane_Set(b->size.y))),
+			Lane_Mul(Lane_Abs(Lane_Dot3(axesB[2], x, y, z)), Lane_Set(b->size.z)));
+		const Lane_t distance=Lane_Abs(Lane_Dot3(relativePosition, x, y, z));
+
+		const Lane_t overlap=Lane_Sub(Lane_Add(rA, rB), distance);
+
+		// Separating axis found, no collision
+		if(Lane_MoveMask(Lane_And(valid, Lane_Less(overlap, zero))))
+			return false;
+
+		Lane_Store(&axisX[i], x);
+		Lane_Store(&axisY[i], y);
+		Lane_Store(&axisZ[i], z);
+		Lane_Store(&overlaps[i], Lane_Select(valid, overlap, noOverlap));
+	}
+
+	// No separating axis found, the first smallest overlap wins same as the scalar test
+	uint32_t minAxis=0;
+
+	for(uint32_t i=1;i<OBB_AXIS_SLOTS;i++)
+	{
+		if(overlaps[i]<overlaps[minAxis])
+			minAxis=i;
+	}
+
+	OBBToOBBFillContact(a, b, relativePosition, Vec3(axisX[minAxis], axisY[minAxis], axisZ[minAxis]), overlaps[minAxis], contact);
+
+	return true;
+}
+
+// Finds the contact between two bodies without touching either of them.
+// Returns false if they aren't colliding, otherwise fills in contact for PhysicsResolveContact.
+bool PhysicsCollisionContact(const RigidBody_t *a, const RigidBody_t *b, PhysicsContact_t *contact)
 {
 	if(a->type==RIGIDBODY_SPHERE&&b->type==RIGIDBODY_SPHERE)
-		return SphereToSphereCollision(a, b);
+	{
+		contact->swapped=false;
+		return SphereToSphereContact(a, b, contact);
+	}
 	else if(a->type==RIGIDBODY_SPHERE&&b->type==RIGIDBODY_OBB)
-		return SphereToOBBCollision(a, b);
+	{
+		contact->swapped=true;
+		return SphereToOBBContact(a, b, contact);
+	}
 	else if(a->type==RIGIDBODY_OBB&&b->type==RIGIDBODY_SPHERE)
-		return SphereToOBBCollision(b, a);
+	{
+		contact->swapped=false;
+		return SphereToOBBContact(b, a, contact);
+	}
 	else if(a->type==RIGIDBODY_OBB&&b->type==RIGIDBODY_OBB)
-		return OBBToOBBCollision(b, a);
+	{
+		contact->swapped=true;
+		return PhysicsOBBToOBBContact(b, a, contact);
+	}
+
+	return false;
+}
+
+// Applies the impulses for a contact from PhysicsCollisionContact, a and b must be passed in the same order.
+// Returns the impact speed, 0 if they were already separating.
+float PhysicsResolveContact(RigidBody_t *a, RigidBody_t *b, const PhysicsContact_t *contact)
+{
+	if(contact->swapped)
+		return ResolveCollision(b, a, contact->position, contact->normal, contact->penetration);
+
+	return ResolveCollision(a, b, contact->position, contact->normal, contact->penetration);
+}
+
+float PhysicsCollisionResponse(RigidBody_t *a, RigidBody_t *b)
+{
+	PhysicsContact_t contact;
+
+	if(!PhysicsCollisionContact(a, b, &contact))
+		return 0.0f;
 
-	return 0.0f;
+	return PhysicsResolveContact(a, b, &contact);
 }
 
 void SpringIntegrate(Spring_t *s, vec3 target, float dt)
@@ -1,12 +1,19 @@
 #ifndef __PHYSICS_H__
 #define __PHYSICS_H__
 
+#include <stdbool.h>
 #include "../math/math.h"
 
 // Define constants
 #define WORLD_SCALE 1000.0f
 #define EXPLOSION_POWER (50.0f*WORLD_SCALE)
 
+// Integration constraints, shared by PhysicsIntegrate and PhysicsWorld_Integrate
+#define PHYSICS_BOUNDARY_RADIUS 2000.0f
+#define PHYSICS_MAX_VELOCITY 500.0f
+#define PHYSICS_LINEAR_DAMPING 0.999f
+#define PHYSICS_ANGULAR_DAMPING 0.998f
+
 typedef enum
 {
 	RIGIDBODY_OBB=0,
@@ -33,8 +40,22 @@ typedef struct RigidBody_s
 	};
 } RigidBody_t;
 
+// Contact between two bodies, normal points from the first body to the second in resolve order,
+// swapped means the pair gets resolved as (b, a) rather than the order it was tested in.
+typedef struct
+{
+	vec3 position;
+	vec3 normal;
+	float penetration;
+	bool swapped;
+} PhysicsContact_t;
+
 void PhysicsIntegrate(RigidBody_t *body, const float dt);
 void PhysicsExplode(RigidBody_t *body);
+bool PhysicsOBBToOBBContact(const RigidBody_t *a, const RigidBody_t *b, PhysicsContact_t *contact);
+bool PhysicsOBBToOBBContactScalar(const RigidBody_t *a, const RigidBody_t *b, PhysicsContact_t *contact);
+bool PhysicsCollisionContact(const RigidBody_t *a, const RigidBody_t *b, PhysicsContact_t *contact);
+float PhysicsResolveContact(RigidBody_t *a, RigidBody_t *b, const PhysicsContact_t *contact);
 float PhysicsCollisionResponse(RigidBody_t *a, RigidBody_t *b);
 
 typedef struct
@@ -0,0 +1,147 @@
+#ifndef __PHYSICSSIMD_H__
+#define __PHYSICSSIMD_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// SIMD lanes for the physics kernels, picks the widest the compiler is targeting.
+// Lane_t holds one float per body (or axis), LaneMask_t is the result of a compare.
+// Lane_MoveMask packs a mask down to one bit per lane, lane 0 in bit 0.
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+#define PHYSICS_LANES 8
+
+typedef __m256 Lane_t;
+typedef __m256 LaneMask_t;
+
+static inline Lane_t Lane_Load(const float *p) { return _mm256_load_ps(p); }
+static inline void Lane_Store(float *p, const Lane_t a) { _mm256_store_ps(p, a); }
+static inline Lane_t Lane_Set(const float a) { return _mm256_set1_ps(a); }
+static inline Lane_t Lane_Add(const Lane_t a, const Lane_t b) { return _mm256_add_ps(a, b); }
+static inline Lane_t Lane_Sub(const Lane_t a, const Lane_t b) { return _mm256_sub_ps(a, b); }
+static inline Lane_t Lane_Mul(const Lane_t a, const Lane_t b) { return _mm256_mul_ps(a, b); }
+static inline Lane_t Lane_Div(const Lane_t a, const Lane_t b) { return _mm256_div_ps(a, b); }
+static inline Lane_t Lane_Min(const Lane_t a, const Lane_t b) { return _mm256_min_ps(a, b); }
+static inline Lane_t Lane_Max(const Lane_t a, const Lane_t b) { return _mm256_max_ps(a, b); }
+static inline Lane_t Lane_Sqrt(const Lane_t a) { return _mm256_sqrt_ps(a); }
+static inline Lane_t Lane_Abs(const Lane_t a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+static inline LaneMask_t Lane_Greater(const Lane_t a, const Lane_t b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline LaneMask_t Lane_Less(const Lane_t a, const Lane_t b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline LaneMask_t Lane_LessEqual(const Lane_t a, const Lane_t b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+static inline LaneMask_t Lane_And(const LaneMask_t a, const LaneMask_t b) { return _mm256_and_ps(a, b); }
+static inline Lane_t Lane_Select(const LaneMask_t mask, const Lane_t a, const Lane_t b) { return _mm256_blendv_ps(b, a, mask); }
+static inline LaneMask_t Lane_LoadMask(const uint32_t *p) { return _mm256_castsi256_ps(_mm256_load_si256((const __m256i *)p)); }
+static inline uint32_t Lane_MoveMask(const LaneMask_t mask) { return (uint32_t)_mm256_movemask_ps(mask); }
+static inline bool Lane_AllSet(const LaneMask_t mask) { return _mm256_movemask_ps(mask)==0xFF; }
+#elif defined(__SSE2__)||defined(_M_X64)
+#include <emmintrin.h>
+
+#define PHYSICS_LANES 4
+
+typedef __m128 Lane_t;
+typedef __m128 LaneMask_t;
+
+static inline Lane_t Lane_Load(const float *p) { return _mm_load_ps(p); }
+static inline void Lane_Store(float *p, const Lane_t a) { _mm_store_ps(p, a); }
+static inline Lane_t Lane_Set(const float a) { return _mm_set1_ps(a); }
+static inline Lane_t Lane_Add(const Lane_t a, const Lane_t b) { return _mm_add_ps(a, b); }
+static inline Lane_t Lane_Sub(const Lane_t a, const Lane_t b) { return _mm_sub_ps(a, b); }
+static inline Lane_t Lane_Mul(const Lane_t a, const Lane_t b) { return _mm_mul_ps(a, b); }
+static inline Lane_t Lane_Div(const Lane_t a, const Lane_t b) { return _mm_div_ps(a, b); }
+static inline Lane_t Lane_Min(const Lane_t a, const Lane_t b) { return _mm_min_ps(a, b); }
+static inline Lane_t Lane_Max(const Lane_t a, const Lane_t b) { return _mm_max_ps(a, b); }
+static inline Lane_t Lane_Sqrt(const Lane_t a) { return _mm_sqrt_ps(a); }
+static inline Lane_t Lane_Abs(const Lane_t a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline LaneMask_t Lane_Greater(const Lane_t a, const Lane_t b) { return _mm_cmpgt_ps(a, b); }
+static inline LaneMask_t Lane_Less(const Lane_t a, const Lane_t b) { return _mm_cmplt_ps(a, b); }
+static inline LaneMask_t Lane_LessEqual(const Lane_t a, const Lane_t b) { return _mm_cmple_ps(a, b); }
+static inline LaneMask_t Lane_And(const LaneMask_t a, const LaneMask_t b) { return _mm_and_ps(a, b); }
+static inline Lane_t Lane_Select(const LaneMask_t mask, const Lane_t a, const Lane_t b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+static inline LaneMask_t Lane_LoadMask(const uint32_t *p) { return _mm_castsi128_ps(_mm_load_si128((const __m128i *)p)); }
+static inline uint32_t Lane_MoveMask(const LaneMask_t mask) { return (uint32_t)_mm_movemask_ps(mask); }
+static inline bool Lane_AllSet(const LaneMask_t mask) { return _mm_movemask_ps(mask)==0xF; }
+#elif defined(__ARM_NEON)&&defined(__aarch64__)
+#include <arm_neon.h>
+
+#define PHYSICS_LANES 4
+
+typedef float32x4_t Lane_t;
+typedef uint32x4_t LaneMask_t;
+
+static inline Lane_t Lane_Load(const float *p) { return vld1q_f32(p); }
+static inline void Lane_Store(float *p, const Lane_t a) { vst1q_f32(p, a); }
+static inline Lane_t Lane_Set(const float a) { return vdupq_n_f32(a); }
+static inline Lane_t Lane_Add(const Lane_t a, const Lane_t b) { return vaddq_f32(a, b); }
+static inline Lane_t Lane_Sub(const Lane_t a, const Lane_t b) { return vsubq_f32(a, b); }
+static inline Lane_t Lane_Mul(const Lane_t a, const Lane_t b) { return vmulq_f32(a, b); }
+static inline Lane_t Lane_Div(const Lane_t a, const Lane_t b) { return vdivq_f32(a, b); }
+static inline Lane_t Lane_Min(const Lane_t a, const Lane_t b) { return vminq_f32(a, b); }
+static inline Lane_t Lane_Max(const Lane_t a, const Lane_t b) { return vmaxq_f32(a, b); }
+static inline Lane_t Lane_Sqrt(const Lane_t a) { return vsqrtq_f32(a); }
+static inline Lane_t Lane_Abs(const Lane_t a) { return vabsq_f32(a); }
+static inline LaneMask_t Lane_Greater(const Lane_t a, const Lane_t b) { return vcgtq_f32(a, b); }
+static inline LaneMask_t Lane_Less(const Lane_t a, const Lane_t b) { return vcltq_f32(a, b); }
+static inline LaneMask_t Lane_LessEqual(const Lane_t a, const Lane_t b) { return vcleq_f32(a, b); }
+static inline LaneMask_t Lane_And(const LaneMask_t a, const LaneMask_t b) { return vandq_u32(a, b); }
+static inline Lane_t Lane_Select(const LaneMask_t mask, const Lane_t a, const Lane_t b) { return vbslq_f32(mask, a, b); }
+static inline LaneMask_t Lane_LoadMask(const uint32_t *p) { return vld1q_u32(p); }
+static inline bool Lane_AllSet(const LaneMask_t mask) { return vminvq_u32(mask)==UINT32_MAX; }
+
+// No movemask on NEON, keep one bit per lane and add them up
+static inline uint32_t Lane_MoveMask(const LaneMask_t mask)
+{
+	static const uint32_t bits[4]={ 1, 2, 4, 8 };
+	return vaddvq_u32(vandq_u32(mask, vld1q_u32(bits)));
+}
+#else
+#define PHYSICS_LANES 1
+
+typedef float Lane_t;
+typedef bool LaneMask_t;
+
+static inline Lane_t Lane_Load(const float *p) { return *p; }
+static inline void Lane_Store(float *p, const Lane_t a) { *p=a; }
+static inline Lane_t Lane_Set(const float a) { return a; }
+static inline Lane_t Lane_Add(const Lane_t a, const Lane_t b) { return a+b; }
+static inline Lane_t Lane_Sub(const Lane_t a, const Lane_t b) { return a-b; }
+static inline Lane_t Lane_Mul(const Lane_t a, const Lane_t b) { return a*b; }
+static inline Lane_t Lane_Div(const Lane_t a, const Lane_t b) { return a/b; }
+static inline Lane_t Lane_Min(const Lane_t a, const Lane_t b) { return fminf(a, b); }
+static inline Lane_t Lane_Max(const Lane_t a, const Lane_t b) { return fmaxf(a, b); }
+static inline Lane_t Lane_Sqrt(const Lane_t a) { return sqrtf(a); }
+static inline Lane_t Lane_Abs(const Lane_t a) { return fabsf(a); }
+static inline LaneMask_t Lane_Greater(const Lane_t a, const Lane_t b) { return a>b; }
+static inline LaneMask_t Lane_Less(const Lane_t a, const Lane_t b) { return a<b; }
+static inline LaneMask_t Lane_LessEqual(const Lane_t a, const Lane_t b) { return a<=b; }
+static inline LaneMask_t Lane_And(const LaneMask_t a, const LaneMask_t b) { return a&&b; }
+static inline Lane_t Lane_Select(const LaneMask_t mask, const Lane_t a, const Lane_t b) { return mask?a:b; }
+static inline LaneMask_t Lane_LoadMask(const uint32_t *p) { return *p!=0; }
+static inline uint32_t Lane_MoveMask(const LaneMask_t mask) { return mask?1:0; }
+static inline bool Lane_AllSet(const LaneMask_t mask) { return mask; }
+#endif
+
+// Stores only the lanes that aren't masked off, masked lanes keep what's in memory
+static inline void Lane_StoreMasked(float *p, const LaneMask_t keep, const Lane_t a)
+{
+	Lane_Store(p, Lane_Select(keep, Lane_Load(p), a));
+}
+
+// Lowest set bit of a Lane_MoveMask result, bits must be non-zero
+static inline uint32_t Lane_FirstSet(const uint32_t bits)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, bits);
+	return (uint32_t)index;
+#else
+	return (uint32_t)__builtin_ctz(bits);
+#endif
+}
+
+#endif
@@ -0,0 +1,1065 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "../system/system.h"
+#include "../utils/hashmap.h"
+#include "physics.h"
+#include "physicssimd.h"
+#include "physicsworld.h"
+
+_Static_assert(PHYSICSWORLD_LANE_PAD%PHYSICS_LANES==0, "Stream padding must be a whole number of SIMD vectors");
+_Static_assert(sizeof(RigidBodyType_e)==sizeof(float), "Body type stream is stored alongside the float streams");
+
+#define PHYSICSWORLD_ALIGN 32
+
+// Every stream, all of them 4 bytes per body (floats, or flags and counters as uint32_t), used for growing, clearing and moving bodies around
+static const size_t streamOffsets[]=
+{
+	offsetof(PhysicsWorld_t, positionX), offsetof(PhysicsWorld_t, positionY), offsetof(PhysicsWorld_t, positionZ),
+	offsetof(PhysicsWorld_t, velocityX), offsetof(PhysicsWorld_t, velocityY), offsetof(PhysicsWorld_t, velocityZ),
+	offsetof(PhysicsWorld_t, forceX), offsetof(PhysicsWorld_t, forceY), offsetof(PhysicsWorld_t, forceZ),
+	offsetof(PhysicsWorld_t, mass), offsetof(PhysicsWorld_t, invMass),
+	offsetof(PhysicsWorld_t, orientationX), offsetof(PhysicsWorld_t, orientationY), offsetof(PhysicsWorld_t, orientationZ), offsetof(PhysicsWorld_t, orientationW),
+	offsetof(PhysicsWorld_t, angularVelocityX), offsetof(PhysicsWorld_t, angularVelocityY), offsetof(PhysicsWorld_t, angularVelocityZ),
+	offsetof(PhysicsWorld_t, inertia), offsetof(PhysicsWorld_t, invInertia),
+	offsetof(PhysicsWorld_t, sizeX), offsetof(PhysicsWorld_t, sizeY), offsetof(PhysicsWorld_t, sizeZ),
+	offsetof(PhysicsWorld_t, type), offsetof(PhysicsWorld_t, boundingRadius),
+	offsetof(PhysicsWorld_t, previousPositionX), offsetof(PhysicsWorld_t, previousPositionY), offsetof(PhysicsWorld_t, previousPositionZ),
+	offsetof(PhysicsWorld_t, previousOrientationX), offsetof(PhysicsWorld_t, previousOrientationY), offsetof(PhysicsWorld_t, previousOrientationZ), offsetof(PhysicsWorld_t, previousOrientationW),
+	offsetof(PhysicsWorld_t, sleeping), offsetof(PhysicsWorld_t, restSteps), offsetof(PhysicsWorld_t, island),
+};
+
+#define PHYSICSWORLD_NUM_STREAMS (sizeof(streamOffsets)/sizeof(streamOffsets[0]))
+
+static inline uint8_t *PhysicsWorld_GetStream(const PhysicsWorld_t *world, const uint32_t stream)
+{
+	return *(uint8_t **)((uint8_t *)world+streamOffsets[stream]);
+}
+
+static inline void PhysicsWorld_SetStream(PhysicsWorld_t *world, const uint32_t stream, uint8_t *data)
+{
+	*(uint8_t **)((uint8_t *)world+streamOffsets[stream])=data;
+}
+
+bool PhysicsWorld_Reserve(PhysicsWorld_t *world, uint32_t capacity)
+{
+	if(world==NULL)
+		return false;
+
+	capacity=(capacity+PHYSICSWORLD_LANE_PAD-1)&~(PHYSICSWORLD_LANE_PAD-1);
+
+	if(capacity<=world->capacity)
+		return true;
+
+	const size_t streamSize=sizeof(float)*capacity;
+	void *memory=Zone_MallocTagged(zone, streamSize*PHYSICSWORLD_NUM_STREAMS+PHYSICSWORLD_ALIGN-1, TAG_PHYSICS);
+
+	if(memory==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "PhysicsWorld_Reserve: Unable to allocate memory for %u bodies.\n", capacity);
+		return false;
+	}
+
+	// Zone only guarantees 8 byte alignment, the kernel wants whole aligned vectors
+	uint8_t *base=(uint8_t *)(((uintptr_t)memory+PHYSICSWORLD_ALIGN-1)&~(uintptr_t)(PHYSICSWORLD_ALIGN-1));
+
+	for(uint32_t i=0;i<PHYSICSWORLD_NUM_STREAMS;i++)
+	{
+		uint8_t *stream=base+streamSize*i;
+
+		if(world->count)
+			memcpy(stream, PhysicsWorld_GetStream(world, i), sizeof(float)*world->count);
+
+		memset(stream+sizeof(float)*world->count, 0, streamSize-sizeof(float)*world->count);
+
+		PhysicsWorld_SetStream(world, i, stream);
+	}
+
+	if(world->memory)
+		Zone_Free(zone, world->memory);
+
+	world->memory=memory;
+	world->capacity=capacity;
+
+	return true;
+}
+
+bool PhysicsWorld_Init(PhysicsWorld_t *world, uint32_t capacity)
+{
+	if(world==NULL)
+		return false;
+
+	memset(world, 0, sizeof(PhysicsWorld_t));
+
+	world->pool=ThreadPool_GetDefault();
+	world->nextIsland=1;
+
+	return PhysicsWorld_Reserve(world, capacity?capacity:PHYSICSWORLD_LANE_PAD);
+}
+
+void PhysicsWorld_Destroy(PhysicsWorld_t *world)
+{
+	if(world==NULL)
+		return;
+
+	if(world->memory)
+		Zone_Free(zone, world->memory);
+
+	if(world->pairs)
+		Zone_Free(zone, world->pairs);
+
+	if(world->contacts)
+		Zone_Free(zone, world->contacts);
+
+	SpatialHash_Destroy(&world->broadPhase);
+
+	memset(world, 0, sizeof(PhysicsWorld_t));
+}
+
+void PhysicsWorld_Clear(PhysicsWorld_t *world)
+{
+	if(world==NULL)
+		return;
+
+	// Padding past the end has to stay zeroed for the kernel
+	for(uint32_t i=0;i<PHYSICSWORLD_NUM_STREAMS;i++)
+		memset(PhysicsWorld_GetStream(world, i), 0, sizeof(float)*world->count);
+
+	world->count=0;
+	world->numContacts=0;
+	world->numSleeping=0;
+}
+
+// Returns the new body's index, or UINT32_MAX if the world couldn't grow
+uint32_t PhysicsWorld_AddBody(PhysicsWorld_t *world, const RigidBody_t *body)
+{
+	if(world==NULL||body==NULL)
+		return UINT32_MAX;
+
+	if(world->count>=world->capacity)
+	{
+		if(!PhysicsWorld_Reserve(world, world->capacity*2))
+			return UINT32_MAX;
+	}
+
+	const uint32_t index=world->count++;
+
+	PhysicsWorld_SetBody(world, index, body);
+
+	// Nothing to interpolate from yet
+	world->previousPositionX[index]=body->position.x;
+	world->previousPositionY[index]=body->position.y;
+	world->previousPositionZ[index]=body->position.z;
+	world->previousOrientationX[index]=body->orientation.x;
+	world->previousOrientationY[index]=body->orientation.y;
+	world->previousOrientationZ[index]=body->orientation.z;
+	world->previousOrientationW[index]=body->orientation.w;
+
+	return index;
+}
+
+// Swap removes, the last body takes the removed body's index.
+// Removing a sleeping body wakes the rest of it's island, anything that was resting on it has nothing holding it up now.
+bool PhysicsWorld_RemoveBody(PhysicsWorld_t *world, uint32_t index)
+{
+	if(world==NULL||index>=world->count)
+		return false;
+
+	PhysicsWorld_WakeBody(world, index);
+
+	const uint32_t last=--world->count;
+
+	for(uint32_t i=0;i<PHYSICSWORLD_NUM_STREAMS;i++)
+	{
+		uint32_t *stream=(uint32_t *)PhysicsWorld_GetStream(world, i);
+
+		stream[index]=stream[last];
+		stream[last]=0;
+	}
+
+	return true;
+}
+
+bool PhysicsWorld_GetBody(const PhysicsWorld_t *world, uint32_t index, RigidBody_t *body)
+{
+	if(world==NULL||body==NULL||index>=world->count)
+		return false;
+
+	body->position=Vec3(world->positionX[index], world->positionY[index], world->positionZ[index]);
+	body->velocity=Vec3(world->velocityX[index], world->velocityY[index], world->velocityZ[index]);
+	body->force=Vec3(world->forceX[index], world->forceY[index], world->forceZ[index]);
+	body->mass=world->mass[index];
+	body->invMass=world->invMass[index];
+
+	body->orientation=Vec4(world->orientationX[index], world->orientationY[index], world->orientationZ[index], world->orientationW[index]);
+	body->angularVelocity=Vec3(world->angularVelocityX[index], world->angularVelocityY[index], world->angularVelocityZ[index]);
+	body->inertia=world->inertia[index];
+	body->invInertia=world->invInertia[index];
+
+	body->type=world->type[index];
+	body->size=Vec3(world->sizeX[index], world->sizeY[index], world->sizeZ[index]);
+
+	return true;
+}
+
+bool PhysicsWorld_SetBody(PhysicsWorld_t *world, uint32_t index, const RigidBody_t *body)
+{
+	if(world==NULL||body==NULL||index>=world->count)
+		return false;
+
+	world->positionX[index]=body->position.x;
+	world->positionY[index]=body->position.y;
+	world->positionZ[index]=body->position.z;
+	world->velocityX[index]=body->velocity.x;
+	world->velocityY[index]=body->velocity.y;
+	world->velocityZ[index]=body->velocity.z;
+	world->forceX[index]=body->force.x;
+	world->forceY[index]=body->force.y;
+	world->forceZ[index]=body->force.z;
+	world->mass[index]=body->mass;
+	world->invMass[index]=body->invMass;
+
+	world->orientationX[index]=body->orientation.x;
+	world->orientationY[index]=body->orientation.y;
+	world->orientationZ[index]=body->orientation.z;
+	world->orientationW[index]=body->orientation.w;
+	world->angularVelocityX[index]=body->angularVelocity.x;
+	world->angularVelocityY[index]=body->angularVelocity.y;
+	world->angularVelocityZ[index]=body->angularVelocity.z;
+	world->inertia[index]=body->inertia;
+	world->invInertia[index]=body->invInertia;
+
+	world->type[index]=body->type;
+	world->sizeX[index]=body->size.x;
+	world->sizeY[index]=body->size.y;
+	world->sizeZ[index]=body->size.z;
+
+	if(body->type==RIGIDBODY_OBB)
+		world->boundingRadius[index]=Vec3_Length(body->size);
+	else
+		world->boundingRadius[index]=body->radius;
+
+	return true;
+}
+
+uint32_t PhysicsWorld_GetCount(const PhysicsWorld_t *world)
+{
+	if(world==NULL)
+		return 0;
+
+	return world->count;
+}
+
+bool PhysicsWorld_IsSleeping(const PhysicsWorld_t *world, uint32_t index)
+{
+	if(world==NULL||index>=world->count)
+		return false;
+
+	return world->sleeping[index]!=0;
+}
+
+uint32_t PhysicsWorld_GetSleepingCount(const PhysicsWorld_t *world)
+{
+	if(world==NULL)
+		return 0;
+
+	return world->numSleeping;
+}
+
+static inline void PhysicsWorld_Wake(PhysicsWorld_t *world, uint32_t index)
+{
+	world->sleeping[index]=0;
+	world->restSteps[index]=0;
+	world->island[index]=0;
+	world->numSleeping--;
+}
+
+// Wakes every sleeping body in one of the islands in the set
+static void PhysicsWorld_WakeIslands(PhysicsWorld_t *world, HashMap_t *islands)
+{
+	for(uint32_t i=0;i<world->count&&world->numSleeping;i++)
+	{
+		if(world->sleeping[i]&&HashMap_HasInteger(islands, world->island[i]))
+			PhysicsWorld_Wake(world, i);
+	}
+}
+
+// Wakes a body along with everything that fell asleep in the same island
+void PhysicsWorld_WakeBody(PhysicsWorld_t *world, uint32_t index)
+{
+	if(world==NULL||index>=world->count||!world->sleeping[index])
+		return;
+
+	const uint32_t island=world->island[index];
+
+	for(uint32_t i=0;i<world->count;i++)
+	{
+		if(world->sleeping[i]&&world->island[i]==island)
+			PhysicsWorld_Wake(world, i);
+	}
+}
+
+// PhysicsExplode on a body in the world, waking it (and it's island) up first
+void PhysicsWorld_Explode(PhysicsWorld_t *world, uint32_t index)
+{
+	RigidBody_t body;
+
+	if(!PhysicsWorld_GetBody(world, index, &body))
+		return;
+
+	PhysicsWorld_WakeBody(world, index);
+
+	PhysicsExplode(&body);
+	PhysicsWorld_SetBody(world, index, &body);
+}
+
+// Blends a body's transform between the last two steps, alpha is from SimClock_GetAlpha (0 is the previous step, 1 the latest)
+bool PhysicsWorld_GetInterpolatedTransform(const PhysicsWorld_t *world, uint32_t index, const float alpha, vec3 *position, vec4 *orientation)
+{
+	if(world==NULL||index>=world->count)
+		return false;
+
+	if(position)
+	{
+		const vec3 previous=Vec3(world->previousPositionX[index], world->previousPositionY[index], world->previousPositionZ[index]);
+		const vec3 current=Vec3(world->positionX[index], world->positionY[index], world->positionZ[index]);
+
+		*position=Vec3_Lerp(previous, current, alpha);
+	}
+
+	if(orientation)
+	{
+		const vec4 previous=Vec4(world->previousOrientationX[index], world->previousOrientationY[index], world->previousOrientationZ[index], world->previousOrientationW[index]);
+		vec4 current=Vec4(world->orientationX[index], world->orientationY[index], world->orientationZ[index], world->orientationW[index]);
+
+		// Take the short way around
+		if(Vec4_Dot(previous, current)<0.0f)
+			current=Vec4_Muls(current, -1.0f);
+
+		*orientation=Vec4_Lerp(previous, current, alpha);
+		Vec4_Normalize(orientation);
+	}
+
+	return true;
+}
+
+// Finds every body whose bounding sphere touches a sphere, testing PHYSICS_LANES bodies at a time.
+// Writes up to maxIndices body indices in ascending order, returns the total number found (which can be more than maxIndices).
+uint32_t PhysicsWorld_QuerySphere(const PhysicsWorld_t *world, const vec3 center, const float radius, uint32_t *indices, const uint32_t maxIndices)
+{
+	if(world==NULL)
+		return 0;
+
+	const Lane_t centerX=Lane_Set(center.x);
+	const Lane_t centerY=Lane_Set(center.y);
+	const Lane_t centerZ=Lane_Set(center.z);
+	const Lane_t queryRadius=Lane_Set(radius);
+
+	uint32_t numFound=0;
+
+	for(uint32_t i=0;i<world->count;i+=PHYSICS_LANES)
+	{
+		const Lane_t dx=Lane_Sub(Lane_Load(&world->positionX[i]), centerX);
+		const Lane_t dy=Lane_Sub(Lane_Load(&world->positionY[i]), centerY);
+		const Lane_t dz=Lane_Sub(Lane_Load(&world->positionZ[i]), centerZ);
+		const Lane_t distanceSq=Lane_Add(Lane_Add(Lane_Mul(dx, dx), Lane_Mul(dy, dy)), Lane_Mul(dz, dz));
+		const Lane_t radiiSum=Lane_Add(Lane_Load(&world->boundingRadius[i]), queryRadius);
+
+		uint32_t hits=Lane_MoveMask(Lane_LessEqual(distanceSq, Lane_Mul(radiiSum, radiiSum)));
+
+		// Padding past the last body is zeroed and could be inside the query sphere
+		if(world->count-i<PHYSICS_LANES)
+			hits&=(1u<<(world->count-i))-1;
+
+		while(hits)
+		{
+			if(numFound<maxIndices&&indices)
+				indices[numFound]=i+Lane_FirstSet(hits);
+
+			numFound++;
+			hits&=hits-1;
+		}
+	}
+
+	return numFound;
+}
+
+typedef struct
+{
+	PhysicsWorld_t *world;
+	float dt;
+} PhysicsWorldIntegrate_t;
+
+// Same steps as PhysicsIntegrate and ApplyConstraints, PHYSICS_LANES bodies at a time, vectors of only sleeping bodies are skipped.
+// start and end are in whole vectors, not bodies.
+static void PhysicsWorld_IntegrateRange(uint32_t start, uint32_t end, void *userdata)
+{
+	const PhysicsWorldIntegrate_t *integrate=(const PhysicsWorldIntegrate_t *)userdata;
+	PhysicsWorld_t *world=integrate->world;
+
+	const Lane_t zero=Lane_Set(0.0f);
+	const Lane_t one=Lane_Set(1.0f);
+	const Lane_t dt=Lane_Set(integrate->dt);
+	const Lane_t halfDT=Lane_Set(0.5f*integrate->dt);
+	const Lane_t maxVelocity=Lane_Set(PHYSICS_MAX_VELOCITY);
+	const Lane_t minVelocity=Lane_Set(-PHYSICS_MAX_VELOCITY);
+	const Lane_t boundaryRadiusSq=Lane_Set(PHYSICS_BOUNDARY_RADIUS*PHYSICS_BOUNDARY_RADIUS);
+	const Lane_t linearDamping=Lane_Set(PHYSICS_LINEAR_DAMPING);
+	const Lane_t angularDamping=Lane_Set(PHYSICS_ANGULAR_DAMPING);
+
+	for(uint32_t i=start*PHYSICS_LANES;i<end*PHYSICS_LANES;i+=PHYSICS_LANES)
+	{
+		// Sleeping lanes are worked out along with the rest but never stored
+		const LaneMask_t sleeping=Lane_LoadMask(&world->sleeping[i]);
+
+		if(Lane_AllSet(sleeping))
+			continue;
+
+		// Gravity is off, same as PhysicsIntegrate, so force is just what's been accumulated
+		const Lane_t forceScale=Lane_Mul(Lane_Load(&world->invMass[i]), dt);
+
+		Lane_t velocityX=Lane_Add(Lane_Load(&world->velocityX[i]), Lane_Mul(Lane_Load(&world->forceX[i]), forceScale));
+		Lane_t velocityY=Lane_Add(Lane_Load(&world->velocityY[i]), Lane_Mul(Lane_Load(&world->forceY[i]), forceScale));
+		Lane_t velocityZ=Lane_Add(Lane_Load(&world->velocityZ[i]), Lane_Mul(Lane_Load(&world->forceZ[i]), forceScale));
+
+		const Lane_t positionX=Lane_Add(Lane_Load(&world->positionX[i]), Lane_Mul(velocityX, dt));
+		const Lane_t positionY=Lane_Add(Lane_Load(&world->positionY[i]), Lane_Mul(velocityY, dt));
+		const Lane_t positionZ=Lane_Add(Lane_Load(&world->positionZ[i]), Lane_Mul(velocityZ, dt));
+
+		Lane_StoreMasked(&world->positionX[i], sleeping, positionX);
+		Lane_StoreMasked(&world->positionY[i], sleeping, positionY);
+		Lane_StoreMasked(&world->positionZ[i], sleeping, positionZ);
+
+		// Two midpoint steps of the angular velocity, see IntegrateAngularVelocity
+		const Lane_t qx=Lane_Load(&world->orientationX[i]);
+		const Lane_t qy=Lane_Load(&world->orientationY[i]);
+		const Lane_t qz=Lane_Load(&world->orientationZ[i]);
+		const Lane_t qw=Lane_Load(&world->orientationW[i]);
+		Lane_t wx=Lane_Load(&world->angularVelocityX[i]);
+		Lane_t wy=Lane_Load(&world->angularVelocityY[i]);
+		Lane_t wz=Lane_Load(&world->angularVelocityZ[i]);
+
+		const Lane_t mx=Lane_Add(qx, Lane_Mul(Lane_Sub(Lane_Add(Lane_Mul(qw, wx), Lane_Mul(qy, wz)), Lane_Mul(qz, wy)), halfDT));
+		const Lane_t my=Lane_Add(qy, Lane_Mul(Lane_Add(Lane_Sub(Lane_Mul(qw, wy), Lane_Mul(qx, wz)), Lane_Mul(qz, wx)), halfDT));
+		const Lane_t mz=Lane_Add(qz, Lane_Mul(Lane_Sub(Lane_Add(Lane_Mul(qw, wz), Lane_Mul(qx, wy)), Lane_Mul(qy, wx)), halfDT));
+		const Lane_t mw=Lane_Add(qw, Lane_Mul(Lane_Sub(Lane_Sub(Lane_Sub(zero, Lane_Mul(qx, wx)), Lane_Mul(qy, wy)), Lane_Mul(qz, wz)), halfDT));
+
+		Lane_t rx=Lane_Add(qx, Lane_Mul(Lane_Sub(Lane_Add(Lane_Mul(mw, wx), Lane_Mul(my, wz)), Lane_Mul(mz, wy)), halfDT));
+		Lane_t ry=Lane_Add(qy, Lane_Mul(Lane_Add(Lane_Sub(Lane_Mul(mw, wy), Lane_Mul(mx, wz)), Lane_Mul(mz, wx)), halfDT));
+		Lane_t rz=Lane_Add(qz, Lane_Mul(Lane_Sub(Lane_Add(Lane_Mul(mw, wz), Lane_Mul(mx, wy)), Lane_Mul(my, wx)), halfDT));
+		Lane_t rw=Lane_Add(qw, Lane_Mul(Lane_Sub(Lane_Sub(Lane_Sub(zero, Lane_Mul(mx, wx)), Lane_Mul(my, wy)), Lane_Mul(mz, wz)), halfDT));
+
+		// Zero length quaternions (padding) are left alone, like Vec4_Normalize
+		const Lane_t length=Lane_Sqrt(Lane_Add(Lane_Add(Lane_Mul(rx, rx), Lane_Mul(ry, ry)), Lane_Add(Lane_Mul(rz, rz), Lane_Mul(rw, rw))));
+		const Lane_t invLength=Lane_Select(Lane_Greater(length, zero), Lane_Div(one, length), one);
+
+		Lane_StoreMasked(&world->orientationX[i], sleeping, Lane_Mul(rx, invLength));
+		Lane_StoreMasked(&world->orientationY[i], sleeping, Lane_Mul(ry, invLength));
+		Lane_StoreMasked(&world->orientationZ[i], sleeping, Lane_Mul(rz, invLength));
+		Lane_StoreMasked(&world->orientationW[i], sleeping, Lane_Mul(rw, invLength));
+
+		// Constraints, clamp velocity then push anything outside the boundary sphere back towards the center.
+		// Force was consumed above, so the push is all that's left in it for the next step.
+		velocityX=Lane_Min(Lane_Max(velocityX, minVelocity), maxVelocity);
+		velocityY=Lane_Min(Lane_Max(velocityY, minVelocity), maxVelocity);
+		velocityZ=Lane_Min(Lane_Max(velocityZ, minVelocity), maxVelocity);
+
+		const Lane_t radius=Lane_Load(&world->sizeX[i]);
+		const Lane_t distanceSq=Lane_Add(Lane_Add(Lane_Mul(positionX, positionX), Lane_Mul(positionY, positionY)), Lane_Mul(positionZ, positionZ));
+		const LaneMask_t outside=Lane_Greater(distanceSq, Lane_Sub(boundaryRadiusSq, Lane_Mul(radius, radius)));
+
+		Lane_StoreMasked(&world->forceX[i], sleeping, Lane_Select(outside, Lane_Sub(zero, positionX), zero));
+		Lane_StoreMasked(&world->forceY[i], sleeping, Lane_Select(outside, Lane_Sub(zero, positionY), zero));
+		Lane_StoreMasked(&world->forceZ[i], sleeping, Lane_Select(outside, Lane_Sub(zero, positionZ), zero));
+
+		Lane_StoreMasked(&world->velocityX[i], sleeping, Lane_Mul(velocityX, linearDamping));
+		Lane_StoreMasked(&world->velocityY[i], sleeping, Lane_Mul(velocityY, linearDamping));
+		Lane_StoreMasked(&world->velocityZ[i], sleeping, Lane_Mul(velocityZ, linearDamping));
+
+		wx=Lane_Mul(wx, angularDamping);
+		wy=Lane_Mul(wy, angularDamping);
+		wz=Lane_Mul(wz, angularDamping);
+
+		Lane_StoreMasked(&world->angularVelocityX[i], sleeping, wx);
+		Lane_StoreMasked(&world->angularVelocityY[i], sleeping, wy);
+		Lane_StoreMasked(&world->angularVelocityZ[i], sleeping, wz);
+	}
+}
+
+// Integrates every body in the world, split across the pool in whole SIMD vectors.
+// pool can be NULL to run on the calling thread.
+void PhysicsWorld_Integrate(PhysicsWorld_t *world, ThreadPool_t *pool, const float dt)
+{
+	if(world==NULL||world->count==0)
+		return;
+
+	PhysicsWorldIntegrate_t integrate=
+	{
+		.world=world,
+		.dt=dt,
+	};
+
+	// Padding bodies are zeroed, so running the last vector over them is harmless
+	const uint32_t numVectors=(world->count+PHYSICS_LANES-1)/PHYSICS_LANES;
+
+	ThreadPool_ParallelFor(pool, 0, numVectors, 0, PhysicsWorld_IntegrateRange, &integrate);
+}
+
+// Realloc that keeps the physics tag on the first allocation
+static void *PhysicsWorld_Realloc(void *ptr, const size_t size)
+{
+	if(ptr==NULL)
+		return Zone_MallocTagged(zone, size, TAG_PHYSICS);
+
+	return Zone_Realloc(zone, ptr, size);
+}
+
+// Bodies and contacts per thread pool chunk for the narrow phase and contact batches
+#define PHYSICSWORLD_GRAIN 32
+
+// Pairs with at least one awake body, from a batch query of just the awake bodies against every body in the hash.
+// Query indices are mapped back to body indices, and each pair comes out once with the lower body index first.
+// Returns the total like SpatialHash_QueryBatch, only the first maxPairs are written.
+static uint32_t PhysicsWorld_QueryAwakePairs(PhysicsWorld_t *world, const vec3 *positions, const uint32_t *bodies, const uint32_t numAwake, SpatialHashPair_t *pairs, const uint32_t maxPairs)
+{
+	const uint32_t numFound=SpatialHash_QueryBatch(&world->broadPhase, world->pool, positions, numAwake, pairs, maxPairs);
+
+	if(numFound>maxPairs)
+		return numFound;
+
+	// Two awake bodies find each other from both sides (and everything finds itself), keep the one from the lower index
+	uint32_t numPairs=0;
+
+	for(uint32_t i=0;i<numFound;i++)
+	{
+		const uint32_t a=bodies[pairs[i].query];
+		const uint32_t b=pairs[i].object;
+
+		if(a==b||(!world->sleeping[b]&&b<a))
+			continue;
+
+		pairs[numPairs++]=(SpatialHashPair_t){ .query=a<b?a:b, .object=a<b?b:a };
+	}
+
+	return numPairs;
+}
+
+// Hashes every body by position and collects the pairs in neighboring cells that have at least one awake body.
+// Sleeping bodies still go in the hash so awake ones can hit them, but only awake bodies are queried,
+//		so pairs of bodies that are both asleep never get generated, and with nothing awake there's no broad phase at all.
+// Grid cells are the size of the largest bounding sphere's diameter, so any two overlapping bodies end up in neighboring cells.
+// Returns the number of pairs in world->pairs.
+static uint32_t PhysicsWorld_BroadPhase(PhysicsWorld_t *world)
+{
+	const uint32_t numAwake=world->count-world->numSleeping;
+
+	if(numAwake==0)
+		return 0;
+
+	float maxRadius=0.0f;
+
+	for(uint32_t i=0;i<world->count;i++)
+		maxRadius=fmaxf(maxRadius, world->boundingRadius[i]);
+
+	const float gridSize=fmaxf(2.0f*maxRadius, 1.0f);
+
+	// Cells that are much too big just cost more pairs, too small misses them, so only shrink by a fair margin
+	SpatialHash_t *broadPhase=&world->broadPhase;
+
+	if(broadPhase->cellStart==NULL||gridSize>broadPhase->gridSize||gridSize<broadPhase->gridSize*0.5f||broadPhase->hashTableSize<world->count)
+	{
+		SpatialHash_Destroy(broadPhase);
+
+		if(!SpatialHash_Create(broadPhase, (world->count*2)|1, gridSize))
+		{
+			DBGPRINTF(DEBUG_ERROR, "Physics_Step: Unable to create broad phase hash.\n");
+			return 0;
+		}
+	}
+
+	SpatialHash_Clear(broadPhase);
+
+	// Object index is the body index, so there's nothing to point at
+	for(uint32_t i=0;i<world->count;i++)
+		SpatialHash_AddObject(broadPhase, Vec3(world->positionX[i], world->positionY[i], world->positionZ[i]), NULL);
+
+	SpatialHash_Build(broadPhase);
+
+	// Nothing asleep, every body is a query anyway and pair mode already only gives each pair once
+	if(world->numSleeping==0)
+	{
+		uint32_t numPairs=SpatialHash_QueryPairs(broadPhase, world->pool, world->pairs, world->maxPairs);
+
+		if(numPairs>world->maxPairs)
+		{
+			SpatialHashPair_t *pairs=(SpatialHashPair_t *)PhysicsWorld_Realloc(world->pairs, sizeof(SpatialHashPair_t)*numPairs);
+
+			if(pairs==NULL)
+			{
+				DBGPRINTF(DEBUG_ERROR, "Physics_Step: Unable to allocate memory for %u pairs.\n", numPairs);
+				return world->maxPairs;
+			}
+
+			world->pairs=pairs;
+			world->maxPairs=numPairs;
+
+			numPairs=SpatialHash_QueryPairs(broadPhase, world->pool, world->pairs, world->maxPairs);
+		}
+
+		return numPairs;
+	}
+
+	// Awake body positions to query with, then which body each one is
+	uint8_t *memory=(uint8_t *)Zone_MallocTagged(zone, (sizeof(vec3)+sizeof(uint32_t))*numAwake, TAG_PHYSICS);
+
+	if(memory==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Physics_Step: Unable to allocate memory for %u awake bodies.\n", numAwake);
+		return 0;
+	}
+
+	vec3 *positions=(vec3 *)memory;
+	uint32_t *bodies=(uint32_t *)(memory+sizeof(vec3)*numAwake);
+	uint32_t numQueries=0;
+
+	for(uint32_t i=0;i<world->count;i++)
+	{
+		if(world->sleeping[i])
+			continue;
+
+		positions[numQueries]=Vec3(world->positionX[i], world->positionY[i], world->positionZ[i]);
+		bodies[numQueries++]=i;
+	}
+
+	// Sized for the raw candidates, duplicates are only dropped once they're all written
+	uint32_t numPairs=PhysicsWorld_QueryAwakePairs(world, positions, bodies, numQueries, world->pairs, world->maxPairs);
+
+	if(numPairs>world->maxPairs)
+	{
+		SpatialHashPair_t *pairs=(SpatialHashPair_t *)PhysicsWorld_Realloc(world->pairs, sizeof(SpatialHashPair_t)*numPairs);
+
+		if(pairs==NULL)
+		{
+			DBGPRINTF(DEBUG_ERROR, "Physics_Step: Unable to allocate memory for %u pairs.\n", numPairs);
+			Zone_Free(zone, memory);
+			return 0;
+		}
+
+		world->pairs=pairs;
+		world->maxPairs=numPairs;
+
+		numPairs=PhysicsWorld_QueryAwakePairs(world, positions, bodies, numQueries, world->pairs, world->maxPairs);
+	}
+
+	Zone_Free(zone, memory);
+
+	return numPairs;
+}
+
+// Tests each candidate pair, writing a contact to the same index.
+// Nothing is changed on the bodies, so pairs can be tested in any order on any thread.
+static void PhysicsWorld_NarrowPhaseRange(uint32_t start, uint32_t end, void *userdata)
+{
+	PhysicsWorld_t *world=(PhysicsWorld_t *)userdata;
+
+	for(uint32_t i=start;i<end;i++)
+	{
+		PhysicsWorldContact_t *contact=&world->contacts[i];
+		RigidBody_t a, b;
+
+		contact->a=world->pairs[i].query;
+		contact->b=world->pairs[i].object;
+		contact->impact=0.0f;
+
+		// Bounding spheres don't touch, so neither can the bodies, skip copying them out
+		const float dx=world->positionX[contact->b]-world->positionX[contact->a];
+		const float dy=world->positionY[contact->b]-world->positionY[contact->a];
+		const float dz=world->positionZ[contact->b]-world->positionZ[contact->a];
+		const float radiiSum=world->boundingRadius[contact->a]+world->boundingRadius[contact->b];
+
+		if(dx*dx+dy*dy+dz*dz>radiiSum*radiiSum)
+		{
+			contact->a=UINT32_MAX;
+			continue;
+		}
+
+		PhysicsWorld_GetBody(world, contact->a, &a);
+		PhysicsWorld_GetBody(world, contact->b, &b);
+
+		if(!PhysicsCollisionContact(&a, &b, &contact->contact))
+			contact->a=UINT32_MAX;
+	}
+}
+
+typedef struct
+{
+	PhysicsWorld_t *world;
+	const uint32_t *order;
+} PhysicsWorldResolve_t;
+
+// Resolves a run of contacts from one batch, no two of them share a body so each body is only written by one thread
+static void PhysicsWorld_ResolveRange(uint32_t start, uint32_t end, void *userdata)
+{
+	const PhysicsWorldResolve_t *resolve=(const PhysicsWorldResolve_t *)userdata;
+	PhysicsWorld_t *world=resolve->world;
+
+	for(uint32_t i=start;i<end;i++)
+	{
+		PhysicsWorldContact_t *contact=&world->contacts[resolve->order[i]];
+		RigidBody_t a, b;
+
+		PhysicsWorld_GetBody(world, contact->a, &a);
+		PhysicsWorld_GetBody(world, contact->b, &b);
+
+		contact->impact=PhysicsResolveContact(&a, &b, &contact->contact);
+
+		PhysicsWorld_SetBody(world, contact->a, &a);
+		PhysicsWorld_SetBody(world, contact->b, &b);
+	}
+}
+
+// Greedy graph coloring, each contact takes the lowest batch neither of it's bodies is in yet.
+// Batches are then resolved one after another, with each batch's contacts spread across the pool.
+// Coloring is done in contact order on one thread, so the batches (and the result) don't depend on the thread count.
+static void PhysicsWorld_ResolveContacts(PhysicsWorld_t *world)
+{
+	const uint32_t numContacts=world->numContacts;
+
+	// Batch bitmask per body, then batch per contact, then contacts sorted by batch
+	const size_t masksSize=sizeof(uint64_t)*world->count;
+	const size_t batchesSize=sizeof(uint8_t)*numContacts;
+	uint8_t *memory=(uint8_t *)Zone_MallocTagged(zone, masksSize+batchesSize+sizeof(uint32_t)*numContacts+sizeof(uint32_t), TAG_PHYSICS);
+
+	if(memory==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Physics_Step: Unable to allocate memory for contact batches.\n");
+		return;
+	}
+
+	uint64_t *bodyBatches=(uint64_t *)memory;
+	uint8_t *contactBatch=memory+masksSize;
+	uint32_t *order=(uint32_t *)(((uintptr_t)(contactBatch+batchesSize)+sizeof(uint32_t)-1)&~(uintptr_t)(sizeof(uint32_t)-1));
+
+	memset(bodyBatches, 0, masksSize);
+
+	// Last batch is the overflow, resolved on the calling thread
+	uint32_t batchStart[PHYSICSWORLD_MAX_BATCHES+2]={ 0 };
+
+	for(uint32_t i=0;i<numContacts;i++)
+	{
+		const PhysicsWorldContact_t *contact=&world->contacts[i];
+		const uint64_t used=bodyBatches[contact->a]|bodyBatches[contact->b];
+		uint32_t batch=PHYSICSWORLD_MAX_BATCHES;
+
+		if(used!=UINT64_MAX)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward64(&index, ~used);
+			batch=(uint32_t)index;
+#else
+			batch=(uint32_t)__builtin_ctzll(~used);
+#endif
+			bodyBatches[contact->a]|=(uint64_t)1<<batch;
+			bodyBatches[contact->b]|=(uint64_t)1<<batch;
+		}
+
+		contactBatch[i]=(uint8_t)batch;
+		batchStart[batch+1]++;
+	}
+
+	for(uint32_t i=0;i<PHYSICSWORLD_MAX_BATCHES+1;i++)
+		batchStart[i+1]+=batchStart[i];
+
+	uint32_t offsets[PHYSICSWORLD_MAX_BATCHES+1];
+	memcpy(offsets, batchStart, sizeof(offsets));
+
+	for(uint32_t i=0;i<numContacts;i++)
+		order[offsets[contactBatch[i]]++]=i;
+
+	PhysicsWorldResolve_t resolve=
+	{
+		.world=world,
+		.order=order,
+	};
+
+	for(uint32_t i=0;i<PHYSICSWORLD_MAX_BATCHES;i++)
+		ThreadPool_ParallelFor(world->pool, batchStart[i], batchStart[i+1], PHYSICSWORLD_GRAIN, PhysicsWorld_ResolveRange, &resolve);
+
+	PhysicsWorld_ResolveRange(batchStart[PHYSICSWORLD_MAX_BATCHES], batchStart[PHYSICSWORLD_MAX_BATCHES+1], &resolve);
+
+	Zone_Free(zone, memory);
+}
+
+static uint32_t PhysicsWorld_FindIsland(uint32_t *parent, uint32_t index)
+{
+	while(parent[index]!=index)
+	{
+		// Path halving
+		parent[index]=parent[parent[index]];
+		index=parent[index];
+	}
+
+	return index;
+}
+
+// Island state flags, per union find root
+#define ISLAND_AWAKE		0x01
+#define ISLAND_MOVING		0x02
+
+// Wakes anything that was hit this step, then puts islands of resting bodies to sleep.
+// Islands are bodies joined by this step's contacts (static bodies don't join them together, or everything on the ground would be one island),
+// an island only sleeps once every body in it has been resting for PHYSICSWORLD_SLEEP_STEPS steps.
+static void PhysicsWorld_UpdateSleep(PhysicsWorld_t *world)
+{
+	const uint32_t count=world->count;
+
+	if(!count)
+		return;
+
+	// Wake islands that took an impact from an awake body
+	if(world->numSleeping)
+	{
+		HashMap_t wakeIslands;
+		bool wake=false;
+
+		for(uint32_t i=0;i<world->numContacts;i++)
+		{
+			const PhysicsWorldContact_t *contact=&world->contacts[i];
+
+			if(contact->impact<=0.0f||!(world->sleeping[contact->a]|world->sleeping[contact->b]))
+				continue;
+
+			if(!wake)
+			{
+				if(!HashMap_Init(&wakeIslands, HASHMAP_KEY_INTEGER, HASHMAP_STORAGE_ZONE, 0, 0))
+					break;
+
+				wake=true;
+			}
+
+			if(world->sleeping[contact->a])
+				HashMap_InsertInteger(&wakeIslands, world->island[contact->a], NULL);
+
+			if(world->sleeping[contact->b])
+				HashMap_InsertInteger(&wakeIslands, world->island[contact->b], NULL);
+		}
+
+		if(wake)
+		{
+			PhysicsWorld_WakeIslands(world, &wakeIslands);
+			HashMap_Destroy(&wakeIslands);
+		}
+	}
+
+	// Count how long each awake body has been resting
+	const float linearSq=PHYSICSWORLD_SLEEP_LINEAR*PHYSICSWORLD_SLEEP_LINEAR;
+	const float angularSq=PHYSICSWORLD_SLEEP_ANGULAR*PHYSICSWORLD_SLEEP_ANGULAR;
+
+	for(uint32_t i=0;i<count;i++)
+	{
+		if(world->sleeping[i])
+			continue;
+
+		const float speedSq=world->velocityX[i]*world->velocityX[i]+world->velocityY[i]*world->velocityY[i]+world->velocityZ[i]*world->velocityZ[i];
+		const float spinSq=world->angularVelocityX[i]*world->angularVelocityX[i]+world->angularVelocityY[i]*world->angularVelocityY[i]+world->angularVelocityZ[i]*world->angularVelocityZ[i];
+
+		if(speedSq<linearSq&&spinSq<angularSq)
+		{
+			if(world->restSteps[i]<PHYSICSWORLD_SLEEP_STEPS)
+				world->restSteps[i]++;
+		}
+		else
+			world->restSteps[i]=0;
+	}
+
+	// Union find parent, island ID and state per body
+	uint8_t *memory=(uint8_t *)Zone_MallocTagged(zone, (sizeof(uint32_t)*2+sizeof(uint8_t))*count, TAG_PHYSICS);
+
+	if(memory==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Physics_Step: Unable to allocate memory for islands.\n");
+		return;
+	}
+
+	uint32_t *parent=(uint32_t *)memory;
+	uint32_t *islandID=parent+count;
+	uint8_t *state=(uint8_t *)(islandID+count);
+
+	for(uint32_t i=0;i<count;i++)
+	{
+		parent[i]=i;
+		islandID[i]=0;
+		state[i]=0;
+	}
+
+	for(uint32_t i=0;i<world->numContacts;i++)
+	{
+		const PhysicsWorldContact_t *contact=&world->contacts[i];
+
+		if(world->invMass[contact->a]==0.0f||world->invMass[contact->b]==0.0f)
+			continue;
+
+		const uint32_t a=PhysicsWorld_FindIsland(parent, contact->a);
+		const uint32_t b=PhysicsWorld_FindIsland(parent, contact->b);
+
+		// Lower index as the root keeps it independent of contact order
+		if(a<b)
+			parent[b]=a;
+		else if(b<a)
+			parent[a]=b;
+	}
+
+	for(uint32_t i=0;i<count;i++)
+	{
+		const uint32_t root=PhysicsWorld_FindIsland(parent, i);
+
+		if(!world->sleeping[i])
+		{
+			state[root]|=ISLAND_AWAKE;
+
+			if(world->restSteps[i]<PHYSICSWORLD_SLEEP_STEPS)
+				state[root]|=ISLAND_MOVING;
+		}
+	}
+
+	// Put resting islands to sleep, sleeping bodies they touch are merged in and take the new island ID
+	HashMap_t merged;
+	bool merge=false;
+
+	for(uint32_t i=0;i<count;i++)
+	{
+		const uint32_t root=PhysicsWorld_FindIsland(parent, i);
+
+		if(state[root]!=ISLAND_AWAKE)
+			continue;
+
+		if(!islandID[root])
+		{
+			islandID[root]=world->nextIsland++;
+
+			if(!world->nextIsland)
+				world->nextIsland=1;
+		}
+
+		if(world->sleeping[i])
+		{
+			if(world->island[i]!=islandID[root])
+			{
+				if(!merge)
+					merge=HashMap_Init(&merged, HASHMAP_KEY_INTEGER, HASHMAP_STORAGE_ZONE, sizeof(uint32_t), 0);
+
+				if(merge)
+					HashMap_InsertInteger(&merged, world->island[i], &islandID[root]);
+
+				world->island[i]=islandID[root];
+			}
+
+			continue;
+		}
+
+		world->sleeping[i]=UINT32_MAX;
+		world->island[i]=islandID[root];
+		world->numSleeping++;
+
+		world->velocityX[i]=world->velocityY[i]=world->velocityZ[i]=0.0f;
+		world->angularVelocityX[i]=world->angularVelocityY[i]=world->angularVelocityZ[i]=0.0f;
+		world->forceX[i]=world->forceY[i]=world->forceZ[i]=0.0f;
+	}
+
+	// Relabel the rest of any sleeping island that got merged
+	if(merge)
+	{
+		for(uint32_t i=0;i<count;i++)
+		{
+			if(!world->sleeping[i])
+				continue;
+
+			const uint32_t *island=(const uint32_t *)HashMap_GetInteger(&merged, world->island[i]);
+
+			if(island)
+				world->island[i]=*island;
+		}
+
+		HashMap_Destroy(&merged);
+	}
+
+	Zone_Free(zone, memory);
+}
+
+// Broad phase, narrow phase and resolve, returns the number of contacts
+static uint32_t PhysicsWorld_Collide(PhysicsWorld_t *world)
+{
+	world->numContacts=0;
+
+	if(world->count<2)
+		return 0;
+
+	const uint32_t numPairs=PhysicsWorld_BroadPhase(world);
+
+	if(numPairs==0)
+		return 0;
+
+	if(numPairs>world->maxContacts)
+	{
+		PhysicsWorldContact_t *contacts=(PhysicsWorldContact_t *)PhysicsWorld_Realloc(world->contacts, sizeof(PhysicsWorldContact_t)*numPairs);
+
+		if(contacts==NULL)
+		{
+			DBGPRINTF(DEBUG_ERROR, "Physics_Step: Unable to allocate memory for %u contacts.\n", numPairs);
+			return 0;
+		}
+
+		world->contacts=contacts;
+		world->maxContacts=numPairs;
+	}
+
+	ThreadPool_ParallelFor(world->pool, 0, numPairs, PHYSICSWORLD_GRAIN, PhysicsWorld_NarrowPhaseRange, world);
+
+	// Pack the pairs that did collide down to the front, keeping their order
+	uint32_t numContacts=0;
+
+	for(uint32_t i=0;i<numPairs;i++)
+	{
+		if(world->contacts[i].a!=UINT32_MAX)
+			world->contacts[numContacts++]=world->contacts[i];
+	}
+
+	world->numContacts=numContacts;
+
+	if(numContacts)
+		PhysicsWorld_ResolveContacts(world);
+
+	return numContacts;
+}
+
+// Steps the world by dt (meant to be SimClock_GetStep, once per tick), integrating every body then finding and resolving collisions between them:
+//	broad phase - spatial hash pairs with at least one awake body,
+//	narrow phase - contacts for every pair, in parallel,
+//	resolve - contacts split into batches with no shared bodies, each batch in parallel,
+//	sleep - islands hit by an awake body wake up, islands that have been resting long enough go to sleep.
+// Contacts are tested against the integrated positions, then resolved in batch order.
+// Runs on world->pool, results are the same for any number of threads (or none).
+// Returns the number of contacts, which are left in world->contacts until the next step.
+uint32_t Physics_Step(PhysicsWorld_t *world, const float dt)
+{
+	if(world==NULL)
+		return 0;
+
+	memcpy(world->previousPositionX, world->positionX, sizeof(float)*world->count);
+	memcpy(world->previousPositionY, world->positionY, sizeof(float)*world->count);
+	memcpy(world->previousPositionZ, world->positionZ, sizeof(float)*world->count);
+	memcpy(world->previousOrientationX, world->orientationX, sizeof(float)*world->count);
+	memcpy(world->previousOrientationY, world->orientationY, sizeof(float)*world->count);
+	memcpy(world->previousOrientationZ, world->orientationZ, sizeof(float)*world->count);
+	memcpy(world->previousOrientationW, world->orientationW, sizeof(float)*world->count);
+
+	PhysicsWorld_Integrate(world, world->pool, dt);
+
+	world->numContacts=PhysicsWorld_Collide(world);
+
+	PhysicsWorld_UpdateSleep(world);
+
+	return world->numContacts;
+}
@@ -0,0 +1,99 @@
+#ifndef __PHYSICSWORLD_H__
+#define __PHYSICSWORLD_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../math/math.h"
+#include "../system/threads.h"
+#include "../utils/spatialhash.h"
+#include "physics.h"
+
+// Streams are padded out to a multiple of this many bodies, so the integration kernel never needs a scalar tail
+#define PHYSICSWORLD_LANE_PAD 8
+
+// Bodies moving slower than these (units/sec and radians/sec) for PHYSICSWORLD_SLEEP_STEPS steps in a row are resting,
+// once every body touching it is resting too, the whole island goes to sleep
+#define PHYSICSWORLD_SLEEP_LINEAR 0.5f
+#define PHYSICSWORLD_SLEEP_ANGULAR 0.05f
+#define PHYSICSWORLD_SLEEP_STEPS 60
+
+// Contacts are split into at most this many batches where no two contacts share a body,
+// anything that doesn't fit gets resolved on it's own after them.
+#define PHYSICSWORLD_MAX_BATCHES 64
+
+// A contact found by Physics_Step, a and b are body indices, impact is the speed it was resolved at (0 if they were separating)
+typedef struct
+{
+	uint32_t a, b;
+	PhysicsContact_t contact;
+	float impact;
+} PhysicsWorldContact_t;
+
+// Rigid bodies stored as a structure of arrays, one stream per component.
+// Each stream is capacity floats long and 32 byte aligned, bodies past count are zeroed padding.
+// Body indices are dense, removing a body moves the last one into its place.
+// RigidBody_t is still the per-body interface, use PhysicsWorld_GetBody/SetBody to copy a body out and back in.
+typedef struct
+{
+	uint32_t count, capacity;
+
+	float *positionX, *positionY, *positionZ;
+	float *velocityX, *velocityY, *velocityZ;
+	float *forceX, *forceY, *forceZ;
+	float *mass, *invMass;
+
+	float *orientationX, *orientationY, *orientationZ, *orientationW;
+	float *angularVelocityX, *angularVelocityY, *angularVelocityZ;
+	float *inertia, *invInertia;
+
+	// Radius is sizeX, same as the RigidBody_t union
+	float *sizeX, *sizeY, *sizeZ;
+	RigidBodyType_e *type;
+
+	// Sphere around each body, the radius for spheres and half the diagonal for OBBs, kept up to date by PhysicsWorld_SetBody
+	float *boundingRadius;
+
+	// Transform before the last Physics_Step, for interpolating between fixed steps when rendering
+	float *previousPositionX, *previousPositionY, *previousPositionZ;
+	float *previousOrientationX, *previousOrientationY, *previousOrientationZ, *previousOrientationW;
+
+	// Sleeping bodies are all bits set (so it loads straight as a SIMD mask), 0 when awake.
+	// Sleeping bodies aren't integrated and pairs of them never come out of the broad phase, they keep the ID of the island they fell asleep with.
+	uint32_t *sleeping;
+	uint32_t *restSteps;
+	uint32_t *island;
+	uint32_t nextIsland, numSleeping;
+
+	// Single allocation backing all the streams
+	void *memory;
+
+	// Pool Physics_Step runs on, starts as the default pool, NULL steps on the calling thread
+	ThreadPool_t *pool;
+
+	// Broad phase, candidate pairs and the contacts from the last step
+	SpatialHash_t broadPhase;
+	SpatialHashPair_t *pairs;
+	uint32_t maxPairs;
+	PhysicsWorldContact_t *contacts;
+	uint32_t numContacts, maxContacts;
+} PhysicsWorld_t;
+
+bool PhysicsWorld_Init(PhysicsWorld_t *world, uint32_t capacity);
+void PhysicsWorld_Destroy(PhysicsWorld_t *world);
+void PhysicsWorld_Clear(PhysicsWorld_t *world);
+bool PhysicsWorld_Reserve(PhysicsWorld_t *world, uint32_t capacity);
+uint32_t PhysicsWorld_AddBody(PhysicsWorld_t *world, const RigidBody_t *body);
+bool PhysicsWorld_RemoveBody(PhysicsWorld_t *world, uint32_t index);
+bool PhysicsWorld_GetBody(const PhysicsWorld_t *world, uint32_t index, RigidBody_t *body);
+bool PhysicsWorld_SetBody(PhysicsWorld_t *world, uint32_t index, const RigidBody_t *body);
+uint32_t PhysicsWorld_GetCount(const PhysicsWorld_t *world);
+bool PhysicsWorld_IsSleeping(const PhysicsWorld_t *world, uint32_t index);
+uint32_t PhysicsWorld_GetSleepingCount(const PhysicsWorld_t *world);
+void PhysicsWorld_WakeBody(PhysicsWorld_t *world, uint32_t index);
+void PhysicsWorld_Explode(PhysicsWorld_t *world, uint32_t index);
+uint32_t PhysicsWorld_QuerySphere(const PhysicsWorld_t *world, const vec3 center, const float radius, uint32_t *indices, const uint32_t maxIndices);
+bool PhysicsWorld_GetInterpolatedTransform(const PhysicsWorld_t *world, uint32_t index, const float alpha, vec3 *position, vec4 *orientation);
+void PhysicsWorld_Integrate(PhysicsWorld_t *world, ThreadPool_t *pool, const float dt);
+uint32_t Physics_Step(PhysicsWorld_t *world, const float dt);
+
+#endif
@@ -0,0 +1,335 @@
+// Per-frame linear (bump) allocator.
+
+// Each thread gets it's own set of arenas, one per frame in flight, so allocation is just a pointer bump with no locking.
+// FrameArena_BeginFrame bumps that frame's epoch, and each thread resets it's own arena lazily on the next allocation
+//		that sees the new epoch, so nothing ever touches another thread's arena.
+// Allocations that don't fit fall back to the zone and are freed when the arena resets.
+//
+// Memory returned is only valid until the same frame index comes around again (FRAMES_IN_FLIGHT frames later).
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <threads.h>
+#include <stdatomic.h>
+#include "system.h"
+#include "framearena.h"
+
+_Static_assert((FRAMEARENA_ALIGN&(FRAMEARENA_ALIGN-1))==0, "Frame arena alignment must be a power of two");
+
+typedef struct
+{
+	// Zone allocation backing all of this thread's arenas, and the aligned start of the first one
+	uint8_t *memory;
+	uint8_t *base;
+	FrameArena_t arenas[FRAMEARENA_MAX_FRAMES];
+} FrameArenaThread_t;
+
+static uint32_t numFrames=0;
+static size_t arenaSize=0;
+
+static atomic_uint currentFrame=0;
+static atomic_uint frameEpoch[FRAMEARENA_MAX_FRAMES];
+
+static atomic_uint numThreads=0;
+static FrameArenaThread_t threads[FRAMEARENA_MAX_THREADS];
+
+static thread_local FrameArenaThread_t *threadArenas=NULL;
+
+static inline uint8_t *FrameArena_AlignPtr(uint8_t *ptr)
+{
+	return (uint8_t *)(((uintptr_t)ptr+(FRAMEARENA_ALIGN-1))&~(uintptr_t)(FRAMEARENA_ALIGN-1));
+}
+
+// Debug check that an allocation lives up to FRAMEARENA_ALIGN
+static inline void *FrameArena_CheckAlign(void *ptr)
+{
+#ifdef _DEBUG
+	if((uintptr_t)ptr&(FRAMEARENA_ALIGN-1))
+		DBGPRINTF(DEBUG_ERROR, "FrameArena: Allocation %p isn't %d byte aligned.\n", ptr, FRAMEARENA_ALIGN);
+#endif
+
+	return ptr;
+}
+
+static void FrameArena_ResetArena(FrameArena_t *arena, uint32_t epoch)
+{
+	if(arena->offset>arena->highWater)
+		arena->highWater=arena->offset;
+
+	if(arena->overflowSize>arena->overflowHighWater)
+		arena->overflowHighWater=arena->overflowSize;
+
+	// Give back anything that had to come from the zone
+	FrameArenaOverflow_t *overflow=arena->overflow;
+
+	while(overflow)
+	{
+		FrameArenaOverflow_t *next=overflow->next;
+		Zone_Free(zone, overflow);
+		overflow=next;
+	}
+
+	arena->overflow=NULL;
+	arena->overflowSize=0;
+	arena->offset=0;
+	arena->lastOffset=0;
+	arena->lastAlloc=SIZE_MAX;
+	arena->epoch=epoch;
+}
+
+// Get (or claim) this thread's set of arenas
+static FrameArenaThread_t *FrameArena_GetThread(void)
+{
+	if(threadArenas)
+		return threadArenas;
+
+	if(!numFrames)
+	{
+		DBGPRINTF(DEBUG_ERROR, "FrameArena: Not initialized.\n");
+		return NULL;
+	}
+
+	const uint32_t index=atomic_fetch_add(&numThreads, 1);
+
+	if(index>=FRAMEARENA_MAX_THREADS)
+	{
+		atomic_fetch_sub(&numThreads, 1);
+		DBGPRINTF(DEBUG_ERROR, "FrameArena: Too many threads (max %d).\n", FRAMEARENA_MAX_THREADS);
+		return NULL;
+	}
+
+	FrameArenaThread_t *thread=&threads[index];
+
+	thread->memory=(uint8_t *)Zone_MallocTagged(zone, arenaSize*numFrames+FRAMEARENA_ALIGN-1, TAG_SYSTEM);
+
+	if(thread->memory==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "FrameArena: Unable to allocate memory for thread arenas.\n");
+		return NULL;
+	}
+
+	// Zone only guarantees 8 byte alignment, arenaSize is a multiple of FRAMEARENA_ALIGN so every arena after the first stays aligned
+	thread->base=FrameArena_AlignPtr(thread->memory);
+
+	for(uint32_t i=0;i<numFrames;i++)
+	{
+		memset(&thread->arenas[i], 0, sizeof(FrameArena_t));
+		thread->arenas[i].base=thread->base+arenaSize*i;
+		thread->arenas[i].lastAlloc=SIZE_MAX;
+		thread->arenas[i].epoch=atomic_load(&frameEpoch[i]);
+	}
+
+	threadArenas=thread;
+
+	return thread;
+}
+
+static FrameArena_t *FrameArena_GetArena(void)
+{
+	FrameArenaThread_t *thread=FrameArena_GetThread();
+
+	if(thread==NULL)
+		return NULL;
+
+	const uint32_t frame=atomic_load(&currentFrame);
+	FrameArena_t *arena=&thread->arenas[frame];
+	const uint32_t epoch=atomic_load(&frameEpoch[frame]);
+
+	// Frame came back around, reset it
+	if(arena->epoch!=epoch)
+		FrameArena_ResetArena(arena, epoch);
+
+	return arena;
+}
+
+bool FrameArena_Init(uint32_t frames, size_t size)
+{
+	if(frames==0||frames>FRAMEARENA_MAX_FRAMES)
+	{
+		DBGPRINTF(DEBUG_ERROR, "FrameArena_Init: Invalid frame count %d (max %d).\n", frames, FRAMEARENA_MAX_FRAMES);
+		return false;
+	}
+
+	numFrames=frames;
+	arenaSize=(size+(FRAMEARENA_ALIGN-1))&~(size_t)(FRAMEARENA_ALIGN-1);
+
+	atomic_store(&currentFrame, 0);
+	atomic_store(&numThreads, 0);
+
+	for(uint32_t i=0;i<FRAMEARENA_MAX_FRAMES;i++)
+		atomic_store(&frameEpoch[i], 0);
+
+	memset(threads, 0, sizeof(threads));
+
+	return true;
+}
+
+// Only call on shutdown, once no other threads are allocating
+void FrameArena_Destroy(void)
+{
+	const uint32_t count=atomic_load(&numThreads);
+
+	for(uint32_t i=0;i<count;i++)
+	{
+		for(uint32_t j=0;j<numFrames;j++)
+			FrameArena_ResetArena(&threads[i].arenas[j], 0);
+
+		if(threads[i].memory)
+			Zone_Free(zone, threads[i].memory);
+	}
+
+	memset(threads, 0, sizeof(threads));
+	atomic_store(&numThreads, 0);
+	numFrames=0;
+
+	threadArenas=NULL;
+}
+
+// Called once the frame's fence has signaled, everything allocated the last time this frame index was used is released
+void FrameArena_BeginFrame(uint32_t index)
+{
+	if(index>=numFrames)
+		return;
+
+	atomic_fetch_add(&frameEpoch[index], 1);
+	atomic_store(&currentFrame, index);
+}
+
+void *FrameArena_Malloc(size_t size)
+{
+	if(!size)
+		return NULL;
+
+	FrameArena_t *arena=FrameArena_GetArena();
+
+	if(arena==NULL)
+		return NULL;
+
+	const size_t offset=(arena->offset+(FRAMEARENA_ALIGN-1))&~(size_t)(FRAMEARENA_ALIGN-1);
+
+	if(offset+size<=arenaSize)
+	{
+		arena->lastOffset=arena->offset;
+		arena->lastAlloc=offset;
+		arena->offset=offset+size;
+
+		if(arena->offset>arena->highWater)
+			arena->highWater=arena->offset;
+
+		return FrameArena_CheckAlign(arena->base+offset);
+	}
+
+	// Didn't fit, fall back to the zone and track it so it's freed on reset, padded so the data can be aligned
+	FrameArenaOverflow_t *overflow=(FrameArenaOverflow_t *)Zone_MallocTagged(zone, sizeof(FrameArenaOverflow_t)+size+FRAMEARENA_ALIGN-1, TAG_SYSTEM);
+
+	if(overflow==NULL)
+		return NULL;
+
+	overflow->data=FrameArena_AlignPtr((uint8_t *)overflow+sizeof(FrameArenaOverflow_t));
+	overflow->size=size;
+	overflow->prev=NULL;
+	overflow->next=arena->overflow;
+
+	if(arena->overflow)
+		arena->overflow->prev=overflow;
+
+	arena->overflow=overflow;
+	arena->overflowSize+=size;
+	arena->overflowCount++;
+
+	return FrameArena_CheckAlign(overflow->data);
+}
+
+void *FrameArena_Calloc(size_t size, size_t count)
+{
+	void *ptr=FrameArena_Malloc(size*count);
+
+	if(ptr)
+		memset(ptr, 0, size*count);
+
+	return ptr;
+}
+
+// Optional early release, must be called from the allocating thread.
+// The most recent arena allocation is popped and overflow blocks go back to the zone, anything else waits for the reset.
+void FrameArena_Free(void *ptr)
+{
+	if(ptr==NULL)
+		return;
+
+	FrameArena_t *arena=FrameArena_GetArena();
+
+	if(arena==NULL)
+		return;
+
+	uint8_t *bytes=(uint8_t *)ptr;
+
+	// Inside this thread's arenas, only the last allocation can be rolled back
+	if(bytes>=threadArenas->base&&bytes<threadArenas->base+arenaSize*numFrames)
+	{
+		if(bytes==arena->base+arena->lastAlloc)
+		{
+			arena->offset=arena->lastOffset;
+			arena->lastAlloc=SIZE_MAX;
+		}
+
+		return;
+	}
+
+	// Otherwise it has to be an overflow block from this arena
+	for(FrameArenaOverflow_t *overflow=arena->overflow;overflow;overflow=overflow->next)
+	{
+		if(overflow->data==bytes)
+		{
+			if(overflow->prev)
+				overflow->prev->next=overflow->next;
+			else
+				arena->overflow=overflow->next;
+
+			if(overflow->next)
+				overflow->next->prev=overflow->prev;
+
+			arena->overflowSize-=overflow->size;
+
+			Zone_Free(zone, overflow);
+			return;
+		}
+	}
+}
+
+// Largest amount of arena memory any one thread has used in a frame
+size_t FrameArena_GetHighWater(void)
+{
+	const uint32_t count=atomic_load(&numThreads);
+	size_t highWater=0;
+
+	for(uint32_t i=0;i<count;i++)
+	{
+		for(uint32_t j=0;j<numFrames;j++)
+		{
+			if(threads[i].arenas[j].highWater>highWater)
+				highWater=threads[i].arenas[j].highWater;
+		}
+	}
+
+	return highWater;
+}
+
+void FrameArena_Print(void)
+{
+	const uint32_t count=atomic_load(&numThreads);
+
+	DBGPRINTF(DEBUG_WARNING, "Frame arenas: %d threads, %d frames, %0.3fKB each\n", count, numFrames, (float)arenaSize/1000.0f);
+
+	for(uint32_t i=0;i<count;i++)
+	{
+		for(uint32_t j=0;j<numFrames;j++)
+		{
+			const FrameArena_t *arena=&threads[i].arenas[j];
+
+			DBGPRINTF(DEBUG_WARNING, "\tThread %d, Frame %d: High water: %0.3fKB, Overflow high water: %0.3fKB, Overflows: %d\n",
+					  i, j, (float)arena->highWater/1000.0f, (float)arena->overflowHighWater/1000.0f, arena->overflowCount);
+		}
+	}
+}
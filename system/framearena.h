@@ -0,0 +1,58 @@
+#ifndef __FRAMEARENA_H__
+#define __FRAMEARENA_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// Per-thread arena size for each frame in flight
+#ifndef FRAMEARENA_SIZE
+#define FRAMEARENA_SIZE (1*1024*1024)
+#endif
+
+// Enough for a full thread pool (THREAD_POOL_MAX_WORKERS) plus the main, audio and network threads
+#define FRAMEARENA_MAX_THREADS 48
+#define FRAMEARENA_MAX_FRAMES 8
+
+// Every allocation (arena or overflow) is aligned to this, enough for SSE/NEON loads
+#define FRAMEARENA_ALIGN 16
+
+// Allocations that didn't fit in the arena, these come from the zone and get freed on reset.
+// The header sits at the start of the zone block, data is the first FRAMEARENA_ALIGN aligned byte after it.
+typedef struct FrameArenaOverflow_s
+{
+	struct FrameArenaOverflow_s *next, *prev;
+	size_t size;
+	uint8_t *data;
+} FrameArenaOverflow_t;
+
+typedef struct
+{
+	uint8_t *base;
+	size_t offset;
+
+	// Start of the most recent allocation and the offset before it, so it can be popped
+	size_t lastAlloc, lastOffset;
+
+	// Frame epoch this arena was last reset for
+	uint32_t epoch;
+
+	FrameArenaOverflow_t *overflow;
+	size_t overflowSize;
+
+	// Stats
+	size_t highWater;
+	size_t overflowHighWater;
+	uint32_t overflowCount;
+} FrameArena_t;
+
+bool FrameArena_Init(uint32_t numFrames, size_t size);
+void FrameArena_Destroy(void);
+void FrameArena_BeginFrame(uint32_t index);
+void *FrameArena_Malloc(size_t size);
+void *FrameArena_Calloc(size_t size, size_t count);
+void FrameArena_Free(void *ptr);
+size_t FrameArena_GetHighWater(void);
+void FrameArena_Print(void);
+
+#endif
@@ -1,404 +1,1833 @@
+// Two-level segregated fit (TLSF) zone allocator.
+
+// Free blocks are binned into ZONE_FL_COUNT power of two ranges, each split into ZONE_SL_COUNT linear ranges,
+//		with a bitmap per level so a suitable free list can be found with a couple of bit scans.
+// Blocks carry boundary tags (prevPhysical pointer + free/prev free flags), so finding and coalescing
+//		physical neighbors on free is O(1) as well.
+//
+// Small blocks are also cached per thread on free, and handed straight back out on the next allocation of
+//		that size and tag from the same thread, without taking the zone mutex. Cached blocks stay allocated as
+//		far as the free lists are concerned. A block freed on a thread other than the one that allocated it is
+//		pushed onto the owner's lock-free remote free list, which the owner drains when it runs out of blocks.
+//
+// On Linux/Android the zone memory is an anonymous mapping, so untouched pages never get committed, and large
+//		free runs can have their pages handed back with madvise(MADV_DONTNEED) by Zone_Trim.
+//
+// Zone_TraceStart records every malloc/free/realloc to a binary trace, see bench/zonereplay.c for replaying them.
+
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
 #include <assert.h>
+#include <threads.h>
+#include <stdatomic.h>
+#include <time.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#if defined(LINUX)||defined(ANDROID)
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 #include "../system/system.h"
 #include "memzone.h"
 
-#define SIZE_MASK (((size_t)-1)>>1)
-#define SIZE_SHIFT (0)
+// Block size flags, sizes are always aligned, so the lower bits are free to use
+#define BLOCK_FREE_BIT ((size_t)1)
+#define BLOCK_PREVFREE_BIT ((size_t)2)
+#define BLOCK_GUARD_BIT ((size_t)4)
+
+// Free blocks never have guards, so on those the guard bit instead marks that the block's pages were already released
+#define BLOCK_RELEASED_BIT BLOCK_GUARD_BIT
+
+// Used blocks keep their allocation tag in the top byte of the size, block sizes never get anywhere near that large.
+// 32 bit builds don't have the spare bits, so everything is accounted as TAG_NONE there.
+// The byte below that holds the owning thread cache index+1, 0 if the block isn't owned by a thread cache.
+// The bit below that marks a freed block sitting in a thread cache, it's still a used block as far as the heap is concerned.
+#if SIZE_MAX>UINT32_MAX
+#define BLOCK_TAG_SHIFT 56
+#define BLOCK_TAG_MASK ((size_t)0xFF<<BLOCK_TAG_SHIFT)
+#define BLOCK_OWNER_SHIFT 48
+#define BLOCK_OWNER_MASK ((size_t)0xFF<<BLOCK_OWNER_SHIFT)
+#define BLOCK_CACHED_BIT ((size_t)1<<47)
+#else
+#define BLOCK_TAG_SHIFT 0
+#define BLOCK_TAG_MASK ((size_t)0)
+#define BLOCK_OWNER_SHIFT 0
+#define BLOCK_OWNER_MASK ((size_t)0)
+#define BLOCK_CACHED_BIT ((size_t)0)
+#endif
+
+#define BLOCK_FLAGS_MASK (BLOCK_FREE_BIT|BLOCK_PREVFREE_BIT|BLOCK_GUARD_BIT|BLOCK_TAG_MASK|BLOCK_OWNER_MASK|BLOCK_CACHED_BIT)
+#define BLOCK_SIZE_MASK (~BLOCK_FLAGS_MASK)
+
+// A used block only costs the size field, prevPhysical is stored at the end of the previous block
+#define BLOCK_OVERHEAD (sizeof(size_t))
+
+// Offset from block header to the user pointer
+#define BLOCK_START_OFFSET (offsetof(ZoneBlock_t, size)+sizeof(size_t))
+
+// Smallest payload needs to hold the free list pointers and the next block's prevPhysical
+#define BLOCK_SIZE_MIN (sizeof(ZoneBlock_t)-sizeof(ZoneBlock_t *))
+#define BLOCK_SIZE_MAX ((size_t)1<<ZONE_FL_MAX)
+
+// Bit scan helpers
+static inline uint32_t FindLastSet(size_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse64(&index, (unsigned __int64)value);
+	return (uint32_t)index;
+#else
+	return (uint32_t)(sizeof(unsigned long long)*8-1-__builtin_clzll((unsigned long long)value));
+#endif
+}
+
+static inline uint32_t FindFirstSet32(uint32_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return (uint32_t)index;
+#else
+	return (uint32_t)__builtin_ctz(value);
+#endif
+}
+
+static inline uint32_t FindFirstSet64(uint64_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return (uint32_t)index;
+#else
+	return (uint32_t)__builtin_ctzll(value);
+#endif
+}
+
+// Block header accessors
+static inline size_t BlockSize(const ZoneBlock_t *block)
+{
+	return block->size&BLOCK_SIZE_MASK;
+}
+
+static inline void BlockSetSize(ZoneBlock_t *block, const size_t size)
+{
+	block->size=size|(block->size&BLOCK_FLAGS_MASK);
+}
+
+static inline bool BlockIsLast(const ZoneBlock_t *block)
+{
+	return BlockSize(block)==0;
+}
+
+static inline bool BlockIsFree(const ZoneBlock_t *block)
+{
+	return (block->size&BLOCK_FREE_BIT)!=0;
+}
+
+// Freed, but held in a thread cache rather than the zone's free lists
+static inline bool BlockIsCached(const ZoneBlock_t *block)
+{
+	return (block->size&BLOCK_CACHED_BIT)!=0;
+}
+
+static inline bool BlockIsPrevFree(const ZoneBlock_t *block)
+{
+	return (block->size&BLOCK_PREVFREE_BIT)!=0;
+}
+
+static inline bool BlockIsGuarded(const ZoneBlock_t *block)
+{
+	return (block->size&BLOCK_GUARD_BIT)!=0;
+}
+
+static inline ZoneTag_e BlockTag(const ZoneBlock_t *block)
+{
+	return (ZoneTag_e)((block->size&BLOCK_TAG_MASK)>>BLOCK_TAG_SHIFT);
+}
+
+static inline void BlockSetTag(ZoneBlock_t *block, const ZoneTag_e tag)
+{
+	block->size=(block->size&~BLOCK_TAG_MASK)|(((size_t)tag<<BLOCK_TAG_SHIFT)&BLOCK_TAG_MASK);
+}
+
+static inline uint32_t BlockOwner(const ZoneBlock_t *block)
+{
+	return (uint32_t)((block->size&BLOCK_OWNER_MASK)>>BLOCK_OWNER_SHIFT);
+}
+
+static inline void BlockSetOwner(ZoneBlock_t *block, const uint32_t owner)
+{
+	block->size=(block->size&~BLOCK_OWNER_MASK)|(((size_t)owner<<BLOCK_OWNER_SHIFT)&BLOCK_OWNER_MASK);
+}
+
+static inline void *BlockToPtr(const ZoneBlock_t *block)
+{
+	return (void *)((uint8_t *)block+BLOCK_START_OFFSET);
+}
+
+static inline ZoneBlock_t *BlockFromPtr(const void *ptr)
+{
+	return (ZoneBlock_t *)((uint8_t *)ptr-BLOCK_START_OFFSET);
+}
+
+static inline ZoneBlock_t *BlockFirst(const MemZone_t *zone)
+{
+	return (ZoneBlock_t *)((uint8_t *)zone->memory-BLOCK_OVERHEAD);
+}
+
+static inline ZoneBlock_t *BlockNext(const ZoneBlock_t *block)
+{
+	return (ZoneBlock_t *)((uint8_t *)BlockToPtr(block)+BlockSize(block)-BLOCK_OVERHEAD);
+}
+
+// Get the next block and point it's boundary tag back at this block
+static inline ZoneBlock_t *BlockLinkNext(ZoneBlock_t *block)
+{
+	ZoneBlock_t *next=BlockNext(block);
+	next->prevPhysical=block;
+
+	return next;
+}
+
+static inline void BlockMarkFree(ZoneBlock_t *block)
+{
+	ZoneBlock_t *next=BlockLinkNext(block);
+
+	next->size|=BLOCK_PREVFREE_BIT;
+	block->size|=BLOCK_FREE_BIT;
+}
+
+static inline void BlockMarkUsed(ZoneBlock_t *block)
+{
+	ZoneBlock_t *next=BlockNext(block);
+
+	next->size&=~BLOCK_PREVFREE_BIT;
+	block->size&=~BLOCK_FREE_BIT;
+}
+
+// Write the trailing canary into the last bytes of a block's payload
+static inline void BlockSetGuard(ZoneBlock_t *block)
+{
+	const uint64_t guard=ZONE_GUARD_PATTERN;
+
+	block->size|=BLOCK_GUARD_BIT;
+	memcpy((uint8_t *)BlockToPtr(block)+BlockSize(block)-ZONE_GUARD_SIZE, &guard, ZONE_GUARD_SIZE);
+}
+
+static inline bool BlockCheckGuard(const ZoneBlock_t *block)
+{
+	uint64_t guard;
+
+	if(!BlockIsGuarded(block))
+		return true;
+
+	memcpy(&guard, (uint8_t *)BlockToPtr(block)+BlockSize(block)-ZONE_GUARD_SIZE, ZONE_GUARD_SIZE);
+
+	return guard==ZONE_GUARD_PATTERN;
+}
+
+// Payload bytes the user can touch, excluding the guard
+static inline size_t BlockUsableSize(const ZoneBlock_t *block)
+{
+	return BlockSize(block)-(BlockIsGuarded(block)?ZONE_GUARD_SIZE:0);
+}
+
+// Map a block size to first/second level indices
+static inline void MappingInsert(const size_t size, uint32_t *fl, uint32_t *sl)
+{
+	if(size<ZONE_SMALL_BLOCK_SIZE)
+	{
+		// Small blocks all go in the first list, linearly split
+		*fl=0;
+		*sl=(uint32_t)(size/(ZONE_SMALL_BLOCK_SIZE/ZONE_SL_COUNT));
+	}
+	else
+	{
+		const uint32_t last=FindLastSet(size);
+
+		*sl=(uint32_t)(size>>(last-ZONE_SL_LOG2))^(1U<<ZONE_SL_LOG2);
+		*fl=last-(ZONE_FL_SHIFT-1);
+	}
+}
+
+// Same as MappingInsert, but rounds up to the next list so any block found is large enough
+static inline void MappingSearch(size_t size, uint32_t *fl, uint32_t *sl)
+{
+	if(size>=ZONE_SMALL_BLOCK_SIZE)
+		size+=((size_t)1<<(FindLastSet(size)-ZONE_SL_LOG2))-1;
+
+	MappingInsert(size, fl, sl);
+}
+
+static ZoneBlock_t *SearchSuitableBlock(MemZone_t *zone, uint32_t *fl, uint32_t *sl)
+{
+	if(*fl>=ZONE_FL_COUNT)
+		return NULL;
+
+	// Search for a non-empty list at this first level index, at or above the second level index
+	uint32_t slMap=zone->slBitmap[*fl]&(~0U<<*sl);
+
+	if(!slMap)
+	{
+		// None there, try a larger first level index
+		const uint64_t flMap=zone->flBitmap&(~(uint64_t)0<<(*fl+1));
+
+		// Out of memory
+		if(!flMap)
+			return NULL;
+
+		*fl=FindFirstSet64(flMap);
+		slMap=zone->slBitmap[*fl];
+	}
+
+	*sl=FindFirstSet32(slMap);
+
+	return zone->freeBlocks[*fl][*sl];
+}
+
+static void RemoveFreeBlock(MemZone_t *zone, ZoneBlock_t *block, const uint32_t fl, const uint32_t sl)
+{
+	ZoneBlock_t *prev=block->prevFree;
+	ZoneBlock_t *next=block->nextFree;
+
+	if(next)
+		next->prevFree=prev;
+
+	if(prev)
+		prev->nextFree=next;
+
+	// If this block is the head of the list, set new head and clear bitmaps if the list is now empty
+	if(zone->freeBlocks[fl][sl]==block)
+	{
+		zone->freeBlocks[fl][sl]=next;
+
+		if(next==NULL)
+		{
+			zone->slBitmap[fl]&=~(1U<<sl);
+
+			if(!zone->slBitmap[fl])
+				zone->flBitmap&=~((uint64_t)1<<fl);
+		}
+	}
+}
+
+static void InsertFreeBlock(MemZone_t *zone, ZoneBlock_t *block, const uint32_t fl, const uint32_t sl)
+{
+	ZoneBlock_t *current=zone->freeBlocks[fl][sl];
+
+	block->nextFree=current;
+	block->prevFree=NULL;
+
+	if(current)
+		current->prevFree=block;
+
+	// Insert the new block at the head of the list and mark bitmaps
+	zone->freeBlocks[fl][sl]=block;
+	zone->flBitmap|=(uint64_t)1<<fl;
+	zone->slBitmap[fl]|=1U<<sl;
+}
+
+static inline void BlockRemove(MemZone_t *zone, ZoneBlock_t *block)
+{
+	uint32_t fl, sl;
+
+	MappingInsert(BlockSize(block), &fl, &sl);
+	RemoveFreeBlock(zone, block, fl, sl);
+}
+
+static inline void BlockInsert(MemZone_t *zone, ZoneBlock_t *block)
+{
+	uint32_t fl, sl;
+
+	MappingInsert(BlockSize(block), &fl, &sl);
+	InsertFreeBlock(zone, block, fl, sl);
+}
+
+static inline bool BlockCanSplit(const ZoneBlock_t *block, const size_t size)
+{
+	return BlockSize(block)>=sizeof(ZoneBlock_t)+size;
+}
+
+// Split a block in two, returns the remaining (free) block
+static ZoneBlock_t *BlockSplit(MemZone_t *zone, ZoneBlock_t *block, const size_t size)
+{
+	ZoneBlock_t *remaining=(ZoneBlock_t *)((uint8_t *)BlockToPtr(block)+size-BLOCK_OVERHEAD);
+	const size_t remainingSize=BlockSize(block)-(size+BLOCK_OVERHEAD);
+
+	remaining->size=remainingSize;
+	BlockSetSize(block, size);
+	BlockMarkFree(remaining);
+
+	zone->allocations++;
+
+	return remaining;
+}
+
+// Merge a block into the previous physical block
+static ZoneBlock_t *BlockAbsorb(MemZone_t *zone, ZoneBlock_t *prev, ZoneBlock_t *block)
+{
+	// Merged free block is only partly released now
+	if(BlockIsFree(prev))
+		prev->size&=~BLOCK_RELEASED_BIT;
+
+	prev->size+=BlockSize(block)+BLOCK_OVERHEAD;
+	BlockLinkNext(prev);
+
+	// Incremental verifier can't be left pointing at a block header that no longer exists
+	if(zone->verifyCursor==block)
+		zone->verifyCursor=prev;
+
+	zone->allocations--;
+
+	return prev;
+}
+
+static ZoneBlock_t *BlockMergePrev(MemZone_t *zone, ZoneBlock_t *block)
+{
+	if(BlockIsPrevFree(block))
+	{
+		ZoneBlock_t *prev=block->prevPhysical;
+
+		BlockRemove(zone, prev);
+		block=BlockAbsorb(zone, prev, block);
+	}
+
+	return block;
+}
+
+static ZoneBlock_t *BlockMergeNext(MemZone_t *zone, ZoneBlock_t *block)
+{
+	ZoneBlock_t *next=BlockNext(block);
+
+	if(BlockIsFree(next))
+	{
+		BlockRemove(zone, next);
+		block=BlockAbsorb(zone, block, next);
+	}
+
+	return block;
+}
+
+// Trim off any excess from a free block that's about to be used, put the remainder back in the free lists
+static void BlockTrimFree(MemZone_t *zone, ZoneBlock_t *block, const size_t size)
+{
+	if(BlockCanSplit(block, size))
+	{
+		ZoneBlock_t *remaining=BlockSplit(zone, block, size);
+
+		BlockLinkNext(block);
+		remaining->size|=BLOCK_PREVFREE_BIT;
+		BlockInsert(zone, remaining);
+	}
+}
+
+// Trim off any excess from a used block, merging the remainder with the next block if that's free
+static void BlockTrimUsed(MemZone_t *zone, ZoneBlock_t *block, const size_t size)
+{
+	if(BlockCanSplit(block, size))
+	{
+		ZoneBlock_t *remaining=BlockSplit(zone, block, size);
+
+		remaining->size&=~BLOCK_PREVFREE_BIT;
+		remaining=BlockMergeNext(zone, remaining);
+		BlockInsert(zone, remaining);
+	}
+}
+
+// Round requested size up to alignment and minimum block size, returns 0 for invalid sizes
+static inline size_t AdjustRequestSize(const size_t size)
+{
+	if(!size)
+		return 0;
+
+	const size_t aligned=(size+(ZONE_ALIGN-1))&~(size_t)(ZONE_ALIGN-1);
+
+	if(aligned>=BLOCK_SIZE_MAX)
+		return 0;
+
+	return aligned<BLOCK_SIZE_MIN?BLOCK_SIZE_MIN:aligned;
+}
+
+// Power of two size class for the allocation histogram
+static inline uint32_t SizeClass(const size_t size)
+{
+	const uint32_t sizeClass=size?FindLastSet(size):0;
+
+	return sizeClass<ZONE_HISTOGRAM_BUCKETS?sizeClass:ZONE_HISTOGRAM_BUCKETS-1;
+}
+
+static inline void UpdatePeak(atomic_size_t *peak, const size_t value)
+{
+	size_t current=atomic_load_explicit(peak, memory_order_relaxed);
+
+	while(value>current&&!atomic_compare_exchange_weak_explicit(peak, &current, value, memory_order_relaxed, memory_order_relaxed));
+}
+
+// Account a new allocation to the block's tag, these are all atomic so they don't need the mutex
+static void TagAlloc(MemZone_t *zone, const ZoneBlock_t *block, const size_t size)
+{
+	ZoneTagCounters_t *stats=&zone->tagStats[BlockTag(block)];
+	const size_t blockSize=BlockSize(block)+BLOCK_OVERHEAD;
+
+	UpdatePeak(&stats->peakBytes, atomic_fetch_add_explicit(&stats->liveBytes, blockSize, memory_order_relaxed)+blockSize);
+
+	atomic_fetch_add_explicit(&stats->liveAllocs, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&stats->totalAllocs, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&stats->frameAllocs, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&stats->histogram[SizeClass(size)], 1, memory_order_relaxed);
+}
+
+// Remove a block from it's tag's accounting
+static void TagFree(MemZone_t *zone, const ZoneBlock_t *block)
+{
+	ZoneTagCounters_t *stats=&zone->tagStats[BlockTag(block)];
+
+	atomic_fetch_sub_explicit(&stats->liveBytes, BlockSize(block)+BLOCK_OVERHEAD, memory_order_relaxed);
+	atomic_fetch_sub_explicit(&stats->liveAllocs, 1, memory_order_relaxed);
+}
+
+// Re-account a block that was resized in place
+static void TagResize(MemZone_t *zone, const ZoneBlock_t *block, const size_t oldSize)
+{
+	ZoneTagCounters_t *stats=&zone->tagStats[BlockTag(block)];
+	const size_t delta=BlockSize(block)-oldSize;
+
+	UpdatePeak(&stats->peakBytes, atomic_fetch_add_explicit(&stats->liveBytes, delta, memory_order_relaxed)+delta);
+}
+
+// Take the zone mutex, counting how often it was already held by another thread
+static inline void ZoneLock(MemZone_t *zone)
+{
+	if(mtx_trylock(&zone->mutex)!=thrd_success)
+	{
+		atomic_fetch_add_explicit(&zone->lockContended, 1, memory_order_relaxed);
+		mtx_lock(&zone->mutex);
+	}
+
+	zone->lockAcquires++;
+}
+
+// Mark a used block free, merge it with any free physical neighbors, and put the result back into the free lists, mutex must be held
+static void BlockRelease(MemZone_t *zone, ZoneBlock_t *block)
+{
+	block->size&=~(BLOCK_GUARD_BIT|BLOCK_TAG_MASK|BLOCK_OWNER_MASK|BLOCK_CACHED_BIT);
+
+	BlockMarkFree(block);
+	block=BlockMergePrev(zone, block);
+	block=BlockMergeNext(zone, block);
+	BlockInsert(zone, block);
+}
+
+#if ZONE_THREAD_CACHE
+// Cache slot the calling thread holds in each zone it's used, cache is NULL if the zone had no free slots
+typedef struct
+{
+	MemZone_t *zone;
+	ZoneThreadCache_t *cache;
+} ZoneThreadCacheRef_t;
+
+static thread_local ZoneThreadCacheRef_t threadCaches[ZONE_CACHE_MAX_ZONES];
+
+// Remote free list value while a cache slot has no owner, frees that see it go straight back to the zone
+#define CACHE_REMOTE_CLOSED ((ZoneBlock_t *)(uintptr_t)1)
+
+static ZoneThreadCacheRef_t *CacheFind(const MemZone_t *zone)
+{
+	for(uint32_t i=0;i<ZONE_CACHE_MAX_ZONES;i++)
+	{
+		if(threadCaches[i].zone==zone)
+			return &threadCaches[i];
+	}
+
+	return NULL;
+}
+
+// Calling thread's cache in this zone without claiming one, NULL if it doesn't have one
+static ZoneThreadCache_t *CacheCurrent(const MemZone_t *zone)
+{
+	const ZoneThreadCacheRef_t *ref=CacheFind(zone);
+
+	return ref?ref->cache:NULL;
+}
+
+// Get (or claim) the calling thread's cache, NULL if they're all taken or the thread is already using too many zones
+static ZoneThreadCache_t *CacheGet(MemZone_t *zone)
+{
+	ZoneThreadCacheRef_t *ref=CacheFind(zone);
+
+	if(ref)
+		return ref->cache;
+
+	ref=CacheFind(NULL);
+
+	if(ref==NULL)
+		return NULL;
+
+	ref->zone=zone;
+	ref->cache=NULL;
+
+	for(uint32_t i=0;i<ZONE_CACHE_MAX_THREADS;i++)
+	{
+		bool expected=false;
+
+		if(atomic_compare_exchange_strong(&zone->threadCaches[i].active, &expected, true))
+		{
+			ref->cache=&zone->threadCaches[i];
+
+			// Reopen the remote free list, it's closed from when the last owner released the slot (or NULL if it never had one)
+			atomic_store_explicit(&ref->cache->remoteFree, NULL, memory_order_release);
+			break;
+		}
+	}
+
+	return ref->cache;
+}
+
+// Bins hold blocks with at least (class+1)*ZONE_CACHE_CLASS_SIZE usable bytes
+static inline uint32_t CacheClass(const size_t usableSize)
+{
+	const size_t cacheClass=usableSize/ZONE_CACHE_CLASS_SIZE-1;
+
+	return cacheClass<ZONE_CACHE_CLASSES?(uint32_t)cacheClass:ZONE_CACHE_CLASSES-1;
+}
+
+// Add a block to this thread's bins, false if the bin or cache is full
+static bool CachePush(ZoneThreadCache_t *cache, ZoneBlock_t *block)
+{
+	const size_t usableSize=BlockUsableSize(block);
+
+	if(usableSize<ZONE_CACHE_CLASS_SIZE||usableSize>ZONE_CACHE_MAX_SIZE)
+		return false;
+
+	const ZoneTag_e tag=BlockTag(block);
+	const uint32_t cacheClass=CacheClass(usableSize);
+	const size_t blockSize=BlockSize(block)+BLOCK_OVERHEAD;
+	const size_t cachedBytes=atomic_load_explicit(&cache->cachedBytes, memory_order_relaxed);
+
+	if(cache->binCount[tag][cacheClass]>=ZONE_CACHE_MAX_BLOCKS||cachedBytes+blockSize>ZONE_CACHE_MAX_BYTES)
+		return false;
+
+	block->nextFree=cache->bins[tag][cacheClass];
+	cache->bins[tag][cacheClass]=block;
+	cache->binCount[tag][cacheClass]++;
+
+	atomic_store_explicit(&cache->cachedBytes, cachedBytes+blockSize, memory_order_relaxed);
+	atomic_store_explicit(&cache->cachedBlocks, atomic_load_explicit(&cache->cachedBlocks, memory_order_relaxed)+1, memory_order_relaxed);
+
+	return true;
+}
+
+// Move everything other threads have freed back into the bins, anything that doesn't fit goes back to the zone
+static void CacheDrainRemote(MemZone_t *zone, ZoneThreadCache_t *cache)
+{
+	ZoneBlock_t *block=atomic_exchange_explicit(&cache->remoteFree, NULL, memory_order_acquire);
+	ZoneBlock_t *overflow=NULL;
+
+	while(block)
+	{
+		ZoneBlock_t *next=block->nextFree;
+
+		if(!CachePush(cache, block))
+		{
+			block->nextFree=overflow;
+			overflow=block;
+		}
+
+		block=next;
+	}
+
+	if(overflow)
+	{
+		ZoneLock(zone);
+
+		while(overflow)
+		{
+			ZoneBlock_t *next=overflow->nextFree;
+			BlockRelease(zone, overflow);
+			overflow=next;
+		}
+
+		mtx_unlock(&zone->mutex);
+	}
+}
+
+// Find a cached block big enough for the (already adjusted) size
+static ZoneBlock_t *CachePop(MemZone_t *zone, ZoneThreadCache_t *cache, const ZoneTag_e tag, const size_t size)
+{
+	const uint32_t cacheClass=(uint32_t)((size+ZONE_CACHE_CLASS_SIZE-1)/ZONE_CACHE_CLASS_SIZE-1);
+
+	if(cache->bins[tag][cacheClass]==NULL&&atomic_load_explicit(&cache->remoteFree, memory_order_relaxed)!=NULL)
+		CacheDrainRemote(zone, cache);
+
+	ZoneBlock_t *block=cache->bins[tag][cacheClass];
+
+	if(block==NULL)
+		return NULL;
+
+	cache->bins[tag][cacheClass]=block->nextFree;
+	cache->binCount[tag][cacheClass]--;
+
+	block->size&=~BLOCK_CACHED_BIT;
+
+	atomic_store_explicit(&cache->cachedBytes, atomic_load_explicit(&cache->cachedBytes, memory_order_relaxed)-(BlockSize(block)+BLOCK_OVERHEAD), memory_order_relaxed);
+	atomic_store_explicit(&cache->cachedBlocks, atomic_load_explicit(&cache->cachedBlocks, memory_order_relaxed)-1, memory_order_relaxed);
+
+	return block;
+}
+
+// Try to hold on to a freed block instead of giving it back to the zone, either in this thread's cache or in it's owner's remote free list.
+// Blocks are marked cached before they go on either list, so a second free of the same pointer can be caught.
+static bool CacheFree(MemZone_t *zone, ZoneBlock_t *block)
+{
+	const uint32_t owner=BlockOwner(block);
+
+	if(!owner)
+		return false;
+
+	ZoneThreadCache_t *ownerCache=&zone->threadCaches[owner-1];
+
+	block->size|=BLOCK_CACHED_BIT;
+
+	// Anything not taken here goes back to the zone, which clears the mark
+	if(CacheCurrent(zone)==ownerCache)
+		return CachePush(ownerCache, block);
+
+	ZoneBlock_t *head=atomic_load_explicit(&ownerCache->remoteFree, memory_order_relaxed);
+
+	do
+	{
+		// Owner thread has released it's cache and nobody would drain it, caller gives it back to the zone instead.
+		// Checked in the same CAS loop as the push, so a free can't slip in after the owner has taken the list.
+		if(head==CACHE_REMOTE_CLOSED)
+			return false;
+
+		block->nextFree=head;
+	}
+	while(!atomic_compare_exchange_weak_explicit(&ownerCache->remoteFree, &head, block, memory_order_release, memory_order_relaxed));
+
+	atomic_fetch_add_explicit(&ownerCache->remoteFrees, 1, memory_order_relaxed);
+
+	return true;
+}
+#endif
+
+// Check a single block's bounds, boundary tags and guard, only touches the block and it's next neighbor.
+static bool VerifyBlock(const MemZone_t *zone, const ZoneBlock_t *block)
+{
+	const uint8_t *endZone=(uint8_t *)zone->memory+zone->size;
+	const ZoneBlock_t *nextBlock=BlockNext(block);
+
+	if((uint8_t *)block<(uint8_t *)BlockFirst(zone)||(uint8_t *)nextBlock+BLOCK_START_OFFSET>endZone)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Zone_Verify: Corrupted heap! Block (%p>%p) went out of range.\n", nextBlock, endZone);
+		return false;
+	}
+
+	if(BlockIsPrevFree(nextBlock)!=BlockIsFree(block))
+	{
+		DBGPRINTF(DEBUG_ERROR, "Zone_Verify: Corrupted heap! Block (%p) has mismatched previous free flag.\n", nextBlock);
+		return false;
+	}
+
+	if(BlockIsFree(block))
+	{
+		if(BlockIsPrevFree(block))
+		{
+			DBGPRINTF(DEBUG_ERROR, "Zone_Verify: Corrupted heap! Block (%p) wasn't merged with previous free block.\n", block);
+			return false;
+		}
+
+		if(nextBlock->prevPhysical!=block)
+		{
+			DBGPRINTF(DEBUG_ERROR, "Zone_Verify: Corrupted heap! Block (%p) has a bad boundary tag.\n", block);
+			return false;
+		}
+	}
+	else if(!BlockCheckGuard(block))
+	{
+		DBGPRINTF(DEBUG_ERROR, "Zone_Verify: Corrupted heap! Block (%p) guard overwritten.\n", block);
+		return false;
+	}
+
+	return true;
+}
+
+// Walk every block in the heap, mutex must be held
+static bool VerifyAll(const MemZone_t *zone)
+{
+	const ZoneBlock_t *block=BlockFirst(zone);
+
+	if(BlockIsPrevFree(block))
+	{
+		DBGPRINTF(DEBUG_ERROR, "Zone_Verify: Corrupted heap! First block has previous free flag set.\n");
+		return false;
+	}
+
+	for(size_t i=0;i<zone->allocations;i++)
+	{
+		if(!VerifyBlock(zone, block))
+			return false;
+
+		block=BlockNext(block);
+	}
+
+	if(!BlockIsLast(block))
+	{
+		DBGPRINTF(DEBUG_ERROR, "Zone_Verify: Corrupted heap! Block count mismatch.\n");
+		return false;
+	}
+
+	return true;
+}
+
+// Check the next verifyInterval blocks from where the last call left off, wrapping around at the end of the zone, mutex must be held
+static bool VerifySlice(MemZone_t *zone)
+{
+	for(uint32_t i=0;i<zone->verifyInterval;i++)
+	{
+		if(zone->verifyCursor==NULL||BlockIsLast(zone->verifyCursor))
+			zone->verifyCursor=BlockFirst(zone);
+
+		if(!VerifyBlock(zone, zone->verifyCursor))
+			return false;
+
+		zone->verifyCursor=BlockNext(zone->verifyCursor);
+	}
+
+	return true;
+}
+
+// Per-allocation check based on the current verify mode, mutex must be held
+static bool VerifyOnMalloc(MemZone_t *zone)
+{
+	switch(zone->verifyMode)
+	{
+		case ZONE_VERIFY_SAMPLED:
+			if(++zone->verifyCounter<zone->verifyInterval)
+				return true;
+
+			zone->verifyCounter=0;
+			return VerifyAll(zone);
+
+		case ZONE_VERIFY_INCREMENTAL:
+			return VerifySlice(zone);
+
+		case ZONE_VERIFY_FULL:
+			return VerifyAll(zone);
+
+		case ZONE_VERIFY_OFF:
+		default:
+			return true;
+	}
+}
+
+// Reserve the zone as an anonymous mapping, nothing is committed until it's touched.
+// Returns NULL if mapping isn't supported or fails, the caller falls back to malloc.
+static MemZone_t *ZoneMap(const size_t size)
+{
+#if defined(LINUX)||defined(ANDROID)
+	size_t pageSize=(size_t)sysconf(_SC_PAGESIZE);
+	size_t mappedSize=(size+ZONE_HUGEPAGE_SIZE-1)&~(size_t)(ZONE_HUGEPAGE_SIZE-1);
+	void *mapping=MAP_FAILED;
+
+#if ZONE_HUGEPAGES==2&&defined(MAP_HUGETLB)
+	// No MAP_NORESERVE here, so this fails up front instead of faulting later if there aren't enough huge pages reserved
+	mapping=mmap(NULL, mappedSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+
+	if(mapping!=MAP_FAILED)
+		pageSize=ZONE_HUGEPAGE_SIZE;
+	else
+		DBGPRINTF(DEBUG_WARNING, "Zone_Init: No huge pages available, falling back to transparent huge pages.\n");
+#endif
+
+	if(mapping==MAP_FAILED)
+	{
+		mapping=mmap(NULL, mappedSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+
+		if(mapping==MAP_FAILED)
+		{
+			DBGPRINTF(DEBUG_WARNING, "Zone_Init: Unable to map zone memory, falling back to malloc.\n");
+			return NULL;
+		}
+
+#if ZONE_HUGEPAGES>=1&&defined(MADV_HUGEPAGE)
+		// Only a hint, the kernel may not have THP enabled
+		madvise(mapping, mappedSize, MADV_HUGEPAGE);
+#endif
+	}
+
+	MemZone_t *zone=(MemZone_t *)mapping;
+
+	zone->mapped=true;
+	zone->mappedSize=mappedSize;
+	zone->pageSize=pageSize;
+
+	return zone;
+#else
+	return NULL;
+#endif
+}
+
+static void ZoneUnmap(MemZone_t *zone)
+{
+#if defined(LINUX)||defined(ANDROID)
+	if(zone->mapped)
+	{
+		munmap(zone, zone->mappedSize);
+		return;
+	}
+#endif
+
+	free(zone);
+}
+
+MemZone_t *Zone_Init(size_t size)
+{
+	if(size<sizeof(ZoneBlock_t)*2||size-2*BLOCK_OVERHEAD>=BLOCK_SIZE_MAX)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Zone_Init: Invalid zone size.\n");
+		return NULL;
+	}
+
+	// Allocate all the needed memory into the Zone structure pointer.
+	MemZone_t *zone=ZoneMap(size+sizeof(MemZone_t));
+
+	if(zone==NULL)
+	{
+		zone=(MemZone_t *)malloc(size+sizeof(MemZone_t));
+
+		if(zone==NULL)
+		{
+			DBGPRINTF(DEBUG_ERROR, "Zone_Init: Unable to allocate memory for zone.\n");
+			return NULL;
+		}
+
+		zone->mapped=false;
+		zone->mappedSize=0;
+		zone->pageSize=0;
+	}
+
+	zone->trimFrame=0;
+	zone->trimmedBytes=0;
+
+	// Set the memory pointer to the allocations to just off the end of Zone's structure.
+	zone->memory=(uint8_t *)zone+sizeof(MemZone_t);
+	zone->size=size;
+
+	// Clear free lists
+	zone->flBitmap=0;
+	memset(zone->slBitmap, 0, sizeof(zone->slBitmap));
+	memset(zone->freeBlocks, 0, sizeof(zone->freeBlocks));
+
+	// Set up initial free block, this block's prevPhysical sits just before the zone memory and is never used.
+	const size_t poolSize=(size-2*BLOCK_OVERHEAD)&~(size_t)(ZONE_ALIGN-1);
+	ZoneBlock_t *block=BlockFirst(zone);
+
+	block->size=poolSize|BLOCK_FREE_BIT;
+	BlockInsert(zone, block);
+
+	// Zero sized, used, sentinel block at the end, so merging never needs bounds checks.
+	ZoneBlock_t *sentinel=BlockLinkNext(block);
+	sentinel->size=BLOCK_PREVFREE_BIT;
+
+	zone->allocations=1;
+
+	zone->verifyMode=ZONE_VERIFY_DEFAULT_MODE;
+	zone->verifyFlags=ZONE_VERIFY_DEFAULT_FLAGS;
+	zone->verifyInterval=ZONE_VERIFY_DEFAULT_INTERVAL;
+	zone->verifyCounter=0;
+	zone->verifyCursor=NULL;
+
+	memset(zone->tagStats, 0, sizeof(zone->tagStats));
+	memset(zone->threadCaches, 0, sizeof(zone->threadCaches));
+
+	zone->lockAcquires=0;
+	atomic_init(&zone->lockContended, 0);
+
+	atomic_init(&zone->tracing, false);
+	zone->traceFile=NULL;
+	zone->traceBuffer=NULL;
+	zone->traceCount=0;
+	zone->traceStart=0;
+	zone->traceEvents=0;
+
+	// Create a mutex for thread safety
+	if(mtx_init(&zone->mutex, mtx_plain))
+	{
+		DBGPRINTF(DEBUG_ERROR, "Zone_Init: Unable to create mutex.\n");
+		ZoneUnmap(zone);
+		return NULL;
+	}
+
+	if(mtx_init(&zone->traceMutex, mtx_plain))
+	{
+		DBGPRINTF(DEBUG_ERROR, "Zone_Init: Unable to create trace mutex.\n");
+		mtx_destroy(&zone->mutex);
+		ZoneUnmap(zone);
+		return NULL;
+	}
+
+#ifdef _DEBUG
+	DBGPRINTF(DEBUG_INFO, "Zone_Init: Allocated at %p, size: %0.3fMB\n", zone, (float)size/1000.0f/1000.0f);
+#endif
+
+#ifdef ZONE_TRACE_FILE
+	Zone_TraceStart(zone, ZONE_TRACE_FILE);
+#endif
+
+	return zone;
+}
+
+void Zone_Destroy(MemZone_t *zone)
+{
+	if(zone)
+	{
+#if ZONE_THREAD_CACHE
+		ZoneThreadCacheRef_t *ref=CacheFind(zone);
+
+		if(ref)
+		{
+			ref->zone=NULL;
+			ref->cache=NULL;
+		}
+#endif
+
+		Zone_TraceStop(zone);
+
+		mtx_destroy(&zone->traceMutex);
+		mtx_destroy(&zone->mutex);
+		ZoneUnmap(zone);
+	}
+}
+
+#if ZONE_TRACE
+static atomic_uint traceThreads=0;
+static thread_local uint32_t traceThread=0;
+
+static uint64_t TraceTime(void)
+{
+	struct timespec ts;
+
+	timespec_get(&ts, TIME_UTC);
+
+	return (uint64_t)ts.tv_sec*1000000000ull+(uint64_t)ts.tv_nsec;
+}
+
+// Write out buffered events, traceMutex must be held
+static void TraceFlush(MemZone_t *zone)
+{
+	if(zone->traceCount&&fwrite(zone->traceBuffer, sizeof(ZoneTraceEvent_t), zone->traceCount, zone->traceFile)!=zone->traceCount)
+		DBGPRINTF(DEBUG_ERROR, "Zone_Trace: Unable to write trace events.\n");
+
+	zone->traceCount=0;
+}
+
+// Add an event to the trace, traceMutex must be held
+static void TraceRecord(MemZone_t *zone, const ZoneTraceOp_e op, const void *ptr, const void *oldPtr, const size_t size, const ZoneTag_e tag)
+{
+	// Tracing may have been stopped while waiting on the mutex
+	if(zone->traceFile==NULL)
+		return;
+
+	if(traceThread==0)
+		traceThread=atomic_fetch_add(&traceThreads, 1)+1;
+
+	ZoneTraceEvent_t *event=&zone->traceBuffer[zone->traceCount++];
+
+	event->time=TraceTime()-zone->traceStart;
+	event->ptr=(uint64_t)(uintptr_t)ptr;
+	event->oldPtr=(uint64_t)(uintptr_t)oldPtr;
+	event->size=size>UINT32_MAX?UINT32_MAX:(uint32_t)size;
+	event->thread=(uint16_t)(traceThread-1);
+	event->op=(uint8_t)op;
+	event->tag=(uint8_t)((uint32_t)tag<NUM_ZONE_TAGS?tag:TAG_NONE);
+
+	zone->traceEvents++;
+
+	if(zone->traceCount>=ZONE_TRACE_BUFFER)
+		TraceFlush(zone);
+}
+#endif
+
+static void ZoneFree(MemZone_t *zone, void *ptr);
+
+static void *ZoneMalloc(MemZone_t *zone, size_t size, ZoneTag_e tag)
+{
+	if(!zone)
+	{
+		DBGPRINTF(DEBUG_ERROR, "ZONE IS NULL.\n");
+		return NULL;
+	}
+
+	const bool guarded=(zone->verifyFlags&ZONE_VERIFY_GUARDS)!=0;
+	const size_t adjustedSize=AdjustRequestSize(size?size+(guarded?ZONE_GUARD_SIZE:0):0);
+
+	if(!adjustedSize)
+	{
+#ifdef _DEBUG
+		DBGPRINTF(DEBUG_WARNING, "Zone_Malloc: Attempted to allocate invalid size (%zu bytes)\n", size);
+#endif
+		return NULL;
+	}
+
+	if((uint32_t)tag>=NUM_ZONE_TAGS)
+		tag=TAG_NONE;
+
+	uint32_t owner=0;
+
+#if ZONE_THREAD_CACHE
+	if(adjustedSize<=ZONE_CACHE_MAX_SIZE)
+	{
+		ZoneThreadCache_t *cache=CacheGet(zone);
+
+		if(cache)
+		{
+			ZoneBlock_t *block=CachePop(zone, cache, tag, adjustedSize);
+
+			if(block)
+			{
+				atomic_store_explicit(&cache->hits, atomic_load_explicit(&cache->hits, memory_order_relaxed)+1, memory_order_relaxed);
+
+				TagAlloc(zone, block, size);
+
+				if(zone->verifyFlags&ZONE_VERIFY_FILL)
+					memset(BlockToPtr(block), ZONE_FILL_ALLOC, size);
+
+				return BlockToPtr(block);
+			}
+
+			atomic_store_explicit(&cache->misses, atomic_load_explicit(&cache->misses, memory_order_relaxed)+1, memory_order_relaxed);
+			owner=(uint32_t)(cache-zone->threadCaches)+1;
+		}
+	}
+#endif
+
+	ZoneLock(zone);
+
+	if(!VerifyOnMalloc(zone))
+	{
+		mtx_unlock(&zone->mutex);
+		return NULL;
+	}
+
+	// Find the free list that will hold a large enough block
+	uint32_t fl, sl;
+	MappingSearch(adjustedSize, &fl, &sl);
+
+	ZoneBlock_t *block=SearchSuitableBlock(zone, &fl, &sl);
+
+	if(block==NULL)
+	{
+		mtx_unlock(&zone->mutex);
+
+		DBGPRINTF(DEBUG_ERROR, "Zone_Malloc: Unable locate large enough free block (%0.3fKB).\n", (float)size/1000.0f);
+		return NULL;
+	}
+
+	// Pull it from the free list, split off what isn't needed and mark it used
+	RemoveFreeBlock(zone, block, fl, sl);
+	block->size&=~BLOCK_RELEASED_BIT;
+	BlockTrimFree(zone, block, adjustedSize);
+	BlockMarkUsed(block);
+
+	if(guarded)
+		BlockSetGuard(block);
+
+	BlockSetTag(block, tag);
+	BlockSetOwner(block, owner);
+
+	mtx_unlock(&zone->mutex);
+
+	TagAlloc(zone, block, size);
+
+	if(zone->verifyFlags&ZONE_VERIFY_FILL)
+		memset(BlockToPtr(block), ZONE_FILL_ALLOC, size);
+
+#ifdef _DEBUG
+	DBGPRINTF(DEBUG_WARNING, "Zone_Malloc: Allocated block, location: %p, size: %0.3fKB\n", block, (float)BlockSize(block)/1000.0f);
+#endif
+
+	return BlockToPtr(block);
+}
+
+void *Zone_Malloc(MemZone_t *zone, size_t size)
+{
+	return Zone_MallocTagged(zone, size, TAG_NONE);
+}
+
+void *Zone_MallocTagged(MemZone_t *zone, size_t size, ZoneTag_e tag)
+{
+	void *ptr=ZoneMalloc(zone, size, tag);
+
+#if ZONE_TRACE
+	if(ptr&&atomic_load_explicit(&zone->tracing, memory_order_relaxed))
+	{
+		mtx_lock(&zone->traceMutex);
+		TraceRecord(zone, ZONE_TRACE_MALLOC, ptr, NULL, size, tag);
+		mtx_unlock(&zone->traceMutex);
+	}
+#endif
+
+	return ptr;
+}
+
+void *Zone_Calloc(MemZone_t *zone, size_t size, size_t count)
+{
+	return Zone_CallocTagged(zone, size, count, TAG_NONE);
+}
+
+void *Zone_CallocTagged(MemZone_t *zone, size_t size, size_t count, ZoneTag_e tag)
+{
+	void *ptr=Zone_MallocTagged(zone, size*count, tag);
+
+	if(ptr)
+		memset(ptr, 0, size*count);
+
+	return ptr;
+}
+
+static void *ZoneRealloc(MemZone_t *zone, void *ptr, size_t size)
+{
+	// Input pointer is NULL, just do an allocation
+	if(!ptr)
+		return ZoneMalloc(zone, size, TAG_NONE);
+
+	// Size=0, free the block
+	if(!size)
+	{
+		ZoneFree(zone, ptr);
+		return NULL;
+	}
+
+	ZoneBlock_t *block=BlockFromPtr(ptr);
+
+	// Block being reallocated shouldn't be free
+	if(BlockIsFree(block)||BlockIsCached(block))
+	{
+		DBGPRINTF(DEBUG_ERROR, "Zone_Realloc: attempted to reallocate a free block.\n");
+		return NULL;
+	}
+
+	// Guarded blocks stay guarded, regardless of current verify flags
+	const bool guarded=BlockIsGuarded(block);
+	const size_t adjustedSize=AdjustRequestSize(size+(guarded?ZONE_GUARD_SIZE:0));
+
+	if(!adjustedSize)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Zone_Realloc: Invalid size (%zu bytes).\n", size);
+		return NULL;
+	}
+
+	if(!BlockCheckGuard(block))
+		DBGPRINTF(DEBUG_ERROR, "Zone_Realloc: Block (%p) guard overwritten.\n", block);
+
+	ZoneLock(zone);
+
+	const size_t currentSize=BlockSize(block);
+	const size_t usableSize=currentSize-(guarded?ZONE_GUARD_SIZE:0);
+	ZoneBlock_t *next=BlockNext(block);
+	const size_t combinedSize=currentSize+BlockSize(next)+BLOCK_OVERHEAD;
+
+	// Enlarging and there isn't an adjacent free block large enough, allocate a new block and copy original data.
+	if(adjustedSize>currentSize&&(!BlockIsFree(next)||adjustedSize>combinedSize))
+	{
+		mtx_unlock(&zone->mutex);
+
+		void *newPtr=ZoneMalloc(zone, size, BlockTag(block));
+
+		if(newPtr)
+		{
+			memcpy(newPtr, ptr, usableSize<size?usableSize:size);
+			ZoneFree(zone, ptr);
+		}
+
+#ifdef _DEBUG
+		DBGPRINTF(DEBUG_WARNING, "Zone_Realloc: Allocating new block (%p) and copying.\n", newPtr);
+#endif
+
+		return newPtr;
+	}
 
-#define FREE_MASK (~SIZE_MASK)
-#define FREE_SHIFT (sizeof(size_t)*8-1)
+	// Enlarging into the adjacent free block
+	if(adjustedSize>currentSize)
+	{
+		BlockMergeNext(zone, block);
+		BlockMarkUsed(block);
 
-MemZone_t *Zone_Init(size_t size)
-{
-	// Allocate all the needed memory into the Zone structure pointer.
-	MemZone_t *zone=(MemZone_t *)malloc(size+sizeof(MemZone_t));
+#ifdef _DEBUG
+		DBGPRINTF(DEBUG_WARNING, "Zone_Realloc: Enlarging block (%p) into adjacent free block.\n", ptr);
+#endif
+	}
 
-	if(zone==NULL)
+	// Give back anything that's left over, either from shrinking or from the merge above
+	BlockTrimUsed(zone, block, adjustedSize);
+
+	if(guarded)
+		BlockSetGuard(block);
+
+	TagResize(zone, block, currentSize);
+
+	mtx_unlock(&zone->mutex);
+
+	if((zone->verifyFlags&ZONE_VERIFY_FILL)&&size>usableSize)
+		memset((uint8_t *)ptr+usableSize, ZONE_FILL_ALLOC, size-usableSize);
+
+	return ptr;
+}
+
+void *Zone_Realloc(MemZone_t *zone, void *ptr, size_t size)
+{
+#if ZONE_TRACE
+	// Trace mutex is held across the whole realloc, so another thread can't reuse the old block and record that first
+	if(zone&&atomic_load_explicit(&zone->tracing, memory_order_relaxed))
 	{
-		DBGPRINTF(DEBUG_ERROR, "Zone_Init: Unable to allocate memory for zone.\n");
-		return NULL;
+		mtx_lock(&zone->traceMutex);
+
+		const ZoneTag_e tag=ptr?BlockTag(BlockFromPtr(ptr)):TAG_NONE;
+		void *newPtr=ZoneRealloc(zone, ptr, size);
+
+		// A failed realloc leaves the old block alone
+		if(newPtr||!size)
+			TraceRecord(zone, ZONE_TRACE_REALLOC, newPtr, ptr, size, tag);
+
+		mtx_unlock(&zone->traceMutex);
+
+		return newPtr;
 	}
+#endif
 
-	// Set the memory pointer to the allocations to just off the end of Zone's structure.
-	zone->memory=(uint8_t *)zone+sizeof(MemZone_t);
+	return ZoneRealloc(zone, ptr, size);
+}
 
-	// Set up initial free block header.
-	size_t *header=zone->memory;
-	*header=FREE_MASK|(size&SIZE_MASK);
+static void ZoneFree(MemZone_t *zone, void *ptr)
+{
+	if(ptr==NULL)
+	{
+#ifdef _DEBUG
+		DBGPRINTF(DEBUG_ERROR, "Zone_Free: Attempted to free NULL pointer.\n");
+#endif
+		return;
+	}
 
-	zone->allocations=1;
-	zone->size=size;
+	ZoneBlock_t *block=BlockFromPtr(ptr);
 
-	// Create a mutex for thread safety
-	if(mtx_init(&zone->mutex, mtx_plain))
+	// Cached blocks are just as freed, they're only not back in the zone yet
+	if(BlockIsFree(block)||BlockIsCached(block))
 	{
-		DBGPRINTF(DEBUG_ERROR, "Zone_Init: Unable to create mutex.\n");
-		return false;
+#ifdef _DEBUG
+		DBGPRINTF(DEBUG_ERROR, "Zone_Free: Attempted to free already freed pointer.\n");
+#endif
+		return;
 	}
 
 #ifdef _DEBUG
-	DBGPRINTF(DEBUG_INFO, "Zone_Init: Allocated at %p, size: %0.3fMB\n", zone, (float)size/1000.0f/1000.0f);
+	DBGPRINTF(DEBUG_WARNING, "Zone_Free: Freed block, location: %p, size: %0.3fKB\n", block, (float)BlockSize(block)/1000.0f);
 #endif
 
-	return zone;
+	const bool guardIntact=BlockCheckGuard(block);
+
+	if(!guardIntact)
+		DBGPRINTF(DEBUG_ERROR, "Zone_Free: Block (%p) guard overwritten.\n", block);
+
+	// Fill before marking it free, the free list pointers and boundary tag go in after.
+	// The guard is left alone, cached blocks are still checked by the verifier.
+	if(zone->verifyFlags&ZONE_VERIFY_FILL)
+		memset(ptr, ZONE_FILL_FREE, BlockUsableSize(block));
+
+	TagFree(zone, block);
+
+#if ZONE_THREAD_CACHE
+	// Corrupted blocks go straight back to the zone rather than being handed out again
+	if(guardIntact&&CacheFree(zone, block))
+		return;
+#endif
+
+	ZoneLock(zone);
+	BlockRelease(zone, block);
+	mtx_unlock(&zone->mutex);
 }
 
-void Zone_Destroy(MemZone_t *zone)
+void Zone_Free(MemZone_t *zone, void *ptr)
 {
-	if(zone)
-		free(zone);
+#if ZONE_TRACE
+	// Recorded before the block is released, so it's always ahead of anything that reuses the address
+	if(zone&&ptr&&atomic_load_explicit(&zone->tracing, memory_order_relaxed))
+	{
+		mtx_lock(&zone->traceMutex);
+		TraceRecord(zone, ZONE_TRACE_FREE, ptr, NULL, 0, BlockTag(BlockFromPtr(ptr)));
+		mtx_unlock(&zone->traceMutex);
+	}
+#endif
+
+	ZoneFree(zone, ptr);
 }
 
-void *Zone_Malloc(MemZone_t *zone, size_t size)
+// Give all of the calling thread's cached blocks back to the zone and release it's cache slot.
+// Threads that allocate from the zone should call this before exiting, thread workers do it automatically for the global zone.
+// A thread holds a separate cache in each zone it allocates from, each one is released on it's own.
+void Zone_ReleaseThreadCache(MemZone_t *zone)
 {
-	if(!Zone_VerifyHeap(zone))
-		return NULL;
+#if ZONE_THREAD_CACHE
+	if(!zone)
+		return;
 
-	size+=sizeof(size_t);	// Block header
-	size=(size+7)&~7;		// Align to 8-byte boundary
+	ZoneThreadCacheRef_t *ref=CacheFind(zone);
 
-	if(size==sizeof(size_t))
+	if(ref==NULL)
+		return;
+
+	ZoneThreadCache_t *cache=ref->cache;
+
+	// Never got a slot, just free up the entry
+	if(cache==NULL)
 	{
-#ifdef _DEBUG
-		DBGPRINTF(DEBUG_WARNING, "Zone_Malloc: Attempted to allocate 0 bytes\n");
-#endif
-		return NULL;
+		ref->zone=NULL;
+		return;
 	}
 
-	mtx_lock(&zone->mutex);
+	// Close the remote free list and pick up anything that was already queued, any frees after this go straight to the zone
+	ZoneBlock_t *remote=atomic_exchange_explicit(&cache->remoteFree, CACHE_REMOTE_CLOSED, memory_order_acq_rel);
 
-	// Search for free blocks
-	size_t *block=zone->memory;
+	ZoneLock(zone);
 
-	for(size_t i=0;i<zone->allocations;i++)
+	while(remote)
 	{
-		bool isFree=((*block&FREE_MASK)>>FREE_SHIFT)==true;
-		size_t blockSize=*block&SIZE_MASK;
+		ZoneBlock_t *next=remote->nextFree;
+		BlockRelease(zone, remote);
+		remote=next;
+	}
 
-		// Is block free and large enough?
-		if(isFree&&size<=blockSize)
+	for(uint32_t i=0;i<NUM_ZONE_TAGS;i++)
+	{
+		for(uint32_t j=0;j<ZONE_CACHE_CLASSES;j++)
 		{
-			size_t newFreeSize=blockSize-size;
+			ZoneBlock_t *block=cache->bins[i][j];
 
-			// Set the new location and header for free block, only if we haven't consumed entire block
-			if(size<blockSize&&newFreeSize>sizeof(size_t))
+			while(block)
 			{
-				size_t *newBlock=(size_t *)((uint8_t *)block+size);
-				*newBlock=FREE_MASK|(newFreeSize&SIZE_MASK);
-
-				zone->allocations++;
+				ZoneBlock_t *next=block->nextFree;
+				BlockRelease(zone, block);
+				block=next;
 			}
-			else
-				size+=newFreeSize; // Consume the remainder of the block
-
-			// Set the new block size
-			*block=size&SIZE_MASK;
 
-			mtx_unlock(&zone->mutex);
-
-#ifdef _DEBUG
-			DBGPRINTF(DEBUG_WARNING, "Zone_Malloc: Allocated block, location: %p, size: %0.3fKB\n", block, (float)(size-sizeof(size_t))/1000.0f);
-#endif
-			return (void *)((uint8_t *)block+sizeof(size_t));
+			cache->bins[i][j]=NULL;
+			cache->binCount[i][j]=0;
 		}
-
-		block=(size_t *)((uint8_t *)block+blockSize);
 	}
 
 	mtx_unlock(&zone->mutex);
 
-	DBGPRINTF(DEBUG_ERROR, "Zone_Malloc: Unable locate large enough free block (%0.3fKB).\n", (float)(size-sizeof(size_t))/1000.0f);
-	return NULL;
+	atomic_store(&cache->cachedBytes, 0);
+	atomic_store(&cache->cachedBlocks, 0);
+
+	// Slot can only be claimed again once it's empty and closed
+	atomic_store(&cache->active, false);
+
+	ref->zone=NULL;
+	ref->cache=NULL;
+#else
+	(void)zone;
+#endif
 }
 
-void *Zone_Calloc(MemZone_t *zone, size_t size, size_t count)
+// Set heap integrity checking mode, interval is allocations per full walk for sampled mode, or blocks per step for incremental mode.
+// Flags only apply to allocations made after this call.
+void Zone_SetVerifyMode(MemZone_t *zone, ZoneVerifyMode_e mode, uint32_t interval, uint32_t flags)
 {
-	void *ptr=Zone_Malloc(zone, size*count);
+	if(!zone)
+		return;
 
-	if(ptr)
-		memset(ptr, 0, size*count);
+	ZoneLock(zone);
 
-	return ptr;
+	zone->verifyMode=mode;
+	zone->verifyFlags=flags;
+	zone->verifyInterval=interval?interval:1;
+	zone->verifyCounter=0;
+
+	mtx_unlock(&zone->mutex);
 }
 
-void *Zone_Realloc(MemZone_t *zone, void *ptr, size_t size)
+// Check a slice of the heap when in incremental mode, meant to be called once per frame
+bool Zone_VerifyStep(MemZone_t *zone)
 {
-	// Input pointer is NULL, just do an allocation
-	if(!ptr)
-		return Zone_Malloc(zone, size);
+	if(!zone)
+	{
+		DBGPRINTF(DEBUG_ERROR, "ZONE IS NULL.\n");
+		return false;
+	}
 
-	size_t *block=(size_t *)((uint8_t *)ptr-sizeof(size_t));
-	size_t currentSize=*block&SIZE_MASK;
-	bool isFree=((*block&FREE_MASK)>>FREE_SHIFT)==true;
+	if(zone->verifyMode!=ZONE_VERIFY_INCREMENTAL)
+		return true;
 
-	// Block being reallocated shouldn't be free
-	if(isFree)
+	ZoneLock(zone);
+	bool result=VerifySlice(zone);
+	mtx_unlock(&zone->mutex);
+
+	return result;
+}
+
+// Walk all the blocks in the heap and verify that none go out of bounds, boundary tags are consistent and guards are intact
+bool Zone_VerifyHeap(MemZone_t *zone)
+{
+	if(!zone)
 	{
-		DBGPRINTF(DEBUG_ERROR, "Zone_Realloc: attempted to reallocate a free block.\n");
-		return NULL;
+		DBGPRINTF(DEBUG_ERROR, "ZONE IS NULL.\n");
+		return false;
 	}
 
-	size+=sizeof(size_t);	// Block header
-	size=(size+7)&~7;		// Align to 8-byte boundary
+	ZoneLock(zone);
+	bool result=VerifyAll(zone);
+	mtx_unlock(&zone->mutex);
+
+	return result;
+}
+
+// Roll over the per-frame allocation counters, meant to be called once per frame
+void Zone_NextFrame(MemZone_t *zone)
+{
+	if(!zone)
+		return;
 
-	if(size==sizeof(size_t))
+	for(uint32_t i=0;i<NUM_ZONE_TAGS;i++)
 	{
-		// Size=0, free the block
-		Zone_Free(zone, ptr);
-		return NULL;
+		ZoneTagCounters_t *stats=&zone->tagStats[i];
+		const uint32_t frameAllocs=atomic_exchange_explicit(&stats->frameAllocs, 0, memory_order_relaxed);
+
+		if(frameAllocs>atomic_load_explicit(&stats->peakFrameAllocs, memory_order_relaxed))
+			atomic_store_explicit(&stats->peakFrameAllocs, frameAllocs, memory_order_relaxed);
+
+		atomic_store_explicit(&stats->lastFrameAllocs, frameAllocs, memory_order_relaxed);
 	}
-	else if(size<=currentSize)
-	{
-		// Shrinking Block:
 
-		// If the sizes are equal, just bail.
-		if(size==currentSize)
-		{
-#ifdef _DEBUG
-			DBGPRINTF(DEBUG_WARNING, "Zone_Realloc: Location: %p, new size (%0.3fKB) == old size (%0.3fKB).\n", ptr, (float)size/1000.0f, (float)currentSize/1000.0f);
+#if ZONE_TRIM_THRESHOLD
+	if(++zone->trimFrame>=ZONE_TRIM_INTERVAL)
+	{
+		zone->trimFrame=0;
+		Zone_Trim(zone, ZONE_TRIM_THRESHOLD);
+	}
 #endif
-			return ptr;
-		}
+}
 
-		mtx_lock(&zone->mutex);
+// Give the pages of free blocks at least threshold bytes back to the OS, returns the number of bytes released.
+// Released pages read back as zero and get committed again the next time they're touched.
+// Only the page aligned interior of each block is released, the free list links and boundary tags stay resident.
+size_t Zone_Trim(MemZone_t *zone, size_t threshold)
+{
+	if(!zone)
+		return 0;
 
-		// Otherwise, if there is a free block after, expand that block otherwise, create a new free block if possible.
-#ifdef _DEBUG
-		DBGPRINTF(DEBUG_WARNING, "Zone_Realloc: Location: %p, new size (%0.3fKB) < old size (%0.3fKB).\n", ptr, (float)size/1000.0f, (float)currentSize/1000.0f);
-#endif
-		size_t *nextBlock=(size_t *)((uint8_t *)block+currentSize);
-		size_t nextSize=*nextBlock&SIZE_MASK;
-		bool nextIsFree=((*nextBlock&FREE_MASK)>>FREE_SHIFT)==true;
+	size_t released=0;
 
-		// Check if nextBlock is a free block.
-		if(nextBlock&&nextIsFree)
-		{
-			// Calculate the total new free size.
-			size_t freeSize=currentSize-size+nextSize;
+#if defined(LINUX)||defined(ANDROID)
+	if(!zone->mapped)
+		return 0;
 
-			// Resize the Block's size to the new size.
-			*block=size&SIZE_MASK;
+	const uintptr_t pageMask=(uintptr_t)zone->pageSize-1;
 
-			// Create a new block at the end of Block's new size.
-			size_t *newBlock=(size_t *)((uint8_t *)block+size);
-			*newBlock=FREE_MASK|(freeSize&SIZE_MASK);
+	if(threshold<zone->pageSize)
+		threshold=zone->pageSize;
 
-#ifdef _DEBUG
-			DBGPRINTF(DEBUG_WARNING, "Zone_Realloc: Free block merge.\n");
-#endif
-		}
-		else
+	ZoneLock(zone);
+
+	// Anything in a lower first level list is too small
+	uint32_t fl, sl;
+	MappingInsert(threshold, &fl, &sl);
+
+	uint64_t flMap=fl<64?zone->flBitmap&(~(uint64_t)0<<fl):0;
+
+	while(flMap)
+	{
+		fl=FindFirstSet64(flMap);
+		uint32_t slMap=zone->slBitmap[fl];
+
+		while(slMap)
 		{
-			// If there isn't a free nextBlock, insert a free block in the size of the remaining size.
-			// But only if the new size is enough to also fit a block header in it's place.
-			size_t freeSize=currentSize-size;
+			sl=FindFirstSet32(slMap);
 
-			if(freeSize>sizeof(size_t))
+			for(ZoneBlock_t *block=zone->freeBlocks[fl][sl];block;block=block->nextFree)
 			{
-				// Resize the original block's size to the new size.
-				*block=size&SIZE_MASK;
+				if(BlockSize(block)<threshold||(block->size&BLOCK_RELEASED_BIT))
+					continue;
+
+				const uintptr_t start=((uintptr_t)&block->prevFree+sizeof(ZoneBlock_t *)+pageMask)&~pageMask;
+				const uintptr_t end=(uintptr_t)BlockNext(block)&~pageMask;
+
+				if(end>start&&!madvise((void *)start, end-start, MADV_DONTNEED))
+				{
+					released+=end-start;
+					block->size|=BLOCK_RELEASED_BIT;
+				}
+			}
 
-				// Create a newBlock at the end of Block's new size.
-				size_t *newBlock=(size_t *)((uint8_t *)block+size);
-				*newBlock=FREE_MASK|(freeSize&SIZE_MASK);
+			slMap&=slMap-1;
+		}
+
+		flMap&=flMap-1;
+	}
+
+	zone->trimmedBytes+=released;
 
-				zone->allocations++;
+	mtx_unlock(&zone->mutex);
 
 #ifdef _DEBUG
-				DBGPRINTF(DEBUG_WARNING, "Zone_Realloc: Free block insert.\n");
+	if(released)
+		DBGPRINTF(DEBUG_INFO, "Zone_Trim: Released %0.3fMB.\n", (float)released/1000.0f/1000.0f);
+#endif
 #endif
-			}
-		}
 
-		mtx_unlock(&zone->mutex);
+	return released;
+}
+
+// Start recording every malloc/free/realloc to a trace file
+bool Zone_TraceStart(MemZone_t *zone, const char *filename)
+{
+#if ZONE_TRACE
+	if(!zone||!filename)
+		return false;
+
+	mtx_lock(&zone->traceMutex);
 
-		// Return the adjusted block's address after adjusting free blocks.
-		return ptr;
+	if(zone->traceFile)
+	{
+		mtx_unlock(&zone->traceMutex);
+		DBGPRINTF(DEBUG_ERROR, "Zone_TraceStart: Already tracing.\n");
+		return false;
 	}
-	else
+
+	FILE *file=fopen(filename, "wb");
+
+	if(file==NULL)
 	{
-		// Enlarging block:
+		mtx_unlock(&zone->traceMutex);
+		DBGPRINTF(DEBUG_ERROR, "Zone_TraceStart: Unable to open trace file %s.\n", filename);
+		return false;
+	}
 
-		size_t *nextBlock=(size_t *)((uint8_t *)block+currentSize);
-		size_t nextSize=*nextBlock&SIZE_MASK;
-		bool nextIsFree=((*nextBlock&FREE_MASK)>>FREE_SHIFT)==true;
+	// Not from the zone, so tracing doesn't change what's being traced
+	zone->traceBuffer=(ZoneTraceEvent_t *)malloc(sizeof(ZoneTraceEvent_t)*ZONE_TRACE_BUFFER);
 
-		// If there is an adjacent free block.
-		if(nextBlock&&nextIsFree)
-		{
-			// Calculate total size of this block and the free block.
-			size_t totalSize=currentSize+nextSize;
+	ZoneTraceHeader_t header=
+	{
+		.magic=ZONE_TRACE_MAGIC,
+		.version=ZONE_TRACE_VERSION,
+		.eventSize=sizeof(ZoneTraceEvent_t),
+		.padding=0,
+		.zoneSize=zone->size
+	};
+
+	if(zone->traceBuffer==NULL||fwrite(&header, sizeof(ZoneTraceHeader_t), 1, file)!=1)
+	{
+		free(zone->traceBuffer);
+		zone->traceBuffer=NULL;
+		fclose(file);
+		mtx_unlock(&zone->traceMutex);
+		DBGPRINTF(DEBUG_ERROR, "Zone_TraceStart: Unable to start trace.\n");
+		return false;
+	}
 
-			// If it is large enough to expand this block into.
-			if(size<=totalSize)
-			{
-				size_t freeSize=totalSize-size;
+	zone->traceFile=file;
+	zone->traceCount=0;
+	zone->traceEvents=0;
+	zone->traceStart=TraceTime();
 
-				mtx_lock(&zone->mutex);
+	atomic_store(&zone->tracing, true);
 
-				// Free size must be larger than the header in order to split a free block,
-				//     otherwise consume the whole block.
-				if(freeSize>sizeof(size_t))
-				{
-					size_t *newBlock=(size_t *)((uint8_t *)block+size);
-					*newBlock=FREE_MASK|(freeSize&SIZE_MASK);
+	mtx_unlock(&zone->traceMutex);
 
-					*block=size&SIZE_MASK;
+	DBGPRINTF(DEBUG_INFO, "Zone_TraceStart: Tracing allocations to %s\n", filename);
 
-#ifdef _DEBUG
-					DBGPRINTF(DEBUG_WARNING, "Zone_Realloc: Enlarging block (%p) into adjacent free block.\n", ptr);
+	return true;
+#else
+	DBGPRINTF(DEBUG_ERROR, "Zone_TraceStart: Tracing isn't enabled (ZONE_TRACE=0).\n");
+	return false;
 #endif
-				}
-				else
-				{
-					*block=totalSize&SIZE_MASK;
+}
 
-#ifdef _DEBUG
-					DBGPRINTF(DEBUG_WARNING, "Zone_Realloc: Enlarging block (%p), consuming free block.\n", ptr);
-#endif
-				}
+void Zone_TraceStop(MemZone_t *zone)
+{
+#if ZONE_TRACE
+	if(!zone)
+		return;
 
-				mtx_unlock(&zone->mutex);
+	atomic_store(&zone->tracing, false);
 
-				return ptr;
-			}
-		}
+	mtx_lock(&zone->traceMutex);
 
-		// If there isn't a a free block to use, just allocate a new block and copy original data.
-		void *newBlock=Zone_Malloc(zone, size);
+	if(zone->traceFile)
+	{
+		TraceFlush(zone);
+		fclose(zone->traceFile);
 
-		if(newBlock)
-		{
-			memcpy(newBlock, ptr, currentSize);
-			Zone_Free(zone, ptr);
-		}
+		free(zone->traceBuffer);
 
-#ifdef _DEBUG
-		DBGPRINTF(DEBUG_WARNING, "Zone_Realloc: Allocating new block (%p) and copying.\n", newBlock);
-#endif
+		zone->traceFile=NULL;
+		zone->traceBuffer=NULL;
 
-		return newBlock;
+		DBGPRINTF(DEBUG_INFO, "Zone_TraceStop: Recorded %zu events.\n", zone->traceEvents);
 	}
+
+	mtx_unlock(&zone->traceMutex);
+#endif
 }
 
-void Zone_Free(MemZone_t *zone, void *ptr)
+const char *Zone_GetTagName(ZoneTag_e tag)
 {
-	if(ptr==NULL)
+	static const char *tagNames[NUM_ZONE_TAGS]=
 	{
-#ifdef _DEBUG
-		DBGPRINTF(DEBUG_ERROR, "Zone_Free: Attempted to free NULL pointer.\n");
-#endif
-		return;
-	}
+		"None",
+		"System",
+		"Vulkan",
+		"VR",
+		"UI",
+		"Font",
+		"Image",
+		"Model",
+		"Audio",
+		"Physics",
+		"Camera",
+		"Utils",
+	};
+
+	if((uint32_t)tag>=NUM_ZONE_TAGS)
+		return "Invalid";
+
+	return tagNames[tag];
+}
 
-	size_t *block=(size_t *)((uint8_t *)ptr-sizeof(size_t));
+bool Zone_GetTagStats(MemZone_t *zone, ZoneTag_e tag, ZoneTagStats_t *stats)
+{
+	if(!zone||!stats||(uint32_t)tag>=NUM_ZONE_TAGS)
+		return false;
 
-	bool isFree=((*block&FREE_MASK)>>FREE_SHIFT)==true;
-	size_t blockSize=*block&SIZE_MASK;
+	const ZoneTagCounters_t *counters=&zone->tagStats[tag];
 
-	if(isFree)
-	{
-#ifdef _DEBUG
-		DBGPRINTF(DEBUG_ERROR, "Zone_Free: Attempted to free already freed pointer.\n");
-#endif
-		return;
-	}
+	stats->liveBytes=atomic_load_explicit(&counters->liveBytes, memory_order_relaxed);
+	stats->peakBytes=atomic_load_explicit(&counters->peakBytes, memory_order_relaxed);
+	stats->liveAllocs=atomic_load_explicit(&counters->liveAllocs, memory_order_relaxed);
+	stats->totalAllocs=atomic_load_explicit(&counters->totalAllocs, memory_order_relaxed);
+	stats->frameAllocs=atomic_load_explicit(&counters->frameAllocs, memory_order_relaxed);
+	stats->lastFrameAllocs=atomic_load_explicit(&counters->lastFrameAllocs, memory_order_relaxed);
+	stats->peakFrameAllocs=atomic_load_explicit(&counters->peakFrameAllocs, memory_order_relaxed);
 
-#ifdef _DEBUG
-	DBGPRINTF(DEBUG_WARNING, "Zone_Free: Freed block, location: %p, size: %0.3fKB\n", block, (float)(blockSize-sizeof(size_t))/1000.0f);
-#endif
+	for(uint32_t i=0;i<ZONE_HISTOGRAM_BUCKETS;i++)
+		stats->histogram[i]=atomic_load_explicit(&counters->histogram[i], memory_order_relaxed);
+
+	return true;
+}
 
-	mtx_lock(&zone->mutex);
+// Overall usage and fragmentation, walks the free lists so it's cheap enough to call at runtime but not per allocation
+bool Zone_GetStats(MemZone_t *zone, ZoneStats_t *stats)
+{
+	if(!zone||!stats)
+		return false;
 
-	// Freeing a block is as simple as setting it to free.
-	*block|=FREE_MASK;
+	memset(stats, 0, sizeof(ZoneStats_t));
 
-	// Check previous and next blocks to see if either are free blocks,
-	//     if they are, merge them all into one large free block.
-	size_t *nextBlock=(size_t *)((uint8_t *)block+blockSize);
-	bool isNextFree=((*nextBlock&FREE_MASK)>>FREE_SHIFT)==true;
+	for(uint32_t i=0;i<NUM_ZONE_TAGS;i++)
+		stats->usedBytes+=atomic_load_explicit(&zone->tagStats[i].liveBytes, memory_order_relaxed);
 
-	// If next is valid and free, enlarge Block by nextBlock's size
-	//     and decrement allocations (removes next).
-	if(nextBlock&&isNextFree)
+	for(uint32_t i=0;i<ZONE_CACHE_MAX_THREADS;i++)
 	{
-		blockSize+=*nextBlock&SIZE_MASK;
-		*block=FREE_MASK|(blockSize&SIZE_MASK);
+		const ZoneThreadCache_t *cache=&zone->threadCaches[i];
 
-		zone->allocations--;
+		stats->cachedBytes+=atomic_load_explicit(&cache->cachedBytes, memory_order_relaxed);
+		stats->cachedBlocks+=atomic_load_explicit(&cache->cachedBlocks, memory_order_relaxed);
+		stats->cacheHits+=atomic_load_explicit(&cache->hits, memory_order_relaxed);
+		stats->cacheMisses+=atomic_load_explicit(&cache->misses, memory_order_relaxed);
+		stats->remoteFrees+=atomic_load_explicit(&cache->remoteFrees, memory_order_relaxed);
 	}
 
-	// Search for the previous block.
-	//
-	// TODO: Change this to use "previous pointers" or offsets to the previous block,
-	//     so this doesn't have to iterate over the list. It's not exactly slow, but can be avoided.
-	size_t *prevBlock=NULL;
-	size_t *currentBlock=zone->memory;
+	stats->lockContended=atomic_load_explicit(&zone->lockContended, memory_order_relaxed);
 
-	for(size_t i=0;i<zone->allocations;i++)
-	{
-		size_t currentSize=*currentBlock&SIZE_MASK;
+	ZoneLock(zone);
 
-		if(currentBlock==block)
-			break;
+	stats->lockAcquires=zone->lockAcquires;
+	stats->trimmedBytes=zone->trimmedBytes;
 
-		prevBlock=currentBlock;
-		currentBlock=(size_t *)((uint8_t *)currentBlock+currentSize);
-	}
+	uint64_t flMap=zone->flBitmap;
 
-	// If prevBlock is found and is free, enlarge prevBlock by Block's size
-	//     and decrement allocations (removes Block).
-	// Note: Block may have been also enlarged and merged by the previous operation,
-	//     thus merging all 3 blocks together into a single free block.
-	if(prevBlock)
+	while(flMap)
 	{
-		bool isPrevFree=((*prevBlock&FREE_MASK)>>FREE_SHIFT)==true;
-		size_t prevSize=*prevBlock&SIZE_MASK;
+		const uint32_t fl=FindFirstSet64(flMap);
+		uint32_t slMap=zone->slBitmap[fl];
 
-		if(isPrevFree)
+		while(slMap)
 		{
-			prevSize+=blockSize;
-			*prevBlock=FREE_MASK|(prevSize&SIZE_MASK);
+			const uint32_t sl=FindFirstSet32(slMap);
+
+			for(const ZoneBlock_t *block=zone->freeBlocks[fl][sl];block;block=block->nextFree)
+			{
+				const size_t size=BlockSize(block);
+
+				stats->freeBytes+=size;
+				stats->freeBlocks++;
+
+				if(size>stats->largestFree)
+					stats->largestFree=size;
+			}
 
-			zone->allocations--;
+			slMap&=slMap-1;
 		}
+
+		flMap&=flMap-1;
 	}
 
+	// Cached blocks are still allocated as far as the zone is concerned, but they aren't in use
+	stats->usedBlocks=zone->allocations-stats->freeBlocks;
+	stats->usedBlocks-=stats->cachedBlocks<stats->usedBlocks?stats->cachedBlocks:stats->usedBlocks;
+
 	mtx_unlock(&zone->mutex);
+
+	if(stats->freeBytes)
+		stats->fragmentation=1.0f-(float)stats->largestFree/(float)stats->freeBytes;
+
+	return true;
 }
 
-// Walk the blocks in the heap and verify that none go out of bounds
-bool Zone_VerifyHeap(MemZone_t *zone)
+// Print overall usage, fragmentation and the per-tag breakdown
+void Zone_PrintStats(MemZone_t *zone)
 {
-	if(!zone)
-	{
-		DBGPRINTF(DEBUG_ERROR, "ZONE IS NULL.\n");
-		return false;
-	}
+	ZoneStats_t stats;
+
+	if(!Zone_GetStats(zone, &stats))
+		return;
 
-	size_t *block=zone->memory;
-	size_t *endZone=(size_t *)((uint8_t *)zone->memory+zone->size);
+	DBGPRINTF(DEBUG_WARNING, "Zone used: %0.3fMB in %zu blocks, Free: %0.3fMB in %zu blocks, Largest free: %0.3fMB, Fragmentation: %0.1f%%\n",
+			  (float)stats.usedBytes/1000.0f/1000.0f, stats.usedBlocks, (float)stats.freeBytes/1000.0f/1000.0f, stats.freeBlocks,
+			  (float)stats.largestFree/1000.0f/1000.0f, stats.fragmentation*100.0f);
 
-	for(size_t i=0;i<zone->allocations;i++)
+	DBGPRINTF(DEBUG_WARNING, "Zone trimmed: %0.3fMB released to the OS\n", (float)stats.trimmedBytes/1000.0f/1000.0f);
+
+	DBGPRINTF(DEBUG_WARNING, "Zone lock: %zu acquires, %zu contended, Thread caches: %0.3fKB in %zu blocks, %zu hits, %zu misses, %zu remote frees\n",
+			  stats.lockAcquires, stats.lockContended, (float)stats.cachedBytes/1000.0f, stats.cachedBlocks, stats.cacheHits, stats.cacheMisses, stats.remoteFrees);
+
+	for(uint32_t i=0;i<NUM_ZONE_TAGS;i++)
 	{
-		size_t blockSize=*block&SIZE_MASK;
-		size_t *nextBlock=(size_t *)((uint8_t *)block+blockSize);
+		ZoneTagStats_t tagStats;
 
-		if(nextBlock>endZone)
+		if(!Zone_GetTagStats(zone, (ZoneTag_e)i, &tagStats)||!tagStats.totalAllocs)
+			continue;
+
+		DBGPRINTF(DEBUG_WARNING, "\t%-8s Live: %0.3fKB (%zu), Peak: %0.3fKB, Total allocs: %zu, Allocs/frame: %d (peak %d)\n",
+				  Zone_GetTagName((ZoneTag_e)i), (float)tagStats.liveBytes/1000.0f, tagStats.liveAllocs, (float)tagStats.peakBytes/1000.0f,
+				  tagStats.totalAllocs, tagStats.lastFrameAllocs, tagStats.peakFrameAllocs);
+
+		// Histogram, only the size classes that have been used
+		char line[512];
+		int length=snprintf(line, sizeof(line), "\t\tSizes:");
+
+		for(uint32_t j=0;j<ZONE_HISTOGRAM_BUCKETS&&length>0&&(size_t)length<sizeof(line);j++)
 		{
-			DBGPRINTF(DEBUG_ERROR, "Zone_VerifyHeap: Corrupted heap! Block (%p>%p) went out of range.\n", nextBlock, endZone);
-			return false;
+			if(tagStats.histogram[j])
+				length+=snprintf(line+length, sizeof(line)-length, " %zu:%d", (size_t)1<<j, tagStats.histogram[j]);
 		}
 
-		block=(size_t *)((uint8_t *)block+blockSize);
+		DBGPRINTF(DEBUG_WARNING, "%s\n", line);
 	}
-
-	return true;
 }
 
 // Iterate over the allocations and print out some stats.
@@ -406,15 +1835,12 @@ void Zone_Print(MemZone_t *zone)
 {
 	DBGPRINTF(DEBUG_WARNING, "Zone size: %0.2fMB  Location: 0x%p\n", (float)(zone->size/1000.0f/1000.0f), zone);
 
-	size_t *block=zone->memory;
+	ZoneBlock_t *block=BlockFirst(zone);
 
-	for(size_t i=0;i<zone->allocations;i++)
+	for(size_t i=0;i<zone->allocations&&!BlockIsLast(block);i++)
 	{
-		bool isFree=((*block&FREE_MASK)>>FREE_SHIFT)==true;
-		size_t blockSize=*block&SIZE_MASK;
-
-		DBGPRINTF(DEBUG_WARNING, "\tBlock: %p, Address: %p, Size: %0.3fKB, Free: %s\n", block, (uint8_t *)block+sizeof(size_t), (float)(blockSize-sizeof(size_t))/1000.0f, isFree?"yes":"no");
+		DBGPRINTF(DEBUG_WARNING, "\tBlock: %p, Address: %p, Size: %0.3fKB, Free: %s\n", block, BlockToPtr(block), (float)BlockSize(block)/1000.0f, BlockIsFree(block)?"yes":"no");
 
-		block=(size_t *)((uint8_t *)block+blockSize);
+		block=BlockNext(block);
 	}
 }
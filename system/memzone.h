@@ -2,7 +2,245 @@
 #define __MEMZONE_H__
 
 #include <threads.h>
+#include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+// Two-level segregated fit (TLSF) configuration.
+// First level splits free blocks by power of two, second level linearly subdivides each
+//     power of two into ZONE_SL_COUNT ranges.
+#define ZONE_ALIGN_LOG2 3
+#define ZONE_ALIGN (1<<ZONE_ALIGN_LOG2)
+
+#define ZONE_SL_LOG2 5
+#define ZONE_SL_COUNT (1<<ZONE_SL_LOG2)
+
+#define ZONE_FL_SHIFT (ZONE_SL_LOG2+ZONE_ALIGN_LOG2)
+#if SIZE_MAX>UINT32_MAX
+#define ZONE_FL_MAX 40
+#else
+#define ZONE_FL_MAX 30
+#endif
+#define ZONE_FL_COUNT (ZONE_FL_MAX-ZONE_FL_SHIFT+1)
+
+#define ZONE_SMALL_BLOCK_SIZE (1<<ZONE_FL_SHIFT)
+
+// Heap integrity checking modes
+typedef enum
+{
+	ZONE_VERIFY_OFF=0,		// No checking
+	ZONE_VERIFY_SAMPLED,	// Full heap walk every verifyInterval allocations
+	ZONE_VERIFY_INCREMENTAL,// Check verifyInterval blocks per allocation and per Zone_VerifyStep call
+	ZONE_VERIFY_FULL		// Full heap walk on every allocation
+} ZoneVerifyMode_e;
+
+// Heap integrity checking options
+#define ZONE_VERIFY_GUARDS	0x1	// Trailing canary on each allocation, checked on free and by the verifier
+#define ZONE_VERIFY_FILL	0x2	// Fill new allocations with ZONE_FILL_ALLOC and freed blocks with ZONE_FILL_FREE
+
+#define ZONE_GUARD_SIZE sizeof(uint64_t)
+#define ZONE_GUARD_PATTERN 0xFDFDFDFDFDFDFDFDull
+#define ZONE_FILL_ALLOC 0xCD
+#define ZONE_FILL_FREE 0xDD
+
+#ifndef ZONE_VERIFY_DEFAULT_MODE
+#ifdef _DEBUG
+#define ZONE_VERIFY_DEFAULT_MODE ZONE_VERIFY_INCREMENTAL
+#else
+#define ZONE_VERIFY_DEFAULT_MODE ZONE_VERIFY_OFF
+#endif
+#endif
+
+#ifndef ZONE_VERIFY_DEFAULT_INTERVAL
+#define ZONE_VERIFY_DEFAULT_INTERVAL 64
+#endif
+
+#ifndef ZONE_VERIFY_DEFAULT_FLAGS
+#ifdef _DEBUG
+#define ZONE_VERIFY_DEFAULT_FLAGS (ZONE_VERIFY_GUARDS)
+#else
+#define ZONE_VERIFY_DEFAULT_FLAGS (0)
+#endif
+#endif
+
+// Large zone backing on Linux/Android, the zone is reserved with mmap and pages only get committed when first touched.
+// ZONE_HUGEPAGES: 0 normal pages, 1 transparent huge pages (MADV_HUGEPAGE),
+//		2 explicit huge pages (MAP_HUGETLB), falls back to transparent huge pages if none are reserved.
+#ifndef ZONE_HUGEPAGES
+#define ZONE_HUGEPAGES 0
+#endif
+
+#define ZONE_HUGEPAGE_SIZE (2*1024*1024)
+
+// Free runs at least ZONE_TRIM_THRESHOLD bytes have their pages given back to the OS every ZONE_TRIM_INTERVAL frames,
+//		a threshold of 0 disables automatic trimming.
+#ifndef ZONE_TRIM_THRESHOLD
+#define ZONE_TRIM_THRESHOLD (4*1024*1024)
+#endif
+
+#ifndef ZONE_TRIM_INTERVAL
+#define ZONE_TRIM_INTERVAL 600
+#endif
+
+// Allocation tracing, every malloc/free/realloc is written to a binary trace file that the zonereplay benchmark can replay.
+// Defining ZONE_TRACE_FILE starts a trace to that file as soon as the zone is created.
+#ifndef ZONE_TRACE
+#define ZONE_TRACE 1
+#endif
+
+#define ZONE_TRACE_MAGIC 0x4352545A	// "ZTRC"
+#define ZONE_TRACE_VERSION 1
+
+// Events buffered in memory before being written out
+#define ZONE_TRACE_BUFFER 4096
+
+typedef enum
+{
+	ZONE_TRACE_MALLOC=0,
+	ZONE_TRACE_FREE,
+	ZONE_TRACE_REALLOC
+} ZoneTraceOp_e;
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t eventSize;
+	uint32_t padding;
+	uint64_t zoneSize;
+} ZoneTraceHeader_t;
+
+// One trace event, events are written in the order they took effect.
+// ptr is the address returned by malloc/realloc or passed to free, oldPtr is the address passed to realloc.
+typedef struct
+{
+	uint64_t time;		// Nanoseconds since the trace started
+	uint64_t ptr;
+	uint64_t oldPtr;
+	uint32_t size;		// Requested size
+	uint16_t thread;	// Index of the calling thread, in order of each thread's first traced call
+	uint8_t op;			// ZoneTraceOp_e
+	uint8_t tag;		// ZoneTag_e
+} ZoneTraceEvent_t;
+
+// Allocation tags, each allocation is accounted to one of these so zone usage can be broken down by subsystem
+typedef enum
+{
+	TAG_NONE=0,
+	TAG_SYSTEM,
+	TAG_VULKAN,
+	TAG_VR,
+	TAG_UI,
+	TAG_FONT,
+	TAG_IMAGE,
+	TAG_MODEL,
+	TAG_AUDIO,
+	TAG_PHYSICS,
+	TAG_CAMERA,
+	TAG_UTILS,
+	NUM_ZONE_TAGS
+} ZoneTag_e;
+
+// Allocation size histogram, bucket N counts requested sizes in [2^N, 2^(N+1))
+#define ZONE_HISTOGRAM_BUCKETS 32
+
+typedef struct
+{
+	// Block bytes (including header) currently allocated, and the most there has ever been
+	size_t liveBytes, peakBytes;
+	size_t liveAllocs, totalAllocs;
+
+	// Allocations made this frame, last frame, and the most in any one frame
+	uint32_t frameAllocs, lastFrameAllocs, peakFrameAllocs;
+
+	uint32_t histogram[ZONE_HISTOGRAM_BUCKETS];
+} ZoneTagStats_t;
+
+// Live counters backing ZoneTagStats_t, updated without holding the zone mutex
+typedef struct
+{
+	atomic_size_t liveBytes, peakBytes;
+	atomic_size_t liveAllocs, totalAllocs;
+	atomic_uint frameAllocs, lastFrameAllocs, peakFrameAllocs;
+	atomic_uint histogram[ZONE_HISTOGRAM_BUCKETS];
+} ZoneTagCounters_t;
+
+typedef struct
+{
+	size_t usedBytes, freeBytes;
+	size_t usedBlocks, freeBlocks;
+	size_t largestFree;
+
+	// Blocks sitting in thread caches, still allocated as far as the zone is concerned
+	size_t cachedBytes, cachedBlocks;
+
+	// 1-(largestFree/freeBytes), 0 means all free memory is one contiguous block
+	float fragmentation;
+
+	// Zone mutex acquisitions and how many of those had to wait, thread cache hits/misses and cross-thread frees
+	size_t lockAcquires, lockContended;
+	size_t cacheHits, cacheMisses, remoteFrees;
+
+	// Bytes given back to the OS by Zone_Trim over the life of the zone
+	size_t trimmedBytes;
+} ZoneStats_t;
+
+// Per-thread caches of recently freed small blocks, so most malloc/free pairs never take the zone mutex.
+// The owning thread index is stored in the block's size word, which needs 64 bit sizes.
+#ifndef ZONE_THREAD_CACHE
+#if SIZE_MAX>UINT32_MAX
+#define ZONE_THREAD_CACHE 1
+#else
+#define ZONE_THREAD_CACHE 0
+#endif
+#endif
+
+#define ZONE_CACHE_MAX_THREADS 16
+
+// Zones one thread can hold a cache in at the same time, past that it allocates straight from the zone.
+// Each zone's cache has to be released separately, with Zone_ReleaseThreadCache.
+#define ZONE_CACHE_MAX_ZONES 4
+
+// Size classes are ZONE_CACHE_CLASS_SIZE apart, anything bigger than ZONE_CACHE_MAX_SIZE always goes to the zone
+#define ZONE_CACHE_CLASS_SIZE 16
+#define ZONE_CACHE_CLASSES 32
+#define ZONE_CACHE_MAX_SIZE (ZONE_CACHE_CLASS_SIZE*ZONE_CACHE_CLASSES)
+
+// Most blocks held per bin and most bytes held per thread, extra frees go back to the zone
+#define ZONE_CACHE_MAX_BLOCKS 64
+#define ZONE_CACHE_MAX_BYTES (256*1024)
+
+struct ZoneBlock_s;
+
+typedef struct
+{
+	atomic_bool active;
+
+	// Only touched by the owning thread, blocks are linked through nextFree.
+	// Binned by tag as well as size, since a cached block's tag can't be changed without the zone mutex.
+	struct ZoneBlock_s *bins[NUM_ZONE_TAGS][ZONE_CACHE_CLASSES];
+	uint32_t binCount[NUM_ZONE_TAGS][ZONE_CACHE_CLASSES];
+
+	// Blocks freed by other threads, pushed lock-free and drained by the owner.
+	// Set to a closed marker while the slot has no owner, so late frees go back to the zone instead.
+	_Atomic(struct ZoneBlock_s *) remoteFree;
+
+	atomic_size_t cachedBytes, cachedBlocks;
+	atomic_size_t hits, misses, remoteFrees;
+} ZoneThreadCache_t;
+
+// Block header, uses boundary tags so both physical neighbors can be found in O(1).
+// prevPhysical is only valid if the previous block is free, it's stored in the last bytes of that block.
+// nextFree/prevFree are only valid while this block is free, they overlap the block's payload.
+typedef struct ZoneBlock_s
+{
+	struct ZoneBlock_s *prevPhysical;
+	size_t size;
+
+	struct ZoneBlock_s *nextFree;
+	struct ZoneBlock_s *prevFree;
+} ZoneBlock_t;
 
 typedef struct
 {
@@ -11,15 +249,67 @@ typedef struct
 	size_t allocations;
 	size_t size;
 	void *memory;
+
+	// Set if the zone was mmap'd rather than malloc'd, pageSize is the granularity pages can be released at
+	bool mapped;
+	size_t mappedSize;
+	size_t pageSize;
+
+	// Frames since the last automatic trim (only touched by Zone_NextFrame), and total bytes released (mutex held)
+	uint32_t trimFrame;
+	size_t trimmedBytes;
+
+	// Free list bitmaps and heads
+	uint64_t flBitmap;
+	uint32_t slBitmap[ZONE_FL_COUNT];
+	ZoneBlock_t *freeBlocks[ZONE_FL_COUNT][ZONE_SL_COUNT];
+
+	// Heap integrity checking state
+	ZoneVerifyMode_e verifyMode;
+	uint32_t verifyFlags;
+	uint32_t verifyInterval;
+	uint32_t verifyCounter;
+	ZoneBlock_t *verifyCursor;
+
+	// Per-tag accounting
+	ZoneTagCounters_t tagStats[NUM_ZONE_TAGS];
+
+	// Contention counters, lockAcquires is only changed with the mutex held
+	size_t lockAcquires;
+	atomic_size_t lockContended;
+
+	ZoneThreadCache_t threadCaches[ZONE_CACHE_MAX_THREADS];
+
+	// Allocation trace, traceMutex orders the events and guards the buffer and file
+	atomic_bool tracing;
+	mtx_t traceMutex;
+	FILE *traceFile;
+	ZoneTraceEvent_t *traceBuffer;
+	uint32_t traceCount;
+	uint64_t traceStart;
+	size_t traceEvents;
 } MemZone_t;
 
 MemZone_t *Zone_Init(size_t size);
 void Zone_Destroy(MemZone_t *zone);
 void Zone_Free(MemZone_t *zone, void *ptr);
 void *Zone_Malloc(MemZone_t *zone, size_t size);
+void *Zone_MallocTagged(MemZone_t *zone, size_t size, ZoneTag_e tag);
 void *Zone_Calloc(MemZone_t *zone, size_t size, size_t count);
+void *Zone_CallocTagged(MemZone_t *zone, size_t size, size_t count, ZoneTag_e tag);
 void *Zone_Realloc(MemZone_t *zone, void *ptr, size_t size);
+void Zone_SetVerifyMode(MemZone_t *zone, ZoneVerifyMode_e mode, uint32_t interval, uint32_t flags);
+bool Zone_VerifyStep(MemZone_t *zone);
 bool Zone_VerifyHeap(MemZone_t *zone);
+void Zone_ReleaseThreadCache(MemZone_t *zone);
+void Zone_NextFrame(MemZone_t *zone);
+size_t Zone_Trim(MemZone_t *zone, size_t threshold);
+bool Zone_TraceStart(MemZone_t *zone, const char *filename);
+void Zone_TraceStop(MemZone_t *zone);
+const char *Zone_GetTagName(ZoneTag_e tag);
+bool Zone_GetTagStats(MemZone_t *zone, ZoneTag_e tag, ZoneTagStats_t *stats);
+bool Zone_GetStats(MemZone_t *zone, ZoneStats_t *stats);
+void Zone_PrintStats(MemZone_t *zone);
 void Zone_Print(MemZone_t *zone);
 
 #endif
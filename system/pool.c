@@ -0,0 +1,308 @@
+// Fixed-size slot (pool) allocator for small, frequently allocated objects.
+
+// Slots are carved out of contiguous slabs allocated from the zone, and free slots are kept on an intrusive free list.
+// Each thread keeps a small cache of free slots per pool, so most allocations and frees never take the pool mutex,
+//		slots only move between a thread's cache and the shared free list POOL_CACHE_BATCH at a time.
+// Slots may be freed from any thread, they just end up in that thread's cache.
+// A thread's cached slots go back to the shared free lists when it calls Pool_ReleaseThreadCache on exit.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <threads.h>
+#include <stdatomic.h>
+#include "system.h"
+#include "pool.h"
+
+typedef struct
+{
+	PoolSlot_t *freeList;
+	uint32_t count;
+	uint32_t generation;
+} PoolCache_t;
+
+static atomic_uint poolsUsed=0;
+static atomic_uint poolGeneration=0;
+
+// Live pool for each cache index, so an exiting thread can find where to give it's cached slots back to
+static _Atomic(Pool_t *) pools[POOL_MAX_POOLS];
+
+static thread_local PoolCache_t poolCache[POOL_MAX_POOLS];
+
+// Get this thread's cache for a pool, dropping anything left over from a previous pool that used the same index
+static inline PoolCache_t *Pool_GetCache(Pool_t *pool)
+{
+	PoolCache_t *cache=&poolCache[pool->index];
+
+	if(cache->generation!=pool->generation)
+	{
+		cache->freeList=NULL;
+		cache->count=0;
+		cache->generation=pool->generation;
+	}
+
+	return cache;
+}
+
+// Allocate a new slab and add all of it's slots to the shared free list, mutex must be held
+static bool Pool_AddSlab(Pool_t *pool)
+{
+	// Zone only guarantees 8 byte alignment, pad so the slots can be aligned
+	PoolSlab_t *slab=(PoolSlab_t *)Zone_MallocTagged(zone, sizeof(PoolSlab_t)+pool->slotSize*pool->slotsPerSlab+POOL_ALIGN-1, TAG_SYSTEM);
+
+	if(slab==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "Pool_AddSlab: Unable to allocate memory for slab.\n");
+		return false;
+	}
+
+	slab->next=pool->slabs;
+	pool->slabs=slab;
+	pool->numSlabs++;
+
+	// Link slots in reverse, so they get handed out in address order
+	uint8_t *slots=(uint8_t *)(((uintptr_t)slab+sizeof(PoolSlab_t)+POOL_ALIGN-1)&~(uintptr_t)(POOL_ALIGN-1));
+
+	for(uint32_t i=pool->slotsPerSlab;i>0;i--)
+	{
+		PoolSlot_t *slot=(PoolSlot_t *)(slots+pool->slotSize*(i-1));
+
+		slot->next=pool->freeList;
+		pool->freeList=slot;
+	}
+
+	pool->numFree+=pool->slotsPerSlab;
+
+	return true;
+}
+
+bool Pool_Init(Pool_t *pool, size_t slotSize, uint32_t slotsPerSlab)
+{
+	if(pool==NULL)
+		return false;
+
+	if(!slotSize||!slotsPerSlab)
+		return false;
+
+	// Claim a thread cache index
+	uint32_t used=atomic_load(&poolsUsed);
+	uint32_t index;
+
+	do
+	{
+		if(used==UINT32_MAX)
+		{
+			DBGPRINTF(DEBUG_ERROR, "Pool_Init: Too many pools (max %d).\n", POOL_MAX_POOLS);
+			return false;
+		}
+
+		index=0;
+
+		while(used&(1U<<index))
+			index++;
+	} while(!atomic_compare_exchange_weak(&poolsUsed, &used, used|(1U<<index)));
+
+	pool->index=index;
+	pool->generation=atomic_fetch_add(&poolGeneration, 1)+1;
+
+	// Slots need to be able to hold the free list pointer, and keep alignment
+	if(slotSize<sizeof(PoolSlot_t))
+		slotSize=sizeof(PoolSlot_t);
+
+	pool->slotSize=(slotSize+(POOL_ALIGN-1))&~(size_t)(POOL_ALIGN-1);
+	pool->slotsPerSlab=slotsPerSlab;
+
+	pool->slabs=NULL;
+	pool->numSlabs=0;
+
+	pool->freeList=NULL;
+	pool->numFree=0;
+
+	if(mtx_init(&pool->mutex, mtx_plain))
+	{
+		DBGPRINTF(DEBUG_ERROR, "Pool_Init: Unable to create mutex.\n");
+		atomic_fetch_and(&poolsUsed, ~(1U<<index));
+		return false;
+	}
+
+	atomic_store(&pools[index], pool);
+
+	return true;
+}
+
+// All slots are released, any slots still sitting in other threads' caches are dropped the next time those threads use this index
+void Pool_Destroy(Pool_t *pool)
+{
+	if(pool==NULL)
+		return;
+
+	atomic_store(&pools[pool->index], NULL);
+
+	mtx_lock(&pool->mutex);
+
+	PoolSlab_t *slab=pool->slabs;
+
+	while(slab)
+	{
+		PoolSlab_t *next=slab->next;
+		Zone_Free(zone, slab);
+		slab=next;
+	}
+
+	pool->slabs=NULL;
+	pool->numSlabs=0;
+	pool->freeList=NULL;
+	pool->numFree=0;
+
+	mtx_unlock(&pool->mutex);
+	mtx_destroy(&pool->mutex);
+
+	// Calling thread's cache can be cleared now, others will see the generation change
+	PoolCache_t *cache=&poolCache[pool->index];
+
+	if(cache->generation==pool->generation)
+	{
+		cache->freeList=NULL;
+		cache->count=0;
+		cache->generation=0;
+	}
+
+	atomic_fetch_and(&poolsUsed, ~(1U<<pool->index));
+	pool->generation=0;
+}
+
+void *Pool_Malloc(Pool_t *pool)
+{
+	if(pool==NULL)
+		return NULL;
+
+	PoolCache_t *cache=Pool_GetCache(pool);
+
+	// Thread cache is empty, grab a batch from the shared free list
+	if(cache->freeList==NULL)
+	{
+		mtx_lock(&pool->mutex);
+
+		if(pool->freeList==NULL&&!Pool_AddSlab(pool))
+		{
+			mtx_unlock(&pool->mutex);
+			return NULL;
+		}
+
+		for(uint32_t i=0;i<POOL_CACHE_BATCH&&pool->freeList;i++)
+		{
+			PoolSlot_t *slot=pool->freeList;
+
+			pool->freeList=slot->next;
+			pool->numFree--;
+
+			slot->next=cache->freeList;
+			cache->freeList=slot;
+			cache->count++;
+		}
+
+		mtx_unlock(&pool->mutex);
+	}
+
+	PoolSlot_t *slot=cache->freeList;
+
+	cache->freeList=slot->next;
+	cache->count--;
+
+	return (void *)slot;
+}
+
+void *Pool_Calloc(Pool_t *pool)
+{
+	void *ptr=Pool_Malloc(pool);
+
+	if(ptr)
+		memset(ptr, 0, pool->slotSize);
+
+	return ptr;
+}
+
+void Pool_Free(Pool_t *pool, void *ptr)
+{
+	if(pool==NULL||ptr==NULL)
+		return;
+
+	PoolCache_t *cache=Pool_GetCache(pool);
+	PoolSlot_t *slot=(PoolSlot_t *)ptr;
+
+	slot->next=cache->freeList;
+	cache->freeList=slot;
+	cache->count++;
+
+	// Thread cache has gotten too big, give a batch back to the shared free list
+	if(cache->count>=POOL_CACHE_BATCH*2)
+	{
+		mtx_lock(&pool->mutex);
+
+		for(uint32_t i=0;i<POOL_CACHE_BATCH;i++)
+		{
+			slot=cache->freeList;
+
+			cache->freeList=slot->next;
+			cache->count--;
+
+			slot->next=pool->freeList;
+			pool->freeList=slot;
+			pool->numFree++;
+		}
+
+		mtx_unlock(&pool->mutex);
+	}
+}
+
+// Give all of the calling thread's cached slots back to their pools' shared free lists.
+// Threads that use pools should call this before exiting, thread workers do it automatically.
+// Pools must not be destroyed while this is running.
+void Pool_ReleaseThreadCache(void)
+{
+	for(uint32_t i=0;i<POOL_MAX_POOLS;i++)
+	{
+		PoolCache_t *cache=&poolCache[i];
+
+		if(cache->freeList==NULL)
+			continue;
+
+		// Caches left over from a destroyed pool are just dropped, their slabs are already gone
+		Pool_t *pool=atomic_load(&pools[i]);
+
+		if(pool&&pool->generation==cache->generation)
+		{
+			mtx_lock(&pool->mutex);
+
+			while(cache->freeList)
+			{
+				PoolSlot_t *slot=cache->freeList;
+
+				cache->freeList=slot->next;
+
+				slot->next=pool->freeList;
+				pool->freeList=slot;
+				pool->numFree++;
+			}
+
+			mtx_unlock(&pool->mutex);
+		}
+
+		cache->freeList=NULL;
+		cache->count=0;
+		cache->generation=0;
+	}
+}
+
+void Pool_Print(Pool_t *pool)
+{
+	if(pool==NULL)
+		return;
+
+	mtx_lock(&pool->mutex);
+
+	DBGPRINTF(DEBUG_WARNING, "Pool: Slot size: %zu, Slabs: %d, Capacity: %d, Shared free: %d\n",
+			  pool->slotSize, pool->numSlabs, pool->numSlabs*pool->slotsPerSlab, pool->numFree);
+
+	mtx_unlock(&pool->mutex);
+}
@@ -0,0 +1,52 @@
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <threads.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Every slot is aligned to this
+#define POOL_ALIGN 16
+#define POOL_MAX_POOLS 32
+
+// Number of slots moved between a thread's cache and the shared free list at a time
+#define POOL_CACHE_BATCH 32
+
+// Slab header, at the start of the zone allocation. Slots start at the first POOL_ALIGN aligned byte after it.
+typedef struct PoolSlab_s
+{
+	struct PoolSlab_s *next;
+} PoolSlab_t;
+
+typedef struct PoolSlot_s
+{
+	struct PoolSlot_s *next;
+} PoolSlot_t;
+
+typedef struct
+{
+	mtx_t mutex;
+
+	size_t slotSize;
+	uint32_t slotsPerSlab;
+
+	// Slot in the thread cache table, generation detects caches left over from a destroyed pool
+	uint32_t index;
+	uint32_t generation;
+
+	PoolSlab_t *slabs;
+	uint32_t numSlabs;
+
+	PoolSlot_t *freeList;
+	uint32_t numFree;
+} Pool_t;
+
+bool Pool_Init(Pool_t *pool, size_t slotSize, uint32_t slotsPerSlab);
+void Pool_Destroy(Pool_t *pool);
+void *Pool_Malloc(Pool_t *pool);
+void *Pool_Calloc(Pool_t *pool);
+void Pool_Free(Pool_t *pool, void *ptr);
+void Pool_ReleaseThreadCache(void);
+void Pool_Print(Pool_t *pool);
+
+#endif
@@ -0,0 +1,98 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "system.h"
+#include "simclock.h"
+
+bool SimClock_Init(SimClock_t *simClock, double tickRate, uint32_t maxSteps)
+{
+	if(simClock==NULL)
+		return false;
+
+	if(!(tickRate>0.0))
+	{
+		DBGPRINTF(DEBUG_ERROR, "SimClock_Init: Invalid tick rate %f.\n", tickRate);
+		return false;
+	}
+
+	memset(simClock, 0, sizeof(SimClock_t));
+
+	simClock->step=1.0/tickRate;
+	simClock->maxSteps=maxSteps?maxSteps:SIMCLOCK_DEFAULT_MAX_STEPS;
+
+	return true;
+}
+
+// Throws away any accumulated time, for after loading or unpausing where the frame time is meaningless
+void SimClock_Reset(SimClock_t *simClock)
+{
+	if(simClock==NULL)
+		return;
+
+	simClock->accumulator=0.0;
+	simClock->alpha=0.0f;
+}
+
+// Adds a frame's worth of time and returns how many ticks to run this frame, each of SimClock_GetStep seconds.
+// Call once per frame, then step the simulation that many times and render with SimClock_GetAlpha.
+uint32_t SimClock_Advance(SimClock_t *simClock, double frameTime)
+{
+	if(simClock==NULL)
+		return 0;
+
+	// Clock going backwards or garbage from a stall isn't simulated
+	if(!(frameTime>0.0)||!isfinite(frameTime))
+		frameTime=0.0;
+
+	simClock->accumulator+=frameTime;
+
+	const double maxTime=simClock->step*simClock->maxSteps;
+
+	if(simClock->accumulator>=maxTime+simClock->step)
+	{
+		// Keep the fraction of a tick so alpha stays continuous, drop the rest
+		const double keep=maxTime+fmod(simClock->accumulator, simClock->step);
+
+		simClock->droppedTime+=simClock->accumulator-keep;
+		simClock->accumulator=keep;
+	}
+
+	uint32_t steps=0;
+
+	while(simClock->accumulator>=simClock->step)
+	{
+		simClock->accumulator-=simClock->step;
+		steps++;
+	}
+
+	simClock->tick+=steps;
+	simClock->alpha=(float)(simClock->accumulator/simClock->step);
+
+	return steps;
+}
+
+float SimClock_GetStep(const SimClock_t *simClock)
+{
+	if(simClock==NULL)
+		return 0.0f;
+
+	return (float)simClock->step;
+}
+
+// Fraction of a tick the accumulator is holding, 0 is the previous tick's state, 1 the current one
+float SimClock_GetAlpha(const SimClock_t *simClock)
+{
+	if(simClock==NULL)
+		return 1.0f;
+
+	return simClock->alpha;
+}
+
+uint64_t SimClock_GetTick(const SimClock_t *simClock)
+{
+	if(simClock==NULL)
+		return 0;
+
+	return simClock->tick;
+}
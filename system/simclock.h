@@ -0,0 +1,36 @@
+#ifndef __SIMCLOCK_H__
+#define __SIMCLOCK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIMCLOCK_DEFAULT_RATE 60.0
+#define SIMCLOCK_DEFAULT_MAX_STEPS 4
+
+// Fixed timestep simulation clock.
+// Frame time goes into an accumulator, which is spent in whole ticks of a fixed step size,
+// so anything simulated steps by the same dt no matter the frame rate and replays the same given the same inputs.
+// If a frame takes too long, at most maxSteps ticks are run and the rest of the time is dropped,
+// rather than falling further behind each frame trying to catch up.
+// What's left in the accumulator is exported as alpha, how far the renderer is between the last two ticks.
+typedef struct
+{
+	double step;
+	double accumulator;
+	uint32_t maxSteps;
+
+	// Ticks since init, and time thrown away by the step cap
+	uint64_t tick;
+	double droppedTime;
+
+	float alpha;
+} SimClock_t;
+
+bool SimClock_Init(SimClock_t *simClock, double tickRate, uint32_t maxSteps);
+void SimClock_Reset(SimClock_t *simClock);
+uint32_t SimClock_Advance(SimClock_t *simClock, double frameTime);
+float SimClock_GetStep(const SimClock_t *simClock);
+float SimClock_GetAlpha(const SimClock_t *simClock);
+uint64_t SimClock_GetTick(const SimClock_t *simClock);
+
+#endif
@@ -1,8 +1,317 @@
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+#if defined(LINUX)||defined(ANDROID)
+#include <unistd.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#elif defined(WIN32)
+#include <Windows.h>
+#endif
 #include "system.h"
 #include "threads.h"
 
+// Number of logical CPUs available to the process
+uint32_t Thread_GetCPUCount(void)
+{
+#if defined(LINUX)||defined(ANDROID)
+	const long count=sysconf(_SC_NPROCESSORS_ONLN);
+
+	return count>0?(uint32_t)count:1;
+#elif defined(WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+
+	return info.dwNumberOfProcessors?(uint32_t)info.dwNumberOfProcessors:1;
+#else
+	return 1;
+#endif
+}
+
+// Lock-free queues
+
+static uint32_t Thread_NextPow2(uint32_t value)
+{
+	value--;
+	value|=value>>1;
+	value|=value>>2;
+	value|=value>>4;
+	value|=value>>8;
+	value|=value>>16;
+
+	return value+1;
+}
+
+// Capacity is rounded up to a power of two
+bool ThreadSPSC_Init(ThreadSPSC_t *queue, uint32_t elementSize, uint32_t capacity)
+{
+	if(queue==NULL||!elementSize||!capacity||capacity>0x80000000u)
+		return false;
+
+	memset(queue, 0, sizeof(ThreadSPSC_t));
+
+	capacity=Thread_NextPow2(capacity);
+
+	queue->buffer=(uint8_t *)Zone_Malloc(zone, (size_t)elementSize*capacity);
+
+	if(queue->buffer==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "ThreadSPSC_Init: Unable to allocate queue buffer.\n");
+		return false;
+	}
+
+	queue->elementSize=elementSize;
+	queue->capacity=capacity;
+	queue->mask=capacity-1;
+
+	atomic_init(&queue->head, 0);
+	atomic_init(&queue->tail, 0);
+	queue->cachedHead=0;
+	queue->cachedTail=0;
+
+	return true;
+}
+
+void ThreadSPSC_Destroy(ThreadSPSC_t *queue)
+{
+	if(queue==NULL)
+		return;
+
+	Zone_Free(zone, queue->buffer);
+	queue->buffer=NULL;
+	queue->capacity=0;
+}
+
+// Producer side only, returns false if the queue is full
+bool ThreadSPSC_Push(ThreadSPSC_t *queue, const void *element)
+{
+	const size_t tail=atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+	if(tail-queue->cachedHead>=queue->capacity)
+	{
+		queue->cachedHead=atomic_load_explicit(&queue->head, memory_order_acquire);
+
+		if(tail-queue->cachedHead>=queue->capacity)
+			return false;
+	}
+
+	memcpy(queue->buffer+(tail&queue->mask)*queue->elementSize, element, queue->elementSize);
+	atomic_store_explicit(&queue->tail, tail+1, memory_order_release);
+
+	return true;
+}
+
+// Consumer side only, returns false if the queue is empty
+bool ThreadSPSC_Pop(ThreadSPSC_t *queue, void *element)
+{
+	const size_t head=atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+	if(head==queue->cachedTail)
+	{
+		queue->cachedTail=atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+		if(head==queue->cachedTail)
+			return false;
+	}
+
+	memcpy(element, queue->buffer+(head&queue->mask)*queue->elementSize, queue->elementSize);
+	atomic_store_explicit(&queue->head, head+1, memory_order_release);
+
+	return true;
+}
+
+// Only a snapshot if the other side is active
+uint32_t ThreadSPSC_GetCount(ThreadSPSC_t *queue)
+{
+	if(queue==NULL)
+		return 0;
+
+	const size_t head=atomic_load_explicit(&queue->head, memory_order_acquire);
+	const size_t tail=atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+	return (uint32_t)(tail-head);
+}
+
+// Capacity is rounded up to a power of two
+bool ThreadMPSC_Init(ThreadMPSC_t *queue, uint32_t elementSize, uint32_t capacity)
+{
+	if(queue==NULL||!elementSize||!capacity||capacity>0x80000000u)
+		return false;
+
+	memset(queue, 0, sizeof(ThreadMPSC_t));
+
+	capacity=Thread_NextPow2(capacity);
+
+	// Sequence numbers and elements share one allocation
+	queue->sequence=(atomic_size_t *)Zone_Malloc(zone, (sizeof(atomic_size_t)+elementSize)*(size_t)capacity);
+
+	if(queue->sequence==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "ThreadMPSC_Init: Unable to allocate queue buffer.\n");
+		return false;
+	}
+
+	queue->buffer=(uint8_t *)(queue->sequence+capacity);
+	queue->elementSize=elementSize;
+	queue->capacity=capacity;
+	queue->mask=capacity-1;
+
+	// A slot is free for position pos when it's sequence is pos, and holds an element for pos when it's pos+1
+	for(uint32_t i=0;i<capacity;i++)
+		atomic_init(&queue->sequence[i], i);
+
+	atomic_init(&queue->head, 0);
+	atomic_init(&queue->tail, 0);
+
+	return true;
+}
+
+void ThreadMPSC_Destroy(ThreadMPSC_t *queue)
+{
+	if(queue==NULL)
+		return;
+
+	Zone_Free(zone, queue->sequence);
+	queue->sequence=NULL;
+	queue->buffer=NULL;
+	queue->capacity=0;
+}
+
+// Any thread, returns false if the queue is full
+bool ThreadMPSC_Push(ThreadMPSC_t *queue, const void *element)
+{
+	size_t pos=atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+	for(;;)
+	{
+		const size_t sequence=atomic_load_explicit(&queue->sequence[pos&queue->mask], memory_order_acquire);
+		const intptr_t diff=(intptr_t)sequence-(intptr_t)pos;
+
+		if(diff==0)
+		{
+			// Slot is free, try to claim it
+			if(atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos+1, memory_order_relaxed, memory_order_relaxed))
+				break;
+		}
+		else if(diff<0)
+			return false;	// Consumer hasn't freed this slot yet, full
+		else
+			pos=atomic_load_explicit(&queue->tail, memory_order_relaxed);	// Another producer got it first
+	}
+
+	memcpy(queue->buffer+(pos&queue->mask)*queue->elementSize, element, queue->elementSize);
+	atomic_store_explicit(&queue->sequence[pos&queue->mask], pos+1, memory_order_release);
+
+	return true;
+}
+
+// Consumer side only, returns false if the queue is empty.
+// A producer that has claimed the next slot but not finished writing it also reads as empty.
+bool ThreadMPSC_Pop(ThreadMPSC_t *queue, void *element)
+{
+	const size_t pos=atomic_load_explicit(&queue->head, memory_order_relaxed);
+	const size_t sequence=atomic_load_explicit(&queue->sequence[pos&queue->mask], memory_order_acquire);
+
+	if(sequence!=pos+1)
+		return false;
+
+	memcpy(element, queue->buffer+(pos&queue->mask)*queue->elementSize, queue->elementSize);
+
+	// Free the slot for the producer one lap ahead
+	atomic_store_explicit(&queue->sequence[pos&queue->mask], pos+queue->capacity, memory_order_release);
+	atomic_store_explicit(&queue->head, pos+1, memory_order_relaxed);
+
+	return true;
+}
+
+bool ThreadMPSC_IsEmpty(ThreadMPSC_t *queue)
+{
+	const size_t pos=atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+	return atomic_load_explicit(&queue->sequence[pos&queue->mask], memory_order_acquire)!=pos+1;
+}
+
+// Only a snapshot, includes slots that have been claimed but not written yet
+uint32_t ThreadMPSC_GetCount(ThreadMPSC_t *queue)
+{
+	if(queue==NULL)
+		return 0;
+
+	const size_t head=atomic_load_explicit(&queue->head, memory_order_acquire);
+	const size_t tail=atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+	return tail>head?(uint32_t)(tail-head):0;
+}
+
+// Worker job lanes
+
+static const char *threadPriorityNames[THREAD_PRIORITY_COUNT]={ "Realtime", "Frame", "Background" };
+
+// Worker and lane of the job running on this thread, so jobs can yield to higher lanes
+static thread_local ThreadWorker_t *currentJobWorker=NULL;
+static thread_local uint32_t currentJobLane=THREAD_PRIORITY_COUNT;
+
+static uint64_t Thread_GetTimeNS(void)
+{
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+
+	return (uint64_t)ts.tv_sec*1000000000ull+(uint64_t)ts.tv_nsec;
+}
+
+// Pop from the highest lane with work, only lanes with a higher priority than maxLane are checked
+static bool Thread_PopJob(ThreadWorker_t *worker, uint32_t maxLane, ThreadJob_t *job, uint32_t *lane)
+{
+	for(uint32_t i=0;i<maxLane;i++)
+	{
+		if(ThreadMPSC_Pop(&worker->lanes[i].jobs, job))
+		{
+			*lane=i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool Thread_LanesEmpty(ThreadWorker_t *worker, uint32_t maxLane)
+{
+	for(uint32_t i=0;i<maxLane;i++)
+	{
+		if(!ThreadMPSC_IsEmpty(&worker->lanes[i].jobs))
+			return false;
+	}
+
+	return true;
+}
+
+static void Thread_RunJob(ThreadWorker_t *worker, ThreadJob_t *job, uint32_t lane)
+{
+	ThreadLane_t *jobLane=&worker->lanes[lane];
+	const uint64_t latency=Thread_GetTimeNS()-job->queueTime;
+
+	// Only this worker updates these, atomics are just so the stats can be read from anywhere
+	atomic_fetch_add_explicit(&jobLane->executed, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&jobLane->totalLatency, latency, memory_order_relaxed);
+
+	if(latency>atomic_load_explicit(&jobLane->maxLatency, memory_order_relaxed))
+		atomic_store_explicit(&jobLane->maxLatency, latency, memory_order_relaxed);
+
+	ThreadWorker_t *prevWorker=currentJobWorker;
+	const uint32_t prevLane=currentJobLane;
+
+	currentJobWorker=worker;
+	currentJobLane=lane;
+
+	// If there's a valid pointer on the job item, run it
+	if(job->function)
+		job->function(job->arg);
+
+	currentJobWorker=prevWorker;
+	currentJobLane=prevLane;
+}
+
 // Main worker thread function, this does the actual calling of various job functions in the thread
 int Thread_Worker(void *data)
 {
@@ -15,73 +324,157 @@ int Thread_Worker(void *data)
 
 	for(;;)
 	{
-		mtx_lock(&worker->mutex);
-
-		if(!(worker->stop||worker->numJobs>0)||worker->pause)
-			cnd_wait(&worker->condition, &worker->mutex);
+		ThreadJob_t job;
+		uint32_t lane;
 
-		if(worker->numJobs>0)
+		// Run jobs for as long as there are any, no locking needed
+		if(!atomic_load(&worker->pause)&&Thread_PopJob(worker, THREAD_PRIORITY_COUNT, &job, &lane))
 		{
-			// Get a copy of the current job
-			ThreadJob_t job=worker->jobs[0];
+			Thread_RunJob(worker, &job, lane);
+			continue;
+		}
 
-			// Remove it from the job list
-			worker->numJobs--;
+		mtx_lock(&worker->mutex);
 
-			// Shift job list
-			for(uint32_t i=0;i<worker->numJobs;i++)
-				worker->jobs[i]=worker->jobs[i+1];
+		// Flag that it's about to sleep before checking the queues one last time.
+		// Thread_AddJob pushes then checks the flag, so one of the two always sees the other.
+		atomic_store(&worker->sleeping, true);
+		atomic_thread_fence(memory_order_seq_cst);
 
-			// Unlock the mutex
-			mtx_unlock(&worker->mutex);
+		while(atomic_load(&worker->pause)||(!atomic_load(&worker->stop)&&Thread_LanesEmpty(worker, THREAD_PRIORITY_COUNT)))
+			cnd_wait(&worker->condition, &worker->mutex);
 
-			// If there's a valid pointer on the job item, run it
-			if(job.function)
-				job.function(job.arg);
-		}
-		else if(worker->stop)
-		{
-			// Unlock the mutex
-			mtx_unlock(&worker->mutex);
+		atomic_store(&worker->sleeping, false);
+
+		mtx_unlock(&worker->mutex);
+
+		// Stopping only happens once all queued jobs are done, including any still being pushed
+		if(atomic_load(&worker->stop)&&!Thread_GetJobCount(worker))
 			break;
-		}
 	}
 
 	// If there's a destructor function assigned, call that.
 	if(worker->destructor)
 		worker->destructor(worker->destructorArg);
 
+	// Hand any cached pool slots and zone blocks back before the thread goes away
+	Pool_ReleaseThreadCache();
+	Zone_ReleaseThreadCache(zone);
+
 	return 0;
 }
 
-// Get the number of current jobs
+// Get the number of current jobs, across all lanes
 uint32_t Thread_GetJobCount(ThreadWorker_t *worker)
 {
-	if(worker)
-		return worker->numJobs;
+	if(worker==NULL)
+		return 0;
 
-	return 0;
+	uint32_t count=0;
+
+	for(uint32_t i=0;i<THREAD_PRIORITY_COUNT;i++)
+		count+=ThreadMPSC_GetCount(&worker->lanes[i].jobs);
+
+	return count;
 }
 
-// Adds a job function and argument to the job list
-bool Thread_AddJob(ThreadWorker_t *worker, ThreadFunction_t jobFunc, void *arg)
+// Adds a job function and argument to a job lane, safe to call from any thread.
+// Returns false if that lane is full.
+bool Thread_AddJobPriority(ThreadWorker_t *worker, ThreadPriority_e priority, ThreadFunction_t jobFunc, void *arg)
 {
-	if(worker)
-	{
-		if(worker->numJobs>=THREAD_MAXJOBS)
-			return false;
+	if(worker==NULL||(uint32_t)priority>=THREAD_PRIORITY_COUNT)
+		return false;
+
+	ThreadLane_t *lane=&worker->lanes[priority];
+
+	if(!ThreadMPSC_Push(&lane->jobs, &(ThreadJob_t){ jobFunc, arg, Thread_GetTimeNS() }))
+		return false;
+
+	// Racy max, but it only ever goes up and it's just a stat
+	const uint32_t depth=ThreadMPSC_GetCount(&lane->jobs);
+	uint32_t peak=atomic_load_explicit(&lane->peakDepth, memory_order_relaxed);
 
+	while(depth>peak&&!atomic_compare_exchange_weak_explicit(&lane->peakDepth, &peak, depth, memory_order_relaxed, memory_order_relaxed));
+
+	// Only need the mutex if the worker might be asleep
+	atomic_thread_fence(memory_order_seq_cst);
+
+	if(atomic_load(&worker->sleeping))
+	{
 		mtx_lock(&worker->mutex);
-		worker->jobs[worker->numJobs++]=(ThreadJob_t){ jobFunc, arg };
 		cnd_signal(&worker->condition);
 		mtx_unlock(&worker->mutex);
 	}
-	else
+
+	return true;
+}
+
+// Adds a job on the frame lane
+bool Thread_AddJob(ThreadWorker_t *worker, ThreadFunction_t jobFunc, void *arg)
+{
+	return Thread_AddJobPriority(worker, THREAD_PRIORITY_FRAME, jobFunc, arg);
+}
+
+// True if the job running on this thread has higher priority work waiting behind it on the same worker
+bool Thread_ShouldYield(void)
+{
+	if(currentJobWorker==NULL)
+		return false;
+
+	return !Thread_LanesEmpty(currentJobWorker, currentJobLane);
+}
+
+// Safe point for long running jobs, runs any higher priority jobs queued on this worker and returns how many it ran.
+// Does nothing outside of a worker job, so it can be called from code that isn't always run on a worker.
+uint32_t Thread_YieldJob(void)
+{
+	ThreadWorker_t *worker=currentJobWorker;
+
+	if(worker==NULL)
+		return 0;
+
+	ThreadJob_t job;
+	uint32_t lane, count=0;
+
+	while(!atomic_load(&worker->pause)&&Thread_PopJob(worker, currentJobLane, &job, &lane))
+	{
+		Thread_RunJob(worker, &job, lane);
+		count++;
+	}
+
+	return count;
+}
+
+bool Thread_GetLaneStats(ThreadWorker_t *worker, ThreadPriority_e priority, ThreadLaneStats_t *stats)
+{
+	if(worker==NULL||stats==NULL||(uint32_t)priority>=THREAD_PRIORITY_COUNT)
 		return false;
 
+	ThreadLane_t *lane=&worker->lanes[priority];
+
+	stats->depth=ThreadMPSC_GetCount(&lane->jobs);
+	stats->peakDepth=atomic_load(&lane->peakDepth);
+	stats->executed=atomic_load(&lane->executed);
+	stats->averageLatency=stats->executed?(double)atomic_load(&lane->totalLatency)/stats->executed/1000000.0:0.0;
+	stats->maxLatency=(double)atomic_load(&lane->maxLatency)/1000000.0;
+
 	return true;
 }
 
+void Thread_PrintStats(ThreadWorker_t *worker)
+{
+	if(worker==NULL)
+		return;
+
+	for(uint32_t i=0;i<THREAD_PRIORITY_COUNT;i++)
+	{
+		ThreadLaneStats_t stats;
+
+		if(Thread_GetLaneStats(worker, i, &stats))
+			DBGPRINTF(DEBUG_WARNING, "\t%s lane: %d queued (peak %d), %zu run, latency %0.3fms avg %0.3fms max\n", threadPriorityNames[i], stats.depth, stats.peakDepth, stats.executed, stats.averageLatency, stats.maxLatency);
+	}
+}
+
 // Assigns a constructor function and argument to the thread
 void Thread_AddConstructor(ThreadWorker_t *worker, ThreadFunction_t constructorFunc, void *arg)
 {
@@ -109,10 +502,12 @@ bool Thread_Init(ThreadWorker_t *worker)
 		return false;
 
 	// Not stopped
-	worker->stop=false;
+	atomic_init(&worker->stop, false);
 
 	// Not paused
-	worker->pause=false;
+	atomic_init(&worker->pause, false);
+
+	atomic_init(&worker->sleeping, false);
 
 	// No constructor
 	worker->constructor=NULL;
@@ -122,14 +517,35 @@ bool Thread_Init(ThreadWorker_t *worker)
 	worker->destructor=NULL;
 	worker->destructorArg=NULL;
 
-	// initialize the job list
-	memset(worker->jobs, 0, sizeof(ThreadJob_t)*THREAD_MAXJOBS);
-	worker->numJobs=0;
+	// initialize the job lanes
+	for(uint32_t i=0;i<THREAD_PRIORITY_COUNT;i++)
+	{
+		ThreadLane_t *lane=&worker->lanes[i];
+
+		if(!ThreadMPSC_Init(&lane->jobs, sizeof(ThreadJob_t), THREAD_MAXJOBS))
+		{
+			DBGPRINTF(DEBUG_ERROR, "Unable to create job queue.\r\n");
+
+			while(i--)
+				ThreadMPSC_Destroy(&worker->lanes[i].jobs);
+
+			return false;
+		}
+
+		atomic_init(&lane->peakDepth, 0);
+		atomic_init(&lane->executed, 0);
+		atomic_init(&lane->totalLatency, 0);
+		atomic_init(&lane->maxLatency, 0);
+	}
 
 	// Initialize the mutex
 	if(mtx_init(&worker->mutex, mtx_plain))
 	{
 		DBGPRINTF(DEBUG_ERROR, "Unable to create mutex.\r\n");
+
+		for(uint32_t i=0;i<THREAD_PRIORITY_COUNT;i++)
+			ThreadMPSC_Destroy(&worker->lanes[i].jobs);
+
 		return false;
 	}
 
@@ -137,6 +553,11 @@ bool Thread_Init(ThreadWorker_t *worker)
 	if(cnd_init(&worker->condition))
 	{
 		DBGPRINTF(DEBUG_ERROR, "Unable to create condition.\r\n");
+		mtx_destroy(&worker->mutex);
+
+		for(uint32_t i=0;i<THREAD_PRIORITY_COUNT;i++)
+			ThreadMPSC_Destroy(&worker->lanes[i].jobs);
+
 		return false;
 	}
 
@@ -162,7 +583,7 @@ bool Thread_Start(ThreadWorker_t *worker)
 void Thread_Pause(ThreadWorker_t *worker)
 {
 	mtx_lock(&worker->mutex);
-	worker->pause=true;
+	atomic_store(&worker->pause, true);
 	mtx_unlock(&worker->mutex);
 }
 
@@ -170,7 +591,7 @@ void Thread_Pause(ThreadWorker_t *worker)
 void Thread_Resume(ThreadWorker_t *worker)
 {
 	mtx_lock(&worker->mutex);
-	worker->pause=false;
+	atomic_store(&worker->pause, false);
 	cnd_broadcast(&worker->condition);
 	mtx_unlock(&worker->mutex);
 }
@@ -184,10 +605,10 @@ bool Thread_Destroy(ThreadWorker_t *worker)
 	mtx_lock(&worker->mutex);
 
 	// Stop thread
-	worker->stop=true;
+	atomic_store(&worker->stop, true);
 
 	// Wake up thread
-	worker->pause=false;
+	atomic_store(&worker->pause, false);
 	cnd_broadcast(&worker->condition);
 
 	mtx_unlock(&worker->mutex);
@@ -203,47 +624,1108 @@ bool Thread_Destroy(ThreadWorker_t *worker)
 	mtx_destroy(&worker->mutex);
 	cnd_destroy(&worker->condition);
 
+	for(uint32_t i=0;i<THREAD_PRIORITY_COUNT;i++)
+		ThreadMPSC_Destroy(&worker->lanes[i].jobs);
+
 	return true;
 }
 
-bool ThreadBarrier_Init(ThreadBarrier_t *barrier, uint32_t count)
+// Spin-then-block waiting
+
+// Tell the CPU this is a spin loop, saves power and gives the other hyperthread the core
+static inline void Thread_CPUPause(void)
 {
-	if(count==0)
-		return false;
+#if defined(WIN32)
+	YieldProcessor();
+#elif defined(__x86_64__)||defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)||defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
 
-	if(cnd_init(&barrier->cond)!=thrd_success)
-		return false;
+// Spinning is just wasted time if there's no other CPU to make progress
+static uint32_t Thread_DefaultSpinCount(void)
+{
+	return Thread_GetCPUCount()>1?THREAD_SPIN_COUNT:0;
+}
 
-	if(mtx_init(&barrier->mutex, mtx_plain)!=thrd_success)
-		return false;
+#if defined(LINUX)||defined(ANDROID)
+// Sleeps only if *address is still expected, so a wake between the check and the sleep isn't lost
+static void Thread_FutexWait(atomic_uint *address, uint32_t expected)
+{
+	syscall(SYS_futex, (uint32_t *)address, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
 
-	barrier->count=count;
-	barrier->initCount=count;
-	barrier->check=0;
+static void Thread_FutexWake(atomic_uint *address, int count)
+{
+	syscall(SYS_futex, (uint32_t *)address, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+#endif
 
-	return true;
+// Spin until *address isn't expected anymore, returns false if it gave up
+static bool Thread_SpinWhile(atomic_uint *address, uint32_t expected, uint32_t spinCount)
+{
+	for(uint32_t i=0;i<spinCount;i++)
+	{
+		if(atomic_load_explicit(address, memory_order_acquire)!=expected)
+			return true;
+
+		Thread_CPUPause();
+	}
+
+	return atomic_load_explicit(address, memory_order_acquire)!=expected;
 }
 
-bool ThreadBarrier_Wait(ThreadBarrier_t *barrier)
+// Sleep until *address isn't expected anymore.
+// waiters is bumped first, the waking side changes *address then checks waiters, so one of the two always sees the other.
+static void Thread_BlockWhile(atomic_uint *address, uint32_t expected, atomic_uint *waiters, mtx_t *mutex, cnd_t *cond)
 {
-	mtx_lock(&barrier->mutex);
-	uint32_t check=barrier->check;
+	atomic_fetch_add(waiters, 1);
 
-	if(--barrier->count==0)
-	{
-		barrier->check++;
-		barrier->count=barrier->initCount;
+#if defined(LINUX)||defined(ANDROID)
+	(void)mutex;
+	(void)cond;
 
-		cnd_broadcast(&barrier->cond);
-		mtx_unlock(&barrier->mutex);
+	while(atomic_load(address)==expected)
+		Thread_FutexWait(address, expected);
+#else
+	mtx_lock(mutex);
 
-		return false;
-	}
+	while(atomic_load(address)==expected)
+		cnd_wait(cond, mutex);
 
-	while(check==barrier->check)
-		cnd_wait(&barrier->cond, &barrier->mutex);
+	mtx_unlock(mutex);
+#endif
 
-	mtx_unlock(&barrier->mutex);
+	atomic_fetch_sub(waiters, 1);
+}
 
-	return true;
+// Wake threads sleeping in Thread_BlockWhile, *address must already have been changed
+static void Thread_Wake(atomic_uint *address, atomic_uint *waiters, mtx_t *mutex, cnd_t *cond, bool all)
+{
+	if(!atomic_load(waiters))
+		return;
+
+#if defined(LINUX)||defined(ANDROID)
+	(void)mutex;
+	(void)cond;
+
+	Thread_FutexWake(address, all?INT_MAX:1);
+#else
+	mtx_lock(mutex);
+
+	if(all)
+		cnd_broadcast(cond);
+	else
+		cnd_signal(cond);
+
+	mtx_unlock(mutex);
+#endif
+}
+
+bool ThreadBarrier_Init(ThreadBarrier_t *barrier, uint32_t count)
+{
+	if(barrier==NULL||count==0)
+		return false;
+
+	if(cnd_init(&barrier->cond)!=thrd_success)
+		return false;
+
+	if(mtx_init(&barrier->mutex, mtx_plain)!=thrd_success)
+	{
+		cnd_destroy(&barrier->cond);
+		return false;
+	}
+
+	atomic_init(&barrier->count, count);
+	atomic_init(&barrier->generation, 0);
+	atomic_init(&barrier->waiters, 0);
+	barrier->initCount=count;
+	barrier->spinCount=Thread_DefaultSpinCount();
+
+	atomic_init(&barrier->spins, 0);
+	atomic_init(&barrier->blocks, 0);
+
+	return true;
+}
+
+void ThreadBarrier_Destroy(ThreadBarrier_t *barrier)
+{
+	if(barrier==NULL)
+		return;
+
+	mtx_destroy(&barrier->mutex);
+	cnd_destroy(&barrier->cond);
+}
+
+// Returns false for the last thread to arrive (the one that releases the others), true for the rest
+bool ThreadBarrier_Wait(ThreadBarrier_t *barrier)
+{
+	const uint32_t generation=atomic_load_explicit(&barrier->generation, memory_order_acquire);
+
+	if(atomic_fetch_sub(&barrier->count, 1)==1)
+	{
+		// Reset for the next round before releasing anyone, they could come straight back around
+		atomic_store(&barrier->count, barrier->initCount);
+		atomic_fetch_add(&barrier->generation, 1);
+
+		Thread_Wake(&barrier->generation, &barrier->waiters, &barrier->mutex, &barrier->cond, true);
+
+		return false;
+	}
+
+	if(Thread_SpinWhile(&barrier->generation, generation, barrier->spinCount))
+	{
+		atomic_fetch_add_explicit(&barrier->spins, 1, memory_order_relaxed);
+		return true;
+	}
+
+	atomic_fetch_add_explicit(&barrier->blocks, 1, memory_order_relaxed);
+	Thread_BlockWhile(&barrier->generation, generation, &barrier->waiters, &barrier->mutex, &barrier->cond);
+
+	return true;
+}
+
+void ThreadBarrier_GetStats(ThreadBarrier_t *barrier, size_t *spins, size_t *blocks)
+{
+	if(barrier==NULL)
+		return;
+
+	if(spins)
+		*spins=atomic_load(&barrier->spins);
+
+	if(blocks)
+		*blocks=atomic_load(&barrier->blocks);
+}
+
+bool ThreadEvent_Init(ThreadEvent_t *event, bool autoReset)
+{
+	if(event==NULL)
+		return false;
+
+	if(cnd_init(&event->cond)!=thrd_success)
+		return false;
+
+	if(mtx_init(&event->mutex, mtx_plain)!=thrd_success)
+	{
+		cnd_destroy(&event->cond);
+		return false;
+	}
+
+	atomic_init(&event->state, 0);
+	atomic_init(&event->waiters, 0);
+	event->autoReset=autoReset;
+	event->spinCount=Thread_DefaultSpinCount();
+
+	atomic_init(&event->spins, 0);
+	atomic_init(&event->blocks, 0);
+
+	return true;
+}
+
+void ThreadEvent_Destroy(ThreadEvent_t *event)
+{
+	if(event==NULL)
+		return;
+
+	mtx_destroy(&event->mutex);
+	cnd_destroy(&event->cond);
+}
+
+void ThreadEvent_Set(ThreadEvent_t *event)
+{
+	atomic_store(&event->state, 1);
+	Thread_Wake(&event->state, &event->waiters, &event->mutex, &event->cond, !event->autoReset);
+}
+
+void ThreadEvent_Reset(ThreadEvent_t *event)
+{
+	atomic_store(&event->state, 0);
+}
+
+bool ThreadEvent_IsSet(ThreadEvent_t *event)
+{
+	return atomic_load(&event->state)!=0;
+}
+
+// Auto reset events consume the set, so each set releases exactly one wait
+static inline bool ThreadEvent_TryTake(ThreadEvent_t *event)
+{
+	if(!event->autoReset)
+		return atomic_load_explicit(&event->state, memory_order_acquire)!=0;
+
+	uint32_t expected=1;
+
+	return atomic_compare_exchange_strong(&event->state, &expected, 0);
+}
+
+void ThreadEvent_Wait(ThreadEvent_t *event)
+{
+	if(ThreadEvent_TryTake(event))
+		return;
+
+	bool blocked=false;
+
+	for(;;)
+	{
+		// Another waiter on an auto reset event can take it first, so spin/block again until this one gets it
+		if(blocked||!Thread_SpinWhile(&event->state, 0, event->spinCount))
+		{
+			blocked=true;
+			Thread_BlockWhile(&event->state, 0, &event->waiters, &event->mutex, &event->cond);
+		}
+
+		if(ThreadEvent_TryTake(event))
+			break;
+	}
+
+	atomic_fetch_add_explicit(blocked?&event->blocks:&event->spins, 1, memory_order_relaxed);
+}
+
+void ThreadEvent_GetStats(ThreadEvent_t *event, size_t *spins, size_t *blocks)
+{
+	if(event==NULL)
+		return;
+
+	if(spins)
+		*spins=atomic_load(&event->spins);
+
+	if(blocks)
+		*blocks=atomic_load(&event->blocks);
+}
+
+// Wait handles
+
+bool ThreadWait_Init(ThreadWait_t *wait)
+{
+	if(wait==NULL)
+		return false;
+
+	atomic_init(&wait->count, 0);
+
+	if(mtx_init(&wait->mutex, mtx_plain)!=thrd_success)
+		return false;
+
+	if(cnd_init(&wait->condition)!=thrd_success)
+	{
+		mtx_destroy(&wait->mutex);
+		return false;
+	}
+
+	return true;
+}
+
+// Only safe once ThreadPool_Wait has returned for it
+void ThreadWait_Destroy(ThreadWait_t *wait)
+{
+	if(wait==NULL)
+		return;
+
+	mtx_destroy(&wait->mutex);
+	cnd_destroy(&wait->condition);
+}
+
+bool ThreadWait_IsDone(ThreadWait_t *wait)
+{
+	return wait==NULL||atomic_load(&wait->count)==0;
+}
+
+// Mark one job done, the final decrement happens with the mutex held,
+//		so a waiter that sees the count hit zero can't destroy the wait handle out from under the signaling thread.
+static void ThreadWait_Signal(ThreadWait_t *wait)
+{
+	uint32_t count=atomic_load(&wait->count);
+
+	while(count>1)
+	{
+		if(atomic_compare_exchange_weak(&wait->count, &count, count-1))
+			return;
+	}
+
+	mtx_lock(&wait->mutex);
+
+	if(atomic_fetch_sub(&wait->count, 1)==1)
+		cnd_broadcast(&wait->condition);
+
+	mtx_unlock(&wait->mutex);
+}
+
+// Work stealing deque
+
+static ThreadDequeArray_t *ThreadDeque_AllocArray(int64_t size)
+{
+	ThreadDequeArray_t *array=(ThreadDequeArray_t *)Zone_MallocTagged(zone, sizeof(ThreadDequeArray_t)+sizeof(ThreadPoolJob_t *)*size, TAG_SYSTEM);
+
+	if(array==NULL)
+		return NULL;
+
+	array->next=NULL;
+	array->size=size;
+
+	return array;
+}
+
+static bool ThreadDeque_Init(ThreadDeque_t *deque)
+{
+	ThreadDequeArray_t *array=ThreadDeque_AllocArray(THREAD_DEQUE_SIZE);
+
+	if(array==NULL)
+		return false;
+
+	atomic_init(&deque->top, 0);
+	atomic_init(&deque->bottom, 0);
+	atomic_init(&deque->array, array);
+	deque->retired=NULL;
+
+	return true;
+}
+
+static void ThreadDeque_Destroy(ThreadDeque_t *deque)
+{
+	ThreadDequeArray_t *array=atomic_load(&deque->array);
+
+	if(array)
+		Zone_Free(zone, array);
+
+	while(deque->retired)
+	{
+		ThreadDequeArray_t *next=deque->retired->next;
+		Zone_Free(zone, deque->retired);
+		deque->retired=next;
+	}
+
+	atomic_store(&deque->array, NULL);
+}
+
+// Owner only, returns false if the deque needed to grow and couldn't
+static bool ThreadDeque_Push(ThreadDeque_t *deque, ThreadPoolJob_t *job)
+{
+	const int64_t bottom=atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	const int64_t top=atomic_load_explicit(&deque->top, memory_order_acquire);
+	ThreadDequeArray_t *array=atomic_load_explicit(&deque->array, memory_order_relaxed);
+
+	if(bottom-top>array->size-1)
+	{
+		ThreadDequeArray_t *newArray=ThreadDeque_AllocArray(array->size*2);
+
+		if(newArray==NULL)
+			return false;
+
+		for(int64_t i=top;i<bottom;i++)
+			atomic_store_explicit(&newArray->jobs[i&(newArray->size-1)], atomic_load_explicit(&array->jobs[i&(array->size-1)], memory_order_relaxed), memory_order_relaxed);
+
+		array->next=deque->retired;
+		deque->retired=array;
+
+		atomic_store_explicit(&deque->array, newArray, memory_order_release);
+		array=newArray;
+	}
+
+	atomic_store_explicit(&array->jobs[bottom&(array->size-1)], job, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&deque->bottom, bottom+1, memory_order_relaxed);
+
+	return true;
+}
+
+// Owner only, takes the most recently pushed job
+static ThreadPoolJob_t *ThreadDeque_Take(ThreadDeque_t *deque)
+{
+	const int64_t bottom=atomic_load_explicit(&deque->bottom, memory_order_relaxed)-1;
+	ThreadDequeArray_t *array=atomic_load_explicit(&deque->array, memory_order_relaxed);
+
+	atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+
+	int64_t top=atomic_load_explicit(&deque->top, memory_order_relaxed);
+	ThreadPoolJob_t *job=NULL;
+
+	if(top<=bottom)
+	{
+		job=atomic_load_explicit(&array->jobs[bottom&(array->size-1)], memory_order_relaxed);
+
+		// Last job, race any thieves for it
+		if(top==bottom)
+		{
+			if(!atomic_compare_exchange_strong_explicit(&deque->top, &top, top+1, memory_order_seq_cst, memory_order_relaxed))
+				job=NULL;
+
+			atomic_store_explicit(&deque->bottom, bottom+1, memory_order_relaxed);
+		}
+	}
+	else
+		atomic_store_explicit(&deque->bottom, bottom+1, memory_order_relaxed);
+
+	return job;
+}
+
+// Any thread, takes the oldest job. Sets retry if it lost a race, rather than the deque being empty.
+static ThreadPoolJob_t *ThreadDeque_Steal(ThreadDeque_t *deque, bool *retry)
+{
+	int64_t top=atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	const int64_t bottom=atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+	if(top<bottom)
+	{
+		ThreadDequeArray_t *array=atomic_load_explicit(&deque->array, memory_order_acquire);
+		ThreadPoolJob_t *job=atomic_load_explicit(&array->jobs[top&(array->size-1)], memory_order_relaxed);
+
+		if(!atomic_compare_exchange_strong_explicit(&deque->top, &top, top+1, memory_order_seq_cst, memory_order_relaxed))
+		{
+			*retry=true;
+			return NULL;
+		}
+
+		return job;
+	}
+
+	return NULL;
+}
+
+// Thread pool
+
+// Worker the calling thread belongs to, if it's a pool worker
+static thread_local ThreadPoolWorker_t *currentWorker=NULL;
+
+// First pool to start, used by the calls that don't take a pool
+static _Atomic(ThreadPool_t *) defaultPool=NULL;
+
+static inline ThreadPoolWorker_t *ThreadPool_GetWorker(ThreadPool_t *pool)
+{
+	return (currentWorker&&currentWorker->pool==pool)?currentWorker:NULL;
+}
+
+static inline uint32_t ThreadPool_Random(uint32_t *seed)
+{
+	uint32_t x=*seed;
+
+	x^=x<<13;
+	x^=x>>17;
+	x^=x<<5;
+
+	return *seed=x;
+}
+
+// Queue a job from a thread outside of the pool, returns false if the queue needed to grow and couldn't
+static bool ThreadPool_Enqueue(ThreadPool_t *pool, ThreadPoolJob_t *job)
+{
+	mtx_lock(&pool->queueMutex);
+
+	const uint32_t count=atomic_load_explicit(&pool->queueCount, memory_order_relaxed);
+
+	if(count>=pool->queueSize)
+	{
+		const uint32_t newSize=pool->queueSize?pool->queueSize*2:THREAD_DEQUE_SIZE;
+		ThreadPoolJob_t **newQueue=(ThreadPoolJob_t **)Zone_MallocTagged(zone, sizeof(ThreadPoolJob_t *)*newSize, TAG_SYSTEM);
+
+		if(newQueue==NULL)
+		{
+			mtx_unlock(&pool->queueMutex);
+			return false;
+		}
+
+		// Unwrap the ring into the new buffer
+		for(uint32_t i=0;i<count;i++)
+			newQueue[i]=pool->queue[(pool->queueHead+i)%pool->queueSize];
+
+		Zone_Free(zone, pool->queue);
+
+		pool->queue=newQueue;
+		pool->queueHead=0;
+		pool->queueSize=newSize;
+	}
+
+	pool->queue[(pool->queueHead+count)%pool->queueSize]=job;
+	atomic_store_explicit(&pool->queueCount, count+1, memory_order_release);
+
+	mtx_unlock(&pool->queueMutex);
+
+	return true;
+}
+
+static ThreadPoolJob_t *ThreadPool_Dequeue(ThreadPool_t *pool)
+{
+	if(!atomic_load_explicit(&pool->queueCount, memory_order_acquire))
+		return NULL;
+
+	ThreadPoolJob_t *job=NULL;
+
+	mtx_lock(&pool->queueMutex);
+
+	const uint32_t count=atomic_load_explicit(&pool->queueCount, memory_order_relaxed);
+
+	if(count)
+	{
+		job=pool->queue[pool->queueHead];
+		pool->queueHead=(pool->queueHead+1)%pool->queueSize;
+		atomic_store_explicit(&pool->queueCount, count-1, memory_order_relaxed);
+	}
+
+	mtx_unlock(&pool->queueMutex);
+
+	return job;
+}
+
+// Look for work, own deque first (newest first), then the shared queue, then steal from the other workers (oldest first).
+// worker is NULL for threads that aren't part of the pool, they can still help by stealing.
+static ThreadPoolJob_t *ThreadPool_FindJob(ThreadPool_t *pool, ThreadPoolWorker_t *worker)
+{
+	ThreadPoolJob_t *job=NULL;
+
+	if(worker)
+		job=ThreadDeque_Take(&worker->deque);
+
+	if(job==NULL)
+		job=ThreadPool_Dequeue(pool);
+
+	if(job==NULL)
+	{
+		static thread_local uint32_t externalSeed=0x9E3779B9;
+		uint32_t *seed=worker?&worker->seed:&externalSeed;
+		bool retry;
+
+		// Keep going as long as some steal lost a race, there's still work out there
+		do
+		{
+			retry=false;
+
+			const uint32_t start=ThreadPool_Random(seed)%pool->numWorkers;
+
+			for(uint32_t i=0;i<pool->numWorkers&&job==NULL;i++)
+			{
+				ThreadPoolWorker_t *victim=&pool->workers[(start+i)%pool->numWorkers];
+
+				if(victim!=worker)
+					job=ThreadDeque_Steal(&victim->deque, &retry);
+			}
+		} while(job==NULL&&retry);
+
+		if(job&&worker)
+			atomic_fetch_add_explicit(&worker->stolen, 1, memory_order_relaxed);
+	}
+
+	if(job)
+		atomic_fetch_sub(&pool->pending, 1);
+
+	return job;
+}
+
+static void ThreadPool_RunJob(ThreadPool_t *pool, ThreadPoolWorker_t *worker, ThreadPoolJob_t *job)
+{
+	// Copy it out so the job slot can be reused right away
+	const ThreadPoolJob_t local=*job;
+	Pool_Free(&pool->jobPool, job);
+
+	local.function(local.arg);
+
+	if(local.wait)
+		ThreadWait_Signal(local.wait);
+
+	if(worker)
+		atomic_fetch_add_explicit(&worker->executed, 1, memory_order_relaxed);
+}
+
+static int ThreadPool_Worker(void *data)
+{
+	ThreadPoolWorker_t *worker=(ThreadPoolWorker_t *)data;
+	ThreadPool_t *pool=worker->pool;
+
+	currentWorker=worker;
+
+	for(;;)
+	{
+		ThreadPoolJob_t *job=ThreadPool_FindJob(pool, worker);
+
+		if(job)
+		{
+			ThreadPool_RunJob(pool, worker, job);
+			continue;
+		}
+
+		// Only exit once everything queued has been run
+		if(atomic_load(&pool->stop)&&!atomic_load(&pool->pending))
+			break;
+
+		// Nothing to do, sleep until something gets submitted.
+		// Submitters bump pending before checking sleeping, and this bumps sleeping before checking pending, so a wake up can't be missed.
+		mtx_lock(&pool->sleepMutex);
+		atomic_fetch_add(&pool->sleeping, 1);
+
+		while(!atomic_load(&pool->pending)&&!atomic_load(&pool->stop))
+			cnd_wait(&pool->sleepCondition, &pool->sleepMutex);
+
+		atomic_fetch_sub(&pool->sleeping, 1);
+		mtx_unlock(&pool->sleepMutex);
+	}
+
+	currentWorker=NULL;
+
+	// Hand any cached pool slots and zone blocks back before the thread goes away
+	Pool_ReleaseThreadCache();
+	Zone_ReleaseThreadCache(zone);
+
+	return 0;
+}
+
+// Start a pool with numWorkers threads, 0 for one per CPU
+bool ThreadPool_Init(ThreadPool_t *pool, uint32_t numWorkers)
+{
+	if(pool==NULL)
+		return false;
+
+	memset(pool, 0, sizeof(ThreadPool_t));
+
+	if(!numWorkers)
+		numWorkers=Thread_GetCPUCount();
+
+	if(numWorkers>THREAD_POOL_MAX_WORKERS)
+		numWorkers=THREAD_POOL_MAX_WORKERS;
+
+	if(!Pool_Init(&pool->jobPool, sizeof(ThreadPoolJob_t), 1024))
+	{
+		DBGPRINTF(DEBUG_ERROR, "ThreadPool_Init: Unable to create job pool.\n");
+		return false;
+	}
+
+	if(mtx_init(&pool->queueMutex, mtx_plain)!=thrd_success||mtx_init(&pool->sleepMutex, mtx_plain)!=thrd_success||cnd_init(&pool->sleepCondition)!=thrd_success)
+	{
+		DBGPRINTF(DEBUG_ERROR, "ThreadPool_Init: Unable to create mutex/condition.\n");
+		Pool_Destroy(&pool->jobPool);
+		return false;
+	}
+
+	atomic_init(&pool->queueCount, 0);
+	atomic_init(&pool->sleeping, 0);
+	atomic_init(&pool->pending, 0);
+	atomic_init(&pool->stop, false);
+
+	for(uint32_t i=0;i<numWorkers;i++)
+	{
+		ThreadPoolWorker_t *worker=&pool->workers[i];
+
+		worker->pool=pool;
+		worker->index=i;
+		worker->seed=0x9E3779B9u*(i+1);
+		atomic_init(&worker->executed, 0);
+		atomic_init(&worker->stolen, 0);
+
+		if(!ThreadDeque_Init(&worker->deque))
+		{
+			DBGPRINTF(DEBUG_ERROR, "ThreadPool_Init: Unable to allocate worker deque.\n");
+			ThreadPool_Destroy(pool);
+			return false;
+		}
+
+		// Deques have to exist before any worker starts stealing, so count it after it's set up
+		pool->numWorkers=i+1;
+	}
+
+	for(uint32_t i=0;i<numWorkers;i++)
+	{
+		if(thrd_create(&pool->workers[i].thread, ThreadPool_Worker, (void *)&pool->workers[i])!=thrd_success)
+		{
+			DBGPRINTF(DEBUG_ERROR, "ThreadPool_Init: Unable to create worker thread.\n");
+
+			// Only join the ones that did start
+			pool->numWorkers=i;
+			ThreadPool_Destroy(pool);
+			return false;
+		}
+	}
+
+	ThreadPool_t *expected=NULL;
+	atomic_compare_exchange_strong(&defaultPool, &expected, pool);
+
+#ifdef _DEBUG
+	DBGPRINTF(DEBUG_INFO, "ThreadPool_Init: Started %d workers.\n", numWorkers);
+#endif
+
+	return true;
+}
+
+// Runs everything still queued, then stops and joins the workers
+void ThreadPool_Destroy(ThreadPool_t *pool)
+{
+	if(pool==NULL)
+		return;
+
+	ThreadPool_t *expected=pool;
+	atomic_compare_exchange_strong(&defaultPool, &expected, NULL);
+
+	mtx_lock(&pool->sleepMutex);
+	atomic_store(&pool->stop, true);
+	cnd_broadcast(&pool->sleepCondition);
+	mtx_unlock(&pool->sleepMutex);
+
+	for(uint32_t i=0;i<pool->numWorkers;i++)
+	{
+#ifndef WIN32
+		if(pool->workers[i].thread)
+#endif
+			thrd_join(pool->workers[i].thread, NULL);
+	}
+
+	// Anything left over (only if no workers ever started) gets run here, nothing is ever dropped
+	ThreadPoolJob_t *job;
+
+	while((job=ThreadPool_Dequeue(pool))!=NULL)
+		ThreadPool_RunJob(pool, NULL, job);
+
+	for(uint32_t i=0;i<pool->numWorkers;i++)
+		ThreadDeque_Destroy(&pool->workers[i].deque);
+
+	pool->numWorkers=0;
+
+	Zone_Free(zone, pool->queue);
+	pool->queue=NULL;
+	pool->queueSize=0;
+
+	Pool_Destroy(&pool->jobPool);
+
+	mtx_destroy(&pool->queueMutex);
+	mtx_destroy(&pool->sleepMutex);
+	cnd_destroy(&pool->sleepCondition);
+}
+
+// Queue a job on the pool, wait (optional) is signaled when the job finishes.
+// Work is never dropped, if there's no memory to queue the job it's run right away on the calling thread.
+bool ThreadPool_Submit(ThreadPool_t *pool, ThreadFunction_t function, void *arg, ThreadWait_t *wait)
+{
+	if(pool==NULL||function==NULL)
+		return false;
+
+	if(wait)
+		atomic_fetch_add(&wait->count, 1);
+
+	ThreadPoolJob_t *job=(ThreadPoolJob_t *)Pool_Malloc(&pool->jobPool);
+
+	if(job==NULL||!pool->numWorkers||atomic_load(&pool->stop))
+	{
+		if(job)
+			Pool_Free(&pool->jobPool, job);
+
+		function(arg);
+
+		if(wait)
+			ThreadWait_Signal(wait);
+
+		return true;
+	}
+
+	job->function=function;
+	job->arg=arg;
+	job->wait=wait;
+
+	// Counted before it's visible, so a worker can't take it and decrement first
+	atomic_fetch_add(&pool->pending, 1);
+
+	// Workers push onto their own deque, everyone else goes through the shared queue
+	ThreadPoolWorker_t *worker=ThreadPool_GetWorker(pool);
+
+	if(!((worker&&ThreadDeque_Push(&worker->deque, job))||ThreadPool_Enqueue(pool, job)))
+	{
+		atomic_fetch_sub(&pool->pending, 1);
+		ThreadPool_RunJob(pool, NULL, job);
+		return true;
+	}
+
+	if(atomic_load(&pool->sleeping))
+	{
+		mtx_lock(&pool->sleepMutex);
+		cnd_signal(&pool->sleepCondition);
+		mtx_unlock(&pool->sleepMutex);
+	}
+
+	return true;
+}
+
+// Block until every job submitted with this wait handle has finished.
+// The calling thread runs queued jobs while it waits, so this is safe to call from inside a job.
+void ThreadPool_Wait(ThreadPool_t *pool, ThreadWait_t *wait)
+{
+	if(pool==NULL||wait==NULL)
+		return;
+
+	ThreadPoolWorker_t *worker=ThreadPool_GetWorker(pool);
+
+	while(atomic_load(&wait->count))
+	{
+		ThreadPoolJob_t *job=ThreadPool_FindJob(pool, worker);
+
+		if(job)
+		{
+			ThreadPool_RunJob(pool, worker, job);
+			continue;
+		}
+
+		// Nothing to help with, sleep for a bit.
+		// Timed, since new work that this could help with may show up while the remaining jobs finish.
+		mtx_lock(&wait->mutex);
+
+		if(atomic_load(&wait->count))
+		{
+			struct timespec ts;
+			timespec_get(&ts, TIME_UTC);
+
+			ts.tv_nsec+=1000000;
+
+			if(ts.tv_nsec>=1000000000)
+			{
+				ts.tv_sec++;
+				ts.tv_nsec-=1000000000;
+			}
+
+			cnd_timedwait(&wait->condition, &wait->mutex, &ts);
+		}
+
+		mtx_unlock(&wait->mutex);
+	}
+
+	// The last job to finish may still be holding the mutex
+	mtx_lock(&wait->mutex);
+	mtx_unlock(&wait->mutex);
+}
+
+void ThreadPool_Print(ThreadPool_t *pool)
+{
+	if(pool==NULL)
+		return;
+
+	DBGPRINTF(DEBUG_WARNING, "Thread pool: %d workers, %d jobs pending\n", pool->numWorkers, atomic_load(&pool->pending));
+
+	for(uint32_t i=0;i<pool->numWorkers;i++)
+	{
+		ThreadPoolWorker_t *worker=&pool->workers[i];
+
+		DBGPRINTF(DEBUG_WARNING, "\tWorker %d: %zu jobs run, %zu stolen\n", i, atomic_load(&worker->executed), atomic_load(&worker->stolen));
+	}
+}
+
+ThreadPool_t *ThreadPool_GetDefault(void)
+{
+	return atomic_load(&defaultPool);
+}
+
+// Parallel for
+
+typedef struct
+{
+	ThreadRangeFunction_t function;
+	void *userdata;
+
+	uint32_t begin, end, grainSize, numChunks;
+
+	// Next chunk to hand out
+	atomic_uint next;
+} ThreadParallelFor_t;
+
+// Pulls chunks until there are none left, so uneven chunks balance out without any extra jobs
+static void ThreadParallelFor_Run(void *arg)
+{
+	ThreadParallelFor_t *parallelFor=(ThreadParallelFor_t *)arg;
+	uint32_t chunk;
+
+	while((chunk=atomic_fetch_add(&parallelFor->next, 1))<parallelFor->numChunks)
+	{
+		const uint32_t start=parallelFor->begin+chunk*parallelFor->grainSize;
+		const uint32_t end=(parallelFor->end-start>parallelFor->grainSize)?start+parallelFor->grainSize:parallelFor->end;
+
+		parallelFor->function(start, end, parallelFor->userdata);
+	}
+}
+
+// Split [begin, end) into chunks of grainSize and run them across the pool, returns once every chunk is done.
+// A grainSize of 0 picks one that gives each thread a few chunks.
+// The calling thread works on chunks too, so this is safe to call from inside a job.
+void ThreadPool_ParallelFor(ThreadPool_t *pool, uint32_t begin, uint32_t end, uint32_t grainSize, ThreadRangeFunction_t function, void *userdata)
+{
+	if(function==NULL||end<=begin)
+		return;
+
+	const uint32_t count=end-begin;
+	const uint32_t numThreads=(pool?pool->numWorkers:0)+1;
+
+	if(!grainSize)
+	{
+		grainSize=count/(numThreads*4);
+
+		if(!grainSize)
+			grainSize=1;
+	}
+
+	// Not worth splitting
+	if(pool==NULL||numThreads==1||count<=grainSize)
+	{
+		function(begin, end, userdata);
+		return;
+	}
+
+	ThreadParallelFor_t parallelFor=
+	{
+		.function=function,
+		.userdata=userdata,
+		.begin=begin,
+		.end=end,
+		.grainSize=grainSize,
+		.numChunks=(uint32_t)(((uint64_t)count+grainSize-1)/grainSize),
+	};
+	atomic_init(&parallelFor.next, 0);
+
+	ThreadWait_t wait;
+
+	if(!ThreadWait_Init(&wait))
+	{
+		function(begin, end, userdata);
+		return;
+	}
+
+	// One helper job per extra chunk, up to the number of workers, this thread takes the rest
+	uint32_t numHelpers=parallelFor.numChunks-1;
+
+	if(numHelpers>pool->numWorkers)
+		numHelpers=pool->numWorkers;
+
+	for(uint32_t i=0;i<numHelpers;i++)
+		ThreadPool_Submit(pool, ThreadParallelFor_Run, &parallelFor, &wait);
+
+	ThreadParallelFor_Run(&parallelFor);
+
+	ThreadPool_Wait(pool, &wait);
+	ThreadWait_Destroy(&wait);
+}
+
+// Same as above on the default pool, runs serially if no pool has been started
+void Thread_ParallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, ThreadRangeFunction_t function, void *userdata)
+{
+	ThreadPool_ParallelFor(ThreadPool_GetDefault(), begin, end, grainSize, function, userdata);
+}
+
+// Task graph
+
+bool ThreadGraph_Init(ThreadTaskGraph_t *graph, ThreadPool_t *pool)
+{
+	if(graph==NULL)
+		return false;
+
+	memset(graph, 0, sizeof(ThreadTaskGraph_t));
+
+	graph->pool=pool;
+
+	if(!ThreadWait_Init(&graph->wait))
+	{
+		DBGPRINTF(DEBUG_ERROR, "ThreadGraph_Init: Unable to create wait handle.\n");
+		return false;
+	}
+
+	return true;
+}
+
+void ThreadGraph_Destroy(ThreadTaskGraph_t *graph)
+{
+	if(graph==NULL)
+		return;
+
+	ThreadWait_Destroy(&graph->wait);
+	graph->numTasks=0;
+}
+
+// Add a task that runs after all of the given predecessors have finished, predecessors must already be in this graph.
+// Returns NULL if the graph is full or a predecessor can't take any more successors.
+ThreadTask_t *ThreadGraph_AddTask(ThreadTaskGraph_t *graph, ThreadFunction_t function, void *arg, uint32_t numPredecessors, ThreadTask_t **predecessors)
+{
+	if(graph==NULL||function==NULL||(numPredecessors&&predecessors==NULL))
+		return NULL;
+
+	if(graph->numTasks>=THREAD_GRAPH_MAX_TASKS)
+	{
+		DBGPRINTF(DEBUG_ERROR, "ThreadGraph_AddTask: Too many tasks (max %d).\n", THREAD_GRAPH_MAX_TASKS);
+		return NULL;
+	}
+
+	for(uint32_t i=0;i<numPredecessors;i++)
+	{
+		ThreadTask_t *predecessor=predecessors[i];
+
+		if(predecessor==NULL||predecessor->graph!=graph)
+		{
+			DBGPRINTF(DEBUG_ERROR, "ThreadGraph_AddTask: Predecessor isn't part of this graph.\n");
+			return NULL;
+		}
+
+		if(predecessor->numSuccessors>=THREAD_TASK_MAX_SUCCESSORS)
+		{
+			DBGPRINTF(DEBUG_ERROR, "ThreadGraph_AddTask: Predecessor has too many successors (max %d).\n", THREAD_TASK_MAX_SUCCESSORS);
+			return NULL;
+		}
+	}
+
+	ThreadTask_t *task=&graph->tasks[graph->numTasks++];
+
+	task->function=function;
+	task->arg=arg;
+	task->graph=graph;
+	task->numPredecessors=numPredecessors;
+	task->numSuccessors=0;
+	atomic_init(&task->dependencies, numPredecessors);
+
+	for(uint32_t i=0;i<numPredecessors;i++)
+		predecessors[i]->successors[predecessors[i]->numSuccessors++]=task;
+
+	return task;
+}
+
+// Graphs made without a pool use whatever the default pool is when they run
+static inline ThreadPool_t *ThreadGraph_GetPool(ThreadTaskGraph_t *graph)
+{
+	return graph->pool?graph->pool:ThreadPool_GetDefault();
+}
+
+static void ThreadGraph_RunTask(void *arg)
+{
+	ThreadTask_t *task=(ThreadTask_t *)arg;
+	ThreadTaskGraph_t *graph=task->graph;
+
+	task->function(task->arg);
+
+	// Last predecessor to finish queues the successor.
+	// This happens before this task's own wait signal, so the graph's wait count can't hit zero early.
+	for(uint32_t i=0;i<task->numSuccessors;i++)
+	{
+		ThreadTask_t *successor=task->successors[i];
+
+		if(atomic_fetch_sub(&successor->dependencies, 1)==1)
+			ThreadPool_Submit(ThreadGraph_GetPool(graph), ThreadGraph_RunTask, successor, &graph->wait);
+	}
+}
+
+// Run every task in the graph and wait for them all to finish.
+// The calling thread runs tasks while it waits, with no pool the tasks are just run in the order they were added.
+void ThreadGraph_Run(ThreadTaskGraph_t *graph)
+{
+	if(graph==NULL)
+		return;
+
+	ThreadPool_t *pool=ThreadGraph_GetPool(graph);
+
+	if(pool==NULL)
+	{
+		for(uint32_t i=0;i<graph->numTasks;i++)
+			graph->tasks[i].function(graph->tasks[i].arg);
+
+		return;
+	}
+
+	// Counters all have to be reset before anything starts, a finishing task decrements it's successors
+	for(uint32_t i=0;i<graph->numTasks;i++)
+		atomic_store(&graph->tasks[i].dependencies, graph->tasks[i].numPredecessors);
+
+	for(uint32_t i=0;i<graph->numTasks;i++)
+	{
+		if(!graph->tasks[i].numPredecessors)
+			ThreadPool_Submit(pool, ThreadGraph_RunTask, &graph->tasks[i], &graph->wait);
+	}
+
+	ThreadPool_Wait(pool, &graph->wait);
 }
@@ -5,27 +5,101 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdatomic.h>
+#include <stdalign.h>
+#include "pool.h"
 
+// Capacity of a worker's job queue, must be a power of two
 #define THREAD_MAXJOBS 128
 
+#define THREAD_POOL_MAX_WORKERS 32
+
+// Starting size of each worker's deque, must be a power of two, deques grow as needed
+#define THREAD_DEQUE_SIZE 256
+
+#define THREAD_GRAPH_MAX_TASKS 64
+#define THREAD_TASK_MAX_SUCCESSORS 16
+
 typedef void (*ThreadFunction_t)(void *arg);
 
+// Parallel for callback, processes the range [start, end)
+typedef void (*ThreadRangeFunction_t)(uint32_t start, uint32_t end, void *userdata);
+
 // Structure that holds the function pointer and argument
 // to store in a list that can be iterated as a job list.
 typedef struct
 {
 	ThreadFunction_t function;
 	void *arg;
+
+	// When it was queued, for latency stats
+	uint64_t queueTime;
 } ThreadJob_t;
 
+// Worker job lanes, workers always run the highest lane with work in it first
+typedef enum
+{
+	THREAD_PRIORITY_REALTIME=0,		// Audio and anything else with a hard deadline
+	THREAD_PRIORITY_FRAME,			// Work the current frame is waiting on
+	THREAD_PRIORITY_BACKGROUND,		// Loading, encoding, etc. should call Thread_YieldJob at safe points
+	THREAD_PRIORITY_COUNT
+} ThreadPriority_e;
+
+// Bounded lock-free single producer, single consumer queue.
+// Elements are copied in and out by value, elementSize is fixed when it's created.
+// Each side keeps a cached copy of the other side's index, so the shared cache lines are only touched when it looks full/empty.
+typedef struct
+{
+	uint8_t *buffer;
+	uint32_t elementSize, capacity, mask;
+
+	alignas(64) atomic_size_t head;
+	size_t cachedTail;
+
+	alignas(64) atomic_size_t tail;
+	size_t cachedHead;
+} ThreadSPSC_t;
+
+// Bounded lock-free multiple producer, single consumer queue.
+// Every slot has a sequence number, producers claim a slot by moving the tail, then publish it by bumping the sequence.
+typedef struct
+{
+	uint8_t *buffer;
+	atomic_size_t *sequence;
+	uint32_t elementSize, capacity, mask;
+
+	alignas(64) atomic_size_t head;
+	alignas(64) atomic_size_t tail;
+} ThreadMPSC_t;
+
+typedef struct
+{
+	ThreadMPSC_t jobs;
+
+	atomic_uint peakDepth;
+	atomic_size_t executed;
+
+	// Nanoseconds from queued to started
+	atomic_uint_fast64_t totalLatency, maxLatency;
+} ThreadLane_t;
+
+typedef struct
+{
+	uint32_t depth, peakDepth;
+	size_t executed;
+
+	// Milliseconds
+	double averageLatency, maxLatency;
+} ThreadLaneStats_t;
+
 // Structure for worker context
 typedef struct
 {
-	bool pause;
-	bool stop;
+	atomic_bool pause;
+	atomic_bool stop;
 
-	ThreadJob_t jobs[THREAD_MAXJOBS];
-	uint32_t numJobs;
+	// Jobs are pushed without taking the mutex, it's only used to sleep/wake the worker
+	ThreadLane_t lanes[THREAD_PRIORITY_COUNT];
+	atomic_bool sleeping;
 
 	thrd_t thread;
 	mtx_t mutex;
@@ -38,17 +112,150 @@ typedef struct
 	void *destructorArg;
 } ThreadWorker_t;
 
+// How many times barriers and events spin (with a CPU pause each time) before going to sleep.
+// A few microseconds on most CPUs, long enough to cover short fork/join phases without a syscall.
+#define THREAD_SPIN_COUNT 2000
+
+// Spin-then-block barrier.
+// Threads arriving early spin for a bit waiting on the generation to change, then sleep (futex on Linux, condition otherwise).
+// spins/blocks count waits that finished while spinning and waits that had to sleep.
 typedef struct
 {
-    mtx_t mutex;
-    cnd_t cond;
+	atomic_uint count;
+	atomic_uint generation;
+	atomic_uint waiters;
 	uint32_t initCount;
-	uint32_t count;
-	uint32_t check;
+	uint32_t spinCount;
+
+	mtx_t mutex;
+	cnd_t cond;
+
+	atomic_size_t spins, blocks;
 } ThreadBarrier_t;
 
+// Spin-then-block event, auto reset events wake one waiter per set and clear themselves,
+// manual reset events stay set (releasing every waiter) until reset.
+typedef struct
+{
+	atomic_uint state;
+	atomic_uint waiters;
+	bool autoReset;
+	uint32_t spinCount;
+
+	mtx_t mutex;
+	cnd_t cond;
+
+	atomic_size_t spins, blocks;
+} ThreadEvent_t;
+
+// Wait handle, counts outstanding jobs so the submitter can block until they're all done
+typedef struct
+{
+	atomic_uint count;
+	mtx_t mutex;
+	cnd_t condition;
+} ThreadWait_t;
+
+typedef struct
+{
+	ThreadFunction_t function;
+	void *arg;
+	ThreadWait_t *wait;
+} ThreadPoolJob_t;
+
+typedef struct ThreadDequeArray_s
+{
+	struct ThreadDequeArray_s *next;
+	int64_t size;
+	_Atomic(ThreadPoolJob_t *) jobs[];
+} ThreadDequeArray_t;
+
+// Chase-Lev work stealing deque.
+// Only the owning worker pushes and takes from the bottom, any thread can steal from the top.
+// Arrays replaced by growing are kept on the retired list until the deque is destroyed, a thief may still be reading them.
+typedef struct
+{
+	alignas(64) _Atomic int64_t top;
+	alignas(64) _Atomic int64_t bottom;
+	_Atomic(ThreadDequeArray_t *) array;
+	ThreadDequeArray_t *retired;
+} ThreadDeque_t;
+
+struct ThreadPool_s;
+
+typedef struct
+{
+	struct ThreadPool_s *pool;
+	uint32_t index;
+	uint32_t seed;
+
+	thrd_t thread;
+	ThreadDeque_t deque;
+
+	atomic_size_t executed, stolen;
+} ThreadPoolWorker_t;
+
+typedef struct ThreadPool_s
+{
+	ThreadPoolWorker_t workers[THREAD_POOL_MAX_WORKERS];
+	uint32_t numWorkers;
+
+	Pool_t jobPool;
+
+	// Jobs submitted from threads outside of the pool, FIFO ring buffer that grows as needed
+	mtx_t queueMutex;
+	ThreadPoolJob_t **queue;
+	uint32_t queueHead, queueSize;
+	atomic_uint queueCount;
+
+	// Idle workers sleep on this, pending is the number of jobs queued anywhere in the pool
+	mtx_t sleepMutex;
+	cnd_t sleepCondition;
+	atomic_uint sleeping;
+	atomic_uint pending;
+	atomic_bool stop;
+} ThreadPool_t;
+
+struct ThreadTaskGraph_s;
+
+// Task graph node, becomes runnable once every predecessor has finished
+typedef struct ThreadTask_s
+{
+	ThreadFunction_t function;
+	void *arg;
+
+	struct ThreadTaskGraph_s *graph;
+
+	// Predecessors that haven't finished yet, reset to numPredecessors each time the graph runs
+	atomic_uint dependencies;
+	uint32_t numPredecessors;
+
+	struct ThreadTask_s *successors[THREAD_TASK_MAX_SUCCESSORS];
+	uint32_t numSuccessors;
+} ThreadTask_t;
+
+// Tasks can only depend on tasks that were added before them, so the graph can't have cycles
+// and the order tasks were added in is always a valid serial order.
+// A graph is built once and can be run any number of times, but only one run at a time.
+typedef struct ThreadTaskGraph_s
+{
+	ThreadPool_t *pool;
+
+	ThreadTask_t tasks[THREAD_GRAPH_MAX_TASKS];
+	uint32_t numTasks;
+
+	ThreadWait_t wait;
+} ThreadTaskGraph_t;
+
+uint32_t Thread_GetCPUCount(void);
+
 uint32_t Thread_GetJobCount(ThreadWorker_t *worker);
 bool Thread_AddJob(ThreadWorker_t *worker, ThreadFunction_t jobFunc, void *arg);
+bool Thread_AddJobPriority(ThreadWorker_t *worker, ThreadPriority_e priority, ThreadFunction_t jobFunc, void *arg);
+bool Thread_ShouldYield(void);
+uint32_t Thread_YieldJob(void);
+bool Thread_GetLaneStats(ThreadWorker_t *worker, ThreadPriority_e priority, ThreadLaneStats_t *stats);
+void Thread_PrintStats(ThreadWorker_t *worker);
 void Thread_AddConstructor(ThreadWorker_t *worker, ThreadFunction_t constructorFunc, void *arg);
 void Thread_AddDestructor(ThreadWorker_t *worker, ThreadFunction_t destructorFunc, void *arg);
 bool Thread_Init(ThreadWorker_t *worker);
@@ -57,7 +264,49 @@ void Thread_Pause(ThreadWorker_t *worker);
 void Thread_Resume(ThreadWorker_t *worker);
 bool Thread_Destroy(ThreadWorker_t *worker);
 
+bool ThreadSPSC_Init(ThreadSPSC_t *queue, uint32_t elementSize, uint32_t capacity);
+void ThreadSPSC_Destroy(ThreadSPSC_t *queue);
+bool ThreadSPSC_Push(ThreadSPSC_t *queue, const void *element);
+bool ThreadSPSC_Pop(ThreadSPSC_t *queue, void *element);
+uint32_t ThreadSPSC_GetCount(ThreadSPSC_t *queue);
+
+bool ThreadMPSC_Init(ThreadMPSC_t *queue, uint32_t elementSize, uint32_t capacity);
+void ThreadMPSC_Destroy(ThreadMPSC_t *queue);
+bool ThreadMPSC_Push(ThreadMPSC_t *queue, const void *element);
+bool ThreadMPSC_Pop(ThreadMPSC_t *queue, void *element);
+bool ThreadMPSC_IsEmpty(ThreadMPSC_t *queue);
+uint32_t ThreadMPSC_GetCount(ThreadMPSC_t *queue);
+
 bool ThreadBarrier_Init(ThreadBarrier_t *barrier, uint32_t count);
+void ThreadBarrier_Destroy(ThreadBarrier_t *barrier);
 bool ThreadBarrier_Wait(ThreadBarrier_t *barrier);
+void ThreadBarrier_GetStats(ThreadBarrier_t *barrier, size_t *spins, size_t *blocks);
+
+bool ThreadEvent_Init(ThreadEvent_t *event, bool autoReset);
+void ThreadEvent_Destroy(ThreadEvent_t *event);
+void ThreadEvent_Set(ThreadEvent_t *event);
+void ThreadEvent_Reset(ThreadEvent_t *event);
+bool ThreadEvent_IsSet(ThreadEvent_t *event);
+void ThreadEvent_Wait(ThreadEvent_t *event);
+void ThreadEvent_GetStats(ThreadEvent_t *event, size_t *spins, size_t *blocks);
+
+bool ThreadWait_Init(ThreadWait_t *wait);
+void ThreadWait_Destroy(ThreadWait_t *wait);
+bool ThreadWait_IsDone(ThreadWait_t *wait);
+
+bool ThreadPool_Init(ThreadPool_t *pool, uint32_t numWorkers);
+void ThreadPool_Destroy(ThreadPool_t *pool);
+bool ThreadPool_Submit(ThreadPool_t *pool, ThreadFunction_t function, void *arg, ThreadWait_t *wait);
+void ThreadPool_Wait(ThreadPool_t *pool, ThreadWait_t *wait);
+void ThreadPool_Print(ThreadPool_t *pool);
+ThreadPool_t *ThreadPool_GetDefault(void);
+
+void ThreadPool_ParallelFor(ThreadPool_t *pool, uint32_t begin, uint32_t end, uint32_t grainSize, ThreadRangeFunction_t function, void *userdata);
+void Thread_ParallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, ThreadRangeFunction_t function, void *userdata);
+
+bool ThreadGraph_Init(ThreadTaskGraph_t *graph, ThreadPool_t *pool);
+void ThreadGraph_Destroy(ThreadTaskGraph_t *graph);
+ThreadTask_t *ThreadGraph_AddTask(ThreadTaskGraph_t *graph, ThreadFunction_t function, void *arg, uint32_t numPredecessors, ThreadTask_t **predecessors);
+void ThreadGraph_Run(ThreadTaskGraph_t *graph);
 
 #endif
@@ -2,22 +2,15 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include "../math/math.h"
-#include "../utils/id.h"
 #include "../utils/list.h"
 #include "../font/font.h"
 #include "ui.h"
 
 uint32_t UI_AddBarGraph(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hidden, const char *titleText, bool readonly, float min, float max, float value)
 {
-	uint32_t ID=ID_Generate(UI->baseID);
-
-	if(ID==UINT32_MAX||ID>=UI_HASHTABLE_MAX)
-		return UINT32_MAX;
-
 	UI_Control_t control=
 	{
 		.type=UI_CONTROL_BARGRAPH,
-		.ID=ID,
 		.position=position,
 		.color=color,
 		.childParentID=UINT32_MAX,
@@ -30,7 +23,9 @@ uint32_t UI_AddBarGraph(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hid
 		.barGraph.curValue=value,
 	};
 
-	if(!UI_AddControl(UI, &control))
+	uint32_t ID=UI_AddControl(UI, &control);
+
+	if(ID==UINT32_MAX)
 		return UINT32_MAX;
 
 	// TODO:
@@ -47,7 +42,10 @@ uint32_t UI_AddBarGraph(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hid
 	// Print the text centered
 	vec2 textPosition=Vec2(position.x-(textLength*textSize)*0.5f+size.x*0.5f, position.y+(size.y*0.5f));
 
-	UI->controlsHashtable[ID]->barGraph.titleTextID=UI_AddText(UI, textPosition, textSize, Vec3b(1.0f), hidden, titleText);
+	const uint32_t titleTextID=UI_AddText(UI, textPosition, textSize, Vec3b(1.0f), hidden, titleText);
+
+	// Adding the text can move the control, so look it up again
+	UI_FindControlByID(UI, ID)->barGraph.titleTextID=titleTextID;
 
 	return ID;
 }
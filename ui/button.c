@@ -2,7 +2,6 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include "../math/math.h"
-#include "../utils/id.h"
 #include "../utils/list.h"
 #include "../font/font.h"
 #include "ui.h"
@@ -11,15 +10,9 @@
 // Returns an ID, or UINT32_MAX on failure.
 uint32_t UI_AddButton(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hidden, const char *titleText, UIControlCallback callback)
 {
-	uint32_t ID=ID_Generate(UI->baseID);
-
-	if(ID==UINT32_MAX||ID>=UI_HASHTABLE_MAX)
-		return UINT32_MAX;
-
 	UI_Control_t control=
 	{
 		.type=UI_CONTROL_BUTTON,
-		.ID=ID,
 		.position=position,
 		.color=color,
 		.childParentID=UINT32_MAX,
@@ -28,7 +21,9 @@ uint32_t UI_AddButton(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hidde
 		.button.callback=callback
 	};
 
-	if(!UI_AddControl(UI, &control))
+	uint32_t ID=UI_AddControl(UI, &control);
+
+	if(ID==UINT32_MAX)
 		return UINT32_MAX;
 
 	// TODO:
@@ -44,7 +39,10 @@ uint32_t UI_AddButton(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hidde
 
 	// Print the text centered
 	vec2 textPosition=Vec2(position.x-(textLength*textSize)*0.5f+size.x*0.5f, position.y+(size.y*0.5f));
-	UI->controlsHashtable[ID]->button.titleTextID=UI_AddText(UI, textPosition, textSize, Vec3b(1.0f), hidden, titleText);
+	const uint32_t titleTextID=UI_AddText(UI, textPosition, textSize, Vec3b(1.0f), hidden, titleText);
+
+	// Adding the text can move the control, so look it up again
+	UI_FindControlByID(UI, ID)->button.titleTextID=titleTextID;
 
 	// Left justified
 	//	control->position.x,
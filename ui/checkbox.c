@@ -1,7 +1,6 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
-#include "../utils/id.h"
 #include "../math/math.h"
 #include "../utils/list.h"
 #include "../font/font.h"
@@ -11,15 +10,9 @@
 // Returns an ID, or UINT32_MAX on failure.
 uint32_t UI_AddCheckBox(UI_t *UI, vec2 position, float radius, vec3 color, bool hidden, const char *titleText, bool value)
 {
-	uint32_t ID=ID_Generate(UI->baseID);
-
-	if(ID==UINT32_MAX||ID>=UI_HASHTABLE_MAX)
-		return UINT32_MAX;
-
 	UI_Control_t control=
 	{
 		.type=UI_CONTROL_CHECKBOX,
-		.ID=ID,
 		.position=position,
 		.color=color,
 		.childParentID=UINT32_MAX,
@@ -28,7 +21,9 @@ uint32_t UI_AddCheckBox(UI_t *UI, vec2 position, float radius, vec3 color, bool
 		.checkBox.value=value
 	};
 
-	if(!UI_AddControl(UI, &control))
+	uint32_t ID=UI_AddControl(UI, &control);
+
+	if(ID==UINT32_MAX)
 		return UINT32_MAX;
 
 	// TODO:
@@ -37,12 +32,15 @@ uint32_t UI_AddCheckBox(UI_t *UI, vec2 position, float radius, vec3 color, bool
 	// I suppose this would be fixed with proper render order sorting, maybe later.
 
 	// Text size is the radius of the checkbox, placed radius length away horizontally, centered vertically
-	UI->controlsHashtable[ID]->checkBox.titleTextID=UI_AddText(UI,
+	const uint32_t titleTextID=UI_AddText(UI,
 		Vec2(position.x+radius, position.y), radius,
 		Vec3(1.0f, 1.0f, 1.0f),
 		hidden,
 		titleText);
 
+	// Adding the text can move the control, so look it up again
+	UI_FindControlByID(UI, ID)->checkBox.titleTextID=titleTextID;
+
 	return ID;
 }
 
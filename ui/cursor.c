@@ -2,7 +2,6 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include "../math/math.h"
-#include "../utils/id.h"
 #include "../utils/list.h"
 #include "../font/font.h"
 #include "ui.h"
@@ -11,15 +10,9 @@
 // Returns an ID, or UINT32_MAX on failure.
 uint32_t UI_AddCursor(UI_t *UI, vec2 position, float radius, vec3 color, bool hidden)
 {
-	uint32_t ID=ID_Generate(UI->baseID);
-
-	if(ID==UINT32_MAX||ID>=UI_HASHTABLE_MAX)
-		return UINT32_MAX;
-
 	UI_Control_t control=
 	{
 		.type=UI_CONTROL_CURSOR,
-		.ID=ID,
 		.position=position,
 		.color=color,
 		.childParentID=UINT32_MAX,
@@ -27,7 +20,9 @@ uint32_t UI_AddCursor(UI_t *UI, vec2 position, float radius, vec3 color, bool hi
 		.cursor.radius=radius,
 	};
 
-	if(!UI_AddControl(UI, &control))
+	uint32_t ID=UI_AddControl(UI, &control);
+
+	if(ID==UINT32_MAX)
 		return UINT32_MAX;
 
 	return ID;
@@ -3,22 +3,15 @@
 #include <stdio.h>
 #include "../system/system.h"
 #include "../math/math.h"
-#include "../utils/id.h"
 #include "../utils/list.h"
 #include "../font/font.h"
 #include "ui.h"
 
 uint32_t UI_AddEditText(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hidden,  bool readonly, uint32_t maxLength, const char *initialText)
 {
-	uint32_t ID=ID_Generate(UI->baseID);
-
-	if(ID==UINT32_MAX||ID>=UI_HASHTABLE_MAX)
-		return UINT32_MAX;
-
 	UI_Control_t control=
 	{
 		.type=UI_CONTROL_EDITTEXT,
-		.ID=ID,
 		.position=position,
 		.color=color,
 		.childParentID=UINT32_MAX,
@@ -30,7 +23,7 @@ uint32_t UI_AddEditText(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hid
 		.editText.textOffset=0,
 	};
 
-	control.editText.buffer=(char *)Zone_Malloc(zone, maxLength+1);
+	control.editText.buffer=(char *)Zone_MallocTagged(zone, maxLength+1, TAG_UI);
 
 	if(!control.editText.buffer)
 		return UINT32_MAX;
@@ -43,7 +36,9 @@ uint32_t UI_AddEditText(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hid
 		control.editText.cursorPos=(uint32_t)strlen(control.editText.buffer);
 	}
 
-	if(!UI_AddControl(UI, &control))
+	uint32_t ID=UI_AddControl(UI, &control);
+
+	if(ID==UINT32_MAX)
 		return UINT32_MAX;
 
 	// Get base length of title text
@@ -55,7 +50,10 @@ uint32_t UI_AddEditText(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hid
 	// Print the text left justified
 	vec2 textPosition=Vec2(position.x+8.0f, position.y+(size.y*0.5f));
 
-	UI->controlsHashtable[ID]->editText.titleTextID=UI_AddText(UI, textPosition, textSize, Vec3b(1.0f), hidden, control.editText.buffer);
+	const uint32_t titleTextID=UI_AddText(UI, textPosition, textSize, Vec3b(1.0f), hidden, control.editText.buffer);
+
+	// Adding the text can move the control, so look it up again
+	UI_FindControlByID(UI, ID)->editText.titleTextID=titleTextID;
 
 	return ID;
 }
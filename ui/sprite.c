@@ -3,7 +3,6 @@
 #include <stdio.h>
 #include "../vulkan/vulkan.h"
 #include "../math/math.h"
-#include "../utils/id.h"
 #include "../utils/list.h"
 #include "../font/font.h"
 #include "ui.h"
@@ -14,15 +13,9 @@ extern VkuContext_t vkContext;
 // Returns an ID, or UINT32_MAX on failure.
 uint32_t UI_AddSprite(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hidden, VkuImage_t *image, float rotation)
 {
-	uint32_t ID=ID_Generate(UI->baseID);
-
-	if(ID==UINT32_MAX||ID>=UI_HASHTABLE_MAX)
-		return UINT32_MAX;
-
 	UI_Control_t control=
 	{
 		.type=UI_CONTROL_SPRITE,
-		.ID=ID,
 		.position=position,
 		.color=color,
 		.childParentID=UINT32_MAX,
@@ -32,7 +25,9 @@ uint32_t UI_AddSprite(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hidde
 		.sprite.rotation=rotation
 	};
 
-	if(!UI_AddControl(UI, &control))
+	uint32_t ID=UI_AddControl(UI, &control);
+
+	if(ID==UINT32_MAX)
 		return UINT32_MAX;
 
 	return ID;
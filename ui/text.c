@@ -4,7 +4,6 @@
 #include <stdarg.h>
 #include "../system/system.h"
 #include "../math/math.h"
-#include "../utils/id.h"
 #include "../utils/list.h"
 #include "../font/font.h"
 #include "ui.h"
@@ -14,15 +13,9 @@ uint32_t UI_AddText(UI_t *UI, vec2 position, float size, vec3 color, bool hidden
 	if(UI==NULL||titleText==NULL)
 		return false;
 
-	uint32_t ID=ID_Generate(UI->baseID);
-
-	if(ID==UINT32_MAX||ID>=UI_HASHTABLE_MAX)
-		return UINT32_MAX;
-
 	UI_Control_t control=
 	{
 		.type=UI_CONTROL_TEXT,
-		.ID=ID,
 		.position=position,
 		.color=color,
 		.childParentID=UINT32_MAX,
@@ -31,14 +24,16 @@ uint32_t UI_AddText(UI_t *UI, vec2 position, float size, vec3 color, bool hidden
 	};
 
 	control.text.titleTextLength=strlen(titleText)+1;
-	control.text.titleText=(char *)Zone_Malloc(zone, control.text.titleTextLength);
+	control.text.titleText=(char *)Zone_MallocTagged(zone, control.text.titleTextLength, TAG_UI);
 
 	if(control.text.titleText==NULL)
 		return false;
 
 	memcpy(control.text.titleText, titleText, control.text.titleTextLength);
 
-	if(!UI_AddControl(UI, &control))
+	uint32_t ID=UI_AddControl(UI, &control);
+
+	if(ID==UINT32_MAX)
 		return UINT32_MAX;
 
 	return ID;
@@ -61,7 +56,7 @@ bool UI_UpdateText(UI_t *UI, uint32_t ID, vec2 position, float size, vec3 color,
 		Zone_Free(zone, control->text.titleText);
 
 		control->text.titleTextLength=strlen(titleText)+1;
-		control->text.titleText=(char *)Zone_Malloc(zone, control->text.titleTextLength);
+		control->text.titleText=(char *)Zone_MallocTagged(zone, control->text.titleTextLength, TAG_UI);
 
 		if(control->text.titleText==NULL)
 			return false;
@@ -162,7 +157,7 @@ bool UI_UpdateTextTitleText(UI_t *UI, uint32_t ID, const char *titleText)
 		Zone_Free(zone, control->text.titleText);
 
 		control->text.titleTextLength=strlen(titleText)+1;
-		control->text.titleText=(char *)Zone_Malloc(zone, control->text.titleTextLength);
+		control->text.titleText=(char *)Zone_MallocTagged(zone, control->text.titleTextLength, TAG_UI);
 
 		if(control->text.titleText==NULL)
 			return false;
@@ -196,7 +191,7 @@ bool UI_UpdateTextTitleTextf(UI_t *UI, uint32_t ID, const char *titleText, ...)
 		control->text.titleTextLength=vsnprintf(NULL, 0, titleText, argsCopy);
 		va_end(argsCopy);
 
-		control->text.titleText=(char *)Zone_Malloc(zone, control->text.titleTextLength+1);
+		control->text.titleText=(char *)Zone_MallocTagged(zone, control->text.titleTextLength+1, TAG_UI);
 
 		if(control->text.titleText==NULL)
 		{
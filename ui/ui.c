@@ -5,7 +5,6 @@
 #include "../vulkan/vulkan.h"
 #include "../perframe.h"
 #include "../math/math.h"
-#include "../utils/id.h"
 #include "../utils/list.h"
 #include "../utils/pipeline.h"
 #include "../font/font.h"
@@ -102,7 +101,7 @@ static bool UI_VulkanVertex(UI_t *UI)
 	// ---
 
 	// Create instance buffer and map it
-	vkuCreateHostBuffer(&vkContext, &UI->instanceBuffer, sizeof(UI_Instance_t)*UI_HASHTABLE_MAX, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+	vkuCreateHostBuffer(&vkContext, &UI->instanceBuffer, sizeof(UI_Instance_t)*UI_INSTANCE_MAX, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
 
 	UI->instanceBufferPtr=UI->instanceBuffer.memory->mappedPointer;
 	// ---
@@ -126,17 +125,15 @@ bool UI_Init(UI_t *UI, vec2 position, vec2 size)
 	if(UI==NULL)
 		return false;
 
-	//UI->baseID=0;
-	ID_Init(UI->baseID);
-
 	// Set screen width/height
 	UI->position=position;
 	UI->size=size;
 
-	// Initial 10 pre-allocated list of buttons, uninitialized
-	List_Init(&UI->controls, sizeof(UI_Control_t), 10, NULL);
+	UI->instanceCount=0;
 
-	memset(UI->controlsHashtable, 0, sizeof(UI_Control_t *)*UI_HASHTABLE_MAX);
+	// Initial 16 pre-allocated controls, control IDs are the slot map handles
+	if(!SlotMap_Init(&UI->controls, sizeof(UI_Control_t), 16))
+		return false;
 
 	// Vulkan stuff
 	if(!UI_VulkanPipeline(UI))
@@ -148,9 +145,9 @@ bool UI_Init(UI_t *UI, vec2 position, vec2 size)
 void UI_Destroy(UI_t *UI)
 {
 	// Find any window controls and delete children list, and handle other misc control deletes
-	for(uint32_t i=0;i<List_GetCount(&UI->controls);i++)
+	for(uint32_t i=0;i<SlotMap_GetCount(&UI->controls);i++)
 	{
-		UI_Control_t *control=(UI_Control_t *)List_GetPointer(&UI->controls, i);
+		UI_Control_t *control=(UI_Control_t *)SlotMap_GetDense(&UI->controls, i);
 
 		if(control->type==UI_CONTROL_WINDOW)
 			List_Destroy(&control->window.children);
@@ -162,7 +159,7 @@ void UI_Destroy(UI_t *UI)
 			Zone_Free(zone, control->editText.buffer);
 	}
 
-	List_Destroy(&UI->controls);
+	SlotMap_Destroy(&UI->controls);
 
 	vkuDestroyBuffer(&vkContext, &UI->instanceBuffer);
 
@@ -173,33 +170,103 @@ void UI_Destroy(UI_t *UI)
 	DestroyPipeline(&vkContext, &UI->pipeline);
 }
 
-bool UI_AddControl(UI_t *UI, UI_Control_t *control)
+// Adds a copy of the control to the UI, returns the new control's ID or UINT32_MAX on failure
+uint32_t UI_AddControl(UI_t *UI, UI_Control_t *control)
 {
-	// Add control to controls list
-	if(!List_Add(&UI->controls, control))
-		return false;
+	if(UI==NULL||control==NULL)
+		return UINT32_MAX;
 
-	// Refresh hashmap pointers, controls list may reallocate and change pointers, so just refresh everything any time a control is added.
-	for(uint32_t i=0;i<List_GetCount(&UI->controls);i++)
-	{
-		UI_Control_t *ptr=(UI_Control_t *)List_GetPointer(&UI->controls, i);
-		UI->controlsHashtable[ptr->ID]=ptr;
-	}
+	const uint32_t ID=SlotMap_Add(&UI->controls, control);
 
-	return true;
+	if(ID==SLOTMAP_INVALID)
+		return UINT32_MAX;
+
+	// Control only knows it's ID once it's been added
+	((UI_Control_t *)SlotMap_Get(&UI->controls, ID))->ID=ID;
+
+	return ID;
 }
 
+// Returned pointer is only valid until the next control is added or removed, IDs are what should be kept around.
+// Returns NULL for IDs of controls that have been removed.
 UI_Control_t *UI_FindControlByID(UI_t *UI, uint32_t ID)
 {
-	if(UI==NULL||ID>=UI_HASHTABLE_MAX||ID==UINT32_MAX)
+	if(UI==NULL||ID==UINT32_MAX)
 		return NULL;
 
-	UI_Control_t *control=UI->controlsHashtable[ID];
+	return (UI_Control_t *)SlotMap_Get(&UI->controls, ID);
+}
+
+static uint32_t UI_GetTitleTextID(const UI_Control_t *control)
+{
+	switch(control->type)
+	{
+		case UI_CONTROL_BARGRAPH:	return control->barGraph.titleTextID;
+		case UI_CONTROL_BUTTON:		return control->button.titleTextID;
+		case UI_CONTROL_CHECKBOX:	return control->checkBox.titleTextID;
+		case UI_CONTROL_EDITTEXT:	return control->editText.titleTextID;
+		case UI_CONTROL_WINDOW:		return control->window.titleTextID;
+		default:					return UINT32_MAX;
+	}
+}
+
+// Removes a control along with it's title text, removing a window also removes everything in it.
+// The last control takes the removed control's place in draw order.
+bool UI_RemoveControl(UI_t *UI, uint32_t ID)
+{
+	UI_Control_t *found=UI_FindControlByID(UI, ID);
+
+	if(found==NULL)
+		return false;
+
+	// Removing moves other controls around, so work from a copy
+	UI_Control_t control=*found;
 
-	if(control->ID==ID)
-		return control;
+	SlotMap_Remove(&UI->controls, ID);
+
+	// Take it out of it's window's child list, if it has one.
+	// It's title text went into the window's list with it, but the text's parent is this control, so that ID has to come out here too.
+	UI_Control_t *parent=UI_FindControlByID(UI, control.childParentID);
+	const uint32_t titleTextID=UI_GetTitleTextID(&control);
+
+	if(parent!=NULL&&parent->type==UI_CONTROL_WINDOW)
+	{
+		for(uint32_t i=0;i<List_GetCount(&parent->window.children);)
+		{
+			const uint32_t childID=*(uint32_t *)List_GetPointer(&parent->window.children, i);
+
+			if(childID==ID||childID==titleTextID)
+				List_Del(&parent->window.children, i);
+			else
+				i++;
+		}
+	}
+
+	UI_RemoveControl(UI, titleTextID);
+
+	switch(control.type)
+	{
+		case UI_CONTROL_TEXT:
+			Zone_Free(zone, control.text.titleText);
+			break;
+
+		case UI_CONTROL_EDITTEXT:
+			Zone_Free(zone, control.editText.buffer);
+			break;
+
+		case UI_CONTROL_WINDOW:
+			// Children's title texts are in the child list too, those are already gone by the time they come up
+			for(uint32_t i=0;i<List_GetCount(&control.window.children);i++)
+				UI_RemoveControl(UI, *(uint32_t *)List_GetPointer(&control.window.children, i));
+
+			List_Destroy(&control.window.children);
+			break;
+
+		default:
+			break;
+	}
 
-	return NULL;
+	return true;
 }
 
 // Checks hit on UI controls, also processes certain controls, intended to be used on mouse button down events
@@ -214,9 +281,9 @@ uint32_t UI_TestHit(UI_t *UI, vec2 position)
 	position=Vec2_Addv(position, UI->position);
 
 	// Loop through all controls in the UI
-	for(uint32_t i=0;i<List_GetCount(&UI->controls);i++)
+	for(uint32_t i=0;i<SlotMap_GetCount(&UI->controls);i++)
 	{
-		UI_Control_t *control=List_GetPointer(&UI->controls, i);
+		UI_Control_t *control=SlotMap_GetDense(&UI->controls, i);
 
 		// Only test non-child and visible controls here
 		if(control->childParentID!=UINT32_MAX||control->hidden)
@@ -291,7 +358,7 @@ uint32_t UI_TestHit(UI_t *UI, vec2 position)
 					uint32_t *childID=List_GetPointer(&control->window.children, j);
 					UI_Control_t *child=UI_FindControlByID(UI, *childID);
 
-					if(child->hidden)
+					if(child==NULL||child->hidden)
 						continue;
 
 					vec2 childPos=Vec2_Addv(control->position, child->position);
@@ -658,7 +725,9 @@ static bool UI_AddControlInstance(UI_Instance_t **instance, uint32_t *instanceCo
 	}	
 }
 
-bool UI_Draw(UI_t *UI, uint32_t index, uint32_t eye, float dt)
+// Fills the instance buffer for all visible controls, sprites go at the end in control order.
+// No Vulkan commands are recorded, so this can run on any thread as long as nothing else is changing the UI.
+bool UI_BuildInstances(UI_t *UI, float dt)
 {
 	if(UI==NULL)
 		return false;
@@ -666,12 +735,12 @@ bool UI_Draw(UI_t *UI, uint32_t index, uint32_t eye, float dt)
 	UI_Instance_t *instance=(UI_Instance_t *)UI->instanceBufferPtr;
 	uint32_t instanceCount=0;
 
-	const size_t controlCount=List_GetCount(&UI->controls);
+	const uint32_t controlCount=SlotMap_GetCount(&UI->controls);
 
 	// Build a list of instanceable UI controls
 	for(uint32_t i=0;i<controlCount;i++)
 	{
-		UI_Control_t *control=List_GetPointer(&UI->controls, i);
+		UI_Control_t *control=SlotMap_GetDense(&UI->controls, i);
 
 		// Only add controls that are non-child and visible controls
 		if(control->childParentID!=UINT32_MAX||control->hidden)
@@ -688,12 +757,36 @@ bool UI_Draw(UI_t *UI, uint32_t index, uint32_t eye, float dt)
 				UI_Control_t *child=UI_FindControlByID(UI, *childID);
 
 				// Add child control instances with offset of parent control, but only if visible
-				if(!child->hidden)
+				if(child!=NULL&&!child->hidden)
 					UI_AddControlInstance(&instance, &instanceCount, child, control->position, dt);
 			}
 		}
 	}
 
+	UI->instanceCount=instanceCount;
+
+	// Sprites need descriptor set changes and aren't easy to draw instanced, so they each get their own slot after the rest
+	for(uint32_t i=0;i<controlCount;i++)
+	{
+		UI_Control_t *control=SlotMap_GetDense(&UI->controls, i);
+
+		if(control->type==UI_CONTROL_SPRITE&&!control->hidden)
+		{
+			instance->positionSize.x=control->position.x;
+			instance->positionSize.y=control->position.y;
+			instance->positionSize.z=control->sprite.size.x;
+			instance->positionSize.w=control->sprite.size.y;
+
+			instance->colorValue.x=control->color.x;
+			instance->colorValue.y=control->color.y;
+			instance->colorValue.z=control->color.z;
+			instance->colorValue.w=control->sprite.rotation;
+
+			instance->type=UI_CONTROL_SPRITE;
+			instance++;
+		}
+	}
+
 	// Flush instance buffer caches, mostly needed for Android and maybe some iGPUs
 	vkFlushMappedMemoryRanges(vkContext.device, 1, &(VkMappedMemoryRange)
 	{
@@ -703,6 +796,17 @@ bool UI_Draw(UI_t *UI, uint32_t index, uint32_t eye, float dt)
 		0, VK_WHOLE_SIZE
 	});
 
+	return true;
+}
+
+// Records the UI draw commands, instances must have already been built by UI_BuildInstances
+bool UI_Draw(UI_t *UI, uint32_t index, uint32_t eye)
+{
+	if(UI==NULL)
+		return false;
+
+	const uint32_t controlCount=SlotMap_GetCount(&UI->controls);
+
 	vkCmdBindPipeline(perFrame[index].commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, UI->pipeline.pipeline.pipeline);
 
 	// Bind vertex data buffer
@@ -722,28 +826,14 @@ bool UI_Draw(UI_t *UI, uint32_t index, uint32_t eye, float dt)
 
 	vkCmdPushConstants(perFrame[index].commandBuffer, UI->pipeline.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT|VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(UIPC), &UIPC);
 
-	// Draw sprites, they need descriptor set changes and aren't easy to draw instanced...
-	uint32_t spriteCount=instanceCount;
+	// Draw sprites, same order they were built in
+	uint32_t spriteCount=UI->instanceCount;
 	for(uint32_t i=0;i<controlCount;i++)
 	{
-		UI_Control_t *control=List_GetPointer(&UI->controls, i);
+		UI_Control_t *control=SlotMap_GetDense(&UI->controls, i);
 
 		if(control->type==UI_CONTROL_SPRITE&&!control->hidden)
 		{
-			// TODO: This may be a problem on integrated or mobile platforms, flush needed?
-			instance->positionSize.x=control->position.x;
-			instance->positionSize.y=control->position.y;
-			instance->positionSize.z=control->sprite.size.x;
-			instance->positionSize.w=control->sprite.size.y;
-
-			instance->colorValue.x=control->color.x;
-			instance->colorValue.y=control->color.y;
-			instance->colorValue.z=control->color.z;
-			instance->colorValue.w=control->sprite.rotation;
-
-			instance->type=UI_CONTROL_SPRITE;
-			instance++;
-
 			vkuDescriptorSet_UpdateBindingImageInfo(&UI->pipeline.descriptorSet, 0, control->sprite.image->sampler, control->sprite.image->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 			vkuAllocateUpdateDescriptorSet(&UI->pipeline.descriptorSet, perFrame[index].descriptorPool);
 			vkCmdBindDescriptorSets(perFrame[index].commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, UI->pipeline.pipelineLayout, 0, 1, &UI->pipeline.descriptorSet.descriptorSet, 0, VK_NULL_HANDLE);
@@ -758,7 +848,7 @@ bool UI_Draw(UI_t *UI, uint32_t index, uint32_t eye, float dt)
 	vkCmdBindDescriptorSets(perFrame[index].commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, UI->pipeline.pipelineLayout, 0, 1, &UI->pipeline.descriptorSet.descriptorSet, 0, VK_NULL_HANDLE);
 
 	// Draw instanced UI elements
-	vkCmdDraw(perFrame[index].commandBuffer, 4, instanceCount, 0, 0);
+	vkCmdDraw(perFrame[index].commandBuffer, 4, UI->instanceCount, 0, 0);
 
 	return true;
 }
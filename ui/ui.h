@@ -4,9 +4,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "../math/math.h"
-#include "../utils/id.h"
 #include "../utils/pipeline.h"
 #include "../utils/list.h"
+#include "../utils/slotmap.h"
 
 // Does the callback really need args? (userdata?)
 typedef void (*UIControlCallback)(void *arg);
@@ -14,7 +14,8 @@ typedef void (*UIControlCallback)(void *arg);
 #define UI_CONTROL_WINDOW_TITLEBAR_HEIGHT 16.0f
 #define UI_CONTROL_WINDOW_BORDER 10.0f
 
-#define UI_HASHTABLE_MAX 8192
+// Size of the instance buffer, text controls take one instance per character
+#define UI_INSTANCE_MAX 8192
 
 typedef enum
 {
@@ -126,21 +127,18 @@ typedef struct
 	VkuBuffer_t instanceBuffer;
 	void *instanceBufferPtr;
 
-	// Base ID for generating IDs
-	//uint32_t baseID;
-	ID_t baseID;
+	// Instances written by the last UI_BuildInstances, not counting sprites
+	uint32_t instanceCount;
 
-	// List of controls in UI
-	List_t controls;
-
-	// Hashtable for quick lookup by ID
-	UI_Control_t *controlsHashtable[UI_HASHTABLE_MAX];
+	// Controls in UI, control IDs are handles into this
+	SlotMap_t controls;
 } UI_t;
 
 bool UI_Init(UI_t *UI, vec2 position, vec2 size);
 void UI_Destroy(UI_t *UI);
 
-bool UI_AddControl(UI_t *UI, UI_Control_t *control);
+uint32_t UI_AddControl(UI_t *UI, UI_Control_t *control);
+bool UI_RemoveControl(UI_t *UI, uint32_t ID);
 UI_Control_t *UI_FindControlByID(UI_t *UI, uint32_t ID);
 
 uint32_t UI_AddBarGraph(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hidden, const char *titleText, bool Readonly, float Min, float Max, float value);
@@ -227,6 +225,7 @@ bool UI_WindowAddControl(UI_t *UI, uint32_t ID, uint32_t childID);
 
 uint32_t UI_TestHit(UI_t *UI, vec2 position);
 bool UI_ProcessControl(UI_t *UI, uint32_t ID, vec2 position);
-bool UI_Draw(UI_t *UI, uint32_t index, uint32_t eye, float dt);
+bool UI_BuildInstances(UI_t *UI, float dt);
+bool UI_Draw(UI_t *UI, uint32_t index, uint32_t eye);
 
 #endif
@@ -2,22 +2,15 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include "../math/math.h"
-#include "../utils/id.h"
 #include "../utils/list.h"
 #include "../font/font.h"
 #include "ui.h"
 
 uint32_t UI_AddWindow(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hidden, const char *titleText)
 {
-	uint32_t ID=ID_Generate(UI->baseID);
-
-	if(ID==UINT32_MAX||ID>=UI_HASHTABLE_MAX)
-		return UINT32_MAX;
-
 	UI_Control_t control=
 	{
 		.type=UI_CONTROL_WINDOW,
-		.ID=ID,
 		.position=position,
 		.color=color,
 		.childParentID=UINT32_MAX,
@@ -29,14 +22,19 @@ uint32_t UI_AddWindow(UI_t *UI, vec2 position, vec2 size, vec3 color, bool hidde
 	if(!List_Init(&control.window.children, sizeof(uint32_t), 0, NULL))
 		return UINT32_MAX;
 
-	if(!UI_AddControl(UI, &control))
+	uint32_t ID=UI_AddControl(UI, &control);
+
+	if(ID==UINT32_MAX)
 		return UINT32_MAX;
 
 	// TODO:
 	// This is bit annoying...
 	// The control's title text needs to be added after the actual control, otherwise it will be rendered under this control.
 	// I suppose this would be fixed with proper render order sorting, maybe later.
-	UI->controlsHashtable[ID]->window.titleTextID=UI_AddText(UI, Vec2_Add(position, 0.0f, 16.0f-(UI_CONTROL_WINDOW_BORDER*0.5f)), 16.0f, Vec3b(1.0f), hidden, titleText);
+	const uint32_t titleTextID=UI_AddText(UI, Vec2_Add(position, 0.0f, 16.0f-(UI_CONTROL_WINDOW_BORDER*0.5f)), 16.0f, Vec3b(1.0f), hidden, titleText);
+
+	// Adding the text can move the control, so look it up again
+	UI_FindControlByID(UI, ID)->window.titleTextID=titleTextID;
 
 	return ID;
 }
@@ -159,6 +157,14 @@ bool UI_UpdateWindowTitleText(UI_t *UI, uint32_t ID, const char *titleText)
 	return false;
 }
 
+static void UI_SetParentID(UI_t *UI, uint32_t ID, uint32_t parentID)
+{
+	UI_Control_t *control=UI_FindControlByID(UI, ID);
+
+	if(control!=NULL)
+		control->childParentID=parentID;
+}
+
 bool UI_WindowAddControl(UI_t *UI, uint32_t ID, uint32_t childID)
 {
 	if(UI==NULL||ID==UINT32_MAX)
@@ -175,54 +181,40 @@ bool UI_WindowAddControl(UI_t *UI, uint32_t ID, uint32_t childID)
 		{
 			childControl->childParentID=ID;
 
+			// Controls with a title bring their title text into the window with them
+			uint32_t children[2]={ childID, UINT32_MAX };
+			uint32_t numChildren=1;
+
 			switch(childControl->type)
 			{
 				case UI_CONTROL_BARGRAPH:
-					UI->controlsHashtable[childControl->barGraph.titleTextID]->childParentID=childID;
+					children[1]=childControl->barGraph.titleTextID;
 					break;
 
 				case UI_CONTROL_BUTTON:
-					UI->controlsHashtable[childControl->button.titleTextID]->childParentID=childID;
+					children[1]=childControl->button.titleTextID;
 					break;
 
 				case UI_CONTROL_CHECKBOX:
-					UI->controlsHashtable[childControl->checkBox.titleTextID]->childParentID=childID;
+					children[1]=childControl->checkBox.titleTextID;
 					break;
 
 				case UI_CONTROL_EDITTEXT:
-					UI->controlsHashtable[childControl->editText.titleTextID]->childParentID=childID;
+					children[1]=childControl->editText.titleTextID;
 					break;
 
 				default:
 					break;
 			}
 
-			if(List_Add(&control->window.children, &childID))
+			if(children[1]!=UINT32_MAX)
 			{
-				switch(childControl->type)
-				{
-					case UI_CONTROL_BARGRAPH:
-						List_Add(&control->window.children, &childControl->barGraph.titleTextID);
-						break;
-
-					case UI_CONTROL_BUTTON:
-						List_Add(&control->window.children, &childControl->button.titleTextID);
-						break;
-
-					case UI_CONTROL_CHECKBOX:
-						List_Add(&control->window.children, &childControl->checkBox.titleTextID);
-						break;
-
-					case UI_CONTROL_EDITTEXT:
-						List_Add(&control->window.children, &childControl->editText.titleTextID);
-						break;
-
-					default:
-						break;
-				}
+				UI_SetParentID(UI, children[1], childID);
+				numChildren++;
+			}
 
+			if(List_AddN(&control->window.children, children, numChildren))
 				return true;
-			}
 		}
 		else
 			return false;
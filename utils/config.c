@@ -49,7 +49,7 @@ bool Config_ReadINI(Config_t *config, const char *filename)
 	size_t length=ftell(stream);
 	fseek(stream, 0, SEEK_SET);
 
-	char *buffer=(char *)Zone_Malloc(zone, length+1);
+	char *buffer=(char *)Zone_MallocTagged(zone, length+1, TAG_UTILS);
 
 	if(buffer==NULL)
 		return false;
@@ -75,7 +75,7 @@ bool Config_ReadINI(Config_t *config, const char *filename)
 			if(strcmp(token->string, "config")==0)
 			{
 				// Next token must be a left brace '{'
-				Zone_Free(zone, token);
+				Tokenizer_FreeToken(token);
 				token=Tokenizer_GetNext(&tokenizer);
 
 				if(token->type!=TOKEN_DELIMITER&&token->string[0]!='{')
@@ -88,7 +88,7 @@ bool Config_ReadINI(Config_t *config, const char *filename)
 				while(!(token->type==TOKEN_DELIMITER&&token->string[0]=='}'))
 				{
 					// Look for keyword tokens
-					Zone_Free(zone, token);
+					Tokenizer_FreeToken(token);
 					token=Tokenizer_GetNext(&tokenizer);
 
 					if(token->type==TOKEN_KEYWORD)
@@ -161,7 +161,7 @@ bool Config_ReadINI(Config_t *config, const char *filename)
 		}
 
 		if(token)
-			Zone_Free(zone, token);
+			Tokenizer_FreeToken(token);
 	}
 
 	Zone_Free(zone, buffer);
@@ -0,0 +1,447 @@
+// Open addressing hash map, Robin Hood linear probing with backward shift deletion.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../system/system.h"
+#include "../system/framearena.h"
+#include "hashmap.h"
+
+// Grow once the table is 7/8 full, Robin Hood keeps probe lengths short even that full
+#define HASHMAP_MAX_LOAD(capacity) ((capacity)-((capacity)>>3))
+#define HASHMAP_MIN_CAPACITY 16
+
+// FNV-1a
+uint32_t HashMap_HashString(const char *string)
+{
+	uint32_t hash=2166136261u;
+
+	while(*string)
+	{
+		hash^=(uint8_t)*string++;
+		hash*=16777619u;
+	}
+
+	return hash?hash:1;
+}
+
+// MurmurHash3 64bit finalizer, folded to 32 bits
+uint32_t HashMap_HashInteger(uint64_t integer)
+{
+	integer^=integer>>33;
+	integer*=0xff51afd7ed558ccdull;
+	integer^=integer>>33;
+	integer*=0xc4ceb9fe1a85ec53ull;
+	integer^=integer>>33;
+
+	const uint32_t hash=(uint32_t)integer^(uint32_t)(integer>>32);
+
+	return hash?hash:1;
+}
+
+static void *HashMap_Alloc(HashMap_t *map, size_t size)
+{
+	if(map->storage==HASHMAP_STORAGE_FRAME)
+		return FrameArena_Malloc(size);
+
+	return Zone_MallocTagged(zone, size, TAG_UTILS);
+}
+
+static void HashMap_FreeMemory(HashMap_t *map, void *ptr)
+{
+	if(ptr==NULL)
+		return;
+
+	if(map->storage==HASHMAP_STORAGE_FRAME)
+		FrameArena_Free(ptr);
+	else
+		Zone_Free(zone, ptr);
+}
+
+static inline const char *HashMap_GetEntryString(const HashMapEntry_t *entry)
+{
+	return entry->length<HASHMAP_INLINE_KEY?entry->key.inlineString:entry->key.string;
+}
+
+// How far an entry at index is from where its hash wants it
+static inline uint32_t HashMap_GetDistance(const HashMap_t *map, uint32_t hash, uint32_t index)
+{
+	return (index-(hash&map->mask))&map->mask;
+}
+
+static inline uint8_t *HashMap_GetValue(const HashMap_t *map, uint32_t index)
+{
+	return map->values+(size_t)index*map->valueSize;
+}
+
+// Sets don't have values, so they get a non-NULL pointer back to signal success
+static void *HashMap_SetValue(HashMap_t *map, uint32_t index, const void *value)
+{
+	if(map->valueSize==0)
+		return map->entries;
+
+	uint8_t *data=HashMap_GetValue(map, index);
+
+	if(value)
+		memcpy(data, value, map->valueSize);
+	else
+		memset(data, 0, map->valueSize);
+
+	return data;
+}
+
+static uint32_t HashMap_Find(const HashMap_t *map, uint32_t hash, const char *string, uint32_t length, uint64_t integer)
+{
+	if(map->count==0)
+		return UINT32_MAX;
+
+	for(uint32_t index=hash&map->mask, distance=0;;index=(index+1)&map->mask, distance++)
+	{
+		const HashMapEntry_t *entry=&map->entries[index];
+
+		// Robin Hood ordering means the key would have been placed before anything closer to home than it
+		if(entry->hash==0||HashMap_GetDistance(map, entry->hash, index)<distance)
+			return UINT32_MAX;
+
+		if(entry->hash!=hash)
+			continue;
+
+		if(map->keyType==HASHMAP_KEY_INTEGER)
+		{
+			if(entry->key.integer==integer)
+				return index;
+		}
+		else if(entry->length==length&&memcmp(HashMap_GetEntryString(entry), string, length)==0)
+			return index;
+	}
+}
+
+// Places an entry that isn't in the map yet, returns the index it landed at.
+// Within a run, entries are ordered by home index, so inserting is finding the first entry
+// that's closer to home than the new one and shifting the rest of the run up by one.
+static uint32_t HashMap_Place(HashMap_t *map, const HashMapEntry_t *newEntry)
+{
+	uint32_t index=newEntry->hash&map->mask;
+
+	for(uint32_t distance=0;;index=(index+1)&map->mask, distance++)
+	{
+		const HashMapEntry_t *entry=&map->entries[index];
+
+		if(entry->hash==0||HashMap_GetDistance(map, entry->hash, index)<distance)
+			break;
+	}
+
+	uint32_t empty=index;
+
+	while(map->entries[empty].hash!=0)
+		empty=(empty+1)&map->mask;
+
+	while(empty!=index)
+	{
+		const uint32_t previous=(empty-1)&map->mask;
+
+		map->entries[empty]=map->entries[previous];
+
+		if(map->valueSize)
+			memcpy(HashMap_GetValue(map, empty), HashMap_GetValue(map, previous), map->valueSize);
+
+		empty=previous;
+	}
+
+	map->entries[index]=*newEntry;
+
+	return index;
+}
+
+static bool HashMap_Resize(HashMap_t *map, uint32_t capacity)
+{
+	HashMapEntry_t *oldEntries=map->entries;
+	uint8_t *oldValues=map->values;
+	const uint32_t oldCapacity=map->capacity;
+
+	HashMapEntry_t *entries=(HashMapEntry_t *)HashMap_Alloc(map, sizeof(HashMapEntry_t)*capacity);
+
+	if(entries==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "HashMap_Resize: Unable to allocate memory for entries.\r\n");
+		return false;
+	}
+
+	uint8_t *values=NULL;
+
+	if(map->valueSize)
+	{
+		values=(uint8_t *)HashMap_Alloc(map, (size_t)map->valueSize*capacity);
+
+		if(values==NULL)
+		{
+			DBGPRINTF(DEBUG_ERROR, "HashMap_Resize: Unable to allocate memory for values.\r\n");
+			HashMap_FreeMemory(map, entries);
+			return false;
+		}
+	}
+
+	memset(entries, 0, sizeof(HashMapEntry_t)*capacity);
+
+	map->entries=entries;
+	map->values=values;
+	map->capacity=capacity;
+	map->mask=capacity-1;
+
+	// Stored hashes mean keys never have to be hashed again
+	for(uint32_t i=0;i<oldCapacity;i++)
+	{
+		if(oldEntries[i].hash==0)
+			continue;
+
+		const uint32_t index=HashMap_Place(map, &oldEntries[i]);
+
+		if(map->valueSize)
+			memcpy(HashMap_GetValue(map, index), oldValues+(size_t)i*map->valueSize, map->valueSize);
+	}
+
+	HashMap_FreeMemory(map, oldValues);
+	HashMap_FreeMemory(map, oldEntries);
+
+	return true;
+}
+
+static void *HashMap_InsertEntry(HashMap_t *map, HashMapEntry_t *entry, const void *value)
+{
+	if(map->count+1>HASHMAP_MAX_LOAD(map->capacity))
+	{
+		if(!HashMap_Resize(map, map->capacity*2))
+		{
+			if(map->keyType==HASHMAP_KEY_STRING&&entry->length>=HASHMAP_INLINE_KEY)
+				HashMap_FreeMemory(map, entry->key.string);
+
+			return NULL;
+		}
+	}
+
+	const uint32_t index=HashMap_Place(map, entry);
+	map->count++;
+
+	return HashMap_SetValue(map, index, value);
+}
+
+// Backward shift deletion, pulls the rest of the run back a slot so there's no tombstones
+static void HashMap_RemoveIndex(HashMap_t *map, uint32_t index)
+{
+	HashMapEntry_t *entry=&map->entries[index];
+
+	if(map->keyType==HASHMAP_KEY_STRING&&entry->length>=HASHMAP_INLINE_KEY)
+		HashMap_FreeMemory(map, entry->key.string);
+
+	for(;;)
+	{
+		const uint32_t next=(index+1)&map->mask;
+
+		if(map->entries[next].hash==0||HashMap_GetDistance(map, map->entries[next].hash, next)==0)
+			break;
+
+		map->entries[index]=map->entries[next];
+
+		if(map->valueSize)
+			memcpy(HashMap_GetValue(map, index), HashMap_GetValue(map, next), map->valueSize);
+
+		index=next;
+	}
+
+	memset(&map->entries[index], 0, sizeof(HashMapEntry_t));
+	map->count--;
+}
+
+bool HashMap_Init(HashMap_t *map, HashMapKey_e keyType, HashMapStorage_e storage, uint32_t valueSize, uint32_t count)
+{
+	if(map==NULL)
+		return false;
+
+	memset(map, 0, sizeof(HashMap_t));
+
+	map->keyType=keyType;
+	map->storage=storage;
+	map->valueSize=valueSize;
+
+	// Size it so count entries fit without growing
+	uint32_t capacity=HASHMAP_MIN_CAPACITY;
+
+	while(HASHMAP_MAX_LOAD(capacity)<count)
+		capacity*=2;
+
+	return HashMap_Resize(map, capacity);
+}
+
+void HashMap_Clear(HashMap_t *map)
+{
+	if(map==NULL||map->entries==NULL)
+		return;
+
+	if(map->keyType==HASHMAP_KEY_STRING)
+	{
+		for(uint32_t i=0;i<map->capacity;i++)
+		{
+			if(map->entries[i].hash&&map->entries[i].length>=HASHMAP_INLINE_KEY)
+				HashMap_FreeMemory(map, map->entries[i].key.string);
+		}
+	}
+
+	memset(map->entries, 0, sizeof(HashMapEntry_t)*map->capacity);
+	map->count=0;
+}
+
+void HashMap_Destroy(HashMap_t *map)
+{
+	if(map==NULL)
+		return;
+
+	HashMap_Clear(map);
+
+	HashMap_FreeMemory(map, map->values);
+	HashMap_FreeMemory(map, map->entries);
+
+	memset(map, 0, sizeof(HashMap_t));
+}
+
+uint32_t HashMap_GetCount(HashMap_t *map)
+{
+	if(map==NULL)
+		return 0;
+
+	return map->count;
+}
+
+// Inserts or replaces a key, value can be NULL to zero it.
+// Returns a pointer to the stored value (or non-NULL for sets), NULL if it failed.
+void *HashMap_Insert(HashMap_t *map, const char *key, const void *value)
+{
+	if(map==NULL||key==NULL||map->keyType!=HASHMAP_KEY_STRING)
+		return NULL;
+
+	const uint32_t hash=HashMap_HashString(key);
+	const size_t length=strlen(key);
+
+	if(length>=UINT32_MAX)
+		return NULL;
+
+	const uint32_t index=HashMap_Find(map, hash, key, (uint32_t)length, 0);
+
+	if(index!=UINT32_MAX)
+		return HashMap_SetValue(map, index, value);
+
+	HashMapEntry_t entry={ .hash=hash, .length=(uint32_t)length };
+
+	if(length<HASHMAP_INLINE_KEY)
+		memcpy(entry.key.inlineString, key, length+1);
+	else
+	{
+		entry.key.string=(char *)HashMap_Alloc(map, length+1);
+
+		if(entry.key.string==NULL)
+		{
+			DBGPRINTF(DEBUG_ERROR, "HashMap_Insert: Unable to allocate memory for key.\r\n");
+			return NULL;
+		}
+
+		memcpy(entry.key.string, key, length+1);
+	}
+
+	return HashMap_InsertEntry(map, &entry, value);
+}
+
+// Lookup with a hash from HashMap_HashString, for when the same key is looked up in more than one map
+void *HashMap_GetHashed(HashMap_t *map, uint32_t hash, const char *key)
+{
+	if(map==NULL||key==NULL||map->keyType!=HASHMAP_KEY_STRING||map->valueSize==0)
+		return NULL;
+
+	const uint32_t index=HashMap_Find(map, hash, key, (uint32_t)strlen(key), 0);
+
+	if(index==UINT32_MAX)
+		return NULL;
+
+	return HashMap_GetValue(map, index);
+}
+
+void *HashMap_Get(HashMap_t *map, const char *key)
+{
+	if(key==NULL)
+		return NULL;
+
+	return HashMap_GetHashed(map, HashMap_HashString(key), key);
+}
+
+bool HashMap_Has(HashMap_t *map, const char *key)
+{
+	if(map==NULL||key==NULL||map->keyType!=HASHMAP_KEY_STRING)
+		return false;
+
+	return HashMap_Find(map, HashMap_HashString(key), key, (uint32_t)strlen(key), 0)!=UINT32_MAX;
+}
+
+bool HashMap_Remove(HashMap_t *map, const char *key)
+{
+	if(map==NULL||key==NULL||map->keyType!=HASHMAP_KEY_STRING)
+		return false;
+
+	const uint32_t index=HashMap_Find(map, HashMap_HashString(key), key, (uint32_t)strlen(key), 0);
+
+	if(index==UINT32_MAX)
+		return false;
+
+	HashMap_RemoveIndex(map, index);
+
+	return true;
+}
+
+void *HashMap_InsertInteger(HashMap_t *map, uint64_t key, const void *value)
+{
+	if(map==NULL||map->keyType!=HASHMAP_KEY_INTEGER)
+		return NULL;
+
+	const uint32_t hash=HashMap_HashInteger(key);
+	const uint32_t index=HashMap_Find(map, hash, NULL, 0, key);
+
+	if(index!=UINT32_MAX)
+		return HashMap_SetValue(map, index, value);
+
+	HashMapEntry_t entry={ .hash=hash, .key.integer=key };
+
+	return HashMap_InsertEntry(map, &entry, value);
+}
+
+void *HashMap_GetInteger(HashMap_t *map, uint64_t key)
+{
+	if(map==NULL||map->keyType!=HASHMAP_KEY_INTEGER||map->valueSize==0)
+		return NULL;
+
+	const uint32_t index=HashMap_Find(map, HashMap_HashInteger(key), NULL, 0, key);
+
+	if(index==UINT32_MAX)
+		return NULL;
+
+	return HashMap_GetValue(map, index);
+}
+
+bool HashMap_HasInteger(HashMap_t *map, uint64_t key)
+{
+	if(map==NULL||map->keyType!=HASHMAP_KEY_INTEGER)
+		return false;
+
+	return HashMap_Find(map, HashMap_HashInteger(key), NULL, 0, key)!=UINT32_MAX;
+}
+
+bool HashMap_RemoveInteger(HashMap_t *map, uint64_t key)
+{
+	if(map==NULL||map->keyType!=HASHMAP_KEY_INTEGER)
+		return false;
+
+	const uint32_t index=HashMap_Find(map, HashMap_HashInteger(key), NULL, 0, key);
+
+	if(index==UINT32_MAX)
+		return false;
+
+	HashMap_RemoveIndex(map, index);
+
+	return true;
+}
@@ -0,0 +1,73 @@
+#ifndef __HASHMAP_H__
+#define __HASHMAP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// String keys shorter than this (including the terminator) are stored in the entry, longer ones get their own allocation
+#define HASHMAP_INLINE_KEY 24
+
+typedef enum
+{
+	HASHMAP_KEY_STRING=0,
+	HASHMAP_KEY_INTEGER
+} HashMapKey_e;
+
+// Where the map's memory comes from, frame maps are only valid until the calling thread's frame arena is reset
+typedef enum
+{
+	HASHMAP_STORAGE_ZONE=0,
+	HASHMAP_STORAGE_FRAME
+} HashMapStorage_e;
+
+// Hash 0 marks an empty entry, so stored hashes are never 0
+typedef struct
+{
+	uint32_t hash;
+	uint32_t length;
+
+	union
+	{
+		uint64_t integer;
+		char *string;
+		char inlineString[HASHMAP_INLINE_KEY];
+	} key;
+} HashMapEntry_t;
+
+// Open addressing hash map with Robin Hood linear probing.
+// Entries keep their full hash, so probes compare hashes before touching keys and growing never rehashes a key.
+// Values are stored by copy in a separate array (stride valueSize, which can be 0 for a set),
+// pointers to them are only valid until the next insert or remove.
+typedef struct
+{
+	HashMapKey_e keyType;
+	HashMapStorage_e storage;
+
+	uint32_t valueSize;
+	uint32_t count, capacity, mask;
+
+	HashMapEntry_t *entries;
+	uint8_t *values;
+} HashMap_t;
+
+uint32_t HashMap_HashString(const char *string);
+uint32_t HashMap_HashInteger(uint64_t integer);
+
+bool HashMap_Init(HashMap_t *map, HashMapKey_e keyType, HashMapStorage_e storage, uint32_t valueSize, uint32_t count);
+void HashMap_Destroy(HashMap_t *map);
+void HashMap_Clear(HashMap_t *map);
+uint32_t HashMap_GetCount(HashMap_t *map);
+
+void *HashMap_Insert(HashMap_t *map, const char *key, const void *value);
+void *HashMap_Get(HashMap_t *map, const char *key);
+void *HashMap_GetHashed(HashMap_t *map, uint32_t hash, const char *key);
+bool HashMap_Has(HashMap_t *map, const char *key);
+bool HashMap_Remove(HashMap_t *map, const char *key);
+
+void *HashMap_InsertInteger(HashMap_t *map, uint64_t key, const void *value);
+void *HashMap_GetInteger(HashMap_t *map, uint64_t key);
+bool HashMap_HasInteger(HashMap_t *map, uint64_t key);
+bool HashMap_RemoveInteger(HashMap_t *map, uint64_t key);
+
+#endif
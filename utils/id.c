@@ -1,43 +1,243 @@
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../system/system.h"
 #include "id.h"
 
-void ID_Init(ID_t pool)
+static inline uint32_t ID_FindFirstSet(uint64_t value)
 {
-    for(uint32_t i=0;i<ID_WORDS;i++)
-        pool[i]=0;
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctzll(value);
+#endif
 }
 
-uint32_t ID_Generate(ID_t pool)
+// Realloc that keeps the utils tag on the first allocation and clears the new part
+static uint64_t *ID_Realloc(uint64_t *ptr, uint32_t oldCount, uint32_t newCount)
 {
-    for(uint32_t word=0;word<ID_WORDS;word++)
+    uint64_t *words;
+
+    if(ptr==NULL)
+        words=(uint64_t *)Zone_MallocTagged(zone, sizeof(uint64_t)*newCount, TAG_UTILS);
+    else
+        words=(uint64_t *)Zone_Realloc(zone, ptr, sizeof(uint64_t)*newCount);
+
+    if(words==NULL)
+        return NULL;
+
+    memset(&words[oldCount], 0, sizeof(uint64_t)*(newCount-oldCount));
+
+    return words;
+}
+
+// Grows the bitmap to hold at least count IDs
+static bool ID_Grow(ID_t *pool, uint32_t count)
+{
+    uint32_t numWords=pool->numWords?pool->numWords:1;
+
+    while((uint64_t)numWords*ID_BITS<count)
+        numWords*=2;
+
+    // ID_INVALID can never be handed out
+    if((uint64_t)numWords*ID_BITS>ID_INVALID)
+        numWords=ID_INVALID/ID_BITS;
+
+    if(numWords<=pool->numWords)
+    {
+        DBGPRINTF(DEBUG_ERROR, "ID_Grow: Out of IDs.\r\n");
+        return false;
+    }
+
+    const uint32_t numSummary=(numWords+ID_BITS-1)/ID_BITS;
+
+    uint64_t *bits=ID_Realloc(pool->bits, pool->numWords, numWords);
+
+    if(bits==NULL)
+    {
+        DBGPRINTF(DEBUG_ERROR, "ID_Grow: Unable to allocate memory for bitmap.\r\n");
+        return false;
+    }
+
+    pool->bits=bits;
+
+    uint64_t *summary=ID_Realloc(pool->summary, pool->numSummary, numSummary);
+
+    if(summary==NULL)
+    {
+        // Bitmap keeps its new size, the extra words just aren't used yet
+        DBGPRINTF(DEBUG_ERROR, "ID_Grow: Unable to allocate memory for summary.\r\n");
+        return false;
+    }
+
+    pool->summary=summary;
+
+    // New words start out empty, so the summary word holding the first new one has room
+    if(pool->numWords/ID_BITS<pool->firstFree)
+        pool->firstFree=pool->numWords/ID_BITS;
+
+    pool->numWords=numWords;
+    pool->numSummary=numSummary;
+
+    return true;
+}
+
+// Returns the index of the first bitmap word with a free ID, or UINT32_MAX if it's full
+static uint32_t ID_FindFreeWord(ID_t *pool)
+{
+    for(;pool->firstFree<pool->numSummary;pool->firstFree++)
+    {
+        uint64_t free=~pool->summary[pool->firstFree];
+
+        // Last summary word may cover words past the end of the bitmap
+        const uint32_t base=pool->firstFree*ID_BITS;
+
+        if(pool->numWords-base<ID_BITS)
+            free&=((uint64_t)1<<(pool->numWords-base))-1;
+
+        if(free)
+            return base+ID_FindFirstSet(free);
+    }
+
+    return UINT32_MAX;
+}
+
+static inline void ID_SetWord(ID_t *pool, uint32_t word, uint64_t bits)
+{
+    pool->bits[word]=bits;
+
+    if(bits==UINT64_MAX)
+        pool->summary[word/ID_BITS]|=(uint64_t)1<<(word%ID_BITS);
+    else
+        pool->summary[word/ID_BITS]&=~((uint64_t)1<<(word%ID_BITS));
+}
+
+bool ID_Init(ID_t *pool, uint32_t count)
+{
+    if(pool==NULL)
+        return false;
+
+    memset(pool, 0, sizeof(ID_t));
+
+    return ID_Grow(pool, count?count:ID_INITIAL_COUNT);
+}
+
+void ID_Destroy(ID_t *pool)
+{
+    if(pool==NULL)
+        return;
+
+    if(pool->bits)
+        Zone_Free(zone, pool->bits);
+
+    if(pool->summary)
+        Zone_Free(zone, pool->summary);
+
+    memset(pool, 0, sizeof(ID_t));
+}
+
+uint32_t ID_Generate(ID_t *pool)
+{
+    if(pool==NULL)
+        return ID_INVALID;
+
+    uint32_t word=ID_FindFreeWord(pool);
+
+    if(word==UINT32_MAX)
+    {
+        if(!ID_Grow(pool, pool->numWords*ID_BITS+1))
+            return ID_INVALID;
+
+        word=ID_FindFreeWord(pool);
+    }
+
+    const uint32_t bit=ID_FindFirstSet(~pool->bits[word]);
+
+    ID_SetWord(pool, word, pool->bits[word]|((uint64_t)1<<bit));
+    pool->count++;
+
+    return word*ID_BITS+bit;
+}
+
+// Generates count IDs into the IDs array, taking whole bitmap words at a time where it can.
+// Returns the number of IDs generated, which is only short of count if the pool couldn't grow.
+uint32_t ID_GenerateBulk(ID_t *pool, uint32_t count, uint32_t *IDs)
+{
+    if(pool==NULL||IDs==NULL)
+        return 0;
+
+    // Grow once up front rather than as it runs out
+    if((uint64_t)pool->count+count>(uint64_t)pool->numWords*ID_BITS)
+        ID_Grow(pool, (uint32_t)((uint64_t)pool->count+count>ID_INVALID?ID_INVALID:pool->count+count));
+
+    uint32_t numIDs=0;
+
+    while(numIDs<count)
     {
-        if(pool[word]!=UINT32_MAX)
+        const uint32_t word=ID_FindFreeWord(pool);
+
+        if(word==UINT32_MAX)
+            break;
+
+        const uint32_t base=word*ID_BITS;
+        uint64_t free=~pool->bits[word];
+        uint64_t taken=0;
+
+        while(free&&numIDs<count)
         {
-            for(uint32_t bit=0;bit<ID_BITS;bit++)
-            {
-                uint32_t newID=word*ID_BITS+bit;
-
-                if(newID>=ID_MAX)
-                    break;
-
-                if(!(pool[word]&(1U<<bit)))
-                {
-                    pool[word]|=(1U<<bit);
-                    return newID;
-                }
-            }
+            const uint32_t bit=ID_FindFirstSet(free);
+
+            taken|=(uint64_t)1<<bit;
+            free&=free-1;
+
+            IDs[numIDs++]=base+bit;
         }
+
+        ID_SetWord(pool, word, pool->bits[word]|taken);
     }
 
-    return UINT32_MAX;
+    pool->count+=numIDs;
+
+    return numIDs;
 }
 
-void ID_Remove(ID_t pool, int id)
+void ID_Remove(ID_t *pool, uint32_t id)
 {
-    if(id<0||id>=ID_MAX)
+    if(!ID_IsUsed(pool, id))
         return;
 
-    uint32_t word=id/ID_BITS;
-    uint32_t bit=id%ID_BITS;
-    pool[word]&=~(1U<<bit);
+    const uint32_t word=id/ID_BITS;
+
+    ID_SetWord(pool, word, pool->bits[word]&~((uint64_t)1<<(id%ID_BITS)));
+    pool->count--;
+
+    if(word/ID_BITS<pool->firstFree)
+        pool->firstFree=word/ID_BITS;
+}
+
+void ID_RemoveBulk(ID_t *pool, uint32_t count, const uint32_t *IDs)
+{
+    if(pool==NULL||IDs==NULL)
+        return;
+
+    for(uint32_t i=0;i<count;i++)
+        ID_Remove(pool, IDs[i]);
+}
+
+bool ID_IsUsed(ID_t *pool, uint32_t id)
+{
+    if(pool==NULL||id>=pool->numWords*ID_BITS)
+        return false;
+
+    return (pool->bits[id/ID_BITS]>>(id%ID_BITS))&1;
+}
+
+uint32_t ID_GetCount(ID_t *pool)
+{
+    if(pool==NULL)
+        return 0;
+
+    return pool->count;
 }
@@ -2,23 +2,43 @@
 #define __ID_H__
 
 #include <stdint.h>
+#include <stdbool.h>
 
-#ifndef ID_MAX
-#define ID_MAX 8192
+// Starting number of IDs, the pool doubles whenever it fills up
+#ifndef ID_INITIAL_COUNT
+#define ID_INITIAL_COUNT 8192
 #endif
 
-#ifndef ID_BITS
-#define ID_BITS (sizeof(uint32_t)*8)
-#endif
+#define ID_BITS 64
 
-#ifndef ID_WORDS
-#define ID_WORDS ((ID_MAX+ID_BITS-1)/ID_BITS)
-#endif
+// Each summary word covers this many IDs (one bit per bitmap word)
+#define ID_SUMMARY_IDS (ID_BITS*ID_BITS)
+
+#define ID_INVALID UINT32_MAX
+
+// Two level bitmap ID allocator.
+// bits has one bit per ID (set=used), summary has one bit per bits word (set=word is full),
+// so a free ID is found with two count-trailing-zeros instead of scanning bit by bit.
+// IDs are always handed out lowest first, same as before.
+typedef struct
+{
+    uint64_t *bits;
+    uint64_t *summary;
+
+    uint32_t numWords, numSummary;
+    uint32_t count;
 
-typedef uint32_t ID_t[ID_WORDS];
+    // Lowest summary word that may have free IDs in it
+    uint32_t firstFree;
+} ID_t;
 
-void ID_Init(ID_t pool);
-uint32_t ID_Generate(ID_t pool);
-void ID_Remove(ID_t pool, int id);
+bool ID_Init(ID_t *pool, uint32_t count);
+void ID_Destroy(ID_t *pool);
+uint32_t ID_Generate(ID_t *pool);
+uint32_t ID_GenerateBulk(ID_t *pool, uint32_t count, uint32_t *IDs);
+void ID_Remove(ID_t *pool, uint32_t id);
+void ID_RemoveBulk(ID_t *pool, uint32_t count, const uint32_t *IDs);
+bool ID_IsUsed(ID_t *pool, uint32_t id);
+uint32_t ID_GetCount(ID_t *pool);
 
 #endif
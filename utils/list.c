@@ -11,6 +11,38 @@
 #include "../system/system.h"
 #include "list.h"
 
+// Resizes the buffer to exactly bufSize bytes
+static bool List_Resize(List_t *list, const size_t bufSize)
+{
+	uint8_t *ptr=(uint8_t *)Zone_Realloc(zone, list->buffer, bufSize);
+
+	if(ptr==NULL)
+		return false;
+
+	list->buffer=ptr;
+	list->bufSize=bufSize;
+
+	return true;
+}
+
+// Makes room for the list to be at least size bytes, over allocating by the growth factor to save from having to resize later
+static bool List_Grow(List_t *list, const size_t size)
+{
+	if(size<=list->bufSize)
+		return true;
+
+	const float growthFactor=list->growthFactor>1.0f?list->growthFactor:LIST_GROWTH_FACTOR;
+	size_t bufSize=(size_t)((double)list->bufSize*growthFactor);
+
+	if(bufSize<size)
+		bufSize=size;
+
+	// Keep it a whole number of items
+	bufSize=((bufSize+list->stride-1)/list->stride)*list->stride;
+
+	return List_Resize(list, bufSize);
+}
+
 bool List_Init(List_t *list, const size_t stride, const size_t count, const void *data)
 {
 	if(list==NULL)
@@ -22,6 +54,7 @@ bool List_Init(List_t *list, const size_t stride, const size_t count, const void
 
 	// Save stride
 	list->stride=stride;
+	list->growthFactor=LIST_GROWTH_FACTOR;
 
 	// If initial data was specified, allocate and copy it
 	if(data)
@@ -31,7 +64,7 @@ bool List_Init(List_t *list, const size_t stride, const size_t count, const void
 		// Actual buffer size is 2x list size to help avoid reallocation stalls at the cost of more memory usage
 		list->bufSize=list->size*2;
 
-		list->buffer=(uint8_t *)Zone_Malloc(zone, list->bufSize);
+		list->buffer=(uint8_t *)Zone_MallocTagged(zone, list->bufSize, TAG_UTILS);
 
 		if(list->buffer==NULL)
 			return false;
@@ -48,7 +81,7 @@ bool List_Init(List_t *list, const size_t stride, const size_t count, const void
 		if(count)
 			list->bufSize*=count;
 
-		list->buffer=(uint8_t *)Zone_Malloc(zone, list->bufSize);
+		list->buffer=(uint8_t *)Zone_MallocTagged(zone, list->bufSize, TAG_UTILS);
 
 		if(list->buffer==NULL)
 			return false;
@@ -65,33 +98,52 @@ bool List_Add(List_t *list, void *data)
 	if(!data)
 		return false;
 
-	// Save the current size for inserting data at the end of the list
-	size_t oldSize=list->size;
+	if(!List_Grow(list, list->size+list->stride))
+		return false;
 
-	// Increment list size by the item size (stride)
+	// Copy the data onto the end of the list
+	memcpy(&list->buffer[list->size], (uint8_t *)data, list->stride);
 	list->size+=list->stride;
 
-	// If list size is larger than the buffer, resize it
-	if(list->size>=list->bufSize)
-	{
-		// Over allocate memory to save from having to resize later
-		list->bufSize=list->size*2;
+	return true;
+}
 
-		// Reallocate the buffer
-		uint8_t *ptr=(uint8_t *)Zone_Realloc(zone, list->buffer, list->bufSize);
+// Adds count items from data in one copy
+bool List_AddN(List_t *list, const void *data, const size_t count)
+{
+	if(list==NULL||data==NULL)
+		return false;
 
-		if(ptr==NULL)
-			return false;
+	if(!count)
+		return true;
 
-		list->buffer=ptr;
-	}
+	const size_t size=list->stride*count;
 
-	// Copy the data into the new memory
-	memcpy(&list->buffer[oldSize], (uint8_t *)data, list->stride);
+	if(!List_Grow(list, list->size+size))
+		return false;
+
+	memcpy(&list->buffer[list->size], data, size);
+	list->size+=size;
 
 	return true;
 }
 
+// Adds an item to the end and returns a pointer to it for the caller to fill in, contents are uninitialized.
+// Pointer is only good until the list is next resized.
+void *List_Emplace(List_t *list)
+{
+	if(list==NULL)
+		return NULL;
+
+	if(!List_Grow(list, list->size+list->stride))
+		return NULL;
+
+	void *item=&list->buffer[list->size];
+	list->size+=list->stride;
+
+	return item;
+}
+
 bool List_Del(List_t *list, const size_t index)
 {
 	if(list==NULL)
@@ -101,14 +153,53 @@ bool List_Del(List_t *list, const size_t index)
 	if((index*list->stride)>=list->size)
 		return false;
 
-	// Shift data from index to end, overwriting the item to be removed
-	memcpy(&list->buffer[index*list->stride], &list->buffer[(index+1)*list->stride], list->size-(index*list->stride));
+	// Shift data after index down, overwriting the item to be removed
+	memmove(&list->buffer[index*list->stride], &list->buffer[(index+1)*list->stride], list->size-((index+1)*list->stride));
 	// Update list size
 	list->size-=list->stride;
 
 	return true;
 }
 
+// Removes an item by moving the last item into its place, doesn't keep order
+bool List_SwapRemove(List_t *list, const size_t index)
+{
+	if(list==NULL)
+		return false;
+
+	// Check buffer bounds
+	if((index*list->stride)>=list->size)
+		return false;
+
+	list->size-=list->stride;
+
+	if(index*list->stride!=list->size)
+		memcpy(&list->buffer[index*list->stride], &list->buffer[list->size], list->stride);
+
+	return true;
+}
+
+// Makes sure there's room for at least count items in total without resizing
+bool List_Reserve(List_t *list, const size_t count)
+{
+	if(list==NULL)
+		return false;
+
+	if(list->stride*count<=list->bufSize)
+		return true;
+
+	return List_Resize(list, list->stride*count);
+}
+
+// Sets how much the buffer grows by when it runs out of room, must be more than 1
+void List_SetGrowthFactor(List_t *list, const float growthFactor)
+{
+	if(list==NULL)
+		return;
+
+	list->growthFactor=growthFactor>1.0f?growthFactor:LIST_GROWTH_FACTOR;
+}
+
 void *List_GetPointer(List_t *list, const size_t index)
 {
 	if(list==NULL)
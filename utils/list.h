@@ -4,17 +4,28 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// Default growth factor, how much bigger the buffer gets each time it runs out of room
+#define LIST_GROWTH_FACTOR 2.0f
+
 typedef struct
 {
     size_t size;
 	size_t bufSize;
 	size_t stride;
     uint8_t *buffer;
+
+	// 0 means LIST_GROWTH_FACTOR
+	float growthFactor;
 } List_t;
 
 bool List_Init(List_t *list, const size_t stride, const size_t count, const void *data);
 bool List_Add(List_t *list, void *data);
+bool List_AddN(List_t *list, const void *data, const size_t count);
+void *List_Emplace(List_t *list);
 bool List_Del(List_t *list, const size_t index);
+bool List_SwapRemove(List_t *list, const size_t index);
+bool List_Reserve(List_t *list, const size_t count);
+void List_SetGrowthFactor(List_t *list, const float growthFactor);
 void *List_GetPointer(List_t *list, const size_t index);
 void List_GetCopy(List_t *list, const size_t index, void *data);
 size_t List_GetCount(List_t *list);
@@ -64,7 +64,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 	size_t length=ftell(stream);
 	fseek(stream, 0, SEEK_SET);
 
-	char *buffer=(char *)Zone_Malloc(zone, length+1);
+	char *buffer=(char *)Zone_MallocTagged(zone, length+1, TAG_UTILS);
 
 	if(buffer==NULL)
 		return false;
@@ -98,7 +98,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 				}
 
 				// Next token must be a left brace '{'
-				Zone_Free(zone, token);
+				Tokenizer_FreeToken(token);
 				token=Tokenizer_GetNext(&tokenizer);
 
 				if(token->type!=TOKEN_DELIMITER&&token->string[0]!='{')
@@ -111,7 +111,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 				while(!(token->type==TOKEN_DELIMITER&&token->string[0]=='}'))
 				{
 					// Look for keyword tokens
-					Zone_Free(zone, token);
+					Tokenizer_FreeToken(token);
 					token=Tokenizer_GetNext(&tokenizer);
 
 					if(token->type==TOKEN_KEYWORD)
@@ -125,7 +125,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 							VkShaderStageFlags stage=0;
 
 							// First token should be a left parenthesis '('
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type!=TOKEN_DELIMITER&&token->string[0]!='(')
@@ -138,7 +138,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								// Loop until right parenthesis ')' or until break condition
 								while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 								{
-									Zone_Free(zone, token);
+									Tokenizer_FreeToken(token);
 									token=Tokenizer_GetNext(&tokenizer);
 
 									if(token->type==TOKEN_INT&&param==0)
@@ -194,7 +194,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 										return false;
 									}
 
-									Zone_Free(zone, token);
+									Tokenizer_FreeToken(token);
 									token=Tokenizer_GetNext(&tokenizer);
 
 									if(token->type==TOKEN_DELIMITER)
@@ -250,7 +250,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					return false;
 				}
 
-				Zone_Free(zone, token);
+				Tokenizer_FreeToken(token);
 				token=Tokenizer_GetNext(&tokenizer);
 
 				if(token->type!=TOKEN_DELIMITER&&token->string[0]!='{')
@@ -261,7 +261,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 
 				while(!(token->type==TOKEN_DELIMITER&&token->string[0]=='}'))
 				{
-					Zone_Free(zone, token);
+					Tokenizer_FreeToken(token);
 					token=Tokenizer_GetNext(&tokenizer);
 
 					// Pipeline attribute keywords: "addStage", "addVertexBinding", "addVertexAttribute",
@@ -288,12 +288,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 						uint32_t shaderSize=0;
 						VkShaderStageFlagBits stage=0;
 
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_QUOTED&&param==0)
@@ -302,10 +302,10 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 							{
 								if(strcmp(token->string, "base64")==0&&param==0)
 								{
-									Zone_Free(zone, token);
+									Tokenizer_FreeToken(token);
 									token=Tokenizer_GetNext(&tokenizer);
 
-									shaderData=Zone_Malloc(zone, strlen(token->string));
+									shaderData=Zone_MallocTagged(zone, strlen(token->string), TAG_UTILS);
 
 									if(shaderData==NULL)
 										return false;
@@ -339,7 +339,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER)
@@ -388,12 +388,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 						uint32_t stride=0;
 						VkVertexInputRate inputRate=VK_VERTEX_INPUT_RATE_VERTEX;
 
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_INT&&param==0)
@@ -418,7 +418,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER)
@@ -455,12 +455,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 						VkFormat format=VK_FORMAT_UNDEFINED;
 						uint32_t offset=0;
 
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_INT&&param==0)
@@ -643,7 +643,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER)
@@ -674,14 +674,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "subpass")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.subpass=0;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_INT)
@@ -692,7 +692,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -706,12 +706,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "topology")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -750,7 +750,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -764,12 +764,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "primitiveRestart")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_BOOLEAN)
@@ -785,7 +785,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -799,12 +799,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "depthClamp")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_BOOLEAN)
@@ -820,7 +820,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -834,12 +834,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "rasterizerDiscard")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_BOOLEAN)
@@ -855,7 +855,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -869,14 +869,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "polygonMode")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.polygonMode=VK_POLYGON_MODE_FILL;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 								
 							if(token->type==TOKEN_STRING)
@@ -899,7 +899,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -913,14 +913,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "cullMode")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.cullMode=VK_CULL_MODE_NONE;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -945,7 +945,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -959,14 +959,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "frontFace")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.frontFace=VK_FRONT_FACE_COUNTER_CLOCKWISE;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -987,7 +987,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1001,12 +1001,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "depthBias")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_BOOLEAN)
@@ -1022,7 +1022,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1036,14 +1036,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "depthBiasConstantFactor")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.depthBiasConstantFactor=0.0f;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_FLOAT)
@@ -1054,7 +1054,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1068,14 +1068,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "depthBiasClamp")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.depthBiasClamp=0.0f;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_FLOAT)
@@ -1086,7 +1086,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1100,14 +1100,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "depthBiasSlopeFactor")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.depthBiasSlopeFactor=0.0f;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_FLOAT)
@@ -1118,7 +1118,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1132,14 +1132,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "lineWidth")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.lineWidth=0.0f;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_FLOAT)
@@ -1150,7 +1150,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1164,12 +1164,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "depthTest")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_BOOLEAN)
@@ -1185,7 +1185,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1199,12 +1199,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "depthWrite")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_BOOLEAN)
@@ -1220,7 +1220,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1234,14 +1234,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "depthCompareOp")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.depthCompareOp=VK_COMPARE_OP_NEVER;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -1274,7 +1274,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1288,12 +1288,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "depthBoundsTest")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_BOOLEAN)
@@ -1309,7 +1309,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1323,12 +1323,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "stencilTest")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_BOOLEAN)
@@ -1344,7 +1344,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1358,14 +1358,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "minDepthBounds")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.minDepthBounds=0.0f;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_FLOAT)
@@ -1376,7 +1376,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1390,14 +1390,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "maxDepthBounds")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.maxDepthBounds=0.0f;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_FLOAT)
@@ -1408,7 +1408,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1422,14 +1422,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "frontStencilFailOp")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.frontStencilFailOp=VK_STENCIL_OP_KEEP;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -1462,7 +1462,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1476,14 +1476,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "frontStencilPassOp")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.frontStencilPassOp=VK_STENCIL_OP_KEEP;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -1516,7 +1516,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1530,14 +1530,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "frontStencilDepthFailOp")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.frontStencilDepthFailOp=VK_STENCIL_OP_KEEP;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -1570,7 +1570,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1584,14 +1584,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "frontStencilCompareOp")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.frontStencilCompareOp=VK_COMPARE_OP_NEVER;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -1624,7 +1624,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1638,14 +1638,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "frontStencilCompareMask")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.frontStencilCompareMask=0;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_INT)
@@ -1656,7 +1656,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1670,14 +1670,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "frontStencilWriteMask")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.frontStencilWriteMask=0;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_INT)
@@ -1688,7 +1688,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1702,14 +1702,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "frontStencilReference")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.frontStencilReference=0;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_INT)
@@ -1720,7 +1720,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1734,14 +1734,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "backStencilFailOp")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.backStencilFailOp=VK_STENCIL_OP_KEEP;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -1774,7 +1774,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1788,14 +1788,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "backStencilPassOp")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.backStencilPassOp=VK_STENCIL_OP_KEEP;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -1828,7 +1828,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1842,14 +1842,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "backStencilDepthFailOp")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.backStencilDepthFailOp=VK_STENCIL_OP_KEEP;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -1882,7 +1882,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1896,14 +1896,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "backStencilCompareOp")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.backStencilCompareOp=VK_COMPARE_OP_NEVER;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -1936,7 +1936,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1950,14 +1950,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "backStencilCompareMask")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.backStencilCompareMask=0;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_INT)
@@ -1968,7 +1968,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -1982,14 +1982,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "backStencilWriteMask")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.backStencilWriteMask=0;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_INT)
@@ -2000,7 +2000,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2014,14 +2014,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "backStencilReference")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.backStencilReference=0;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_INT)
@@ -2032,7 +2032,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2046,14 +2046,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "rasterizationSamples")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.rasterizationSamples=VK_SAMPLE_COUNT_1_BIT;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_INT)
@@ -2084,7 +2084,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2098,12 +2098,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "sampleShading")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_BOOLEAN)
@@ -2119,7 +2119,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2133,12 +2133,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "minSampleShading")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_FLOAT)
@@ -2149,7 +2149,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2163,19 +2163,19 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "sampleMask")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						Tokenizer_PrintToken("sampleMask not implemented! ", token);
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "alphaToCoverage")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_BOOLEAN)
@@ -2191,7 +2191,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2205,12 +2205,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "alphaToOne")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_BOOLEAN)
@@ -2226,7 +2226,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2240,12 +2240,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "blendLogicOp")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_BOOLEAN)
@@ -2261,7 +2261,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2275,14 +2275,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "blendLogicOpState")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.blendLogicOpState=VK_LOGIC_OP_CLEAR;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -2329,7 +2329,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2343,12 +2343,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "blend")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_BOOLEAN)
@@ -2364,7 +2364,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2378,14 +2378,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "srcColorBlendFactor")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.srcColorBlendFactor=VK_BLEND_FACTOR_ZERO;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -2440,7 +2440,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2454,14 +2454,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "dstColorBlendFactor")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.dstColorBlendFactor=VK_BLEND_FACTOR_ZERO;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -2516,7 +2516,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2530,12 +2530,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "colorBlendOp")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -2562,7 +2562,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2576,14 +2576,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "srcAlphaBlendFactor")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.srcAlphaBlendFactor=VK_BLEND_FACTOR_ZERO;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -2638,7 +2638,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2652,14 +2652,14 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					}
 					else if(token->type==TOKEN_KEYWORD&&strcmp(token->string, "dstAlphaBlendFactor")==0)
 					{
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
 							pipeline->pipeline.dstAlphaBlendFactor=VK_BLEND_FACTOR_ZERO;
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -2714,7 +2714,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2730,12 +2730,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					{
 						pipeline->pipeline.alphaBlendOp=VK_BLEND_OP_ADD;
 
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -2762,7 +2762,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER&&token->string[0]==')')
@@ -2778,12 +2778,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 					{
 						pipeline->pipeline.colorWriteMask=0;
 
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_STRING)
@@ -2810,7 +2810,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER)
@@ -2834,12 +2834,12 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 						pipeline->pushConstant.size=0;
 						pipeline->pushConstant.stageFlags=0;
 
-						Zone_Free(zone, token);
+						Tokenizer_FreeToken(token);
 						token=Tokenizer_GetNext(&tokenizer);
 
 						while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 						{
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_INT&&param==0)
@@ -2872,7 +2872,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 								return false;
 							}
 
-							Zone_Free(zone, token);
+							Tokenizer_FreeToken(token);
 							token=Tokenizer_GetNext(&tokenizer);
 
 							if(token->type==TOKEN_DELIMITER)
@@ -2903,7 +2903,7 @@ bool CreatePipeline(VkuContext_t *context, Pipeline_t *pipeline, VkRenderPass re
 		}
 
 		if(token)
-			Zone_Free(zone, token);
+			Tokenizer_FreeToken(token);
 	}
 
 	Zone_Free(zone, buffer);
@@ -0,0 +1,259 @@
+// Generational slot map, stable handles with O(1) add, remove and lookup over densely packed items.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../system/system.h"
+#include "slotmap.h"
+
+static inline uint32_t SlotMap_MakeHandle(const uint32_t slot, const uint32_t generation)
+{
+	return (generation<<SLOTMAP_INDEX_BITS)|slot;
+}
+
+// Returns the slot for a handle, or UINT32_MAX if it's out of range or stale
+static inline uint32_t SlotMap_GetSlot(SlotMap_t *slotMap, const uint32_t handle)
+{
+	const uint32_t slot=handle&SLOTMAP_INDEX_MASK;
+
+	if(handle==SLOTMAP_INVALID||slot>=slotMap->numSlots)
+		return UINT32_MAX;
+
+	if(slotMap->generations[slot]!=(handle>>SLOTMAP_INDEX_BITS))
+		return UINT32_MAX;
+
+	return slot;
+}
+
+// Realloc that keeps the utils tag on the first allocation
+static void *SlotMap_Realloc(void *ptr, const size_t size)
+{
+	if(ptr==NULL)
+		return Zone_MallocTagged(zone, size, TAG_UTILS);
+
+	return Zone_Realloc(zone, ptr, size);
+}
+
+static bool SlotMap_GrowDense(SlotMap_t *slotMap)
+{
+	uint32_t capacity=slotMap->capacity?slotMap->capacity*2:8;
+
+	if(capacity>SLOTMAP_MAX)
+		capacity=SLOTMAP_MAX;
+
+	uint8_t *dense=(uint8_t *)SlotMap_Realloc(slotMap->dense, slotMap->stride*capacity);
+
+	if(dense==NULL)
+		return false;
+
+	slotMap->dense=dense;
+
+	uint32_t *denseSlot=(uint32_t *)SlotMap_Realloc(slotMap->denseSlot, sizeof(uint32_t)*capacity);
+
+	if(denseSlot==NULL)
+		return false;
+
+	slotMap->denseSlot=denseSlot;
+	slotMap->capacity=capacity;
+
+	return true;
+}
+
+static bool SlotMap_GrowSlots(SlotMap_t *slotMap)
+{
+	uint32_t capacity=slotMap->slotCapacity?slotMap->slotCapacity*2:8;
+
+	if(capacity>SLOTMAP_MAX)
+		capacity=SLOTMAP_MAX;
+
+	uint32_t *slots=(uint32_t *)SlotMap_Realloc(slotMap->slots, sizeof(uint32_t)*capacity);
+
+	if(slots==NULL)
+		return false;
+
+	slotMap->slots=slots;
+
+	uint32_t *generations=(uint32_t *)SlotMap_Realloc(slotMap->generations, sizeof(uint32_t)*capacity);
+
+	if(generations==NULL)
+		return false;
+
+	slotMap->generations=generations;
+	slotMap->slotCapacity=capacity;
+
+	return true;
+}
+
+bool SlotMap_Init(SlotMap_t *slotMap, const size_t stride, const uint32_t count)
+{
+	if(slotMap==NULL||!stride)
+		return false;
+
+	memset(slotMap, 0, sizeof(SlotMap_t));
+
+	slotMap->stride=stride;
+	slotMap->freeSlot=UINT32_MAX;
+
+	// Optional pre-allocation
+	if(count)
+	{
+		slotMap->capacity=count<SLOTMAP_MAX?count:SLOTMAP_MAX;
+		slotMap->slotCapacity=slotMap->capacity;
+
+		slotMap->dense=(uint8_t *)Zone_MallocTagged(zone, stride*slotMap->capacity, TAG_UTILS);
+		slotMap->denseSlot=(uint32_t *)Zone_MallocTagged(zone, sizeof(uint32_t)*slotMap->capacity, TAG_UTILS);
+		slotMap->slots=(uint32_t *)Zone_MallocTagged(zone, sizeof(uint32_t)*slotMap->slotCapacity, TAG_UTILS);
+		slotMap->generations=(uint32_t *)Zone_MallocTagged(zone, sizeof(uint32_t)*slotMap->slotCapacity, TAG_UTILS);
+
+		if(slotMap->dense==NULL||slotMap->denseSlot==NULL||slotMap->slots==NULL||slotMap->generations==NULL)
+		{
+			SlotMap_Destroy(slotMap);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Copies stride bytes from data into a new item, returns it's handle or SLOTMAP_INVALID
+uint32_t SlotMap_Add(SlotMap_t *slotMap, const void *data)
+{
+	if(slotMap==NULL||data==NULL)
+		return SLOTMAP_INVALID;
+
+	if(slotMap->count>=slotMap->capacity&&!SlotMap_GrowDense(slotMap))
+		return SLOTMAP_INVALID;
+
+	// Reuse a free slot if there is one, otherwise make a new one
+	uint32_t slot=slotMap->freeSlot;
+
+	if(slot!=UINT32_MAX)
+		slotMap->freeSlot=slotMap->slots[slot];
+	else
+	{
+		if(slotMap->numSlots>=SLOTMAP_MAX)
+			return SLOTMAP_INVALID;
+
+		if(slotMap->numSlots>=slotMap->slotCapacity&&!SlotMap_GrowSlots(slotMap))
+			return SLOTMAP_INVALID;
+
+		slot=slotMap->numSlots++;
+		slotMap->generations[slot]=0;
+	}
+
+	const uint32_t index=slotMap->count++;
+
+	memcpy(&slotMap->dense[slotMap->stride*index], data, slotMap->stride);
+	slotMap->denseSlot[index]=slot;
+	slotMap->slots[slot]=index;
+
+	return SlotMap_MakeHandle(slot, slotMap->generations[slot]);
+}
+
+// Swaps the last item into the removed one's place
+bool SlotMap_Remove(SlotMap_t *slotMap, const uint32_t handle)
+{
+	if(slotMap==NULL)
+		return false;
+
+	const uint32_t slot=SlotMap_GetSlot(slotMap, handle);
+
+	if(slot==UINT32_MAX)
+		return false;
+
+	const uint32_t index=slotMap->slots[slot];
+	const uint32_t last=--slotMap->count;
+
+	if(index!=last)
+	{
+		memcpy(&slotMap->dense[slotMap->stride*index], &slotMap->dense[slotMap->stride*last], slotMap->stride);
+		slotMap->denseSlot[index]=slotMap->denseSlot[last];
+		slotMap->slots[slotMap->denseSlot[index]]=index;
+	}
+
+	// Invalidate any outstanding handles and put the slot on the free list
+	slotMap->generations[slot]=(slotMap->generations[slot]+1)&SLOTMAP_GENERATION_MASK;
+	slotMap->slots[slot]=slotMap->freeSlot;
+	slotMap->freeSlot=slot;
+
+	return true;
+}
+
+bool SlotMap_IsValid(SlotMap_t *slotMap, const uint32_t handle)
+{
+	if(slotMap==NULL)
+		return false;
+
+	return SlotMap_GetSlot(slotMap, handle)!=UINT32_MAX;
+}
+
+// Returns NULL for stale or invalid handles
+void *SlotMap_Get(SlotMap_t *slotMap, const uint32_t handle)
+{
+	if(slotMap==NULL)
+		return NULL;
+
+	const uint32_t slot=SlotMap_GetSlot(slotMap, handle);
+
+	if(slot==UINT32_MAX)
+		return NULL;
+
+	return &slotMap->dense[slotMap->stride*slotMap->slots[slot]];
+}
+
+uint32_t SlotMap_GetCount(SlotMap_t *slotMap)
+{
+	if(slotMap==NULL)
+		return 0;
+
+	return slotMap->count;
+}
+
+// Dense access for iterating, index is 0 to SlotMap_GetCount-1
+void *SlotMap_GetDense(SlotMap_t *slotMap, const uint32_t index)
+{
+	if(slotMap==NULL||index>=slotMap->count)
+		return NULL;
+
+	return &slotMap->dense[slotMap->stride*index];
+}
+
+uint32_t SlotMap_GetDenseHandle(SlotMap_t *slotMap, const uint32_t index)
+{
+	if(slotMap==NULL||index>=slotMap->count)
+		return SLOTMAP_INVALID;
+
+	const uint32_t slot=slotMap->denseSlot[index];
+
+	return SlotMap_MakeHandle(slot, slotMap->generations[slot]);
+}
+
+// Removes everything, all outstanding handles become stale
+void SlotMap_Clear(SlotMap_t *slotMap)
+{
+	if(slotMap==NULL)
+		return;
+
+	while(slotMap->count)
+		SlotMap_Remove(slotMap, SlotMap_GetDenseHandle(slotMap, slotMap->count-1));
+}
+
+void SlotMap_Destroy(SlotMap_t *slotMap)
+{
+	if(slotMap==NULL)
+		return;
+
+	if(slotMap->dense)
+		Zone_Free(zone, slotMap->dense);
+
+	if(slotMap->denseSlot)
+		Zone_Free(zone, slotMap->denseSlot);
+
+	if(slotMap->slots)
+		Zone_Free(zone, slotMap->slots);
+
+	if(slotMap->generations)
+		Zone_Free(zone, slotMap->generations);
+
+	memset(slotMap, 0, sizeof(SlotMap_t));
+}
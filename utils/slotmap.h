@@ -0,0 +1,49 @@
+#ifndef __SLOTMAP_H__
+#define __SLOTMAP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Handles are a slot index in the low bits and that slot's generation in the high bits.
+// The generation is bumped every time a slot is freed, so handles to removed items never match again (until it wraps).
+#define SLOTMAP_INDEX_BITS 20
+#define SLOTMAP_INDEX_MASK ((1u<<SLOTMAP_INDEX_BITS)-1)
+#define SLOTMAP_GENERATION_MASK (UINT32_MAX>>SLOTMAP_INDEX_BITS)
+
+// Last index is never handed out, so no valid handle can be SLOTMAP_INVALID
+#define SLOTMAP_MAX (SLOTMAP_INDEX_MASK)
+#define SLOTMAP_INVALID UINT32_MAX
+
+// Generational slot map.
+// Items are packed in a dense array for iteration, handles go through a sparse slot array to find them.
+// Removal swaps the last item into the hole, so dense order only matches insertion order until the first removal,
+//		and pointers into the dense array are only valid until the next add or remove.
+typedef struct
+{
+	size_t stride;
+
+	// Dense items, and which slot each one belongs to
+	uint8_t *dense;
+	uint32_t *denseSlot;
+	uint32_t count, capacity;
+
+	// Sparse slots, dense index for live slots or the next free slot for free ones
+	uint32_t *slots;
+	uint32_t *generations;
+	uint32_t numSlots, slotCapacity;
+	uint32_t freeSlot;
+} SlotMap_t;
+
+bool SlotMap_Init(SlotMap_t *slotMap, const size_t stride, const uint32_t count);
+uint32_t SlotMap_Add(SlotMap_t *slotMap, const void *data);
+bool SlotMap_Remove(SlotMap_t *slotMap, const uint32_t handle);
+bool SlotMap_IsValid(SlotMap_t *slotMap, const uint32_t handle);
+void *SlotMap_Get(SlotMap_t *slotMap, const uint32_t handle);
+uint32_t SlotMap_GetCount(SlotMap_t *slotMap);
+void *SlotMap_GetDense(SlotMap_t *slotMap, const uint32_t index);
+uint32_t SlotMap_GetDenseHandle(SlotMap_t *slotMap, const uint32_t index);
+void SlotMap_Clear(SlotMap_t *slotMap);
+void SlotMap_Destroy(SlotMap_t *slotMap);
+
+#endif
@@ -2,9 +2,61 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include "../system/system.h"
 #include "spatialhash.h"
 
+// Realloc that keeps the utils tag on the first allocation
+static void *SpatialHash_Realloc(void *ptr, const size_t size)
+{
+	if(ptr==NULL)
+		return Zone_MallocTagged(zone, size, TAG_UTILS);
+
+	return Zone_Realloc(zone, ptr, size);
+}
+
+static bool SpatialHash_Reserve(SpatialHash_t *spatialHash, const uint32_t count)
+{
+	if(count<=spatialHash->maxObjects)
+		return true;
+
+	uint32_t maxObjects=spatialHash->maxObjects?spatialHash->maxObjects:64;
+
+	while(maxObjects<count)
+		maxObjects*=2;
+
+	uint32_t *objectCells=(uint32_t *)SpatialHash_Realloc(spatialHash->objectCells, sizeof(uint32_t)*maxObjects);
+
+	if(objectCells==NULL)
+		return false;
+
+	spatialHash->objectCells=objectCells;
+
+	vec3 *positions=(vec3 *)SpatialHash_Realloc(spatialHash->positions, sizeof(vec3)*maxObjects);
+
+	if(positions==NULL)
+		return false;
+
+	spatialHash->positions=positions;
+
+	void **objects=(void **)SpatialHash_Realloc(spatialHash->objects, sizeof(void *)*maxObjects);
+
+	if(objects==NULL)
+		return false;
+
+	spatialHash->objects=objects;
+
+	uint32_t *sortedObjects=(uint32_t *)SpatialHash_Realloc(spatialHash->sortedObjects, sizeof(uint32_t)*maxObjects);
+
+	if(sortedObjects==NULL)
+		return false;
+
+	spatialHash->sortedObjects=sortedObjects;
+	spatialHash->maxObjects=maxObjects;
+
+	return true;
+}
+
 bool SpatialHash_Create(SpatialHash_t *spatialHash, const uint32_t tableSize, const float gridSize)
 {
 	if(spatialHash==NULL)
@@ -16,102 +68,259 @@ bool SpatialHash_Create(SpatialHash_t *spatialHash, const uint32_t tableSize, co
 	if(gridSize<=0.0f)
 		return false;
 
+	memset(spatialHash, 0, sizeof(SpatialHash_t));
+
 	spatialHash->gridSize=gridSize;
 	spatialHash->invGridSize=1.0f/gridSize;
 
 	spatialHash->hashTableSize=tableSize;
 
-	spatialHash->hashTable=(Cell_t *)Zone_Malloc(zone, sizeof(Cell_t)*tableSize);
+	spatialHash->cellStart=(uint32_t *)Zone_MallocTagged(zone, sizeof(uint32_t)*(tableSize+1), TAG_UTILS);
 
-	if(spatialHash->hashTable==NULL)
+	if(spatialHash->cellStart==NULL)
 	{
 		DBGPRINTF(DEBUG_ERROR, "Unable to allocate memory for hash table.\n");
 		return false;
 	}
 
+	memset(spatialHash->cellStart, 0, sizeof(uint32_t)*(tableSize+1));
+
+	if(!SpatialHash_Reserve(spatialHash, 64))
+	{
+		DBGPRINTF(DEBUG_ERROR, "Unable to allocate memory for hash objects.\n");
+		SpatialHash_Destroy(spatialHash);
+		return false;
+	}
+
 	return true;
 }
 
 void SpatialHash_Destroy(SpatialHash_t *spatialHash)
 {
-	Zone_Free(zone, spatialHash->hashTable);
+	if(spatialHash==NULL)
+		return;
+
+	if(spatialHash->cellStart)
+		Zone_Free(zone, spatialHash->cellStart);
+
+	if(spatialHash->objectCells)
+		Zone_Free(zone, spatialHash->objectCells);
+
+	if(spatialHash->positions)
+		Zone_Free(zone, spatialHash->positions);
+
+	if(spatialHash->objects)
+		Zone_Free(zone, spatialHash->objects);
+
+	if(spatialHash->sortedObjects)
+		Zone_Free(zone, spatialHash->sortedObjects);
+
 	memset(spatialHash, 0, sizeof(SpatialHash_t));
 }
 
 static inline uint32_t hashFunction(const int32_t hx, const int32_t hy, const int32_t hz, const uint32_t tableSize)
 {
-	return abs((hx*73856093)^(hy*19349663)^(hz*83492791))%tableSize;
+	return (((uint32_t)hx*73856093u)^((uint32_t)hy*19349663u)^((uint32_t)hz*83492791u))%tableSize;
+}
+
+// Cells are floored so negative coordinates don't all collapse into cell 0
+static inline void SpatialHash_GetCellCoords(const SpatialHash_t *spatialHash, const vec3 value, int32_t cell[3])
+{
+	cell[0]=(int32_t)floorf(value.x*spatialHash->invGridSize);
+	cell[1]=(int32_t)floorf(value.y*spatialHash->invGridSize);
+	cell[2]=(int32_t)floorf(value.z*spatialHash->invGridSize);
+}
+
+static inline uint32_t SpatialHash_Hash(const SpatialHash_t *spatialHash, const vec3 value, const int32_t ox, const int32_t oy, const int32_t oz)
+{
+	int32_t cell[3];
+
+	SpatialHash_GetCellCoords(spatialHash, value, cell);
+
+	return hashFunction(cell[0]+ox, cell[1]+oy, cell[2]+oz, spatialHash->hashTableSize);
 }
 
-// Clear hash table
+// Whether an object is really in a cell, rather than just in a bucket that cell aliases to
+static inline bool SpatialHash_InCell(const SpatialHash_t *spatialHash, const uint32_t object, const int32_t cell[3])
+{
+	int32_t objectCell[3];
+
+	SpatialHash_GetCellCoords(spatialHash, spatialHash->positions[object], objectCell);
+
+	return objectCell[0]==cell[0]&&objectCell[1]==cell[1]&&objectCell[2]==cell[2];
+}
+
+// Clear hash table, buffers are kept for the next round of adds
 void SpatialHash_Clear(SpatialHash_t *spatialHash)
 {
-	memset(spatialHash->hashTable, 0, sizeof(Cell_t)*spatialHash->hashTableSize);
+	if(spatialHash==NULL)
+		return;
+
+	spatialHash->numObjects=0;
+	spatialHash->dirty=true;
 }
 
-// Add object to table
+// Add object to table, it won't show up in queries until the table is built again
 bool SpatialHash_AddObject(SpatialHash_t *spatialHash, const vec3 value, void *object)
 {
-	const int32_t hx=(const int32_t)(value.x*spatialHash->invGridSize);
-	const int32_t hy=(const int32_t)(value.y*spatialHash->invGridSize);
-	const int32_t hz=(const int32_t)(value.z*spatialHash->invGridSize);
-	const uint32_t index=hashFunction(hx, hy, hz, spatialHash->hashTableSize);
+	if(spatialHash==NULL||spatialHash->cellStart==NULL)
+		return false;
 
-	if(index>spatialHash->hashTableSize)
+	if(spatialHash->numObjects==UINT32_MAX||!SpatialHash_Reserve(spatialHash, spatialHash->numObjects+1))
 	{
-		DBGPRINTF(DEBUG_ERROR, "Invalid hash index.\n");
+		DBGPRINTF(DEBUG_ERROR, "Unable to allocate memory for hash objects.\n");
 		return false;
 	}
 
-	if(spatialHash->hashTable[index].numObjects<100)
+	spatialHash->objectCells[spatialHash->numObjects]=SpatialHash_Hash(spatialHash, value, 0, 0, 0);
+	spatialHash->positions[spatialHash->numObjects]=value;
+	spatialHash->objects[spatialHash->numObjects]=object;
+	spatialHash->numObjects++;
+	spatialHash->dirty=true;
+
+	return true;
+}
+
+// Counting sort the added objects by cell.
+// Objects in a cell keep the order they were added in.
+bool SpatialHash_Build(SpatialHash_t *spatialHash)
+{
+	if(spatialHash==NULL||spatialHash->cellStart==NULL)
+		return false;
+
+	uint32_t *cellStart=spatialHash->cellStart;
+	const uint32_t tableSize=spatialHash->hashTableSize;
+
+	memset(cellStart, 0, sizeof(uint32_t)*(tableSize+1));
+
+	// Count objects per cell, offset by one so the prefix sum leaves each cell's start in place
+	for(uint32_t i=0;i<spatialHash->numObjects;i++)
+		cellStart[spatialHash->objectCells[i]+1]++;
+
+	for(uint32_t i=0;i<tableSize;i++)
+		cellStart[i+1]+=cellStart[i];
+
+	// Scatter, using cellStart as the write cursor for each cell, which leaves it pointing at the next cell's start
+	for(uint32_t i=0;i<spatialHash->numObjects;i++)
+		spatialHash->sortedObjects[cellStart[spatialHash->objectCells[i]]++]=i;
+
+	// Shift back down to get the starts again
+	for(uint32_t i=tableSize;i>0;i--)
+		cellStart[i]=cellStart[i-1];
+
+	cellStart[0]=0;
+
+	spatialHash->dirty=false;
+
+	return true;
+}
+
+uint32_t SpatialHash_GetCellIndex(const SpatialHash_t *spatialHash, const vec3 value)
+{
+	if(spatialHash==NULL||spatialHash->cellStart==NULL)
+		return UINT32_MAX;
+
+	return SpatialHash_Hash(spatialHash, value, 0, 0, 0);
+}
+
+// Returns the object indices in a cell as one contiguous range, only valid after a build
+const uint32_t *SpatialHash_GetCell(const SpatialHash_t *spatialHash, const uint32_t cellIndex, uint32_t *count)
+{
+	if(spatialHash==NULL||spatialHash->cellStart==NULL||cellIndex>=spatialHash->hashTableSize)
 	{
-		spatialHash->hashTable[index].objects[spatialHash->hashTable[index].numObjects++]=object;
-		return true;
+		if(count)
+			*count=0;
+
+		return NULL;
 	}
 
-	DBGPRINTF(DEBUG_ERROR, "Ran out of bucket space.\n");
-	return false;
+	const uint32_t start=spatialHash->cellStart[cellIndex];
+
+	if(count)
+		*count=spatialHash->cellStart[cellIndex+1]-start;
+
+	return &spatialHash->sortedObjects[start];
 }
 
-void SpatialHash_TestObjects(SpatialHash_t *spatialHash, vec3 value, void *a, void (*testFunc)(void *a, void *b))
+void *SpatialHash_GetObject(const SpatialHash_t *spatialHash, const uint32_t index)
 {
-	// Neighbor cell offsets
-	const int32_t offsets[27][3]=
-	{
-		{-1,-1,-1 }, {-1,-1, 0 }, {-1,-1, 1 },
-		{-1, 0,-1 }, {-1, 0, 0 }, {-1, 0, 1 },
-		{-1, 1,-1 }, {-1, 1, 0 }, {-1, 1, 1 },
-		{ 0,-1,-1 }, { 0,-1, 0 }, { 0,-1, 1 },
-		{ 0, 0,-1 }, { 0, 0, 0 }, { 0, 0, 1 },
-		{ 0, 1,-1 }, { 0, 1, 0 }, { 0, 1, 1 },
-		{ 1,-1,-1 }, { 1,-1, 0 }, { 1,-1, 1 },
-		{ 1, 0,-1 }, { 1, 0, 0 }, { 1, 0, 1 },
-		{ 1, 1,-1 }, { 1, 1, 0 }, { 1, 1, 1 }
-	};
+	if(spatialHash==NULL||index>=spatialHash->numObjects)
+		return NULL;
 
-	// Object hash position
-	const int32_t hx=(const int32_t)(value.x*spatialHash->invGridSize);
-	const int32_t hy=(const int32_t)(value.y*spatialHash->invGridSize);
-	const int32_t hz=(const int32_t)(value.z*spatialHash->invGridSize);
+	return spatialHash->objects[index];
+}
 
-	// Iterate over cell offsets
-	for(uint32_t j=0;j<27;j++)
+uint32_t SpatialHash_GetObjectCount(const SpatialHash_t *spatialHash)
+{
+	if(spatialHash==NULL)
+		return 0;
+
+	return spatialHash->numObjects;
+}
+
+// Neighbor cell offsets
+static const int32_t neighborOffsets[27][3]=
+{
+	{-1,-1,-1 }, {-1,-1, 0 }, {-1,-1, 1 },
+	{-1, 0,-1 }, {-1, 0, 0 }, {-1, 0, 1 },
+	{-1, 1,-1 }, {-1, 1, 0 }, {-1, 1, 1 },
+	{ 0,-1,-1 }, { 0,-1, 0 }, { 0,-1, 1 },
+	{ 0, 0,-1 }, { 0, 0, 0 }, { 0, 0, 1 },
+	{ 0, 1,-1 }, { 0, 1, 0 }, { 0, 1, 1 },
+	{ 1,-1,-1 }, { 1,-1, 0 }, { 1,-1, 1 },
+	{ 1, 0,-1 }, { 1, 0, 0 }, { 1, 0, 1 },
+	{ 1, 1,-1 }, { 1, 1, 0 }, { 1, 1, 1 }
+};
+
+// Hashes the 27 cells around a position, dropping any that alias to a bucket already in the list,
+// otherwise objects in that bucket would be visited once for every neighbor that hashed there.
+static uint32_t SpatialHash_GetNeighborCells(const SpatialHash_t *spatialHash, const vec3 value, uint32_t cells[27])
+{
+	uint32_t numCells=0;
+
+	for(uint32_t i=0;i<27;i++)
 	{
-		const uint32_t hashIndex=hashFunction(hx+offsets[j][0], hy+offsets[j][1], hz+offsets[j][2], spatialHash->hashTableSize);
+		const uint32_t cell=SpatialHash_Hash(spatialHash, value, neighborOffsets[i][0], neighborOffsets[i][1], neighborOffsets[i][2]);
+		bool duplicate=false;
 
-		if(hashIndex>spatialHash->hashTableSize)
+		for(uint32_t j=0;j<numCells;j++)
 		{
-			DBGPRINTF(DEBUG_ERROR, "Invalid hash index.\n");
-			return;
+			if(cells[j]==cell)
+			{
+				duplicate=true;
+				break;
+			}
 		}
 
-		Cell_t *neighborCell=&spatialHash->hashTable[hashIndex];
+		if(!duplicate)
+			cells[numCells++]=cell;
+	}
+
+	return numCells;
+}
+
+void SpatialHash_TestObjects(SpatialHash_t *spatialHash, vec3 value, void *a, void (*testFunc)(void *a, void *b))
+{
+	if(spatialHash==NULL||spatialHash->cellStart==NULL)
+		return;
+
+	// Build on first query after adding objects
+	if(spatialHash->dirty)
+		SpatialHash_Build(spatialHash);
+
+	uint32_t cells[27];
+	const uint32_t numCells=SpatialHash_GetNeighborCells(spatialHash, value, cells);
+
+	// Iterate over neighbor cells
+	for(uint32_t j=0;j<numCells;j++)
+	{
+		const uint32_t start=spatialHash->cellStart[cells[j]], end=spatialHash->cellStart[cells[j]+1];
 
 		// Iterate over objects in the neighbor cell
-		for(uint32_t k=0;k<neighborCell->numObjects;k++)
+		for(uint32_t k=start;k<end;k++)
 		{
 			// Object 'B'
-			void *b=neighborCell->objects[k];
+			void *b=spatialHash->objects[spatialHash->sortedObjects[k]];
 
 			if(a==b)
 				continue;
@@ -121,3 +330,334 @@ void SpatialHash_TestObjects(SpatialHash_t *spatialHash, vec3 value, void *a, vo
 		}
 	}
 }
+
+typedef struct
+{
+	const SpatialHash_t *spatialHash;
+
+	// NULL in pair mode, where the queries are the objects themselves
+	const vec3 *positions;
+
+	// Candidates per query, then turned into each query's first output slot
+	uint32_t *offsets;
+
+	SpatialHashPair_t *pairs;
+	uint32_t maxPairs;
+} SpatialHashQuery_t;
+
+// Runs one query, writing candidates from the first output slot up to maxPairs if pairs isn't NULL.
+// Pair mode only takes objects with a higher index than the query object, so each pair comes out once.
+static uint32_t SpatialHash_RunQuery(const SpatialHashQuery_t *query, const uint32_t index, SpatialHashPair_t *pairs, uint32_t first)
+{
+	const SpatialHash_t *spatialHash=query->spatialHash;
+	const bool pairMode=query->positions==NULL;
+	const vec3 position=pairMode?spatialHash->positions[index]:query->positions[index];
+
+	uint32_t cells[27];
+	const uint32_t numCells=SpatialHash_GetNeighborCells(spatialHash, position, cells);
+	uint32_t count=0;
+
+	for(uint32_t j=0;j<numCells;j++)
+	{
+		const uint32_t start=spatialHash->cellStart[cells[j]], end=spatialHash->cellStart[cells[j]+1];
+
+		for(uint32_t k=start;k<end;k++)
+		{
+			const uint32_t object=spatialHash->sortedObjects[k];
+
+			if(pairMode&&object<=index)
+				continue;
+
+			if(pairs&&first+count<query->maxPairs)
+				pairs[first+count]=(SpatialHashPair_t){ .query=index, .object=object };
+
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static void SpatialHash_CountRange(uint32_t start, uint32_t end, void *userdata)
+{
+	SpatialHashQuery_t *query=(SpatialHashQuery_t *)userdata;
+
+	for(uint32_t i=start;i<end;i++)
+		query->offsets[i]=SpatialHash_RunQuery(query, i, NULL, 0);
+}
+
+static void SpatialHash_WriteRange(uint32_t start, uint32_t end, void *userdata)
+{
+	SpatialHashQuery_t *query=(SpatialHashQuery_t *)userdata;
+
+	for(uint32_t i=start;i<end;i++)
+	{
+		if(query->offsets[i]<query->maxPairs)
+			SpatialHash_RunQuery(query, i, query->pairs, query->offsets[i]);
+	}
+}
+
+// Count candidates per query, prefix sum them into output offsets, then write.
+// Both passes split the queries across the pool, and the output comes out in the same order as running serially.
+static uint32_t SpatialHash_RunQueries(SpatialHash_t *spatialHash, ThreadPool_t *pool, const vec3 *positions, const uint32_t numQueries, SpatialHashPair_t *pairs, const uint32_t maxPairs)
+{
+	if(spatialHash->dirty)
+		SpatialHash_Build(spatialHash);
+
+	if(numQueries==0)
+		return 0;
+
+	uint32_t *offsets=(uint32_t *)Zone_MallocTagged(zone, sizeof(uint32_t)*numQueries, TAG_UTILS);
+
+	if(offsets==NULL)
+	{
+		DBGPRINTF(DEBUG_ERROR, "SpatialHash_RunQueries: Unable to allocate memory for query offsets.\n");
+		return 0;
+	}
+
+	SpatialHashQuery_t query=
+	{
+		.spatialHash=spatialHash,
+		.positions=positions,
+		.offsets=offsets,
+		.pairs=pairs,
+		.maxPairs=pairs?maxPairs:0,
+	};
+
+	ThreadPool_ParallelFor(pool, 0, numQueries, 0, SpatialHash_CountRange, &query);
+
+	uint64_t total=0;
+
+	for(uint32_t i=0;i<numQueries;i++)
+	{
+		const uint32_t count=offsets[i];
+
+		offsets[i]=total>UINT32_MAX?UINT32_MAX:(uint32_t)total;
+		total+=count;
+	}
+
+	if(query.maxPairs)
+		ThreadPool_ParallelFor(pool, 0, numQueries, 0, SpatialHash_WriteRange, &query);
+
+	Zone_Free(zone, offsets);
+
+	return total>UINT32_MAX?UINT32_MAX:(uint32_t)total;
+}
+
+// Finds everything in the cells around each probe position, one (probe index, object index) pair per candidate.
+// Returns the total number of candidates, only the first maxPairs are written, so a bigger buffer can be passed if it comes back larger.
+// pool can be NULL to run on the calling thread.
+uint32_t SpatialHash_QueryBatch(SpatialHash_t *spatialHash, ThreadPool_t *pool, const vec3 *positions, const uint32_t numPositions, SpatialHashPair_t *pairs, const uint32_t maxPairs)
+{
+	if(spatialHash==NULL||spatialHash->cellStart==NULL||positions==NULL)
+		return 0;
+
+	return SpatialHash_RunQueries(spatialHash, pool, positions, numPositions, pairs, maxPairs);
+}
+
+// Broad phase pairs, every pair of objects in neighboring cells comes out once, with query (a) less than object (b).
+// Returns the total like SpatialHash_QueryBatch.
+uint32_t SpatialHash_QueryPairs(SpatialHash_t *spatialHash, ThreadPool_t *pool, SpatialHashPair_t *pairs, const uint32_t maxPairs)
+{
+	if(spatialHash==NULL||spatialHash->cellStart==NULL)
+		return 0;
+
+	return SpatialHash_RunQueries(spatialHash, pool, NULL, spatialHash->numObjects, pairs, maxPairs);
+}
+
+// Inserts into the nearest list (sorted by distance, at most k long) if it's closer than what's there
+static void SpatialHash_InsertNearest(const uint32_t object, const float distanceSq, const uint32_t k, uint32_t *found, uint32_t *indices, float *distancesSq)
+{
+	uint32_t i=*found;
+
+	if(i==k)
+	{
+		if(distanceSq>=distancesSq[k-1])
+			return;
+
+		i--;
+	}
+	else
+		(*found)++;
+
+	for(;i>0&&distancesSq[i-1]>distanceSq;i--)
+	{
+		indices[i]=indices[i-1];
+		distancesSq[i]=distancesSq[i-1];
+	}
+
+	indices[i]=object;
+	distancesSq[i]=distanceSq;
+}
+
+// Finds up to k objects nearest to position within maxDistance, closest first.
+// Searches shells of cells outwards from the position's cell and stops once the shell is further than the k'th hit,
+// or falls back to checking every object once a shell covers more cells than there are buckets.
+// Read only, so any number of threads can query a built table at once.
+// Returns the number found, indices and distancesSq (squared distances) need room for k entries.
+uint32_t SpatialHash_QueryNearest(const SpatialHash_t *spatialHash, const vec3 position, const uint32_t k, const float maxDistance, uint32_t *indices, float *distancesSq)
+{
+	if(spatialHash==NULL||spatialHash->cellStart==NULL||indices==NULL||distancesSq==NULL||k==0||maxDistance<=0.0f)
+		return 0;
+
+	if(spatialHash->dirty)
+	{
+		DBGPRINTF(DEBUG_WARNING, "SpatialHash_QueryNearest: Hash needs building before querying.\n");
+		return 0;
+	}
+
+	const float maxDistanceSq=maxDistance*maxDistance;
+	const float maxShell=ceilf(maxDistance*spatialHash->invGridSize);
+	uint32_t found=0;
+
+	int32_t center[3];
+	SpatialHash_GetCellCoords(spatialHash, position, center);
+
+	for(int32_t r=0;(float)r<=maxShell;r++)
+	{
+		const uint64_t shellWidth=2*(uint64_t)r+1;
+
+		if(shellWidth*shellWidth*shellWidth>spatialHash->hashTableSize)
+		{
+			// Every bucket is being hit anyway, quicker to just check everything.
+			// Nearest list is rebuilt from scratch, as some of what was found may be there again.
+			found=0;
+
+			for(uint32_t i=0;i<spatialHash->numObjects;i++)
+			{
+				const float distanceSq=Vec3_LengthSq(Vec3_Subv(spatialHash->positions[i], position));
+
+				if(distanceSq<=maxDistanceSq)
+					SpatialHash_InsertNearest(i, distanceSq, k, &found, indices, distancesSq);
+			}
+
+			return found;
+		}
+
+		// Cells on the surface of the shell
+		for(int32_t dx=-r;dx<=r;dx++)
+		{
+			for(int32_t dy=-r;dy<=r;dy++)
+			{
+				const bool edge=abs(dx)==r||abs(dy)==r;
+
+				for(int32_t dz=-r;dz<=r;dz+=(edge||r==0)?1:2*r)
+				{
+					const int32_t cell[3]={ center[0]+dx, center[1]+dy, center[2]+dz };
+					const uint32_t bucket=hashFunction(cell[0], cell[1], cell[2], spatialHash->hashTableSize);
+					const uint32_t start=spatialHash->cellStart[bucket], end=spatialHash->cellStart[bucket+1];
+
+					for(uint32_t j=start;j<end;j++)
+					{
+						const uint32_t object=spatialHash->sortedObjects[j];
+
+						// Each object is only taken from its own cell, so nothing comes up twice
+						if(!SpatialHash_InCell(spatialHash, object, cell))
+							continue;
+
+						const float distanceSq=Vec3_LengthSq(Vec3_Subv(spatialHash->positions[object], position));
+
+						if(distanceSq<=maxDistanceSq)
+							SpatialHash_InsertNearest(object, distanceSq, k, &found, indices, distancesSq);
+					}
+				}
+			}
+		}
+
+		// Anything not found yet is at least r cells away
+		const float shellDistance=(float)r*spatialHash->gridSize;
+
+		if(found==k&&distancesSq[k-1]<=shellDistance*shellDistance)
+			break;
+	}
+
+	return found;
+}
+
+// Walks the cells a ray passes through (Amanatides and Woo DDA) and collects the objects in them, in the order the ray reaches their cells.
+// Objects are hashed by a single point, so this only finds candidates whose point lies in a cell the ray touches,
+// narrow phase tests are up to the caller.
+// Read only like SpatialHash_QueryNearest, returns the number of objects written, stopping when maxIndices is reached.
+uint32_t SpatialHash_QueryRay(const SpatialHash_t *spatialHash, const vec3 origin, const vec3 direction, const float maxDistance, uint32_t *indices, const uint32_t maxIndices)
+{
+	if(spatialHash==NULL||spatialHash->cellStart==NULL||indices==NULL||maxIndices==0||!(maxDistance>0.0f)||!isfinite(maxDistance))
+		return 0;
+
+	if(spatialHash->dirty)
+	{
+		DBGPRINTF(DEBUG_WARNING, "SpatialHash_QueryRay: Hash needs building before querying.\n");
+		return 0;
+	}
+
+	const float length=Vec3_Length(direction);
+
+	if(length<=0.0f)
+		return 0;
+
+	const float dir[3]={ direction.x/length, direction.y/length, direction.z/length };
+	const float start[3]={ origin.x, origin.y, origin.z };
+
+	int32_t cell[3], step[3];
+	float tMax[3], tDelta[3];
+
+	SpatialHash_GetCellCoords(spatialHash, origin, cell);
+
+	for(uint32_t i=0;i<3;i++)
+	{
+		if(dir[i]>0.0f)
+		{
+			step[i]=1;
+			tMax[i]=((float)(cell[i]+1)*spatialHash->gridSize-start[i])/dir[i];
+			tDelta[i]=spatialHash->gridSize/dir[i];
+		}
+		else if(dir[i]<0.0f)
+		{
+			step[i]=-1;
+			tMax[i]=((float)cell[i]*spatialHash->gridSize-start[i])/dir[i];
+			tDelta[i]=-spatialHash->gridSize/dir[i];
+		}
+		else
+		{
+			step[i]=0;
+			tMax[i]=INFINITY;
+			tDelta[i]=INFINITY;
+		}
+	}
+
+	uint32_t count=0;
+
+	for(;;)
+	{
+		const uint32_t bucket=hashFunction(cell[0], cell[1], cell[2], spatialHash->hashTableSize);
+
+		for(uint32_t j=spatialHash->cellStart[bucket];j<spatialHash->cellStart[bucket+1];j++)
+		{
+			const uint32_t object=spatialHash->sortedObjects[j];
+
+			if(!SpatialHash_InCell(spatialHash, object, cell))
+				continue;
+
+			indices[count++]=object;
+
+			if(count==maxIndices)
+				return count;
+		}
+
+		// Step along whichever axis hits its next cell boundary first
+		uint32_t axis=0;
+
+		if(tMax[1]<tMax[axis])
+			axis=1;
+
+		if(tMax[2]<tMax[axis])
+			axis=2;
+
+		if(tMax[axis]>maxDistance)
+			break;
+
+		cell[axis]+=step[axis];
+		tMax[axis]+=tDelta[axis];
+	}
+
+	return count;
+}
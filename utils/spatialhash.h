@@ -4,24 +4,51 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "../math/math.h"
+#include "../system/threads.h"
 
+// A candidate from a batch query, query is the probe (or object 'a' in pair mode) index, object is the index of what it found
 typedef struct
 {
-	uint32_t numObjects;
-	void *objects[100];
-} Cell_t;
+	uint32_t query;
+	uint32_t object;
+} SpatialHashPair_t;
 
+// Spatial hash stored as flat arrays.
+// Adding an object appends its hashed cell and pointer, SpatialHash_Build then counting sorts them by cell
+// (count per cell, prefix sum, scatter), so every cell's objects end up in one contiguous range of sortedObjects.
+// There's no per-cell limit, and clearing/rebuilding only costs the number of objects plus one counter per cell.
 typedef struct
 {
 	uint32_t hashTableSize;
 	float gridSize, invGridSize;
-	Cell_t *hashTable;
+
+	// Objects in the order they were added, with the position they were added at and the cell it hashed to
+	uint32_t numObjects, maxObjects;
+	uint32_t *objectCells;
+	vec3 *positions;
+	void **objects;
+
+	// Cell i's objects are sortedObjects[cellStart[i]] to sortedObjects[cellStart[i+1]-1], as indices into objects
+	uint32_t *cellStart;
+	uint32_t *sortedObjects;
+
+	// Objects were added since the last build
+	bool dirty;
 } SpatialHash_t;
 
 bool SpatialHash_Create(SpatialHash_t *spatialHash, const uint32_t tableSize, const float gridSize);
 void SpatialHash_Destroy(SpatialHash_t *spatialHash);
 void SpatialHash_Clear(SpatialHash_t *spatialHash);
 bool SpatialHash_AddObject(SpatialHash_t *spatialHash, const vec3 value, void *object);
+bool SpatialHash_Build(SpatialHash_t *spatialHash);
+uint32_t SpatialHash_GetCellIndex(const SpatialHash_t *spatialHash, const vec3 value);
+const uint32_t *SpatialHash_GetCell(const SpatialHash_t *spatialHash, const uint32_t cellIndex, uint32_t *count);
+void *SpatialHash_GetObject(const SpatialHash_t *spatialHash, const uint32_t index);
+uint32_t SpatialHash_GetObjectCount(const SpatialHash_t *spatialHash);
 void SpatialHash_TestObjects(SpatialHash_t *spatialHash, vec3 value, void *a, void (*testFunc)(void *a, void *b));
+uint32_t SpatialHash_QueryBatch(SpatialHash_t *spatialHash, ThreadPool_t *pool, const vec3 *positions, const uint32_t numPositions, SpatialHashPair_t *pairs, const uint32_t maxPairs);
+uint32_t SpatialHash_QueryPairs(SpatialHash_t *spatialHash, ThreadPool_t *pool, SpatialHashPair_t *pairs, const uint32_t maxPairs);
+uint32_t SpatialHash_QueryNearest(const SpatialHash_t *spatialHash, const vec3 position, const uint32_t k, const float maxDistance, uint32_t *indices, float *distancesSq);
+uint32_t SpatialHash_QueryRay(const SpatialHash_t *spatialHash, const vec3 origin, const vec3 direction, const float maxDistance, uint32_t *indices, const uint32_t maxIndices);
 
 #endif
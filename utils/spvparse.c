@@ -666,7 +666,7 @@ bool parseSpv(const uint32_t *opCodes, const uint32_t codeSize)
 
 	printSpvHeader(header);
 
-	SpvID_t *IDs=(SpvID_t *)Zone_Malloc(zone, sizeof(SpvID_t)*header->bound);
+	SpvID_t *IDs=(SpvID_t *)Zone_MallocTagged(zone, sizeof(SpvID_t)*header->bound, TAG_UTILS);
 
 	if(IDs==NULL)
 		return false;
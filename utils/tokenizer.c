@@ -3,13 +3,127 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <threads.h>
 #include "../system/system.h"
+#include "../system/pool.h"
 #include "tokenizer.h"
 
+// Tokens are small and short lived, so they come from a pool, with short strings stored inline after the token
+#define TOKEN_SLOT_SIZE 64
+#define TOKEN_INLINE_STRING (TOKEN_SLOT_SIZE-sizeof(Token_t))
+
+static Pool_t tokenPool;
+static once_flag tokenPoolOnce=ONCE_FLAG_INIT;
+
+// Keyword array address to its lookup set, plus the boolean names to their values
+static mtx_t keywordMutex;
+static HashMap_t keywordSets;
+static HashMap_t booleanMap;
+
+static void Tokenizer_InitPool(void)
+{
+	Pool_Init(&tokenPool, TOKEN_SLOT_SIZE, 256);
+
+	mtx_init(&keywordMutex, mtx_plain);
+	HashMap_Init(&keywordSets, HASHMAP_KEY_INTEGER, HASHMAP_STORAGE_ZONE, sizeof(HashMap_t *), 4);
+
+	HashMap_Init(&booleanMap, HASHMAP_KEY_STRING, HASHMAP_STORAGE_ZONE, sizeof(bool), 2);
+	HashMap_Insert(&booleanMap, "false", &(bool) { false });
+	HashMap_Insert(&booleanMap, "true", &(bool) { true });
+}
+
+static HashMap_t *Tokenizer_GetKeywordSet(size_t numKeywords, const char **keywords)
+{
+	if(numKeywords==0||keywords==NULL)
+		return NULL;
+
+	call_once(&tokenPoolOnce, Tokenizer_InitPool);
+
+	mtx_lock(&keywordMutex);
+
+	HashMap_t **cached=(HashMap_t **)HashMap_GetInteger(&keywordSets, (uint64_t)(uintptr_t)keywords);
+
+	if(cached)
+	{
+		HashMap_t *set=*cached;
+		mtx_unlock(&keywordMutex);
+
+		return set;
+	}
+
+	HashMap_t *set=(HashMap_t *)Zone_MallocTagged(zone, sizeof(HashMap_t), TAG_UTILS);
+
+	if(set==NULL)
+	{
+		mtx_unlock(&keywordMutex);
+		return NULL;
+	}
+
+	if(!HashMap_Init(set, HASHMAP_KEY_STRING, HASHMAP_STORAGE_ZONE, 0, (uint32_t)numKeywords))
+	{
+		Zone_Free(zone, set);
+		mtx_unlock(&keywordMutex);
+		return NULL;
+	}
+
+	for(size_t i=0;i<numKeywords;i++)
+		HashMap_Insert(set, keywords[i], NULL);
+
+	HashMap_InsertInteger(&keywordSets, (uint64_t)(uintptr_t)keywords, &set);
+
+	mtx_unlock(&keywordMutex);
+
+	return set;
+}
+
+static Token_t *Tokenizer_AllocToken(size_t stringSize)
+{
+	call_once(&tokenPoolOnce, Tokenizer_InitPool);
+
+	Token_t *token=(Token_t *)Pool_Malloc(&tokenPool);
+
+	if(token==NULL)
+		return NULL;
+
+	if(stringSize==0)
+		return token;
+
+	if(stringSize<=TOKEN_INLINE_STRING)
+		token->string=(char *)(token+1);
+	else
+	{
+		token->string=(char *)Zone_MallocTagged(zone, stringSize, TAG_UTILS);
+
+		if(token->string==NULL)
+		{
+			Pool_Free(&tokenPool, token);
+			return NULL;
+		}
+	}
+
+	return token;
+}
+
+void Tokenizer_FreeToken(Token_t *token)
+{
+	if(token==NULL)
+		return;
+
+	// Strings that didn't fit inline have their own allocation
+	if(token->type==TOKEN_STRING||token->type==TOKEN_QUOTED||token->type==TOKEN_KEYWORD)
+	{
+		if(token->string!=(char *)(token+1))
+			Zone_Free(zone, token->string);
+	}
+
+	Pool_Free(&tokenPool, token);
+}
+
 bool Tokenizer_Init(Tokenizer_t *context, size_t stringLength, char *string, size_t numKeywords, const char **keywords)
 {
 	context->numKeywords=numKeywords;
 	context->keywords=keywords;
+	context->keywordSet=Tokenizer_GetKeywordSet(numKeywords, keywords);
 
 	context->stringLength=stringLength;
 	context->stringPosition=0;
@@ -19,7 +133,6 @@ bool Tokenizer_Init(Tokenizer_t *context, size_t stringLength, char *string, siz
 }
 
 static const char delimiters[]="\'\"{}[]()<>!@#$%^&*-+=,.:;\\/|`~ \t\n\r";
-static const char *booleans[]={ "false", "true" };
 
 static bool IsAlpha(const char c)
 {
@@ -48,15 +161,12 @@ static bool IsDelimiter(const char c)
 	return false;
 }
 
-static bool IsWord(const char *word, const char *stringArray[], size_t arraySize)
+static bool IsWord(const char *word, HashMap_t *wordSet)
 {
-	for(size_t i=0;i<arraySize;i++)
-	{
-		if(strcmp(word, stringArray[i])==0)
-			return true;
-	}
+	if(wordSet==NULL)
+		return false;
 
-	return false;
+	return HashMap_Has(wordSet, word);
 }
 
 static char GetChar(Tokenizer_t *context, size_t offset)
@@ -155,13 +265,12 @@ Token_t *Tokenizer_GetNext(Tokenizer_t *context)
 		while(!IsDelimiter(GetChar(context, count))&&GetChar(context, count)!='\0')
 			count++;
 
-		token=(Token_t *)Zone_Malloc(zone, sizeof(Token_t)+count+1);
+		token=Tokenizer_AllocToken(count+1);
 
 		if(token==NULL)
 			return NULL;
 
 		token->type=TOKEN_STRING;
-		token->string=(char *)(token+1);
 
 		memcpy(token->string, &context->string[context->stringPosition], count);
 		token->string[count]='\0';
@@ -169,17 +278,15 @@ Token_t *Tokenizer_GetNext(Tokenizer_t *context)
 		context->stringPosition+=count;
 
 		// Re-classify the string if it matches any of these:
-		if(IsWord(token->string, booleans, sizeof(booleans)/sizeof(booleans[0])))
+		const bool *boolean=(const bool *)HashMap_Get(&booleanMap, token->string);
+
+		// Boolean shares the union with string, so it can't go on to the keyword check after setting it
+		if(boolean)
 		{
 			token->type=TOKEN_BOOLEAN;
-
-			if(strcmp(token->string, "true")==0)
-				token->boolean=true;
-			else
-				token->boolean=false;
+			token->boolean=*boolean;
 		}
-
-		if(IsWord(token->string, context->keywords, context->numKeywords))
+		else if(IsWord(token->string, context->keywordSet))
 			token->type=TOKEN_KEYWORD;
 	}
 	else if(GetChar(context, 0)=='0'&&(GetChar(context, 1)=='x'||GetChar(context, 1)=='X')) // Hexidecimal numbers
@@ -187,7 +294,7 @@ Token_t *Tokenizer_GetNext(Tokenizer_t *context)
 		const char *start=context->string+context->stringPosition+2;
 		char *end=NULL;
 
-		token=(Token_t *)Zone_Malloc(zone, sizeof(Token_t));
+		token=Tokenizer_AllocToken(0);
 
 		if(token==NULL)
 			return NULL;
@@ -202,7 +309,7 @@ Token_t *Tokenizer_GetNext(Tokenizer_t *context)
 		const char *start=context->string+context->stringPosition+2;
 		char *end=NULL;
 
-		token=(Token_t *)Zone_Malloc(zone, sizeof(Token_t));
+		token=Tokenizer_AllocToken(0);
 
 		if(token==NULL)
 			return NULL;
@@ -218,7 +325,7 @@ Token_t *Tokenizer_GetNext(Tokenizer_t *context)
 		char *end=NULL;
 		size_t count=0;
 
-		token=(Token_t *)Zone_Malloc(zone, sizeof(Token_t));
+		token=Tokenizer_AllocToken(0);
 
 		if(token==NULL)
 			return NULL;
@@ -256,13 +363,12 @@ Token_t *Tokenizer_GetNext(Tokenizer_t *context)
 			while(GetChar(context, count)!='\"'&&GetChar(context, count)!='\0')
 				count++;
 
-			token=(Token_t *)Zone_Malloc(zone, sizeof(Token_t)+count+1);
+			token=Tokenizer_AllocToken(count+1);
 
 			if(token==NULL)
 				return NULL;
 
 			token->type=TOKEN_QUOTED;
-			token->string=(char *)(token+1);
 
 			memcpy(token->string, &context->string[context->stringPosition], count);
 			token->string[count]='\0';
@@ -271,7 +377,7 @@ Token_t *Tokenizer_GetNext(Tokenizer_t *context)
 		}
 		else
 		{
-			token=(Token_t *)Zone_Malloc(zone, sizeof(Token_t));
+			token=Tokenizer_AllocToken(0);
 
 			if(token==NULL)
 				return NULL;
@@ -341,7 +447,7 @@ bool Tokenizer_ArgumentHelper(Tokenizer_t *tokenizer, char *fmt, ...)
 		// Loop until right parenthesis ')' or until break condition
 		while(!(token->type==TOKEN_DELIMITER&&token->string[0]==')'))
 		{
-			Zone_Free(zone, token);
+			Tokenizer_FreeToken(token);
 			token=Tokenizer_GetNext(tokenizer);
 
 			void *arg=va_arg(ap, void *);
@@ -415,7 +521,7 @@ bool Tokenizer_ArgumentHelper(Tokenizer_t *tokenizer, char *fmt, ...)
 					return false;
 			}
 
-			Zone_Free(zone, token);
+			Tokenizer_FreeToken(token);
 			token=Tokenizer_GetNext(tokenizer);
 
 			if(token->type==TOKEN_DELIMITER)
@@ -437,7 +543,7 @@ bool Tokenizer_ArgumentHelper(Tokenizer_t *tokenizer, char *fmt, ...)
 	}
 
 	va_end(ap);
-	Zone_Free(zone, token);
+	Tokenizer_FreeToken(token);
 
 	return true;
 }
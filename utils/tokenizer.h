@@ -2,6 +2,7 @@
 #define __TOKENIZER_H__
 
 #include <stdint.h>
+#include "hashmap.h"
 
 typedef enum
 {
@@ -33,13 +34,16 @@ typedef struct
 	size_t stringPosition;
 	char *string;
 
+	// Keyword arrays need to be static, the lookup set for each array is built the first time it's seen and kept
 	size_t numKeywords;
 	const char **keywords;
+	HashMap_t *keywordSet;
 } Tokenizer_t;
 
 bool Tokenizer_Init(Tokenizer_t *context, size_t stringLength, char *string, size_t numKeywords, const char **keywords);
 Token_t *Tokenizer_GetNext(Tokenizer_t *context);
 Token_t *Tokenizer_PeekNext(Tokenizer_t *context);
+void Tokenizer_FreeToken(Token_t *token);
 void Tokenizer_PrintToken(const char *msg, const Token_t *token);
 bool Tokenizer_ArgumentHelper(Tokenizer_t *tokenizer, char *fmt, ...);
 
@@ -363,7 +363,7 @@ static bool VR_InitSystem(XruContext_t *xrContext, const XrFormFactor formFactor
 		return false;
 	}
 
-	char *instanceExtensionNames=Zone_Malloc(zone, instanceExtensionNamesSize);
+	char *instanceExtensionNames=Zone_MallocTagged(zone, instanceExtensionNamesSize, TAG_VR);
 
 	if(instanceExtensionNames==NULL)
 	{
@@ -387,7 +387,7 @@ static bool VR_InitSystem(XruContext_t *xrContext, const XrFormFactor formFactor
 		return false;
 	}
 
-	char *extensionNames=Zone_Malloc(zone, extensionNamesSize);
+	char *extensionNames=Zone_MallocTagged(zone, extensionNamesSize, TAG_VR);
 
 	if(extensionNames==NULL)
 	{
@@ -542,7 +542,7 @@ static bool VR_InitSwapchain(XruContext_t *xrContext, VkuContext_t *context)
 
 	DBGPRINTF(DEBUG_INFO, "VR: Runtime supports %d swapchain formats.\n", swapchainFormatCount);
 
-	int64_t *swapchainFormats=Zone_Malloc(zone, sizeof(int64_t)*swapchainFormatCount);
+	int64_t *swapchainFormats=Zone_MallocTagged(zone, sizeof(int64_t)*swapchainFormatCount, TAG_VR);
 
 	if(swapchainFormats==NULL)
 	{
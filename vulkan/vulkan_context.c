@@ -126,7 +126,7 @@ VkBool32 vkuCreateContext(VkInstance instance, VkuContext_t *context)
 	}
 
 	// Allocate an array of handles
-	VkPhysicalDevice *deviceHandles=(VkPhysicalDevice *)Zone_Malloc(zone, sizeof(VkPhysicalDevice)*physicalDeviceCount);
+	VkPhysicalDevice *deviceHandles=(VkPhysicalDevice *)Zone_MallocTagged(zone, sizeof(VkPhysicalDevice)*physicalDeviceCount, TAG_VULKAN);
 
 	if(deviceHandles==NULL)
 	{
@@ -152,7 +152,7 @@ VkBool32 vkuCreateContext(VkInstance instance, VkuContext_t *context)
 	vkGetPhysicalDeviceQueueFamilyProperties(deviceHandles[context->deviceIndex], &queueFamilyCount, VK_NULL_HANDLE);
 
 	// Allocate the memory for the structs 
-	VkQueueFamilyProperties *queueFamilyProperties=(VkQueueFamilyProperties *)Zone_Malloc(zone, sizeof(VkQueueFamilyProperties)*queueFamilyCount);
+	VkQueueFamilyProperties *queueFamilyProperties=(VkQueueFamilyProperties *)Zone_MallocTagged(zone, sizeof(VkQueueFamilyProperties)*queueFamilyCount, TAG_VULKAN);
 
 	if(queueFamilyProperties==NULL)
 	{
@@ -219,7 +219,7 @@ VkBool32 vkuCreateContext(VkInstance instance, VkuContext_t *context)
 	uint32_t extensionCount=0;
 	vkEnumerateDeviceExtensionProperties(context->physicalDevice, VK_NULL_HANDLE, &extensionCount, VK_NULL_HANDLE);
 
-	VkExtensionProperties *extensionProperties=(VkExtensionProperties *)Zone_Malloc(zone, sizeof(VkExtensionProperties)*extensionCount);
+	VkExtensionProperties *extensionProperties=(VkExtensionProperties *)Zone_MallocTagged(zone, sizeof(VkExtensionProperties)*extensionCount, TAG_VULKAN);
 
 	if(extensionProperties==VK_NULL_HANDLE)
 	{
@@ -538,7 +538,7 @@ VkBool32 vkuCreateContext(VkInstance instance, VkuContext_t *context)
 		size_t pipelineCacheSize=ftell(stream);
 		fseek(stream, 0, SEEK_SET);
 
-		uint8_t *pipelineCacheData=(uint8_t *)Zone_Malloc(zone, pipelineCacheSize);
+		uint8_t *pipelineCacheData=(uint8_t *)Zone_MallocTagged(zone, pipelineCacheSize, TAG_VULKAN);
 
 		if(pipelineCacheData)
 		{
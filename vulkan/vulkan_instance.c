@@ -40,7 +40,7 @@ VkBool32 vkuCreateInstance(VkInstance *instance)
 		return VK_FALSE;
 	}
 
-	VkExtensionProperties *extensionProperties=(VkExtensionProperties *)Zone_Malloc(zone, sizeof(VkExtensionProperties)*extensionCount);
+	VkExtensionProperties *extensionProperties=(VkExtensionProperties *)Zone_MallocTagged(zone, sizeof(VkExtensionProperties)*extensionCount, TAG_VULKAN);
 
 	if(extensionProperties==VK_NULL_HANDLE)
 	{
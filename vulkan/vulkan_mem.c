@@ -3,10 +3,28 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <threads.h>
 #include "../system/system.h"
+#include "../system/pool.h"
 #include "../math/math.h"
 #include "vulkan.h"
 
+// Block list nodes are all the same size and churn on every allocation split/merge, so they come from a pool
+static Pool_t blockPool;
+static once_flag blockPoolOnce=ONCE_FLAG_INIT;
+
+static void vkuMem_InitPool(void)
+{
+	Pool_Init(&blockPool, sizeof(VkuMemBlock_t), 256);
+}
+
+static VkuMemBlock_t *vkuMem_AllocBlock(void)
+{
+	call_once(&blockPoolOnce, vkuMem_InitPool);
+
+	return (VkuMemBlock_t *)Pool_Malloc(&blockPool);
+}
+
 bool vkuMem_Init(VkuContext_t *context, VkuMemZone_t *vkZone, uint32_t typeIndex, size_t size)
 {
 	// Set up create info with slab size
@@ -28,7 +46,7 @@ bool vkuMem_Init(VkuContext_t *context, VkuMemZone_t *vkZone, uint32_t typeIndex
 		return false;
 	}
 
-	vkZone->blocks=(VkuMemBlock_t *)Zone_Malloc(zone, sizeof(VkuMemBlock_t));
+	vkZone->blocks=vkuMem_AllocBlock();
 
 	if(vkZone->blocks==NULL)
 	{
@@ -77,10 +95,13 @@ void vkuMem_Destroy(VkuContext_t *context, VkuMemZone_t *vkZone)
 
 		while(block!=NULL)
 		{
-			Zone_Free(zone, block);
-			block=block->next;
+			VkuMemBlock_t *next=block->next;
+			Pool_Free(&blockPool, block);
+			block=next;
 		}
 
+		vkZone->blocks=NULL;
+
 		if(vkZone->mappedPointer)
 			vkUnmapMemory(context->device, vkZone->deviceMemory);
 
@@ -117,7 +138,7 @@ void vkuMem_Free(VkuMemZone_t *vkZone, VkuMemBlock_t *block)
 		if(block==vkZone->blocks)
 			vkZone->blocks=Last;
 
-		Zone_Free(zone, block);
+		Pool_Free(&blockPool, block);
 		block=Last;
 	}
 
@@ -134,7 +155,7 @@ void vkuMem_Free(VkuMemZone_t *vkZone, VkuMemBlock_t *block)
 		if(next==vkZone->blocks)
 			vkZone->blocks=block;
 
-		Zone_Free(zone, next);
+		Pool_Free(&blockPool, next);
 	}
 }
 
@@ -162,7 +183,13 @@ VkuMemBlock_t *vkuMem_Malloc(VkuMemZone_t *vkZone, VkMemoryRequirements memoryRe
 			if(remainingSize>=minimumBlockSize)
 			{
 				// Create a new free space block from the extra space
-				VkuMemBlock_t *newBlock=(VkuMemBlock_t *)Zone_Malloc(zone, sizeof(VkuMemBlock_t));
+				VkuMemBlock_t *newBlock=vkuMem_AllocBlock();
+
+				if(newBlock==NULL)
+				{
+					DBGPRINTF(DEBUG_ERROR, "Vulkan mem: Failed to allocate memory for memory block.\n");
+					return NULL;
+				}
 
 				// Align the new block's offset
 				newBlock->offset=baseBlock->offset+alignedSize;
@@ -39,7 +39,7 @@ VkShaderModule vkuCreateShaderModule(VkDevice device, const char *shaderFile)
 	uint32_t size=(uint32_t)(ceilf((float)ftell(stream)/sizeof(uint32_t))*sizeof(uint32_t));
 	fseek(stream, 0, SEEK_SET);
 
-	uint32_t *data=(uint32_t *)Zone_Malloc(zone, size);
+	uint32_t *data=(uint32_t *)Zone_MallocTagged(zone, size, TAG_VULKAN);
 
 	if(data==NULL)
 		return VK_NULL_HANDLE;
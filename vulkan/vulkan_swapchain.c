@@ -25,7 +25,7 @@ VkBool32 vkuCreateSwapchain(VkuContext_t *context, VkuSwapchain_t *swapchain, Vk
 	uint32_t formatCount=0;
 	vkGetPhysicalDeviceSurfaceFormatsKHR(context->physicalDevice, context->surface, &formatCount, VK_NULL_HANDLE);
 
-	VkSurfaceFormatKHR *surfaceFormats=(VkSurfaceFormatKHR *)Zone_Malloc(zone, sizeof(VkSurfaceFormatKHR)*formatCount);
+	VkSurfaceFormatKHR *surfaceFormats=(VkSurfaceFormatKHR *)Zone_MallocTagged(zone, sizeof(VkSurfaceFormatKHR)*formatCount, TAG_VULKAN);
 
 	if(surfaceFormats==NULL)
 		return VK_FALSE;
@@ -68,7 +68,7 @@ VkBool32 vkuCreateSwapchain(VkuContext_t *context, VkuSwapchain_t *swapchain, Vk
 	uint32_t presentModeCount=0;
 	vkGetPhysicalDeviceSurfacePresentModesKHR(context->physicalDevice, context->surface, &presentModeCount, NULL);
 
-	VkPresentModeKHR *presentModes=(VkPresentModeKHR *)Zone_Malloc(zone, sizeof(VkPresentModeKHR)*presentModeCount);
+	VkPresentModeKHR *presentModes=(VkPresentModeKHR *)Zone_MallocTagged(zone, sizeof(VkPresentModeKHR)*presentModeCount, TAG_VULKAN);
 
 	if(presentModes==NULL)
 		return VK_FALSE;